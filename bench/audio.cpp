@@ -0,0 +1,156 @@
+#include "bench.h"
+
+#include "audio/mix.h"
+#include "audio/mixer.h"
+#include "audio/wav.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+// Compares the SIMD mixing loops against their scalar versions, then
+// times the whole mixer with hundreds of voices playing at once, mostly
+// resampled from 44.1 kHz with varying pitch. Last, the mixer thread runs
+// in real time alongside a set of streamed tracks, to check decoding
+// keeps ahead of it.
+
+#define NUM_VOICES 256
+#define SOUND_SECONDS 2
+#define NUM_STREAMS 16
+#define STREAM_SECONDS 20
+#define STREAM_RUN_SECONDS 3
+
+static float Random(float min, float max)
+{
+    return min + (max - min) * (rand() / (float)RAND_MAX);
+}
+
+static void MakeTone(Sound &sound, int channels, int sampleRate, float frequency)
+{
+    sound.channels = channels;
+    sound.sampleRate = sampleRate;
+    sound.frames = sampleRate * SOUND_SECONDS;
+    sound.samples.assign(((size_t)sound.frames + 1) * channels, 0.0f);
+    for (int i = 0; i < sound.frames; i++)
+    {
+        for (int c = 0; c < channels; c++)
+            sound.samples[(size_t)i * channels + c] = sinf(i * frequency * (c + 1) * 6.2831853f / sampleRate) * 0.5f;
+    }
+}
+
+// A 16-bit stereo WAV file in memory, as a track would be mapped
+static std::vector<unsigned char> MakeTrack(const char *path)
+{
+    FILE *file = fopen(path, "w+b");
+    std::vector<unsigned char> data;
+    if (!file)
+        return data;
+
+    BeginWavFile(file, 44100);
+    std::vector<float> frames(44100 * 2);
+    for (int second = 0; second < STREAM_SECONDS; second++)
+    {
+        for (int i = 0; i < 44100; i++)
+            frames[i * 2] = frames[i * 2 + 1] = sinf((second * 44100 + i) * 0.05f) * 0.5f;
+        WriteWavFrames(file, frames.data(), 44100);
+    }
+    FinishWavFile(file);
+
+    data.resize((size_t)ftell(file));
+    rewind(file);
+    if (fread(data.data(), 1, data.size(), file) != data.size())
+        data.clear();
+    fclose(file);
+    remove(path);
+    return data;
+}
+
+int main()
+{
+    const int frames = AUDIO_FRAMES_PER_BUFFER;
+    std::vector<float> left(frames), right(frames);
+
+    Sound mono, stereo;
+    MakeTone(mono, 1, 44100, 440.0f);
+    MakeTone(stereo, 2, 44100, 220.0f);
+    MixGain gain = { 0.5f, 0.5f, 0.0001f, -0.0001f };
+    uint64_t resampled = (uint64_t)(44100.0 / 48000.0 * MIX_POSITION_ONE);
+
+    BenchCompare("mono, same rate", frames,
+        [&] { BenchKeep(MixMonoScalar(left.data(), right.data(), frames, mono.samples.data(), 0, MIX_POSITION_ONE, gain)); },
+        [&] { BenchKeep(MixMono(left.data(), right.data(), frames, mono.samples.data(), 0, MIX_POSITION_ONE, gain)); });
+
+    BenchCompare("mono, resampled", frames,
+        [&] { BenchKeep(MixMonoScalar(left.data(), right.data(), frames, mono.samples.data(), 12345, resampled, gain)); },
+        [&] { BenchKeep(MixMono(left.data(), right.data(), frames, mono.samples.data(), 12345, resampled, gain)); });
+
+    BenchCompare("stereo, same rate", frames,
+        [&] { BenchKeep(MixStereoScalar(left.data(), right.data(), frames, stereo.samples.data(), 0, MIX_POSITION_ONE, gain)); },
+        [&] { BenchKeep(MixStereo(left.data(), right.data(), frames, stereo.samples.data(), 0, MIX_POSITION_ONE, gain)); });
+
+    BenchCompare("stereo, resampled", frames,
+        [&] { BenchKeep(MixStereoScalar(left.data(), right.data(), frames, stereo.samples.data(), 12345, resampled, gain)); },
+        [&] { BenchKeep(MixStereo(left.data(), right.data(), frames, stereo.samples.data(), 12345, resampled, gain)); });
+
+    // A quarter of the voices are stereo, and a quarter play at the
+    // output rate; everything else is resampled
+    Sound native;
+    MakeTone(native, 1, AUDIO_SAMPLE_RATE, 330.0f);
+    AudioMixer mixer(new NullAudioSink(AUDIO_SAMPLE_RATE, frames));
+    for (int i = 0; i < NUM_VOICES; i++)
+    {
+        const Sound *sound = i % 4 == 0 ? &stereo : (i % 4 == 1 ? &native : &mono);
+        float pitch = i % 4 == 1 ? 1.0f : Random(0.5f, 2.0f);
+        mixer.play(sound, Random(0.1f, 0.5f) / NUM_VOICES, Random(-1.0f, 1.0f), pitch, true);
+    }
+
+    std::vector<float> out((size_t)frames * 2);
+    printf("mixer (%d voices, %d frames per buffer)\n", NUM_VOICES, frames);
+    double ns = BenchRun("per voice-frame", (long)frames * NUM_VOICES, [&] {
+        mixer.mix(out.data(), frames);
+        BenchKeep(out[0]);
+    });
+
+    AudioStats stats = mixer.getStats();
+    double bufferMs = ns * frames * NUM_VOICES * 1e-6;
+    printf("  %-40s %10.3f ms of %.3f ms (%.1f%% of a core)\n", "per buffer", bufferMs, stats.bufferMs,
+           bufferMs * 100.0 / stats.bufferMs);
+    printf("  %-40s %10d\n", "active voices", stats.activeVoices);
+
+    std::vector<unsigned char> track = MakeTrack("bench-audio-track.wav");
+    if (track.empty())
+        return 1;
+
+    // Nothing here fails, so the streamer has no need to log
+    AudioStreamer streamer(nullptr);
+    AudioMixer music(new NullAudioSink(AUDIO_SAMPLE_RATE, frames));
+    std::vector<AudioStream *> streams;
+    for (int i = 0; i < NUM_STREAMS; i++)
+    {
+        streams.push_back(streamer.openMemory(track.data(), track.size(), true));
+        music.playStream(streams.back(), 1.0f / NUM_STREAMS, Random(-1.0f, 1.0f));
+    }
+
+    music.startThread();
+    std::this_thread::sleep_for(std::chrono::seconds(STREAM_RUN_SECONDS));
+    music.stopThread();
+
+    stats = music.getStats();
+    int buffered = 0;
+    for (AudioStream *stream : streams)
+        buffered += stream->getBufferedFrames();
+
+    printf("streaming (%d tracks from 44.1 kHz WAV, %d s in real time)\n", NUM_STREAMS, STREAM_RUN_SECONDS);
+    printf("  %-40s %10.3f ms\n", "average mix per buffer", stats.averageMixMs);
+    printf("  %-40s %10.3f ms\n", "peak mix per buffer", stats.peakMixMs);
+    printf("  %-40s %10.1f ms\n", "average prefetched per track", buffered * 1000.0 / NUM_STREAMS / 44100);
+    printf("  %-40s %10u\n", "stream underruns", stats.streamUnderruns);
+
+    // The voices still hold references, so the streams outlive these
+    // calls; the streamer frees everything when it goes
+    for (AudioStream *stream : streams)
+        streamer.close(stream);
+    return 0;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <chrono>
+#include <stdio.h>
+
+// Minimal timing harness for the CPU benchmarks. Each body is run until
+// at least BENCH_MIN_SECONDS have passed and the mean time per item is
+// reported, so results are comparable across batch sizes.
+
+#define BENCH_MIN_SECONDS 0.25
+
+// Keeps the compiler from optimising away work whose result is unused
+#if defined(__GNUC__) || defined(__clang__)
+template <typename T>
+inline void BenchKeep(const T &value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+#else
+#include <intrin.h>
+template <typename T>
+inline void BenchKeep(const T &value)
+{
+    static volatile char sink;
+    sink = *(const volatile char *)&value;
+    _ReadWriteBarrier();
+}
+#endif
+
+// Returns nanoseconds per item
+template <typename F>
+double BenchRun(const char *name, long items, F body)
+{
+    using clock = std::chrono::steady_clock;
+
+    // Warm caches and branch predictors before timing
+    body();
+
+    long runs = 0;
+    auto start = clock::now();
+    double elapsed;
+    do
+    {
+        body();
+        runs++;
+        elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    } while (elapsed < BENCH_MIN_SECONDS);
+
+    double nsPerItem = elapsed * 1e9 / ((double)runs * items);
+    printf("  %-40s %10.3f ns/item\n", name, nsPerItem);
+    return nsPerItem;
+}
+
+// Times a scalar and an optimised implementation of the same operation
+template <typename A, typename B>
+void BenchCompare(const char *name, long items, A scalar, B optimised)
+{
+    printf("%s (%ld items)\n", name, items);
+    double base = BenchRun("scalar", items, scalar);
+    double fast = BenchRun("simd", items, optimised);
+    printf("  %-40s %10.2fx\n", "speedup", base / fast);
+}
@@ -0,0 +1,230 @@
+#include "game.h"
+
+#include <math.h>
+
+#include "../game/renderer/shader.h"
+#include "../game/renderer/static-batch.h"
+#include "../game/renderer/gpu-culling.h"
+#include "../game/renderer/gpu-timer.h"
+#include "../game/renderer/render-graph.h"
+#include "../game/renderer/uniform-ring.h"
+#include "../game/renderer/uniforms.h"
+
+// Draws a GRID_SIZE x GRID_SIZE field of cubes from a camera turning on
+// the spot inside a ring of walls, which hide everything outside it but
+// what shows through the gaps. Cycles every FRAMES_PER_MODE frames between
+// drawing the whole StaticMeshBatch, culling it against the frustum, and
+// culling it against the frustum and the Hi-Z pyramid of the previous
+// frame's depth. Logs how many cubes each mode draws, the GPU time of
+// culling and drawing them, and of building the pyramid.
+
+#define GRID_SIZE 128
+#define WALL_COUNT 24
+#define WALL_RADIUS 6.0f
+#define MAX_DRAWS (GRID_SIZE * GRID_SIZE + WALL_COUNT)
+#define FRAMES_PER_MODE 300
+
+#define CAMERA_FOV 1.0f
+#define CAMERA_NEAR 0.1f
+#define CAMERA_FAR 200.0f
+#define CAMERA_TURN_SPEED 0.3f // radians per second
+
+enum BenchMode
+{
+    MODE_NO_CULLING,
+    MODE_FRUSTUM,
+    MODE_OCCLUSION,
+    MODE_COUNT
+};
+
+static const char *modeNames[MODE_COUNT] = { "none", "frustum", "occlusion" };
+
+class CullingBench : public Game
+{
+private:
+    OpenGL *gl;
+    GpuResources *resources;
+    UniformRing *uniforms;
+    RenderGraph *graph;
+    Shader *batchShader;
+    StaticMeshBatch *batch;
+    GpuCuller *culler;
+    HiZPyramid *hiz;
+    GpuTimer *timer;
+
+    BenchMode mode = MODE_NO_CULLING;
+    int frame = 0;
+    float angle = 0.0f;
+    double frameTime = 0.0;
+
+public:
+    CullingBench(OpenGL *gl)
+    {
+        this->gl = gl;
+    }
+
+    void Setup()
+    {
+        resources = new GpuResources(gl);
+        uniforms = new UniformRing(platform, gl, 16 * 1024);
+        graph = new RenderGraph(platform, gl, resources);
+        batchShader = new Shader(platform, gl, resources,
+                                 platform->ReadFileToString("/share/tonic/shaders/batch.vert"),
+                                 platform->ReadFileToString("/share/tonic/shaders/basic.frag"));
+        batch = new StaticMeshBatch(platform, gl, MAX_DRAWS);
+        culler = new GpuCuller(platform, gl, resources, MAX_DRAWS);
+        hiz = new HiZPyramid(platform, gl, resources);
+        timer = new GpuTimer(gl, resources, nullptr);
+
+        // A unit cube, shaded darker towards the bottom
+        float vertices[8 * 6];
+        for (int i = 0; i < 8; i++)
+        {
+            float *vertex = vertices + i * 6;
+            vertex[0] = (i & 1) ? 0.5f : -0.5f;
+            vertex[1] = (i & 2) ? 0.5f : -0.5f;
+            vertex[2] = (i & 4) ? 0.5f : -0.5f;
+            vertex[3] = vertex[4] = vertex[5] = (i & 2) ? 1.0f : 0.4f;
+        }
+        unsigned int indices[] = {
+            0, 2, 1, 1, 2, 3,  4, 5, 6, 5, 7, 6,  // -z, +z
+            0, 1, 4, 1, 5, 4,  2, 6, 3, 3, 6, 7,  // -y, +y
+            0, 4, 2, 2, 4, 6,  1, 3, 5, 3, 7, 5   // -x, +x
+        };
+        unsigned int cube = batch->addMesh(vertices, 8, indices, 36);
+        batch->build();
+
+        for (int z = 0; z < GRID_SIZE; z++)
+        {
+            for (int x = 0; x < GRID_SIZE; x++)
+            {
+                DrawData draw;
+                draw.transform = mat4::translate(vec3(x - GRID_SIZE / 2 + 0.5f, 0.25f, z - GRID_SIZE / 2 + 0.5f)) *
+                                 mat4::scale(vec3(0.5f));
+                draw.color = vec4((float)x / GRID_SIZE, 0.5f, (float)z / GRID_SIZE, 1.0f);
+                batch->addDraw(cube, draw);
+            }
+        }
+
+        // Segments of the ring, a little narrower than their share of it.
+        // They are tall enough that from the camera nothing shows over them.
+        for (int i = 0; i < WALL_COUNT; i++)
+        {
+            float wallAngle = i * 6.2831853f / WALL_COUNT;
+            float width = 0.8f * 6.2831853f * WALL_RADIUS / WALL_COUNT;
+
+            DrawData draw;
+            draw.transform = mat4::translate(vec3(sinf(wallAngle) * WALL_RADIUS, 4.0f, cosf(wallAngle) * WALL_RADIUS)) *
+                             mat4::rotate(wallAngle, vec3(0.0f, 1.0f, 0.0f)) *
+                             mat4::scale(vec3(width, 8.0f, 0.2f));
+            draw.color = vec4(0.6f, 0.6f, 0.6f, 1.0f);
+            batch->addDraw(cube, draw);
+        }
+
+        platform->Log("Culling benchmark: %d cubes and %d walls, %d frames per mode, %s\n",
+                      GRID_SIZE * GRID_SIZE, WALL_COUNT, FRAMES_PER_MODE,
+                      culler->hasIndirectCount() ? "indirect count" : "no indirect count");
+    }
+
+    void Frame(float deltaTime)
+    {
+        timer->beginFrame();
+        uniforms->beginFrame();
+
+        int width, height;
+        platform->GetWindowSize(&width, &height);
+
+        angle += CAMERA_TURN_SPEED * deltaTime;
+
+        CameraUniforms camera;
+        vec3 eye = vec3(0.0f, 1.0f, 0.0f);
+        vec3 forward = vec3(sinf(angle), -0.05f, cosf(angle));
+        camera.view = mat4::lookAt(eye, eye + forward, vec3(0.0f, 1.0f, 0.0f));
+        camera.projection = mat4::perspective(CAMERA_FOV, (float)width / height, CAMERA_NEAR, CAMERA_FAR);
+        camera.viewProjection = camera.projection * camera.view;
+        camera.position = vec4(eye, 1.0f);
+        uniforms->bind(UNIFORM_BINDING_CAMERA, uniforms->push(camera));
+
+        // The pyramid is a frame old. At the first frame of the mode it is
+        // older still, but that frame is not counted.
+        bool occlusion = mode == MODE_OCCLUSION && hiz->levels > 0;
+
+        graph->reset();
+        RenderResource backbuffer = graph->importBackbuffer("backbuffer", width, height);
+        RenderResource color, depth;
+
+        graph->addPass("scene",
+            [&](RenderPassBuilder &builder) {
+                color = builder.write(builder.create("scene color", RenderTargetDesc{ width, height, RENDER_FORMAT_RGBA8 }), RENDER_LOAD_CLEAR);
+                depth = builder.write(builder.create("scene depth", RenderTargetDesc{ width, height, RENDER_FORMAT_DEPTH32F }), RENDER_LOAD_CLEAR);
+                builder.setClearColor(vec4(0.0f, 0.0f, 0.0f, 1.0f));
+            },
+            [&](RenderPassContext &) {
+                glEnable(GL_DEPTH_TEST);
+
+                GpuScope scope(timer, "draw");
+                if (mode == MODE_NO_CULLING)
+                {
+                    gl->glUseProgram(batchShader->shaderId);
+                    batch->draw();
+                }
+                else
+                {
+                    culler->draw(batch, batchShader, camera.viewProjection, occlusion ? hiz : nullptr);
+                }
+            });
+
+        // Built every frame whatever the mode, so its cost is always there
+        // to compare against what it saves
+        graph->addPass("hi-z",
+            [&](RenderPassBuilder &builder) {
+                builder.read(depth);
+                builder.setSideEffect();
+            },
+            [&](RenderPassContext &context) {
+                GpuScope scope(timer, "hi-z");
+                hiz->build(context.getTexture(depth), width, height);
+            });
+
+        graph->addPass("present",
+            [&](RenderPassBuilder &builder) {
+                builder.read(color);
+                builder.write(backbuffer, RENDER_LOAD_ANY);
+            },
+            [&](RenderPassContext &context) {
+                context.blit(color);
+            });
+
+        graph->execute();
+
+        uniforms->endFrame();
+        resources->endFrame();
+
+        // The first frame of each mode carries the previous mode's swap, so skip it
+        if (frame > 0)
+            frameTime += deltaTime * 1000.0;
+
+        if (++frame == FRAMES_PER_MODE)
+        {
+            // Reading the count stalls, so only once per mode
+            int drawn = mode == MODE_NO_CULLING ? batch->getDrawCount() : culler->readVisibleCount();
+
+            const ProfileStat *draw = timer->get("draw");
+            const ProfileStat *build = timer->get("hi-z");
+            float drawMs = draw ? draw->average : 0.0f;
+            float buildMs = build ? build->average : 0.0f;
+
+            platform->Log("%-10s %6d of %6d drawn   cull and draw %8.3f ms   hi-z %8.3f ms   frame %8.3f ms\n",
+                          modeNames[mode], drawn, batch->getDrawCount(), drawMs, buildMs, frameTime / (FRAMES_PER_MODE - 1));
+
+            mode = (BenchMode)((mode + 1) % MODE_COUNT);
+            frame = 0;
+            frameTime = 0.0;
+        }
+    }
+};
+
+Game *Initialize(OpenGL *gl)
+{
+    return new CullingBench(gl);
+}
@@ -0,0 +1,149 @@
+#include "bench.h"
+
+#include "ecs/world.h"
+#include "ecs/command-buffer.h"
+
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+// Integrates positions for a million entities per frame through an ECS
+// query, single threaded and in parallel, against the usual object model
+// of heap-allocated objects with a virtual update. Also times a frame's
+// worth of structural changes through a command buffer.
+
+#define NUM_ENTITIES 1000000
+#define NUM_CHANGES 10000
+
+struct Position
+{
+    float x, y, z;
+};
+
+struct Velocity
+{
+    float x, y, z;
+};
+
+// Only on some entities, so the query spans several archetypes
+struct Health
+{
+    float value;
+};
+
+struct Frozen
+{
+};
+
+class GameObject
+{
+public:
+    Position position;
+    Velocity velocity;
+
+    virtual ~GameObject() {}
+    virtual void update(float dt)
+    {
+        position.x += velocity.x * dt;
+        position.y += velocity.y * dt;
+        position.z += velocity.z * dt;
+    }
+};
+
+class DamageableObject : public GameObject
+{
+public:
+    float health = 100.0f;
+};
+
+static float Random(float min, float max)
+{
+    return min + (max - min) * (rand() / (float)RAND_MAX);
+}
+
+int main()
+{
+    const float dt = 1.0f / 60.0f;
+
+    World world;
+    std::vector<Entity> entities(NUM_ENTITIES);
+    std::vector<GameObject *> objects(NUM_ENTITIES);
+
+    for (int i = 0; i < NUM_ENTITIES; i++)
+    {
+        Position position = {Random(-100.0f, 100.0f), Random(-100.0f, 100.0f), Random(-100.0f, 100.0f)};
+        Velocity velocity = {Random(-1.0f, 1.0f), Random(-1.0f, 1.0f), Random(-1.0f, 1.0f)};
+
+        if (i % 4 == 0)
+        {
+            entities[i] = world.create(position, velocity, Health{100.0f});
+            objects[i] = new DamageableObject();
+        }
+        else
+        {
+            entities[i] = world.create(position, velocity);
+            objects[i] = new GameObject();
+        }
+        objects[i]->position = position;
+        objects[i]->velocity = velocity;
+    }
+
+    // Objects allocated over a long session end up scattered in memory
+    for (int i = NUM_ENTITIES - 1; i > 0; i--)
+        std::swap(objects[i], objects[rand() % (i + 1)]);
+
+    unsigned int cores = std::thread::hardware_concurrency();
+    printf("ecs benchmark, %d entities, %u hardware threads\n", NUM_ENTITIES, cores);
+
+    Query<Position, const Velocity> movement = world.query<Position, const Velocity>();
+
+    BenchRun("objects, virtual update", NUM_ENTITIES, [&] {
+        for (GameObject *object : objects)
+            object->update(dt);
+        BenchKeep(objects[0]->position);
+    });
+
+    BenchRun("query, forEach", NUM_ENTITIES, [&] {
+        movement.forEach([dt](Position &position, const Velocity &velocity) {
+            position.x += velocity.x * dt;
+            position.y += velocity.y * dt;
+            position.z += velocity.z * dt;
+        });
+        BenchKeep(*world.get<Position>(entities[0]));
+    });
+
+    BenchRun("query, parallelForEach", NUM_ENTITIES, [&] {
+        movement.parallelForEach([dt](int, Position &position, const Velocity &velocity) {
+            position.x += velocity.x * dt;
+            position.y += velocity.y * dt;
+            position.z += velocity.z * dt;
+        });
+        BenchKeep(*world.get<Position>(entities[0]));
+    });
+
+    // Freeze and thaw a batch of entities from inside queries, as a game
+    // system would; each change moves an entity between archetypes
+    CommandBuffer commands;
+    Query<const Health> thawed = world.query<const Health>();
+    thawed.without<Frozen>();
+    Query<const Frozen> frozen = world.query<const Frozen>();
+
+    BenchRun("command buffer, add and remove", 2 * NUM_CHANGES, [&] {
+        int recorded = 0;
+        thawed.forEachEntity([&](Entity entity, const Health &) {
+            if (recorded++ < NUM_CHANGES)
+                commands.add(entity, Frozen{});
+        });
+        commands.apply(&world);
+
+        frozen.forEachEntity([&](Entity entity, const Frozen &) {
+            commands.remove<Frozen>(entity);
+        });
+        commands.apply(&world);
+    });
+
+    for (GameObject *object : objects)
+        delete object;
+
+    return 0;
+}
@@ -0,0 +1,194 @@
+#include "game.h"
+
+#include <chrono>
+#include <math.h>
+
+#include "../game/renderer/shader.h"
+#include "../game/renderer/mesh.h"
+#include "../game/renderer/instancing.h"
+#include "../game/renderer/static-batch.h"
+#include "../game/renderer/uniform-ring.h"
+#include "../game/renderer/uniforms.h"
+
+// Draws NUM_OBJECTS small triangles, cycling every FRAMES_PER_MODE frames
+// between a single instanced draw, one draw call per object with its
+// constants set through glUniform*, one draw call per object with its
+// constants in the uniform ring, and a StaticMeshBatch multi-draw with
+// one indirect command per object. Logs the average CPU submission time
+// and frame time of each mode.
+
+#define NUM_OBJECTS 100000
+#define FRAMES_PER_MODE 240
+
+enum BenchMode
+{
+    MODE_INSTANCED,
+    MODE_PER_OBJECT,
+    MODE_UNIFORM_RING,
+    MODE_BATCHED,
+    MODE_COUNT
+};
+
+static const char *modeNames[MODE_COUNT] = { "instanced", "per-object", "ring", "batched" };
+
+class InstancingBench : public Game
+{
+private:
+    OpenGL *gl;
+    GpuResources *resources;
+    Shader *instancedShader;
+    Shader *objectShader;
+    Shader *drawShader;
+    Shader *batchShader;
+    int transformLocation, tintLocation;
+    Mesh *triangle;
+    InstanceRenderer *instancer;
+    InstanceData *instances;
+    StaticMeshBatch *batch;
+    UniformRing *uniforms;
+
+    BenchMode mode = MODE_INSTANCED;
+    int frame = 0;
+    double submitTime = 0.0;
+    double frameTime = 0.0;
+
+public:
+    InstancingBench(OpenGL *gl)
+    {
+        this->gl = gl;
+    }
+
+    void Setup()
+    {
+        std::string instancedVert = platform->ReadFileToString("/share/tonic/shaders/instanced.vert");
+        std::string objectVert = platform->ReadFileToString("/share/tonic/shaders/object.vert");
+        std::string frag = platform->ReadFileToString("/share/tonic/shaders/basic.frag");
+
+        resources = new GpuResources(gl);
+        instancedShader = new Shader(platform, gl, resources, instancedVert, frag);
+        objectShader = new Shader(platform, gl, resources, objectVert, frag);
+        drawShader = new Shader(platform, gl, resources, platform->ReadFileToString("/share/tonic/shaders/draw.vert"), frag);
+        batchShader = new Shader(platform, gl, resources, platform->ReadFileToString("/share/tonic/shaders/batch.vert"), frag);
+
+        // Look these up once; the per-object path should only pay for the draws
+        transformLocation = objectShader->getUniformLocation("transform");
+        tintLocation = objectShader->getUniformLocation("tint");
+
+        float vertices[] = {
+            0.5f, -0.5f, 0.0f,  1.0f, 0.0f, 0.0f,
+            -0.5f, -0.5f, 0.0f,  0.0f, 1.0f, 0.0f,
+            0.0f,  0.5f, 0.0f,  0.0f, 0.0f, 1.0f
+        };
+
+        triangle = new Mesh(gl, vertices, 3);
+        instancer = new InstanceRenderer(gl, NUM_OBJECTS);
+
+        // Room for every object's DrawUniforms, each padded to the offset
+        // alignment, plus the camera
+        uniforms = new UniformRing(platform, gl, (NUM_OBJECTS + 1) * 256);
+
+        // Spread the objects over a square grid covering the viewport
+        int side = (int)ceilf(sqrtf((float)NUM_OBJECTS));
+        float cell = 2.0f / side;
+
+        instances = new InstanceData[NUM_OBJECTS];
+        for (int i = 0; i < NUM_OBJECTS; i++)
+        {
+            InstanceData &instance = instances[i];
+            float x = -1.0f + cell * (i % side + 0.5f);
+            float y = -1.0f + cell * (i / side + 0.5f);
+
+            instance.transform = mat4::translate(vec3(x, y, 0.0f)) * mat4::scale(vec3(cell, cell, 1.0f));
+            instance.color = vec4((float)(i % side) / side, (float)(i / side) / side, 1.0f, 1.0f);
+        }
+
+        // The same triangle once in the batch, and one draw per object
+        unsigned int indices[] = { 0, 1, 2 };
+        batch = new StaticMeshBatch(platform, gl, NUM_OBJECTS);
+        unsigned int mesh = batch->addMesh(vertices, 3, indices, 3);
+        batch->build();
+        for (int i = 0; i < NUM_OBJECTS; i++)
+            batch->addDraw(mesh, DrawData{ instances[i].transform, instances[i].color });
+
+        platform->Log("Instancing benchmark: %d objects, %d frames per mode\n", NUM_OBJECTS, FRAMES_PER_MODE);
+    }
+
+    void Frame(float deltaTime)
+    {
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        auto start = std::chrono::steady_clock::now();
+
+        uniforms->beginFrame();
+
+        CameraUniforms camera;
+        camera.view = mat4();
+        camera.projection = mat4();
+        camera.viewProjection = mat4();
+        camera.position = vec4(0.0f);
+        uniforms->bind(UNIFORM_BINDING_CAMERA, uniforms->push(camera));
+
+        if (mode == MODE_INSTANCED)
+        {
+            gl->glUseProgram(instancedShader->shaderId);
+            instancer->draw(triangle, instances, NUM_OBJECTS);
+        }
+        else if (mode == MODE_PER_OBJECT)
+        {
+            gl->glUseProgram(objectShader->shaderId);
+            for (int i = 0; i < NUM_OBJECTS; i++)
+            {
+                const vec4 &color = instances[i].color;
+                gl->glUniformMatrix4fv(transformLocation, 1, GL_FALSE, instances[i].transform.data());
+                gl->glUniform4f(tintLocation, color.x, color.y, color.z, color.w);
+                triangle->draw();
+            }
+        }
+        else if (mode == MODE_UNIFORM_RING)
+        {
+            gl->glUseProgram(drawShader->shaderId);
+            for (int i = 0; i < NUM_OBJECTS; i++)
+            {
+                DrawUniforms draw;
+                draw.transform = instances[i].transform;
+                draw.color = instances[i].color;
+                uniforms->bind(UNIFORM_BINDING_DRAW, uniforms->push(draw));
+                triangle->draw();
+            }
+        }
+        else
+        {
+            gl->glUseProgram(batchShader->shaderId);
+            batch->draw();
+        }
+
+        uniforms->endFrame();
+
+        auto end = std::chrono::steady_clock::now();
+
+        // The first frame of each mode carries the previous mode's swap, so skip it
+        if (frame > 0)
+        {
+            submitTime += std::chrono::duration<double, std::milli>(end - start).count();
+            frameTime += deltaTime * 1000.0;
+        }
+
+        if (++frame == FRAMES_PER_MODE)
+        {
+            int samples = FRAMES_PER_MODE - 1;
+            platform->Log("%-10s submit %8.3f ms   frame %8.3f ms\n",
+                          modeNames[mode], submitTime / samples, frameTime / samples);
+
+            mode = (BenchMode)((mode + 1) % MODE_COUNT);
+            frame = 0;
+            submitTime = 0.0;
+            frameTime = 0.0;
+        }
+    }
+};
+
+Game *Initialize(OpenGL *gl)
+{
+    return new InstancingBench(gl);
+}
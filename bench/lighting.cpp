@@ -0,0 +1,170 @@
+#include "game.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "../game/renderer/shader.h"
+#include "../game/renderer/mesh-asset.h"
+#include "../game/renderer/clustered-lighting.h"
+#include "../game/renderer/gpu-timer.h"
+#include "../game/renderer/uniform-ring.h"
+#include "../game/renderer/uniforms.h"
+
+// Draws a GRID_SIZE x GRID_SIZE field of tori lit by a growing number of
+// point lights scattered over it, cycling every FRAMES_PER_MODE frames
+// through lightCounts. Logs the GPU time of binning the lights into
+// clusters and of the lit draws for each count, so the cost of a light
+// can be read off as the count grows.
+
+#define GRID_SIZE 12
+#define FRAMES_PER_MODE 240
+
+#define CAMERA_FOV 1.0f
+#define CAMERA_NEAR 0.1f
+#define CAMERA_FAR 100.0f
+
+static const int lightCounts[] = { 0, 256, 1024, 4096, 16384 };
+#define MODE_COUNT (int)(sizeof(lightCounts) / sizeof(lightCounts[0]))
+#define MAX_LIGHTS 16384
+
+static float Random(float low, float high)
+{
+    return low + (high - low) * (float)rand() / RAND_MAX;
+}
+
+class LightingBench : public Game
+{
+private:
+    OpenGL *gl;
+    GpuResources *resources;
+    Shader *litShader;
+    MeshAsset *torus;
+    UniformRing *uniforms;
+    ClusteredLighting *lighting;
+    GpuTimer *timer;
+    Light *lights;
+
+    int mode = 0;
+    int frame = 0;
+    double frameTime = 0.0;
+
+public:
+    LightingBench(OpenGL *gl)
+    {
+        this->gl = gl;
+    }
+
+    void Setup()
+    {
+        resources = new GpuResources(gl);
+        litShader = new Shader(platform, gl, resources,
+                               platform->ReadFileToString("/share/tonic/shaders/model.vert"),
+                               platform->ReadFileToString("/share/tonic/shaders/lit.frag"));
+        torus = new MeshAsset(platform, gl, resources, "/share/tonic/models/torus.tmesh");
+        uniforms = new UniformRing(platform, gl, (GRID_SIZE * GRID_SIZE + 4) * 256);
+        lighting = new ClusteredLighting(platform, gl, resources, MAX_LIGHTS);
+        timer = new GpuTimer(gl, resources, nullptr);
+
+        // Small lights spread over the field and a little above it, so
+        // each pixel is touched by a handful however many there are
+        srand(1);
+        lights = new Light[MAX_LIGHTS];
+        for (int i = 0; i < MAX_LIGHTS; i++)
+        {
+            Light &light = lights[i];
+            light.position = vec3(Random(-GRID_SIZE, GRID_SIZE), Random(-0.5f, 1.5f), Random(-GRID_SIZE, GRID_SIZE));
+            light.range = Random(0.5f, 1.5f);
+            light.color = vec3(Random(0.2f, 1.0f), Random(0.2f, 1.0f), Random(0.2f, 1.0f));
+            light.intensity = 1.0f;
+        }
+
+        platform->Log("Lighting benchmark: %d tori, %dx%dx%d clusters, %d frames per light count\n",
+                      GRID_SIZE * GRID_SIZE, CLUSTER_X, CLUSTER_Y, CLUSTER_Z, FRAMES_PER_MODE);
+    }
+
+    void Frame(float deltaTime)
+    {
+        timer->beginFrame();
+
+        glEnable(GL_DEPTH_TEST);
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        uniforms->beginFrame();
+
+        int width, height;
+        platform->GetWindowSize(&width, &height);
+
+        FrameUniforms frameUniforms;
+        frameUniforms.time = 0.0f;
+        frameUniforms.deltaTime = deltaTime;
+        frameUniforms.resolution = vec2((float)width, (float)height);
+        uniforms->bind(UNIFORM_BINDING_FRAME, uniforms->push(frameUniforms));
+
+        CameraUniforms camera;
+        vec3 eye = vec3(0.0f, 6.0f, GRID_SIZE * 1.2f);
+        camera.view = mat4::lookAt(eye, vec3(0.0f, 0.0f, -2.0f), vec3(0.0f, 1.0f, 0.0f));
+        camera.projection = mat4::perspective(CAMERA_FOV, (float)width / height, CAMERA_NEAR, CAMERA_FAR);
+        camera.viewProjection = camera.projection * camera.view;
+        camera.position = vec4(eye, 1.0f);
+        uniforms->bind(UNIFORM_BINDING_CAMERA, uniforms->push(camera));
+
+        // The sun lit.frag expects, without shadows
+        DirectionalLightUniforms sun = {};
+        sun.direction = vec4(normalize(vec3(0.3f, 0.8f, 0.5f)), 0.0f);
+        sun.color = vec4(0.8f, 0.8f, 0.8f, 0.0f);
+        uniforms->bind(UNIFORM_BINDING_DIRECTIONAL_LIGHT, uniforms->push(sun));
+
+        lighting->clear();
+        for (int i = 0; i < lightCounts[mode]; i++)
+            lighting->add(lights[i]);
+
+        timer->begin("light culling");
+        lighting->update(uniforms, camera.view, CAMERA_FOV, (float)width / height, CAMERA_NEAR, CAMERA_FAR);
+        timer->end("light culling");
+
+        timer->begin("shading");
+        gl->glUseProgram(litShader->shaderId);
+        for (int z = 0; z < GRID_SIZE && torus->isLoaded(); z++)
+        {
+            for (int x = 0; x < GRID_SIZE; x++)
+            {
+                DrawUniforms draw;
+                draw.transform = mat4::translate(vec3(2.0f * x - GRID_SIZE + 1.0f, 0.0f, 2.0f * z - GRID_SIZE + 1.0f)) *
+                                 mat4::rotate(1.5707963f, vec3(1.0f, 0.0f, 0.0f)) * torus->getDequantizeMatrix();
+                draw.color = vec4(0.8f, 0.8f, 0.8f, 1.0f);
+                uniforms->bind(UNIFORM_BINDING_DRAW, uniforms->push(draw));
+                torus->draw();
+            }
+        }
+        timer->end("shading");
+
+        uniforms->endFrame();
+
+        // The first frame of each mode carries the previous mode's swap, so skip it
+        if (frame > 0)
+            frameTime += deltaTime * 1000.0;
+
+        if (++frame == FRAMES_PER_MODE)
+        {
+            // GPU times are averaged as they arrive, so by now they are
+            // this light count's alone
+            const ProfileStat *cull = timer->get("light culling");
+            const ProfileStat *shade = timer->get("shading");
+            float cullMs = cull ? cull->average : 0.0f;
+            float shadeMs = shade ? shade->average : 0.0f;
+
+            platform->Log("%6d lights   culling %8.3f ms   shading %8.3f ms   frame %8.3f ms\n",
+                          lightCounts[mode], cullMs, shadeMs, frameTime / (FRAMES_PER_MODE - 1));
+
+            mode = (mode + 1) % MODE_COUNT;
+            frame = 0;
+            frameTime = 0.0;
+        }
+    }
+};
+
+Game *Initialize(OpenGL *gl)
+{
+    return new LightingBench(gl);
+}
@@ -0,0 +1,87 @@
+#include "bench.h"
+
+#include "math/mat.h"
+#include "math/geometry.h"
+#include "math/batch.h"
+#include "math/simd.h"
+
+#include <stdlib.h>
+#include <vector>
+
+// Compares the SIMD paths of the math module against their scalar
+// reference implementations
+
+#define NUM_MATRICES 4096
+#define NUM_POINTS 100000
+
+static float Random(float min, float max)
+{
+    return min + (max - min) * (rand() / (float)RAND_MAX);
+}
+
+int main()
+{
+    printf("math benchmark (AVX2 %s)\n\n", CpuHasAVX2() ? "available" : "unavailable");
+
+    std::vector<mat4> a(NUM_MATRICES), b(NUM_MATRICES), out(NUM_MATRICES);
+    for (int i = 0; i < NUM_MATRICES; i++)
+    {
+        for (int j = 0; j < 16; j++)
+        {
+            a[i].data()[j] = Random(-1.0f, 1.0f);
+            b[i].data()[j] = Random(-1.0f, 1.0f);
+        }
+    }
+
+    BenchCompare("mat4 multiply", NUM_MATRICES,
+        [&] { for (int i = 0; i < NUM_MATRICES; i++) out[i] = mulScalar(a[i], b[i]); BenchKeep(out[0]); },
+        [&] { for (int i = 0; i < NUM_MATRICES; i++) out[i] = a[i] * b[i]; BenchKeep(out[0]); });
+
+    BenchCompare("mat4 multiply (batch)", NUM_MATRICES,
+        [&] { for (int i = 0; i < NUM_MATRICES; i++) out[i] = mulScalar(a[i], b[i]); BenchKeep(out[0]); },
+        [&] { mulBatch(a.data(), b.data(), out.data(), NUM_MATRICES); BenchKeep(out[0]); });
+
+    BenchCompare("mat4 inverse", NUM_MATRICES,
+        [&] { for (int i = 0; i < NUM_MATRICES; i++) out[i] = inverseScalar(a[i]); BenchKeep(out[0]); },
+        [&] { for (int i = 0; i < NUM_MATRICES; i++) out[i] = inverse(a[i]); BenchKeep(out[0]); });
+
+    BenchCompare("frustum extraction", NUM_MATRICES,
+        [&] { for (int i = 0; i < NUM_MATRICES; i++) { Frustum f = extractFrustumScalar(a[i]); BenchKeep(f); } },
+        [&] { for (int i = 0; i < NUM_MATRICES; i++) { Frustum f = extractFrustum(a[i]); BenchKeep(f); } });
+
+    std::vector<vec3> points(NUM_POINTS), transformed(NUM_POINTS);
+    std::vector<float> x(NUM_POINTS), y(NUM_POINTS), z(NUM_POINTS), radius(NUM_POINTS);
+    std::vector<float> ox(NUM_POINTS), oy(NUM_POINTS), oz(NUM_POINTS);
+    for (int i = 0; i < NUM_POINTS; i++)
+    {
+        points[i] = vec3(Random(-50.0f, 50.0f), Random(-50.0f, 50.0f), Random(-50.0f, 50.0f));
+        x[i] = points[i].x;
+        y[i] = points[i].y;
+        z[i] = points[i].z;
+        radius[i] = Random(0.1f, 2.0f);
+    }
+
+    mat4 m = mat4::rotate(0.7f, vec3(1.0f, 1.0f, 0.0f)) * mat4::translate(vec3(1.0f, 2.0f, 3.0f));
+    SoAVec3 in = { x.data(), y.data(), z.data() };
+    SoAVec3 outSoA = { ox.data(), oy.data(), oz.data() };
+
+    BenchCompare("transform points (AoS)", NUM_POINTS,
+        [&] { transformPointsScalar(m, points.data(), transformed.data(), NUM_POINTS); BenchKeep(transformed[0]); },
+        [&] { transformPoints(m, points.data(), transformed.data(), NUM_POINTS); BenchKeep(transformed[0]); });
+
+    BenchCompare("transform points (SoA)", NUM_POINTS,
+        [&] { transformPointsSoAScalar(m, in, outSoA, NUM_POINTS); BenchKeep(ox[0]); },
+        [&] { transformPointsSoA(m, in, outSoA, NUM_POINTS); BenchKeep(ox[0]); });
+
+    mat4 viewProj = mat4::perspective(1.0f, 16.0f / 9.0f, 0.1f, 100.0f) *
+                    mat4::lookAt(vec3(0.0f, 0.0f, 60.0f), vec3(0.0f), vec3(0.0f, 1.0f, 0.0f));
+    Frustum frustum = extractFrustum(viewProj);
+    SoASpheres spheres = { x.data(), y.data(), z.data(), radius.data() };
+    std::vector<unsigned char> visible(NUM_POINTS);
+
+    BenchCompare("frustum cull spheres (SoA)", NUM_POINTS,
+        [&] { int n = cullSpheresSoAScalar(frustum, spheres, visible.data(), NUM_POINTS); BenchKeep(n); },
+        [&] { int n = cullSpheresSoA(frustum, spheres, visible.data(), NUM_POINTS); BenchKeep(n); });
+
+    return 0;
+}
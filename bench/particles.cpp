@@ -0,0 +1,129 @@
+#include "game.h"
+
+#include "../game/renderer/particles.h"
+#include "../game/renderer/gpu-timer.h"
+#include "../game/renderer/uniform-ring.h"
+#include "../game/renderer/uniforms.h"
+
+// Keeps a growing number of particles alive, cycling every
+// FRAMES_PER_MODE frames through particleCounts. Each count is held
+// steady by emitting it once per PARTICLE_LIFETIME seconds. Logs the GPU
+// time of the compute passes and of drawing the particles for each
+// count, so the cost per particle can be read off up to a million.
+
+#define FRAMES_PER_MODE 300
+#define PARTICLE_LIFETIME 2.0f
+
+#define CAMERA_FOV 1.0f
+
+static const int particleCounts[] = { 16384, 131072, 524288, 1048576 };
+#define MODE_COUNT (int)(sizeof(particleCounts) / sizeof(particleCounts[0]))
+#define MAX_PARTICLES 1048576
+
+class ParticleBench : public Game
+{
+private:
+    OpenGL *gl;
+    GpuResources *resources;
+    UniformRing *uniforms;
+    ParticleSystem *particles;
+    GpuTimer *timer;
+    ParticleEmitter emitter;
+
+    int mode = 0;
+    int frame = 0;
+    double frameTime = 0.0;
+
+public:
+    ParticleBench(OpenGL *gl)
+    {
+        this->gl = gl;
+    }
+
+    void Setup()
+    {
+        resources = new GpuResources(gl);
+        uniforms = new UniformRing(platform, gl, 16 * 1024);
+        particles = new ParticleSystem(platform, gl, resources, MAX_PARTICLES);
+        timer = new GpuTimer(gl, resources, nullptr);
+
+        // A cloud drifting in front of the camera, faint enough that a
+        // million of them do not saturate
+        emitter.radius = 2.0f;
+        emitter.velocity = vec3(0.0f);
+        emitter.spread = 0.5f;
+        emitter.color = vec4(0.4f, 0.7f, 1.0f, 0.02f);
+        emitter.minLifetime = PARTICLE_LIFETIME;
+        emitter.maxLifetime = PARTICLE_LIFETIME;
+        particles->gravity = vec3(0.0f);
+
+        platform->Log("Particle benchmark: room for %d particles, %d frames per count\n", MAX_PARTICLES, FRAMES_PER_MODE);
+    }
+
+    void Frame(float deltaTime)
+    {
+        timer->beginFrame();
+
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        uniforms->beginFrame();
+
+        int width, height;
+        platform->GetWindowSize(&width, &height);
+
+        FrameUniforms frameUniforms;
+        frameUniforms.time = 0.0f;
+        frameUniforms.deltaTime = deltaTime;
+        frameUniforms.resolution = vec2((float)width, (float)height);
+        uniforms->bind(UNIFORM_BINDING_FRAME, uniforms->push(frameUniforms));
+
+        CameraUniforms camera;
+        vec3 eye = vec3(0.0f, 0.0f, 6.0f);
+        camera.view = mat4::lookAt(eye, vec3(0.0f), vec3(0.0f, 1.0f, 0.0f));
+        camera.projection = mat4::perspective(CAMERA_FOV, (float)width / height, 0.1f, 100.0f);
+        camera.viewProjection = camera.projection * camera.view;
+        camera.position = vec4(eye, 1.0f);
+        uniforms->bind(UNIFORM_BINDING_CAMERA, uniforms->push(camera));
+
+        emitter.rate = particleCounts[mode] / PARTICLE_LIFETIME;
+
+        timer->begin("simulation");
+        particles->emit(emitter, deltaTime);
+        particles->update(uniforms, deltaTime);
+        timer->end("simulation");
+
+        timer->begin("drawing");
+        particles->draw();
+        timer->end("drawing");
+
+        uniforms->endFrame();
+        resources->endFrame();
+
+        // The first frame of each mode carries the previous mode's swap, so skip it
+        if (frame > 0)
+            frameTime += deltaTime * 1000.0;
+
+        if (++frame == FRAMES_PER_MODE)
+        {
+            // The count has had a full lifetime to settle by now, and GPU
+            // times are averaged as they arrive
+            const ProfileStat *simulate = timer->get("simulation");
+            const ProfileStat *draw = timer->get("drawing");
+            float simulateMs = simulate ? simulate->average : 0.0f;
+            float drawMs = draw ? draw->average : 0.0f;
+
+            platform->Log("%8d particles   simulation %8.3f ms   drawing %8.3f ms   frame %8.3f ms\n",
+                          particleCounts[mode], simulateMs, drawMs, frameTime / (FRAMES_PER_MODE - 1));
+
+            mode = (mode + 1) % MODE_COUNT;
+            frame = 0;
+            frameTime = 0.0;
+        }
+    }
+};
+
+Game *Initialize(OpenGL *gl)
+{
+    return new ParticleBench(gl);
+}
@@ -0,0 +1,117 @@
+#include "bench.h"
+
+#include "physics/physics-world.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <thread>
+
+// Drops piles of circles, boxes and hexagons into bins along a static
+// ground and steps the world at 60 Hz, once on one thread and once on
+// every core. Static walls keep each pile to itself, so every bin is an
+// island of its own, which is what the solver parallelises over. The
+// piles settle and fall asleep partway through, so the later steps
+// measure how little sleeping bodies cost as much as the awake ones.
+
+#define NUM_PILES 64
+#define PILE_COLUMNS 6
+#define PILE_ROWS 12
+#define PILE_SPACING 10.0f
+#define NUM_STEPS 600
+
+static float Random(float min, float max)
+{
+    return min + (max - min) * (rand() / (float)RAND_MAX);
+}
+
+static void BuildScene(PhysicsWorld &world)
+{
+    srand(1);
+
+    BodyDef ground;
+    ground.type = BODY_STATIC;
+    ground.shape = MakeBox(NUM_PILES * PILE_SPACING * 0.5f + 10.0f, 0.5f);
+    ground.position = vec2(NUM_PILES * PILE_SPACING * 0.5f, -0.5f);
+    world.create(ground);
+
+    // Bin walls, half a unit clear of the outer columns
+    BodyDef wall;
+    wall.type = BODY_STATIC;
+    wall.shape = MakeBox(0.25f, PILE_ROWS * 0.6f);
+    for (int pile = 0; pile < NUM_PILES; pile++)
+    {
+        float left = pile * PILE_SPACING - 1.3f;
+        float right = pile * PILE_SPACING + PILE_COLUMNS * 1.1f + 0.2f;
+        wall.position = vec2(left, PILE_ROWS * 0.6f);
+        world.create(wall);
+        wall.position = vec2(right, PILE_ROWS * 0.6f);
+        world.create(wall);
+    }
+
+    vec2 hexagon[6];
+    for (int i = 0; i < 6; i++)
+        hexagon[i] = vec2(cosf(i * 1.0471976f), sinf(i * 1.0471976f)) * 0.45f;
+
+    for (int pile = 0; pile < NUM_PILES; pile++)
+    {
+        for (int row = 0; row < PILE_ROWS; row++)
+        {
+            for (int column = 0; column < PILE_COLUMNS; column++)
+            {
+                BodyDef body;
+                switch ((pile + row + column) % 3)
+                {
+                case 0:
+                    body.shape = MakeCircle(Random(0.3f, 0.5f));
+                    break;
+                case 1:
+                    body.shape = MakeBox(Random(0.3f, 0.5f), Random(0.3f, 0.5f));
+                    break;
+                default:
+                    body.shape = MakePolygon(hexagon, 6);
+                    break;
+                }
+                body.position = vec2(pile * PILE_SPACING + column * 1.1f + Random(-0.1f, 0.1f), 0.6f + row * 1.1f);
+                body.angle = Random(-0.3f, 0.3f);
+                world.create(body);
+            }
+        }
+    }
+}
+
+static void Run(int threadCount)
+{
+    PhysicsWorld world;
+    world.setThreadCount(threadCount);
+    BuildScene(world);
+
+    int bodies = world.getBodyCount();
+    int maxContacts = 0, maxIslands = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < NUM_STEPS; i++)
+    {
+        world.step(PHYSICS_TIME_STEP);
+        if (world.getContactCount() > maxContacts)
+            maxContacts = world.getContactCount();
+        if (world.getActiveIslandCount() > maxIslands)
+            maxIslands = world.getActiveIslandCount();
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    printf("%d thread(s), %d bodies, %d steps\n", threadCount, bodies, NUM_STEPS);
+    printf("  %-40s %10.3f ms\n", "per step", ms / NUM_STEPS);
+    printf("  %-40s %10.1f\n", "bodies per ms", (double)bodies * NUM_STEPS / ms);
+    printf("  %-40s %10d\n", "peak contacts", maxContacts);
+    printf("  %-40s %10d\n", "peak active islands", maxIslands);
+    printf("  %-40s %10d\n", "awake at the end", world.getAwakeBodyCount());
+}
+
+int main()
+{
+    int cores = (int)std::thread::hardware_concurrency();
+
+    Run(1);
+    if (cores > 1)
+        Run(cores);
+    return 0;
+}
@@ -0,0 +1,217 @@
+#include "bench.h"
+
+#include "spatial/bvh.h"
+#include "spatial/loose-grid.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+
+// Builds, maintains and queries a BVH and a loose grid over boxes spread
+// evenly through a cube, at several object counts. The cube grows with
+// the count so density, and so the work per query, stays comparable.
+// Frustum culling is also timed the brute-force way for reference, and
+// degenerate inserts are checked to keep the tree shallow.
+
+#define NUM_QUERIES 1000
+#define NUM_RAYS 1000
+
+// Objects per unit volume, and their size range
+#define DENSITY 0.05f
+#define MIN_SIZE 0.5f
+#define MAX_SIZE 1.5f
+
+static float Random(float min, float max)
+{
+    return min + (max - min) * (rand() / (float)RAND_MAX);
+}
+
+static AABB RandomBox(float side)
+{
+    vec3 center(Random(0.0f, side), Random(0.0f, side), Random(0.0f, side));
+    vec3 half = vec3(Random(MIN_SIZE, MAX_SIZE), Random(MIN_SIZE, MAX_SIZE), Random(MIN_SIZE, MAX_SIZE)) * 0.5f;
+    return AABB(center - half, center + half);
+}
+
+static AABB Offset(const AABB &box, const vec3 &offset)
+{
+    return AABB(box.min + offset, box.max + offset);
+}
+
+// One-off operations too slow to repeat many times, in milliseconds
+template <typename F>
+static double TimeOnce(F body)
+{
+    auto start = std::chrono::steady_clock::now();
+    body();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void Run(int count)
+{
+    float side = cbrtf(count / DENSITY);
+    std::vector<AABB> boxes(count), moved(count);
+    std::vector<unsigned int> ids(count);
+    for (int i = 0; i < count; i++)
+    {
+        boxes[i] = RandomBox(side);
+        moved[i] = Offset(boxes[i], vec3(Random(-0.05f, 0.05f), Random(-0.05f, 0.05f), Random(-0.05f, 0.05f)));
+        ids[i] = (unsigned int)i;
+    }
+
+    // A camera in the middle of the cube, looking a quarter of the way in
+    vec3 eye(side * 0.5f);
+    mat4 viewProj = mat4::perspective(1.0f, 16.0f / 9.0f, 0.1f, side * 0.25f) *
+                    mat4::lookAt(eye, eye + vec3(0.0f, 0.0f, 1.0f), vec3(0.0f, 1.0f, 0.0f));
+    Frustum frustum = extractFrustum(viewProj);
+
+    std::vector<AABB> queryBoxes(NUM_QUERIES);
+    for (AABB &box : queryBoxes)
+    {
+        vec3 center(Random(0.0f, side), Random(0.0f, side), Random(0.0f, side));
+        box = AABB(center - vec3(2.0f), center + vec3(2.0f));
+    }
+
+    std::vector<vec3> rayOrigins(NUM_RAYS), rayDirections(NUM_RAYS);
+    for (int i = 0; i < NUM_RAYS; i++)
+    {
+        rayOrigins[i] = vec3(Random(0.0f, side), Random(0.0f, side), Random(0.0f, side));
+        rayDirections[i] = normalize(vec3(Random(-1.0f, 1.0f), Random(-1.0f, 1.0f), Random(-1.0f, 1.0f)));
+    }
+
+    printf("%d objects in a %.0f unit cube\n", count, side);
+
+    int visible = 0;
+    BenchRun("brute force frustum cull, per object", count, [&] {
+        visible = 0;
+        for (const AABB &box : boxes)
+            visible += frustum.containsAABB(box);
+        BenchKeep(visible);
+    });
+    printf("  %-40s %10d\n", "visible", visible);
+
+    // Queries shared by both structures; 'hits' keeps the work observable
+    auto benchQueries = [&](const char *name, auto &index) {
+        char label[64];
+        int hits = 0;
+
+        snprintf(label, sizeof(label), "%s frustum, per query", name);
+        BenchRun(label, 1, [&] {
+            index.queryFrustum(frustum, [&](unsigned int) { hits++; });
+            BenchKeep(hits);
+        });
+
+        snprintf(label, sizeof(label), "%s overlap, per query", name);
+        BenchRun(label, NUM_QUERIES, [&] {
+            for (const AABB &box : queryBoxes)
+                index.queryAABB(box, [&](unsigned int) { hits++; });
+            BenchKeep(hits);
+        });
+
+        // Nearest box hit, clipping the ray as boxes are found
+        snprintf(label, sizeof(label), "%s raycast, per ray", name);
+        BenchRun(label, NUM_RAYS, [&] {
+            for (int i = 0; i < NUM_RAYS; i++)
+                index.raycast(rayOrigins[i], rayDirections[i], side, [&](unsigned int, float distance) { hits++; return distance; });
+            BenchKeep(hits);
+        });
+    };
+
+    BVH bvh(0.0f);
+    double buildMs = TimeOnce([&] { bvh.build(boxes.data(), ids.data(), count); });
+    printf("  %-40s %10.3f ms (cost %.1f, height %d)\n", "bvh SAH build", buildMs, bvh.getCost(), bvh.getHeight());
+    benchQueries("bvh", bvh);
+
+    // Everything drifts a little: keep the topology, recompute the boxes
+    std::vector<ProxyId> proxies(count);
+    bvh.build(boxes.data(), ids.data(), count, proxies.data());
+    double refitMs = TimeOnce([&] {
+        for (int i = 0; i < count; i++)
+            bvh.setBox(proxies[i], moved[i]);
+        bvh.refit();
+    });
+    printf("  %-40s %10.3f ms\n", "bvh refit, all moved", refitMs);
+
+    BVH dynamic(0.1f);
+    double insertMs = TimeOnce([&] {
+        for (int i = 0; i < count; i++)
+            proxies[i] = dynamic.insert(boxes[i], ids[i]);
+    });
+    printf("  %-40s %10.3f ms (cost %.1f, height %d)\n", "bvh incremental insert", insertMs,
+           dynamic.getCost(), dynamic.getHeight());
+    benchQueries("bvh incremental", dynamic);
+
+    // Small moves stay inside the fat boxes; a tenth move further and
+    // have to be reinserted
+    int reinserted = 0;
+    double updateMs = TimeOnce([&] {
+        for (int i = 0; i < count; i++)
+        {
+            vec3 offset = i % 10 == 0 ? vec3(1.0f, 0.0f, 0.0f) : vec3(0.0f);
+            reinserted += dynamic.update(proxies[i], Offset(moved[i], offset));
+        }
+    });
+    printf("  %-40s %10.3f ms (%d reinserted)\n", "bvh update, all moved", updateMs, reinserted);
+
+    LooseGrid grid(AABB(vec3(0.0f), vec3(side)), MAX_SIZE * 2.0f);
+    std::vector<GridProxy> gridProxies(count);
+    double gridInsertMs = TimeOnce([&] {
+        for (int i = 0; i < count; i++)
+            gridProxies[i] = grid.insert(boxes[i], ids[i]);
+    });
+    printf("  %-40s %10.3f ms\n", "grid insert", gridInsertMs);
+    benchQueries("grid", grid);
+
+    double gridUpdateMs = TimeOnce([&] {
+        for (int i = 0; i < count; i++)
+            grid.update(gridProxies[i], moved[i]);
+    });
+    printf("  %-40s %10.3f ms\n", "grid update, all moved", gridUpdateMs);
+}
+
+// Inserts boxes that give the sibling search nothing to go on: many
+// copies of one box, as when objects spawn at a single point, and boxes
+// that each enclose all the ones before. The tree must stay shallow
+// regardless, and queries must still find everything. Returns false if
+// either fails, which fails the benchmark run.
+static bool RunDegenerate(int count)
+{
+    bool passed = true;
+    const char *names[] = { "identical boxes", "nested boxes" };
+    for (int mode = 0; mode < 2; mode++)
+    {
+        BVH bvh(0.1f);
+        double insertMs = TimeOnce([&] {
+            for (int i = 0; i < count; i++)
+            {
+                float half = mode == 0 ? 0.5f : 0.5f + i;
+                bvh.insert(AABB(vec3(-half), vec3(half)), (unsigned int)i);
+            }
+        });
+
+        int overlaps = 0, hits = 0;
+        bvh.queryAABB(AABB(vec3(-0.1f), vec3(0.1f)), [&](unsigned int) { overlaps++; });
+        float rayLength = 4.0f * count;
+        bvh.raycast(vec3(0.0f, 0.0f, -2.0f * count), vec3(0.0f, 0.0f, 1.0f), rayLength,
+                    [&](unsigned int, float) { hits++; return rayLength; });
+
+        // Every box holds the origin, and the ray passes through all of them
+        int maxHeight = 2 * (int)ceilf(log2f((float)count)) + BVH_MAX_IMBALANCE;
+        bool ok = bvh.getHeight() <= maxHeight && overlaps == count && hits == count;
+        printf("  %-40s %10.3f ms (height %d, %d found)%s\n", names[mode], insertMs, bvh.getHeight(), overlaps,
+               ok ? "" : " FAILED");
+        passed = passed && ok;
+    }
+    return passed;
+}
+
+int main()
+{
+    printf("%d degenerate inserts\n", 20000);
+    bool passed = RunDegenerate(20000);
+
+    const int counts[] = { 10000, 100000, 1000000 };
+    for (int count : counts)
+        Run(count);
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,32 @@
+#version 430 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aColor;
+layout (location = 2) in uint aDrawId; // per-instance, offset by each command's baseInstance
+
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 position;
+} camera;
+
+struct DrawData
+{
+    mat4 transform;
+    vec4 color;
+};
+
+layout (std430, binding = 0) readonly buffer DrawBuffer
+{
+    DrawData draws[];
+};
+
+out vec3 ourColor;
+
+void main()
+{
+    DrawData draw = draws[aDrawId];
+    gl_Position = camera.viewProjection * draw.transform * vec4(aPos, 1.0);
+    ourColor = aColor * draw.color.rgb;
+}
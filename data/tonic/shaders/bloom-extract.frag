@@ -0,0 +1,24 @@
+#version 330 core
+out vec4 FragColor;
+in vec2 uv;
+
+uniform sampler2D source; // texture unit 0, the HDR scene
+uniform vec2 texelSize;   // of the source
+uniform float threshold;
+
+void main()
+{
+    // Four bilinear taps average a 4x4 block, so shrinking the image by
+    // up to four times does not drop small bright details
+    vec3 color = texture(source, uv + texelSize * vec2(-1.0, -1.0)).rgb;
+    color += texture(source, uv + texelSize * vec2(1.0, -1.0)).rgb;
+    color += texture(source, uv + texelSize * vec2(-1.0, 1.0)).rgb;
+    color += texture(source, uv + texelSize * vec2(1.0, 1.0)).rgb;
+    color *= 0.25;
+
+    // Keep only what is brighter than the threshold, scaled so the cut
+    // off is soft rather than a hard edge
+    float brightness = max(color.r, max(color.g, color.b));
+    float contribution = max(brightness - threshold, 0.0) / max(brightness, 0.0001);
+    FragColor = vec4(color * contribution, 1.0);
+}
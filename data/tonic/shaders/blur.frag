@@ -0,0 +1,22 @@
+#version 330 core
+out vec4 FragColor;
+in vec2 uv;
+
+uniform sampler2D source; // texture unit 0
+uniform vec2 direction;   // one texel along the axis being blurred
+
+// A 9 tap Gaussian in 5 samples, each between two taps so bilinear
+// filtering blends them in the right proportion
+const float offsets[3] = float[](0.0, 1.3846153846, 3.2307692308);
+const float weights[3] = float[](0.2270270270, 0.3162162162, 0.0702702703);
+
+void main()
+{
+    vec3 color = texture(source, uv).rgb * weights[0];
+    for (int i = 1; i < 3; i++)
+    {
+        color += texture(source, uv + direction * offsets[i]).rgb * weights[i];
+        color += texture(source, uv - direction * offsets[i]).rgb * weights[i];
+    }
+    FragColor = vec4(color, 1.0);
+}
@@ -0,0 +1,19 @@
+#version 330 core
+out vec4 FragColor;
+in vec2 uv;
+
+uniform sampler2D source; // texture unit 0
+uniform vec4 lift;        // raises the shadows; rgb only
+uniform vec4 gamma;       // bends the midtones; rgb only
+uniform vec4 gain;        // scales the highlights; rgb only
+uniform float saturation;
+
+void main()
+{
+    vec3 color = texture(source, uv).rgb;
+    color = gain.rgb * (color + lift.rgb * (1.0 - color));
+    color = pow(max(color, vec3(0.0)), 1.0 / max(gamma.rgb, vec3(0.0001)));
+
+    float luma = dot(color, vec3(0.2126, 0.7152, 0.0722));
+    FragColor = vec4(mix(vec3(luma), color, saturation), 1.0);
+}
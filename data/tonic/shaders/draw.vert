@@ -0,0 +1,27 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aColor;
+
+// Shared blocks, see renderer/uniforms.h. Camera is bound once per frame,
+// Draw at a new offset into the uniform ring for every draw.
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 position;
+} camera;
+
+layout (std140) uniform Draw
+{
+    mat4 transform;
+    vec4 color;
+} draw;
+
+out vec3 ourColor;
+
+void main()
+{
+    gl_Position = camera.viewProjection * draw.transform * vec4(aPos, 1.0);
+    ourColor = aColor * draw.color.rgb;
+}
@@ -0,0 +1,11 @@
+#version 330 core
+
+// One triangle covering the screen, made from gl_VertexID alone; draw
+// three vertices with any vertex array bound
+out vec2 uv;
+
+void main()
+{
+    uv = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(uv * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,44 @@
+#version 330 core
+out vec4 FragColor;
+in vec2 uv;
+
+uniform sampler2D source; // texture unit 0, tone mapped
+uniform vec2 texelSize;   // of the source
+
+// The classic single pass FXAA: find the edge direction from the luma of
+// the corners, then blur along it by an amount that shrinks with contrast
+#define FXAA_SPAN_MAX 8.0
+#define FXAA_REDUCE_MUL (1.0 / 8.0)
+#define FXAA_REDUCE_MIN (1.0 / 128.0)
+
+float Luma(vec3 color)
+{
+    return dot(color, vec3(0.299, 0.587, 0.114));
+}
+
+void main()
+{
+    float lumaNW = Luma(texture(source, uv + vec2(-1.0, -1.0) * texelSize).rgb);
+    float lumaNE = Luma(texture(source, uv + vec2(1.0, -1.0) * texelSize).rgb);
+    float lumaSW = Luma(texture(source, uv + vec2(-1.0, 1.0) * texelSize).rgb);
+    float lumaSE = Luma(texture(source, uv + vec2(1.0, 1.0) * texelSize).rgb);
+    float lumaM = Luma(texture(source, uv).rgb);
+
+    float lumaMin = min(lumaM, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));
+    float lumaMax = max(lumaM, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));
+
+    vec2 dir = vec2(-((lumaNW + lumaNE) - (lumaSW + lumaSE)), (lumaNW + lumaSW) - (lumaNE + lumaSE));
+    float reduce = max((lumaNW + lumaNE + lumaSW + lumaSE) * 0.25 * FXAA_REDUCE_MUL, FXAA_REDUCE_MIN);
+    float scale = 1.0 / (min(abs(dir.x), abs(dir.y)) + reduce);
+    dir = clamp(dir * scale, vec2(-FXAA_SPAN_MAX), vec2(FXAA_SPAN_MAX)) * texelSize;
+
+    vec3 inner = 0.5 * (texture(source, uv + dir * (1.0 / 3.0 - 0.5)).rgb +
+                        texture(source, uv + dir * (2.0 / 3.0 - 0.5)).rgb);
+    vec3 outer = inner * 0.5 + 0.25 * (texture(source, uv + dir * -0.5).rgb +
+                                       texture(source, uv + dir * 0.5).rgb);
+
+    // Reaching further picked up something outside the local range, so
+    // the edge was misjudged; settle for the inner samples
+    float lumaOuter = Luma(outer);
+    FragColor = vec4((lumaOuter < lumaMin || lumaOuter > lumaMax) ? inner : outer, 1.0);
+}
@@ -0,0 +1,22 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;       // per-vertex position
+layout (location = 1) in vec3 aColor;     // per-vertex colour
+layout (location = 2) in mat4 aTransform; // per-instance model matrix (locations 2-5)
+layout (location = 6) in vec4 aTint;      // per-instance colour
+
+// Shared block, see renderer/uniforms.h
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 position;
+} camera;
+
+out vec3 ourColor;
+
+void main()
+{
+    gl_Position = camera.viewProjection * aTransform * vec4(aPos, 1.0);
+    ourColor = aColor * aTint.rgb;
+}
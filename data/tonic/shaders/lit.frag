@@ -0,0 +1,124 @@
+#version 430 core
+out vec4 FragColor;
+in vec3 ourColor;
+in vec3 viewPosition;
+in vec3 viewNormal;
+
+struct Light
+{
+    vec4 positionRange;  // view space
+    vec4 colorInner;
+    vec4 directionOuter;
+};
+
+// Shared blocks, see renderer/uniforms.h
+layout (std140) uniform Frame
+{
+    float time;
+    float deltaTime;
+    vec2 resolution;
+} frame;
+
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 position;
+} camera;
+
+layout (std140) uniform Lighting
+{
+    vec4 clusters;
+    vec4 frustum;
+    vec4 slicing;
+    vec4 ambient;
+} lighting;
+
+layout (std140) uniform DirectionalLight
+{
+    vec4 direction;  // world space, towards the light
+    vec4 color;
+    vec4 splits;
+    vec4 texelSizes;
+    vec4 shadow;     // x depth bias, y normal offset in texels, z 1 / map size, w cascades
+    mat4 cascades[4]; // SHADOW_CASCADES
+} sun;
+
+// Filled in by cluster-lights.comp, see renderer/clustered-lighting.h
+layout (std430, binding = 5) readonly buffer LightBuffer { Light lights[]; };
+layout (std430, binding = 6) readonly buffer GridBuffer { uvec2 grid[]; };
+layout (std430, binding = 7) readonly buffer IndexBuffer { uint indices[]; };
+
+// The cascades of the directional light, see renderer/cascaded-shadows.h
+layout (binding = 2) uniform sampler2DArrayShadow shadowMap;
+
+vec3 Shade(vec3 albedo, vec3 normal, vec3 toEye, vec3 toLight, vec3 radiance)
+{
+    float diffuse = max(dot(normal, toLight), 0.0);
+    float specular = pow(max(dot(normal, normalize(toLight + toEye)), 0.0), 32.0) * step(0.0, diffuse);
+    return (albedo * diffuse + vec3(0.25 * specular)) * radiance;
+}
+
+// How much of the directional light reaches a point, 0 to 1
+float Shadow(vec3 position, vec3 normal)
+{
+    int count = int(sun.shadow.w);
+    int cascade = 0;
+    while (cascade < count && -position.z > sun.splits[cascade])
+        cascade++;
+    if (cascade == count)
+        return 1.0;
+
+    // Pushing the point out along the normal, by an amount that follows
+    // the cascade's texel size, keeps lit surfaces from shadowing
+    // themselves at grazing angles
+    vec3 offsetPosition = position + normal * sun.texelSizes[cascade] * sun.shadow.y;
+    vec3 coord = (sun.cascades[cascade] * vec4(offsetPosition, 1.0)).xyz;
+    if (any(lessThan(coord, vec3(0.0))) || any(greaterThan(coord, vec3(1.0))))
+        return 1.0;
+
+    // Four bilinear comparisons half a texel apart: a 3x3 texel filter
+    float reference = coord.z - sun.shadow.x;
+    float texel = sun.shadow.z;
+    float lit = 0.0;
+    lit += texture(shadowMap, vec4(coord.xy + vec2(-0.5, -0.5) * texel, float(cascade), reference));
+    lit += texture(shadowMap, vec4(coord.xy + vec2(0.5, -0.5) * texel, float(cascade), reference));
+    lit += texture(shadowMap, vec4(coord.xy + vec2(-0.5, 0.5) * texel, float(cascade), reference));
+    lit += texture(shadowMap, vec4(coord.xy + vec2(0.5, 0.5) * texel, float(cascade), reference));
+    return lit * 0.25;
+}
+
+void main()
+{
+    vec3 normal = normalize(viewNormal);
+    vec3 toEye = normalize(-viewPosition);
+
+    vec3 color = ourColor * lighting.ambient.rgb;
+    vec3 toSun = normalize(mat3(camera.view) * sun.direction.xyz);
+    color += Shade(ourColor, normal, toEye, toSun, sun.color.rgb * Shadow(viewPosition, normal));
+
+    uvec3 size = uvec3(lighting.clusters.xyz);
+    uvec2 tile = min(uvec2(gl_FragCoord.xy / frame.resolution * vec2(size.xy)), size.xy - 1u);
+    uint slice = uint(clamp(log(-viewPosition.z) * lighting.slicing.x + lighting.slicing.y, 0.0, float(size.z - 1u)));
+    uvec2 list = grid[tile.x + tile.y * size.x + slice * size.x * size.y];
+
+    for (uint i = 0u; i < list.y; i++)
+    {
+        Light light = lights[indices[list.x + i]];
+
+        vec3 offset = light.positionRange.xyz - viewPosition;
+        float lightDistance = length(offset);
+        vec3 toLight = offset / lightDistance;
+
+        // Inverse square, windowed so it reaches zero exactly at the range
+        float window = clamp(1.0 - pow(lightDistance / light.positionRange.w, 4.0), 0.0, 1.0);
+        float attenuation = window * window / (lightDistance * lightDistance + 1.0);
+
+        float cone = smoothstep(light.directionOuter.w, light.colorInner.w, dot(-toLight, light.directionOuter.xyz));
+
+        color += Shade(ourColor, normal, toEye, toLight, light.colorInner.rgb * attenuation * cone);
+    }
+
+    FragColor = vec4(color, 1.0);
+}
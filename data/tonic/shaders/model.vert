@@ -0,0 +1,35 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;    // quantised, see MeshAsset
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aUV;
+
+// Shared blocks, see renderer/uniforms.h
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 position;
+} camera;
+
+// 'transform' includes the mesh's dequantize matrix
+layout (std140) uniform Draw
+{
+    mat4 transform;
+    vec4 color;
+} draw;
+
+out vec3 ourColor;
+out vec3 viewPosition;
+out vec3 viewNormal;
+
+void main()
+{
+    vec4 world = draw.transform * vec4(aPos, 1.0);
+    gl_Position = camera.viewProjection * world;
+    viewPosition = (camera.view * world).xyz;
+
+    // The dequantize scale is non-uniform, so use the inverse transpose
+    viewNormal = mat3(camera.view) * (transpose(inverse(mat3(draw.transform))) * aNormal);
+    ourColor = draw.color.rgb;
+}
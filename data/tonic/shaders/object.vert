@@ -0,0 +1,14 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aColor;
+
+uniform mat4 transform; // set once per draw
+uniform vec4 tint;
+
+out vec3 ourColor;
+
+void main()
+{
+    gl_Position = transform * vec4(aPos, 1.0);
+    ourColor = aColor * tint.rgb;
+}
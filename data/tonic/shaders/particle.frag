@@ -0,0 +1,11 @@
+#version 330 core
+out vec4 FragColor;
+in vec2 corner;
+in vec4 ourColor;
+
+void main()
+{
+    // A soft round spot; blended additively, so only the brightness counts
+    float falloff = 1.0 - smoothstep(0.5, 1.0, length(corner));
+    FragColor = vec4(ourColor.rgb * ourColor.a * falloff, 1.0);
+}
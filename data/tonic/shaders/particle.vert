@@ -0,0 +1,38 @@
+#version 430 core
+
+// A camera facing quad per particle, drawn as an instanced 4 vertex
+// triangle strip with any vertex array bound
+struct Particle
+{
+    vec4 positionLife; // w seconds left to live
+    vec4 velocitySize;
+    vec4 color;        // a 1 / lifetime
+};
+
+// Shared block, see renderer/uniforms.h
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 position;
+} camera;
+
+// See renderer/particles.h
+layout (std430, binding = 9) readonly buffer ParticleBuffer { Particle particles[]; };
+
+out vec2 corner;
+out vec4 ourColor;
+
+void main()
+{
+    Particle particle = particles[gl_InstanceID];
+    corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+
+    vec4 center = camera.view * vec4(particle.positionLife.xyz, 1.0);
+    gl_Position = camera.projection * (center + vec4(corner * 0.5 * particle.velocitySize.w, 0.0, 0.0));
+
+    // Fade out over the particle's life
+    float alpha = clamp(particle.positionLife.w * particle.color.a, 0.0, 1.0);
+    ourColor = vec4(particle.color.rgb, alpha);
+}
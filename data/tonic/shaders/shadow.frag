@@ -0,0 +1,6 @@
+#version 330 core
+
+// Shadow casters write depth only
+void main()
+{
+}
@@ -0,0 +1,23 @@
+#version 330 core
+layout (location = 0) in vec3 aPos; // quantised, see MeshAsset
+
+// Shared blocks, see renderer/uniforms.h. While shadows are drawn the
+// camera is the cascade's light view.
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 position;
+} camera;
+
+layout (std140) uniform Draw
+{
+    mat4 transform;
+    vec4 color;
+} draw;
+
+void main()
+{
+    gl_Position = camera.viewProjection * draw.transform * vec4(aPos, 1.0);
+}
@@ -0,0 +1,22 @@
+#version 330 core
+out vec4 FragColor;
+in vec2 uv;
+
+uniform sampler2D source; // texture unit 0, the HDR scene
+uniform sampler2D bloom;  // texture unit 1
+uniform float bloomIntensity;
+uniform float exposure;
+
+// Narkowicz's fit of the ACES filmic curve
+vec3 ACESFilm(vec3 x)
+{
+    return clamp((x * (2.51 * x + 0.03)) / (x * (2.43 * x + 0.59) + 0.14), 0.0, 1.0);
+}
+
+void main()
+{
+    vec3 color = texture(source, uv).rgb;
+    if (bloomIntensity > 0.0)
+        color += texture(bloom, uv).rgb * bloomIntensity;
+    FragColor = vec4(ACESFilm(color * exposure), 1.0);
+}
@@ -0,0 +1,231 @@
+#include "asset-cache.h"
+#include "../platform.h"
+#include "../audio/sound.h"
+
+static const char *typeNames[ASSET_TYPE_COUNT] = { "shaders", "textures", "meshes", "sounds" };
+
+AssetCache::AssetCache(Platform *platform) : platform(platform)
+{
+    for (TypeSlot &slot : types)
+        slot = TypeSlot();
+
+    types[ASSET_SHADER].stats.budgetBytes = ASSET_SHADER_BUDGET;
+    types[ASSET_TEXTURE].stats.budgetBytes = ASSET_TEXTURE_BUDGET;
+    types[ASSET_MESH].stats.budgetBytes = ASSET_MESH_BUDGET;
+    types[ASSET_SOUND].stats.budgetBytes = ASSET_SOUND_BUDGET;
+
+    setLoader(ASSET_SOUND,
+        [platform](const std::string &path, size_t &bytes) -> void * {
+            size_t size;
+            const void *file = platform->MapFile(path, &size);
+            if (!file)
+                return nullptr;
+
+            Sound *sound = new Sound();
+            bool ok = LoadSound(file, size, *sound);
+            platform->UnmapFile(file, size);
+            if (!ok)
+            {
+                platform->Log("Error: %s is not a supported WAV file\n", path.c_str());
+                delete sound;
+                return nullptr;
+            }
+
+            bytes = sound->samples.size() * sizeof(float);
+            return sound;
+        },
+        [](void *asset) { delete (Sound *)asset; },
+        [](void *asset) { return ((Sound *)asset)->voices > 0; });
+}
+
+// Anything still referenced at this point is freed regardless; its
+// handles must not be used afterwards
+AssetCache::~AssetCache()
+{
+    for (auto &pair : entries)
+    {
+        types[pair.second->type].free(pair.second->asset);
+        delete pair.second;
+    }
+    for (RetiredAsset &old : retired)
+        types[old.type].free(old.asset);
+}
+
+void AssetCache::setLoader(AssetType type, AssetLoadFunc load, AssetFreeFunc free, AssetBusyFunc busy)
+{
+    types[type].load = load;
+    types[type].free = free;
+    types[type].busy = busy;
+}
+
+void AssetCache::setBudget(AssetType type, size_t bytes)
+{
+    types[type].stats.budgetBytes = bytes;
+    trim(type);
+}
+
+AssetEntry *AssetCache::acquire(AssetType type, const std::string &path)
+{
+    TypeSlot &slot = types[type];
+    StringId key(path);
+
+    auto found = entries.find(key);
+    if (found != entries.end())
+    {
+        AssetEntry *entry = found->second;
+        if (entry->type != type || entry->path != path)
+        {
+            platform->Log("Error: asset %s collides with %s\n", path.c_str(), entry->path.c_str());
+            return nullptr;
+        }
+
+        slot.stats.hits++;
+        retain(entry);
+        return entry;
+    }
+
+    if (!slot.load)
+    {
+        platform->Log("Error: no loader for %s, needed by %s\n", typeNames[type], path.c_str());
+        return nullptr;
+    }
+
+    size_t bytes = 0;
+    void *asset = slot.load(path, bytes);
+    if (!asset)
+    {
+        slot.stats.failures++;
+        return nullptr;
+    }
+
+    AssetEntry *entry = new AssetEntry{ key, type, path, asset, bytes, 1, nullptr, nullptr };
+    entries[key] = entry;
+
+    slot.stats.loads++;
+    slot.stats.resident++;
+    slot.stats.residentBytes += bytes;
+    slot.stats.referenced++;
+    slot.stats.referencedBytes += bytes;
+
+    // Make room for it among the unreferenced ones
+    trim(type);
+    return entry;
+}
+
+void AssetCache::retain(AssetEntry *entry)
+{
+    if (entry->references++ > 0)
+        return;
+
+    // Back in use; it can no longer be evicted
+    AssetTypeStats &stats = types[entry->type].stats;
+    unlink(entry);
+    stats.referenced++;
+    stats.referencedBytes += entry->bytes;
+}
+
+void AssetCache::release(AssetEntry *entry)
+{
+    if (--entry->references > 0)
+        return;
+
+    TypeSlot &slot = types[entry->type];
+    slot.stats.referenced--;
+    slot.stats.referencedBytes -= entry->bytes;
+
+    // Most recently used end of the list
+    entry->prev = slot.newest;
+    entry->next = nullptr;
+    if (slot.newest)
+        slot.newest->next = entry;
+    else
+        slot.oldest = entry;
+    slot.newest = entry;
+
+    trim(entry->type);
+}
+
+void AssetCache::unlink(AssetEntry *entry)
+{
+    TypeSlot &slot = types[entry->type];
+    if (entry->prev)
+        entry->prev->next = entry->next;
+    else
+        slot.oldest = entry->next;
+    if (entry->next)
+        entry->next->prev = entry->prev;
+    else
+        slot.newest = entry->prev;
+    entry->prev = entry->next = nullptr;
+}
+
+void AssetCache::evict(AssetEntry *entry)
+{
+    TypeSlot &slot = types[entry->type];
+    unlink(entry);
+    slot.stats.evictions++;
+
+    // Gone from the cache either way, so a new acquire loads it afresh,
+    // but the memory is held until whatever is using it lets go
+    if (slot.busy && slot.busy(entry->asset))
+    {
+        retired.push_back(RetiredAsset{ entry->type, entry->asset, entry->bytes });
+    }
+    else
+    {
+        slot.free(entry->asset);
+        slot.stats.resident--;
+        slot.stats.residentBytes -= entry->bytes;
+    }
+
+    entries.erase(entry->key);
+    delete entry;
+}
+
+void AssetCache::trim(AssetType type)
+{
+    TypeSlot &slot = types[type];
+    while (slot.stats.residentBytes > slot.stats.budgetBytes && slot.oldest)
+        evict(slot.oldest);
+}
+
+void AssetCache::update()
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < retired.size(); i++)
+    {
+        RetiredAsset &old = retired[i];
+        TypeSlot &slot = types[old.type];
+        if (slot.busy(old.asset))
+        {
+            retired[kept++] = old;
+            continue;
+        }
+
+        slot.free(old.asset);
+        slot.stats.resident--;
+        slot.stats.residentBytes -= old.bytes;
+    }
+    retired.resize(kept);
+}
+
+void AssetCache::purge()
+{
+    for (TypeSlot &slot : types)
+    {
+        while (slot.oldest)
+            evict(slot.oldest);
+    }
+}
+
+void AssetCache::log() const
+{
+    platform->Log("Assets (KiB: resident / referenced / budget)\n");
+    for (int i = 0; i < ASSET_TYPE_COUNT; i++)
+    {
+        const AssetTypeStats &stats = types[i].stats;
+        platform->Log("  %-10s %9zu %9zu %9zu  %u resident, %u loads, %u hits, %u evictions, %u failed\n",
+                      typeNames[i], stats.residentBytes / 1024, stats.referencedBytes / 1024, stats.budgetBytes / 1024,
+                      stats.resident, stats.loads, stats.hits, stats.evictions, stats.failures);
+    }
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <functional>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../string-id.h"
+
+class Platform;
+
+enum AssetType
+{
+    ASSET_SHADER,
+    ASSET_TEXTURE,
+    ASSET_MESH,
+    ASSET_SOUND,
+    ASSET_TYPE_COUNT
+};
+
+// Default budgets; unreferenced assets are evicted, least recently used
+// first, once their type goes over
+#define ASSET_SHADER_BUDGET (16 * 1024 * 1024)
+#define ASSET_TEXTURE_BUDGET (256 * 1024 * 1024)
+#define ASSET_MESH_BUDGET (128 * 1024 * 1024)
+#define ASSET_SOUND_BUDGET (64 * 1024 * 1024)
+
+// Loads the asset named 'path' and sets 'bytes' to roughly how much memory
+// it keeps (GPU or CPU). Returns nullptr if it could not be loaded.
+typedef std::function<void *(const std::string &path, size_t &bytes)> AssetLoadFunc;
+typedef std::function<void(void *asset)> AssetFreeFunc;
+
+// Returns true while something outside the cache, such as the audio
+// thread, still reads the asset, so that freeing it must wait
+typedef std::function<bool(void *asset)> AssetBusyFunc;
+
+struct AssetTypeStats
+{
+    size_t budgetBytes;
+    size_t residentBytes;
+    size_t referencedBytes; // the part that cannot be evicted
+    unsigned int resident;
+    unsigned int referenced;
+    unsigned int loads;     // from disk
+    unsigned int hits;      // served from memory
+    unsigned int failures;
+    unsigned int evictions;
+};
+
+struct AssetEntry;
+
+// Every asset the game loads, keyed by the StringId of its path. Each is
+// loaded once however many places ask for it, and shared through
+// reference counted handles.
+//
+// When the last handle to an asset goes away, the asset stays resident in
+// case it is wanted again, and joins its type's LRU list. Whenever a type
+// is over its budget, assets are freed from the old end of that list
+// until it is back under; assets still referenced are never freed, so a
+// type can stay over budget while they are in use.
+//
+// Types are loaded by functions registered with setLoader(), so the cache
+// knows nothing about GL; sounds are registered by the cache itself.
+// An evicted asset that its type's busy function still reports in use
+// (a sound a voice is playing) is only unlisted at once; update() frees
+// it once it is idle, and until then it counts as resident.
+// Main thread only.
+class AssetCache
+{
+private:
+    Platform *platform;
+
+    struct TypeSlot
+    {
+        AssetLoadFunc load;
+        AssetFreeFunc free;
+        AssetBusyFunc busy;
+        AssetTypeStats stats;
+        AssetEntry *oldest; // unreferenced entries, least recently used first
+        AssetEntry *newest;
+    };
+    TypeSlot types[ASSET_TYPE_COUNT];
+    std::unordered_map<StringId, AssetEntry *> entries;
+
+    // Evicted while busy, waiting for update() to free them
+    struct RetiredAsset
+    {
+        AssetType type;
+        void *asset;
+        size_t bytes;
+    };
+    std::vector<RetiredAsset> retired;
+
+    void unlink(AssetEntry *entry);
+    void evict(AssetEntry *entry);
+    void trim(AssetType type);
+
+public:
+    explicit AssetCache(Platform *platform);
+    ~AssetCache();
+
+    void setLoader(AssetType type, AssetLoadFunc load, AssetFreeFunc free, AssetBusyFunc busy = nullptr);
+    void setBudget(AssetType type, size_t bytes);
+
+    // Takes a reference to the asset, loading it if it is not resident.
+    // Returns nullptr if it failed to load; failures are not cached, so
+    // the next acquire tries again. Use the typed handles below instead.
+    AssetEntry *acquire(AssetType type, const std::string &path);
+    void retain(AssetEntry *entry);
+    void release(AssetEntry *entry);
+
+    // Frees every unreferenced asset, budget or not
+    void purge();
+
+    // Frees evicted assets that are no longer busy. Called once a frame.
+    void update();
+
+    const AssetTypeStats &getStats(AssetType type) const { return types[type].stats; }
+
+    // Resident and budgeted bytes per type, through Platform::Log
+    void log() const;
+};
+
+struct AssetEntry
+{
+    StringId key;
+    AssetType type;
+    std::string path;
+    void *asset;
+    size_t bytes;
+    int references;
+    AssetEntry *prev, *next; // in the LRU list while unreferenced
+};
+
+// A counted reference to one asset of type T. Copying takes another
+// reference; an empty handle (failed load, or default constructed) gets
+// nullptr.
+template <typename T, AssetType Type>
+class AssetHandle
+{
+private:
+    AssetCache *cache = nullptr;
+    AssetEntry *entry = nullptr;
+
+public:
+    AssetHandle() {}
+    AssetHandle(AssetCache *cache, const std::string &path) : cache(cache), entry(cache->acquire(Type, path)) {}
+    AssetHandle(const AssetHandle &other) : cache(other.cache), entry(other.entry)
+    {
+        if (entry)
+            cache->retain(entry);
+    }
+    AssetHandle(AssetHandle &&other) : cache(other.cache), entry(other.entry) { other.entry = nullptr; }
+    ~AssetHandle() { reset(); }
+
+    AssetHandle &operator=(AssetHandle other)
+    {
+        std::swap(cache, other.cache);
+        std::swap(entry, other.entry);
+        return *this;
+    }
+
+    void reset()
+    {
+        if (entry)
+            cache->release(entry);
+        entry = nullptr;
+    }
+
+    T *get() const { return entry ? (T *)entry->asset : nullptr; }
+    T *operator->() const { return get(); }
+    explicit operator bool() const { return entry != nullptr; }
+
+    const std::string &getPath() const { return entry->path; }
+};
+
+struct Sound;
+typedef AssetHandle<Sound, ASSET_SOUND> SoundHandle;
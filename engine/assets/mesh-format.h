@@ -0,0 +1,123 @@
+#pragma once
+
+#include <stdint.h>
+
+// Binary mesh format (.tmesh) written by tools/mesh-convert and loaded by
+// MeshAsset. Everything is little-endian and laid out so the runtime can
+// map the file and hand its vertex and index ranges to the GPU as they
+// are; nothing is parsed or converted at load time.
+//
+// File layout, each section aligned to MESH_SECTION_ALIGN:
+//
+//   MeshFileHeader
+//   MeshSubmesh[submeshCount]
+//   MeshLod[lodCount]
+//   MeshMeshlet[meshletCount]
+//   vertices        vertexCount * MESH_VERTEX_STRIDE bytes
+//   indices         indexCount * indexSize bytes
+//   meshlet vertices  uint32 per entry, indices into the vertex array
+//   meshlet triangles uint8 x3 per triangle, into the meshlet's vertices
+
+#define MESH_FILE_MAGIC 0x48534d54 // "TMSH"
+#define MESH_FILE_VERSION 2
+#define MESH_SECTION_ALIGN 16
+
+// Quantised vertex, 16 bytes:
+//   position  unorm16 x3 + pad   offset 0, relative to the mesh bounds
+//   normal    int 2_10_10_10_rev offset 8, signed normalised xyz
+//   uv        half float x2      offset 12
+#define MESH_VERTEX_STRIDE 16
+#define MESH_VERTEX_POSITION_OFFSET 0
+#define MESH_VERTEX_NORMAL_OFFSET 8
+#define MESH_VERTEX_UV_OFFSET 12
+
+// Meshlet limits, chosen to fit common mesh shader and cluster culling
+// budgets
+#define MESH_MESHLET_MAX_VERTICES 64
+#define MESH_MESHLET_MAX_TRIANGLES 124
+
+#define MESH_NAME_LENGTH 32
+
+// Full detail plus up to four simplified levels, each with about half the
+// triangles of the one before
+#define MESH_MAX_LODS 5
+
+struct MeshFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t fileSize;
+
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t indexSize; // 2 or 4 bytes
+    uint32_t submeshCount;
+    uint32_t lodCount;
+    uint32_t meshletCount;
+    uint32_t meshletVertexCount;
+    uint32_t meshletTriangleCount;
+
+    // Object-space bounds. Quantised positions map [0, 65535] onto
+    // boundsMin..boundsMax, so position = boundsMin + q / 65535 * extent.
+    float boundsMin[3];
+    float boundsMax[3];
+    float sphere[4]; // centre xyz, radius w
+
+    // Byte offsets of each section from the start of the file
+    uint32_t submeshOffset;
+    uint32_t lodOffset;
+    uint32_t meshletOffset;
+    uint32_t vertexOffset;
+    uint32_t indexOffset;
+    uint32_t meshletVertexOffset;
+    uint32_t meshletTriangleOffset;
+};
+
+// A range of the index buffer drawn with one material. firstIndex and
+// indexCount are the full-detail triangles, which are also its LOD 0.
+struct MeshSubmesh
+{
+    char name[MESH_NAME_LENGTH]; // material name, NUL terminated
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    uint32_t firstLod;
+    uint32_t lodCount;
+    uint32_t firstMeshlet; // meshlets cover LOD 0 only
+    uint32_t meshletCount;
+    float sphere[4];
+};
+
+// One level of detail of a submesh: a range of the shared index buffer
+// over the same vertices as the full-detail mesh
+struct MeshLod
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+
+    // Approximate object-space distance between this level's surface and
+    // the full-detail one; 0 for LOD 0
+    float error;
+};
+
+// Small cluster of triangles for finer-grained culling
+struct MeshMeshlet
+{
+    uint32_t vertexOffset;   // into meshlet vertices
+    uint32_t triangleOffset; // into meshlet triangles, in triangles
+    uint32_t vertexCount;
+    uint32_t triangleCount;
+
+    float sphere[4];
+
+    // Backface cone: every triangle faces away from an eye position for
+    // which dot(normalize(coneApex - eye), coneAxis) >= coneCutoff, so
+    // the whole meshlet can be skipped. A cutoff of 1 disables the test.
+    float coneApex[3];
+    float coneAxis[3];
+    float coneCutoff;
+};
+
+static_assert(sizeof(MeshFileHeader) == 112, "MeshFileHeader layout changed");
+static_assert(sizeof(MeshSubmesh) == 72, "MeshSubmesh layout changed");
+static_assert(sizeof(MeshLod) == 12, "MeshLod layout changed");
+static_assert(sizeof(MeshMeshlet) == 60, "MeshMeshlet layout changed");
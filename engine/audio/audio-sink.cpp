@@ -0,0 +1,52 @@
+#include "audio-sink.h"
+#include "wav.h"
+
+#include <thread>
+
+bool NullAudioSink::write(const float *, int frames)
+{
+    // Deadlines advance by whole buffers rather than from 'now', so the
+    // average rate stays exact however late the thread wakes
+    auto now = std::chrono::steady_clock::now();
+    if (!started)
+    {
+        deadline = now;
+        started = true;
+    }
+
+    deadline += std::chrono::nanoseconds((long long)frames * 1000000000 / sampleRate);
+    if (deadline > now)
+        std::this_thread::sleep_until(deadline);
+    return true;
+}
+
+WavFileSink::WavFileSink(const char *path, int sampleRate, int framesPerBuffer, bool realTime)
+    : clock(sampleRate, framesPerBuffer), realTime(realTime)
+{
+    file = fopen(path, "wb");
+    if (file && !BeginWavFile(file, sampleRate))
+    {
+        fclose(file);
+        file = nullptr;
+    }
+}
+
+WavFileSink::~WavFileSink()
+{
+    if (file)
+    {
+        FinishWavFile(file);
+        fclose(file);
+    }
+}
+
+bool WavFileSink::write(const float *samples, int frames)
+{
+    if (!file)
+        return false;
+
+    WriteWavFrames(file, samples, frames);
+    if (realTime)
+        clock.write(samples, frames);
+    return true;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <stdio.h>
+
+// Where the mixer's output goes: a sound device, or a stand-in for
+// running without one. Buffers are interleaved stereo floats in [-1, 1].
+class AudioSink
+{
+public:
+    virtual ~AudioSink() {}
+
+    virtual int getSampleRate() const = 0;
+    virtual int getFramesPerBuffer() const = 0;
+
+    // Blocks until the buffer has been accepted, which is what paces the
+    // mixer thread. Returns false if the output has failed.
+    virtual bool write(const float *samples, int frames) = 0;
+
+    // Times the device ran dry because a buffer came too late
+    virtual unsigned int getUnderrunCount() const { return 0; }
+};
+
+// Discards the audio, taking as long to do so as playing it would, so the
+// mixer runs at the same rate as it would against a device
+class NullAudioSink : public AudioSink
+{
+private:
+    int sampleRate, framesPerBuffer;
+    std::chrono::steady_clock::time_point deadline;
+    bool started = false;
+
+public:
+    NullAudioSink(int sampleRate, int framesPerBuffer) : sampleRate(sampleRate), framesPerBuffer(framesPerBuffer) {}
+
+    int getSampleRate() const override { return sampleRate; }
+    int getFramesPerBuffer() const override { return framesPerBuffer; }
+    bool write(const float *samples, int frames) override;
+};
+
+// Records the audio to a 16-bit WAV file, for checking the mix without a
+// sound device. Paced like NullAudioSink unless 'realTime' is false, when
+// writes return at once and the mixer renders as fast as it can.
+class WavFileSink : public AudioSink
+{
+private:
+    FILE *file;
+    NullAudioSink clock;
+    bool realTime;
+
+public:
+    WavFileSink(const char *path, int sampleRate, int framesPerBuffer, bool realTime = true);
+    ~WavFileSink();
+
+    bool isOpen() const { return file != nullptr; }
+
+    int getSampleRate() const override { return clock.getSampleRate(); }
+    int getFramesPerBuffer() const override { return clock.getFramesPerBuffer(); }
+    bool write(const float *samples, int frames) override;
+};
@@ -0,0 +1,165 @@
+#include "decoder.h"
+#include "wav.h"
+
+#include <string.h>
+
+#ifdef TONIC_VORBIS
+#include <vorbis/vorbisfile.h>
+#endif
+
+// PCM is converted a chunk at a time straight from the file data
+class WavDecoder : public AudioDecoder
+{
+private:
+    WavInfo info;
+    uint32_t next = 0;
+
+public:
+    explicit WavDecoder(const WavInfo &info) : info(info)
+    {
+        channels = info.channels;
+        sampleRate = info.sampleRate;
+    }
+
+    int read(float *out, int frames) override
+    {
+        uint32_t count = info.frames - next;
+        if ((uint32_t)frames < count)
+            count = (uint32_t)frames;
+
+        WavToFloat(info, info.data + (size_t)next * info.bytesPerFrame, count, out);
+        next += count;
+        return (int)count;
+    }
+
+    bool rewind() override
+    {
+        next = 0;
+        return true;
+    }
+};
+
+#ifdef TONIC_VORBIS
+// libvorbisfile reads through callbacks; these serve it from memory
+struct MemoryFile
+{
+    const unsigned char *data;
+    size_t size, offset;
+};
+
+static size_t MemoryRead(void *out, size_t size, size_t count, void *source)
+{
+    MemoryFile *file = (MemoryFile *)source;
+    size_t bytes = size * count;
+    if (bytes > file->size - file->offset)
+        bytes = file->size - file->offset;
+
+    memcpy(out, file->data + file->offset, bytes);
+    file->offset += bytes;
+    return size ? bytes / size : 0;
+}
+
+static int MemorySeek(void *source, ogg_int64_t offset, int whence)
+{
+    MemoryFile *file = (MemoryFile *)source;
+    ogg_int64_t base = whence == SEEK_SET ? 0 : (whence == SEEK_CUR ? (ogg_int64_t)file->offset : (ogg_int64_t)file->size);
+    if (base + offset < 0 || base + offset > (ogg_int64_t)file->size)
+        return -1;
+
+    file->offset = (size_t)(base + offset);
+    return 0;
+}
+
+static long MemoryTell(void *source)
+{
+    return (long)((MemoryFile *)source)->offset;
+}
+
+class VorbisDecoder : public AudioDecoder
+{
+private:
+    MemoryFile file;
+    OggVorbis_File vorbis;
+    bool opened = false;
+
+public:
+    bool open(const void *data, size_t size)
+    {
+        file = MemoryFile{ (const unsigned char *)data, size, 0 };
+        ov_callbacks callbacks = { MemoryRead, MemorySeek, nullptr, MemoryTell };
+        if (ov_open_callbacks(&file, &vorbis, nullptr, 0, callbacks) != 0)
+            return false;
+        opened = true;
+
+        vorbis_info *info = ov_info(&vorbis, -1);
+        channels = info->channels;
+        sampleRate = (int)info->rate;
+        return true;
+    }
+
+    ~VorbisDecoder()
+    {
+        if (opened)
+            ov_clear(&vorbis);
+    }
+
+    int read(float *out, int frames) override
+    {
+        int done = 0;
+        while (done < frames)
+        {
+            float **pcm;
+            int section;
+            long count = ov_read_float(&vorbis, &pcm, frames - done, &section);
+            if (count == OV_HOLE)
+                continue; // a gap in the data; decoding carries on after it
+            if (count < 0)
+                return done ? done : -1;
+            if (count == 0)
+                break;
+
+            // Planar to interleaved
+            for (long i = 0; i < count; i++)
+            {
+                for (int c = 0; c < channels; c++)
+                    out[(done + i) * channels + c] = pcm[c][i];
+            }
+            done += (int)count;
+        }
+        return done;
+    }
+
+    bool rewind() override
+    {
+        return ov_pcm_seek(&vorbis, 0) == 0;
+    }
+};
+#endif
+
+AudioDecoder *OpenAudioDecoder(const void *data, size_t size)
+{
+    AudioDecoder *decoder = nullptr;
+
+    WavInfo info;
+    if (ParseWav(data, size, info))
+        decoder = new WavDecoder(info);
+
+#ifdef TONIC_VORBIS
+    if (!decoder && size >= 4 && memcmp(data, "OggS", 4) == 0)
+    {
+        VorbisDecoder *vorbis = new VorbisDecoder();
+        if (vorbis->open(data, size))
+            decoder = vorbis;
+        else
+            delete vorbis;
+    }
+#endif
+
+    // The mixer plays mono and stereo only
+    if (decoder && (decoder->channels < 1 || decoder->channels > 2))
+    {
+        delete decoder;
+        decoder = nullptr;
+    }
+    return decoder;
+}
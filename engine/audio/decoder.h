@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stddef.h>
+
+// Incremental decoder over a whole file held in memory (normally a file
+// mapping, so only the parts read so far are paged in). Produces
+// interleaved float frames, mono or stereo.
+class AudioDecoder
+{
+public:
+    virtual ~AudioDecoder() {}
+
+    int channels = 0;
+    int sampleRate = 0;
+
+    // Decodes up to 'frames' frames into 'out'. Returns the number
+    // decoded, 0 at the end of the file, or -1 if the data is corrupt.
+    virtual int read(float *out, int frames) = 0;
+
+    // Back to the first frame, for looping
+    virtual bool rewind() = 0;
+};
+
+// Pick a decoder by the file's signature. Ogg Vorbis needs libvorbisfile
+// at build time (TONIC_VORBIS); WAV is always available. Returns nullptr
+// for unrecognised or unsupported files.
+AudioDecoder *OpenAudioDecoder(const void *data, size_t size);
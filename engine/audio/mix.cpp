@@ -0,0 +1,216 @@
+#include "mix.h"
+
+#include "../math/simd.h"
+
+#define FRACTION_SCALE (1.0f / 4294967296.0f)
+
+uint64_t MixMonoScalar(float *left, float *right, int count, const float *source,
+                       uint64_t position, uint64_t step, const MixGain &gain)
+{
+    float gainL = gain.left, gainR = gain.right;
+    for (int i = 0; i < count; i++)
+    {
+        const float *frame = source + (position >> 32);
+        float fraction = (uint32_t)position * FRACTION_SCALE;
+        float sample = frame[0] + (frame[1] - frame[0]) * fraction;
+
+        left[i] += sample * gainL;
+        right[i] += sample * gainR;
+        gainL += gain.leftStep;
+        gainR += gain.rightStep;
+        position += step;
+    }
+    return position;
+}
+
+uint64_t MixStereoScalar(float *left, float *right, int count, const float *source,
+                         uint64_t position, uint64_t step, const MixGain &gain)
+{
+    float gainL = gain.left, gainR = gain.right;
+    for (int i = 0; i < count; i++)
+    {
+        const float *frame = source + (position >> 32) * 2;
+        float fraction = (uint32_t)position * FRACTION_SCALE;
+        float sampleL = frame[0] + (frame[2] - frame[0]) * fraction;
+        float sampleR = frame[1] + (frame[3] - frame[1]) * fraction;
+
+        left[i] += sampleL * gainL;
+        right[i] += sampleR * gainR;
+        gainL += gain.leftStep;
+        gainR += gain.rightStep;
+        position += step;
+    }
+    return position;
+}
+
+#ifdef TONIC_SSE2
+// Gains for four consecutive frames, and the step between groups of four
+static void RampGains(const MixGain &gain, __m128 &left, __m128 &right, __m128 &leftStep, __m128 &rightStep)
+{
+    __m128 ramp = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    left = _mm_add_ps(_mm_set1_ps(gain.left), _mm_mul_ps(ramp, _mm_set1_ps(gain.leftStep)));
+    right = _mm_add_ps(_mm_set1_ps(gain.right), _mm_mul_ps(ramp, _mm_set1_ps(gain.rightStep)));
+    leftStep = _mm_set1_ps(gain.leftStep * 4.0f);
+    rightStep = _mm_set1_ps(gain.rightStep * 4.0f);
+}
+
+// Fractional parts of the positions of four consecutive frames, as
+// 32-bit integers. These wrap at each whole frame exactly as the low half
+// of the fixed point positions do, so they can be stepped with a vector add.
+static void Fractions(uint64_t position, uint64_t step, __m128i &fraction, __m128i &fractionStep)
+{
+    fraction = _mm_setr_epi32((int)(uint32_t)position, (int)(uint32_t)(position + step),
+                              (int)(uint32_t)(position + step * 2), (int)(uint32_t)(position + step * 3));
+    fractionStep = _mm_set1_epi32((int)(uint32_t)(step * 4));
+}
+
+// SSE2 only converts signed integers: flip the top bit to make the value
+// signed, convert, and add the offset back
+static __m128 FractionToFloat(__m128i fraction)
+{
+    __m128i flipped = _mm_xor_si128(fraction, _mm_set1_epi32((int)0x80000000));
+    __m128 value = _mm_add_ps(_mm_cvtepi32_ps(flipped), _mm_set1_ps(2147483648.0f));
+    return _mm_mul_ps(value, _mm_set1_ps(FRACTION_SCALE));
+}
+
+// Where the vector loop stopped, for the scalar loop to carry on from
+static MixGain RemainingGain(const MixGain &gain, int done)
+{
+    return MixGain{ gain.left + gain.leftStep * done, gain.right + gain.rightStep * done, gain.leftStep, gain.rightStep };
+}
+#endif
+
+uint64_t MixMono(float *left, float *right, int count, const float *source,
+                 uint64_t position, uint64_t step, const MixGain &gain)
+{
+#ifdef TONIC_SSE2
+    __m128 gainL, gainR, gainStepL, gainStepR;
+    RampGains(gain, gainL, gainR, gainStepL, gainStepR);
+
+    int i = 0;
+    if (step == MIX_POSITION_ONE && (uint32_t)position == 0)
+    {
+        // Same rate and on a frame boundary: plain loads, no interpolation
+        const float *frames = source + (position >> 32);
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 sample = _mm_loadu_ps(frames + i);
+            _mm_storeu_ps(left + i, _mm_add_ps(_mm_loadu_ps(left + i), _mm_mul_ps(sample, gainL)));
+            _mm_storeu_ps(right + i, _mm_add_ps(_mm_loadu_ps(right + i), _mm_mul_ps(sample, gainR)));
+            gainL = _mm_add_ps(gainL, gainStepL);
+            gainR = _mm_add_ps(gainR, gainStepR);
+        }
+        position += (uint64_t)i << 32;
+    }
+    else
+    {
+        __m128i fraction, fractionStep;
+        Fractions(position, step, fraction, fractionStep);
+        for (; i + 4 <= count; i += 4)
+        {
+            // The gather stays scalar; the interpolation and gains do not
+            const float *f0 = source + (position >> 32);
+            const float *f1 = source + ((position + step) >> 32);
+            const float *f2 = source + ((position + step * 2) >> 32);
+            const float *f3 = source + ((position + step * 3) >> 32);
+            position += step * 4;
+
+            __m128 first = _mm_setr_ps(f0[0], f1[0], f2[0], f3[0]);
+            __m128 second = _mm_setr_ps(f0[1], f1[1], f2[1], f3[1]);
+            __m128 t = FractionToFloat(fraction);
+            fraction = _mm_add_epi32(fraction, fractionStep);
+
+            __m128 sample = _mm_add_ps(first, _mm_mul_ps(_mm_sub_ps(second, first), t));
+            _mm_storeu_ps(left + i, _mm_add_ps(_mm_loadu_ps(left + i), _mm_mul_ps(sample, gainL)));
+            _mm_storeu_ps(right + i, _mm_add_ps(_mm_loadu_ps(right + i), _mm_mul_ps(sample, gainR)));
+            gainL = _mm_add_ps(gainL, gainStepL);
+            gainR = _mm_add_ps(gainR, gainStepR);
+        }
+    }
+
+    return MixMonoScalar(left + i, right + i, count - i, source, position, step, RemainingGain(gain, i));
+#else
+    return MixMonoScalar(left, right, count, source, position, step, gain);
+#endif
+}
+
+uint64_t MixStereo(float *left, float *right, int count, const float *source,
+                   uint64_t position, uint64_t step, const MixGain &gain)
+{
+#ifdef TONIC_SSE2
+    __m128 gainL, gainR, gainStepL, gainStepR;
+    RampGains(gain, gainL, gainR, gainStepL, gainStepR);
+
+    int i = 0;
+    if (step == MIX_POSITION_ONE && (uint32_t)position == 0)
+    {
+        const float *frames = source + (position >> 32) * 2;
+        for (; i + 4 <= count; i += 4)
+        {
+            // Four interleaved frames, split into left and right
+            __m128 low = _mm_loadu_ps(frames + i * 2);
+            __m128 high = _mm_loadu_ps(frames + i * 2 + 4);
+            __m128 sampleL = _mm_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 sampleR = _mm_shuffle_ps(low, high, _MM_SHUFFLE(3, 1, 3, 1));
+            _mm_storeu_ps(left + i, _mm_add_ps(_mm_loadu_ps(left + i), _mm_mul_ps(sampleL, gainL)));
+            _mm_storeu_ps(right + i, _mm_add_ps(_mm_loadu_ps(right + i), _mm_mul_ps(sampleR, gainR)));
+            gainL = _mm_add_ps(gainL, gainStepL);
+            gainR = _mm_add_ps(gainR, gainStepR);
+        }
+        position += (uint64_t)i << 32;
+    }
+    else
+    {
+        __m128i fraction, fractionStep;
+        Fractions(position, step, fraction, fractionStep);
+        for (; i + 4 <= count; i += 4)
+        {
+            const float *f0 = source + (position >> 32) * 2;
+            const float *f1 = source + ((position + step) >> 32) * 2;
+            const float *f2 = source + ((position + step * 2) >> 32) * 2;
+            const float *f3 = source + ((position + step * 3) >> 32) * 2;
+            position += step * 4;
+
+            __m128 t = FractionToFloat(fraction);
+            fraction = _mm_add_epi32(fraction, fractionStep);
+
+            __m128 firstL = _mm_setr_ps(f0[0], f1[0], f2[0], f3[0]);
+            __m128 firstR = _mm_setr_ps(f0[1], f1[1], f2[1], f3[1]);
+            __m128 secondL = _mm_setr_ps(f0[2], f1[2], f2[2], f3[2]);
+            __m128 secondR = _mm_setr_ps(f0[3], f1[3], f2[3], f3[3]);
+            __m128 sampleL = _mm_add_ps(firstL, _mm_mul_ps(_mm_sub_ps(secondL, firstL), t));
+            __m128 sampleR = _mm_add_ps(firstR, _mm_mul_ps(_mm_sub_ps(secondR, firstR), t));
+            _mm_storeu_ps(left + i, _mm_add_ps(_mm_loadu_ps(left + i), _mm_mul_ps(sampleL, gainL)));
+            _mm_storeu_ps(right + i, _mm_add_ps(_mm_loadu_ps(right + i), _mm_mul_ps(sampleR, gainR)));
+            gainL = _mm_add_ps(gainL, gainStepL);
+            gainR = _mm_add_ps(gainR, gainStepR);
+        }
+    }
+
+    return MixStereoScalar(left + i, right + i, count - i, source, position, step, RemainingGain(gain, i));
+#else
+    return MixStereoScalar(left, right, count, source, position, step, gain);
+#endif
+}
+
+void InterleaveStereo(const float *left, const float *right, int count, float gain, float *out)
+{
+    int i = 0;
+#ifdef TONIC_SSE2
+    __m128 scale = _mm_set1_ps(gain);
+    __m128 low = _mm_set1_ps(-1.0f), high = _mm_set1_ps(1.0f);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 l = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(left + i), scale), low), high);
+        __m128 r = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(right + i), scale), low), high);
+        _mm_storeu_ps(out + i * 2, _mm_unpacklo_ps(l, r));
+        _mm_storeu_ps(out + i * 2 + 4, _mm_unpackhi_ps(l, r));
+    }
+#endif
+    for (; i < count; i++)
+    {
+        float l = left[i] * gain, r = right[i] * gain;
+        out[i * 2] = l < -1.0f ? -1.0f : (l > 1.0f ? 1.0f : l);
+        out[i * 2 + 1] = r < -1.0f ? -1.0f : (r > 1.0f ? 1.0f : r);
+    }
+}
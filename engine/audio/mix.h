@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdint.h>
+
+// Inner loops of the mixer. Voices are summed into separate left and
+// right float buffers, which are interleaved once at the end.
+//
+// Source positions are 32.32 fixed point, in source frames, so a voice
+// can be resampled by any ratio without drifting: 'step' is the distance
+// moved per output frame, 1 << 32 when the rates match. Samples between
+// two source frames are linearly interpolated, so the frame after the
+// last one read must exist (Sound keeps a silent frame at the end).
+
+#define MIX_POSITION_ONE ((uint64_t)1 << 32)
+
+// Gains applied to a voice, ramped linearly by the given amount per
+// output frame so volume and pan changes do not click
+struct MixGain
+{
+    float left, right;
+    float leftStep, rightStep;
+};
+
+// Add 'count' output frames of a mono or interleaved stereo source to
+// 'left' and 'right'. Return the position after the last frame. Stereo
+// sources keep their channels apart, the gains acting as a balance.
+uint64_t MixMono(float *left, float *right, int count, const float *source,
+                 uint64_t position, uint64_t step, const MixGain &gain);
+uint64_t MixStereo(float *left, float *right, int count, const float *source,
+                   uint64_t position, uint64_t step, const MixGain &gain);
+
+// Plain C++ versions, used where SSE2 is unavailable and kept as the
+// reference the SIMD ones are measured against
+uint64_t MixMonoScalar(float *left, float *right, int count, const float *source,
+                       uint64_t position, uint64_t step, const MixGain &gain);
+uint64_t MixStereoScalar(float *left, float *right, int count, const float *source,
+                         uint64_t position, uint64_t step, const MixGain &gain);
+
+// Scales, clamps to [-1, 1] and interleaves the mix buffers
+void InterleaveStereo(const float *left, const float *right, int count, float gain, float *out);
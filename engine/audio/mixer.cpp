@@ -0,0 +1,377 @@
+#include "mixer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+
+// Pitch is kept above this so a voice always moves forward
+#define MIN_PITCH 0.01f
+
+AudioMixer::AudioMixer(AudioSink *sink) : sink(sink), sampleRate(sink->getSampleRate())
+{
+}
+
+AudioMixer::~AudioMixer()
+{
+    stopThread();
+    delete sink;
+}
+
+void AudioMixer::startThread()
+{
+    if (running)
+        return;
+
+    running = true;
+    thread = std::thread(&AudioMixer::run, this);
+}
+
+void AudioMixer::stopThread()
+{
+    if (!running)
+        return;
+
+    running = false;
+    thread.join();
+}
+
+void AudioMixer::run()
+{
+    int frames = sink->getFramesPerBuffer();
+    output.resize((size_t)frames * 2);
+
+    while (running)
+    {
+        mix(output.data(), frames);
+
+        // A failed device would otherwise have the thread spin
+        if (!sink->write(output.data(), frames))
+            std::this_thread::sleep_for(std::chrono::microseconds((long long)frames * 1000000 / sampleRate));
+    }
+}
+
+void AudioMixer::send(const AudioCommand &command)
+{
+    if (!commands.push(command))
+        dropped++;
+}
+
+VoiceId AudioMixer::play(const Sound *sound, float volume, float pan, float pitch, bool loop)
+{
+    VoiceId id = nextVoice++;
+    if (nextVoice == 0)
+        nextVoice = 1;
+
+    // Like a stream's reference, counted before the command is queued
+    sound->voices++;
+    if (!commands.push(AudioCommand{AUDIO_PLAY, id, sound, nullptr, volume, pan, pitch, loop}))
+    {
+        sound->voices--;
+        dropped++;
+    }
+    return id;
+}
+
+VoiceId AudioMixer::playStream(AudioStream *stream, float volume, float pan, float pitch)
+{
+    VoiceId id = nextVoice++;
+    if (nextVoice == 0)
+        nextVoice = 1;
+
+    // The voice's reference, taken now so the stream cannot be freed
+    // while the command is queued
+    stream->references++;
+    if (!commands.push(AudioCommand{AUDIO_PLAY, id, nullptr, stream, volume, pan, pitch, false}))
+    {
+        stream->references--;
+        dropped++;
+    }
+    return id;
+}
+
+void AudioMixer::stop(VoiceId voice)
+{
+    send(AudioCommand{AUDIO_STOP, voice, nullptr, nullptr, 0.0f, 0.0f, 0.0f, false});
+}
+
+void AudioMixer::setVolume(VoiceId voice, float volume)
+{
+    send(AudioCommand{AUDIO_SET_VOLUME, voice, nullptr, nullptr, volume, 0.0f, 0.0f, false});
+}
+
+void AudioMixer::setPan(VoiceId voice, float pan)
+{
+    send(AudioCommand{AUDIO_SET_PAN, voice, nullptr, nullptr, pan, 0.0f, 0.0f, false});
+}
+
+void AudioMixer::setPitch(VoiceId voice, float pitch)
+{
+    send(AudioCommand{AUDIO_SET_PITCH, voice, nullptr, nullptr, pitch, 0.0f, 0.0f, false});
+}
+
+void AudioMixer::setMasterVolume(float volume)
+{
+    send(AudioCommand{AUDIO_SET_MASTER_VOLUME, 0, nullptr, nullptr, volume, 0.0f, 0.0f, false});
+}
+
+void AudioMixer::releaseVoice(int index)
+{
+    if (voices[index].sound)
+        voices[index].sound->voices--;
+    if (voices[index].stream)
+        voices[index].stream->references--;
+    voices[index] = voices[--voiceCount];
+}
+
+AudioMixer::Voice *AudioMixer::findVoice(VoiceId id)
+{
+    for (int i = 0; i < voiceCount; i++)
+    {
+        if (voices[i].id == id)
+            return &voices[i];
+    }
+    return nullptr;
+}
+
+// Constant power panning for mono sources, so a sound is as loud in the
+// middle as at either side. Stereo sources are balanced instead: the far
+// channel is turned down and the near one left alone.
+static void PanGains(int channels, float volume, float pan, float &left, float &right)
+{
+    pan = std::max(-1.0f, std::min(pan, 1.0f));
+    if (channels == 1)
+    {
+        float angle = (pan + 1.0f) * 0.25f * 3.14159265f;
+        left = cosf(angle) * volume;
+        right = sinf(angle) * volume;
+    }
+    else
+    {
+        left = std::min(1.0f, 1.0f - pan) * volume;
+        right = std::min(1.0f, 1.0f + pan) * volume;
+    }
+}
+
+void AudioMixer::apply(const AudioCommand &command)
+{
+    if (command.type == AUDIO_SET_MASTER_VOLUME)
+    {
+        masterVolume = command.value;
+        return;
+    }
+
+    if (command.type == AUDIO_PLAY)
+    {
+        const Sound *sound = command.sound;
+        AudioStream *stream = command.stream;
+        int channels = sound ? sound->channels : stream->getChannels();
+        if (voiceCount == AUDIO_MAX_VOICES || (sound && sound->frames == 0) || (channels != 1 && channels != 2))
+        {
+            if (voiceCount == AUDIO_MAX_VOICES)
+                dropped++;
+            if (sound)
+                sound->voices--;
+            if (stream)
+                stream->references--;
+            return;
+        }
+
+        // Starts at full gain: a fade in would blunt the attack
+        Voice &voice = voices[voiceCount++];
+        voice.id = command.voice;
+        voice.sound = sound;
+        voice.stream = stream;
+        voice.position = 0;
+        voice.volume = command.value;
+        voice.pan = command.pan;
+        voice.pitch = std::max(command.pitch, MIN_PITCH);
+        voice.loop = command.loop;
+        voice.stopping = false;
+        PanGains(channels, voice.volume, voice.pan, voice.gainL, voice.gainR);
+        return;
+    }
+
+    // The voice may have finished already; that is not an error
+    Voice *voice = findVoice(command.voice);
+    if (!voice)
+        return;
+
+    switch (command.type)
+    {
+    case AUDIO_STOP:
+        voice->stopping = true;
+        break;
+    case AUDIO_SET_VOLUME:
+        voice->volume = command.value;
+        break;
+    case AUDIO_SET_PAN:
+        voice->pan = command.value;
+        break;
+    case AUDIO_SET_PITCH:
+        voice->pitch = std::max(command.value, MIN_PITCH);
+        break;
+    default:
+        break;
+    }
+}
+
+// Returns true once a one-shot sound has played to the end
+bool AudioMixer::mixSound(Voice &voice, const MixGain &gain, int frames)
+{
+    const Sound &sound = *voice.sound;
+    uint64_t step = (uint64_t)((double)voice.pitch * sound.sampleRate / sampleRate * MIX_POSITION_ONE);
+    uint64_t end = (uint64_t)sound.frames << 32;
+
+    // Mixed in runs that stop at the end of the sound, to loop or finish
+    // there
+    int done = 0;
+    while (done < frames)
+    {
+        if (voice.position >= end)
+        {
+            if (!voice.loop)
+                return true;
+            voice.position %= end;
+        }
+
+        uint64_t available = (end - voice.position + step - 1) / step;
+        int count = (int)std::min<uint64_t>(available, (uint64_t)(frames - done));
+        MixGain part = { gain.left + gain.leftStep * done, gain.right + gain.rightStep * done, gain.leftStep, gain.rightStep };
+
+        if (sound.channels == 1)
+            voice.position = MixMono(&mixLeft[done], &mixRight[done], count, sound.samples.data(), voice.position, step, part);
+        else
+            voice.position = MixStereo(&mixLeft[done], &mixRight[done], count, sound.samples.data(), voice.position, step, part);
+        done += count;
+    }
+    return false;
+}
+
+// Streams are mixed from a window of frames taken out of the ring: the
+// position is relative to its first frame, and frames already played are
+// dropped from the front after each buffer. Returns true once the stream
+// has played to the end.
+bool AudioMixer::mixStream(Voice &voice, const MixGain &gain, int frames)
+{
+    AudioStream &stream = *voice.stream;
+    if (!stream.primed)
+        return false;
+
+    int channels = stream.getChannels();
+    uint64_t step = (uint64_t)((double)voice.pitch * stream.getSampleRate() / sampleRate * MIX_POSITION_ONE);
+
+    // Interpolating the last output frame reads the source frame after it
+    int needed = (int)((voice.position + step * (frames - 1)) >> 32) + 2;
+    if ((int)stream.window.size() < needed * channels)
+        stream.window.resize((size_t)needed * channels);
+
+    if (stream.windowFrames < needed)
+        stream.windowFrames += stream.pull(&stream.window[(size_t)stream.windowFrames * channels], needed - stream.windowFrames);
+
+    if (stream.windowFrames < needed)
+    {
+        if (!stream.ended || stream.readFrame != stream.writeFrame)
+        {
+            // Decoding fell behind. Play what there is and leave the rest
+            // of the buffer silent; the track carries on where it stopped.
+            stream.underruns++;
+            streamUnderruns++;
+        }
+        else if (!stream.padded)
+        {
+            // The real end: a silent frame to interpolate the last one
+            // towards, as Sound has
+            std::fill(&stream.window[(size_t)stream.windowFrames * channels], &stream.window[(size_t)(stream.windowFrames + 1) * channels], 0.0f);
+            stream.windowFrames++;
+            stream.padded = true;
+        }
+    }
+
+    int count = frames;
+    if (stream.windowFrames < needed)
+    {
+        uint64_t end = stream.windowFrames >= 2 ? (uint64_t)(stream.windowFrames - 1) << 32 : 0;
+        count = voice.position < end ? (int)std::min<uint64_t>((end - voice.position + step - 1) / step, (uint64_t)frames) : 0;
+    }
+
+    if (channels == 1)
+        voice.position = MixMono(mixLeft.data(), mixRight.data(), count, stream.window.data(), voice.position, step, gain);
+    else
+        voice.position = MixStereo(mixLeft.data(), mixRight.data(), count, stream.window.data(), voice.position, step, gain);
+
+    int consumed = std::min((int)(voice.position >> 32), stream.windowFrames);
+    if (consumed > 0)
+    {
+        std::copy(stream.window.begin() + (size_t)consumed * channels, stream.window.begin() + (size_t)stream.windowFrames * channels, stream.window.begin());
+        stream.windowFrames -= consumed;
+        voice.position -= (uint64_t)consumed << 32;
+    }
+
+    return stream.padded && stream.windowFrames <= 1;
+}
+
+void AudioMixer::mix(float *out, int frames)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    AudioCommand command;
+    while (commands.pop(command))
+        apply(command);
+
+    if ((int)mixLeft.size() < frames)
+    {
+        mixLeft.resize(frames);
+        mixRight.resize(frames);
+    }
+    std::fill(mixLeft.begin(), mixLeft.begin() + frames, 0.0f);
+    std::fill(mixRight.begin(), mixRight.begin() + frames, 0.0f);
+
+    for (int v = 0; v < voiceCount;)
+    {
+        Voice &voice = voices[v];
+        int channels = voice.sound ? voice.sound->channels : voice.stream->getChannels();
+
+        // Ramp from last buffer's gains to the new ones; stopping voices
+        // fade out over this buffer
+        float targetL = 0.0f, targetR = 0.0f;
+        if (!voice.stopping)
+            PanGains(channels, voice.volume, voice.pan, targetL, targetR);
+        MixGain gain = { voice.gainL, voice.gainR, (targetL - voice.gainL) / frames, (targetR - voice.gainR) / frames };
+
+        bool finished = voice.sound ? mixSound(voice, gain, frames) : mixStream(voice, gain, frames);
+        voice.gainL = targetL;
+        voice.gainR = targetR;
+
+        if (finished || voice.stopping)
+        {
+            releaseVoice(v);
+            continue;
+        }
+        v++;
+    }
+
+    InterleaveStereo(mixLeft.data(), mixRight.data(), frames, masterVolume, out);
+
+    float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    lastMixMs.store(ms, std::memory_order_relaxed);
+    averageMixMs.store(averageMixMs.load(std::memory_order_relaxed) * 0.95f + ms * 0.05f, std::memory_order_relaxed);
+    if (ms > peakMixMs.load(std::memory_order_relaxed))
+        peakMixMs.store(ms, std::memory_order_relaxed);
+    activeVoices.store(voiceCount, std::memory_order_relaxed);
+    buffersMixed.fetch_add(1, std::memory_order_relaxed);
+}
+
+AudioStats AudioMixer::getStats() const
+{
+    AudioStats stats;
+    stats.lastMixMs = lastMixMs.load(std::memory_order_relaxed);
+    stats.averageMixMs = averageMixMs.load(std::memory_order_relaxed);
+    stats.peakMixMs = peakMixMs.load(std::memory_order_relaxed);
+    stats.bufferMs = sink->getFramesPerBuffer() * 1000.0f / sampleRate;
+    stats.activeVoices = activeVoices.load(std::memory_order_relaxed);
+    stats.buffersMixed = buffersMixed.load(std::memory_order_relaxed);
+    stats.droppedCommands = dropped.load(std::memory_order_relaxed);
+    stats.underruns = sink->getUnderrunCount();
+    stats.streamUnderruns = streamUnderruns.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "audio-sink.h"
+#include "mix.h"
+#include "sound.h"
+#include "stream.h"
+#include "../spsc-queue.h"
+
+#include <atomic>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+#define AUDIO_SAMPLE_RATE 48000
+#define AUDIO_FRAMES_PER_BUFFER 512 // about 10.7 ms at 48 kHz
+
+#define AUDIO_MAX_VOICES 256
+#define AUDIO_COMMAND_QUEUE_SIZE 1024
+
+// Identifies one playback of a sound; never reused. 0 is no voice.
+typedef uint32_t VoiceId;
+
+enum AudioCommandType
+{
+    AUDIO_PLAY,
+    AUDIO_STOP,
+    AUDIO_SET_VOLUME,
+    AUDIO_SET_PAN,
+    AUDIO_SET_PITCH,
+    AUDIO_SET_MASTER_VOLUME
+};
+
+struct AudioCommand
+{
+    AudioCommandType type;
+    VoiceId voice;
+    const Sound *sound;
+    AudioStream *stream;
+    float value; // volume, pan or pitch
+    float pan, pitch;
+    bool loop;
+};
+
+// Mixer timings, in milliseconds of CPU time per buffer
+struct AudioStats
+{
+    float lastMixMs;
+    float averageMixMs;
+    float peakMixMs;
+    float bufferMs; // audio time per buffer; mixing must stay well under it
+    int activeVoices;
+    unsigned int buffersMixed;
+    unsigned int droppedCommands; // queue full, or no voice free
+    unsigned int underruns;       // the sink ran dry
+    unsigned int streamUnderruns; // a stream's decoding fell behind
+};
+
+// Software mixer running on its own thread.
+//
+// The game thread never touches voice state: play(), stop() and the
+// setters only push commands onto a lock-free queue, which the mixer
+// thread drains at the start of every buffer. So a slow frame cannot hold
+// up the audio, and the audio thread never waits on a lock. Commands are
+// therefore applied up to one buffer late, and must all come from one
+// thread.
+//
+// Voices are resampled to the output rate, panned, and summed with SSE.
+// Gain changes are ramped across a buffer so they do not click.
+class AudioMixer
+{
+private:
+    struct Voice
+    {
+        VoiceId id;
+        const Sound *sound;
+        AudioStream *stream; // instead of 'sound'
+        uint64_t position;   // 32.32 fixed point, in source frames
+        float volume, pan, pitch;
+        float gainL, gainR; // as of the end of the last buffer
+        bool loop;
+        bool stopping;      // fading out over this buffer
+    };
+
+    AudioSink *sink;
+    int sampleRate;
+
+    SpscQueue<AudioCommand, AUDIO_COMMAND_QUEUE_SIZE> commands;
+    VoiceId nextVoice = 1; // game thread
+
+    // Mixer thread only
+    Voice voices[AUDIO_MAX_VOICES];
+    int voiceCount = 0;
+    float masterVolume = 1.0f;
+    std::vector<float> mixLeft, mixRight, output;
+
+    std::thread thread;
+    std::atomic<bool> running{false};
+
+    // Written by the mixer thread, read by getStats()
+    std::atomic<float> lastMixMs{0.0f}, averageMixMs{0.0f}, peakMixMs{0.0f};
+    std::atomic<int> activeVoices{0};
+    std::atomic<unsigned int> buffersMixed{0};
+    std::atomic<unsigned int> streamUnderruns{0};
+
+    // Commands that did not fit in the queue, and plays refused because
+    // every voice was busy
+    std::atomic<unsigned int> dropped{0};
+
+    void send(const AudioCommand &command);
+    void apply(const AudioCommand &command);
+    Voice *findVoice(VoiceId id);
+    void releaseVoice(int index);
+    bool mixSound(Voice &voice, const MixGain &gain, int frames);
+    bool mixStream(Voice &voice, const MixGain &gain, int frames);
+    void run();
+
+public:
+    // Takes ownership of the sink
+    explicit AudioMixer(AudioSink *sink);
+    ~AudioMixer();
+
+    // Starts and stops the mixer thread
+    void startThread();
+    void stopThread();
+
+    // The voice counts itself in sound->voices until it has stopped, and
+    // the asset cache keeps a sound loaded while that is above 0; a sound
+    // from anywhere else must outlive its voices. 'pan' runs
+    // from -1 (left) to 1 (right); 'pitch' scales the playback rate.
+    VoiceId play(const Sound *sound, float volume = 1.0f, float pan = 0.0f, float pitch = 1.0f, bool loop = false);
+
+    // Plays a stream from an AudioStreamer; whether it loops was chosen
+    // when it was opened. Playback waits for the first chunk to be
+    // decoded rather than starting with an underrun.
+    VoiceId playStream(AudioStream *stream, float volume = 1.0f, float pan = 0.0f, float pitch = 1.0f);
+    void stop(VoiceId voice);
+    void setVolume(VoiceId voice, float volume);
+    void setPan(VoiceId voice, float pan);
+    void setPitch(VoiceId voice, float pitch);
+    void setMasterVolume(float volume);
+
+    // Runs one buffer's worth of mixing into 'out' (interleaved stereo)
+    // on the calling thread. This is what the mixer thread does; it is
+    // public for offline rendering and benchmarks, and must not be called
+    // while the thread is running.
+    void mix(float *out, int frames);
+
+    int getSampleRate() const { return sampleRate; }
+    AudioStats getStats() const;
+};
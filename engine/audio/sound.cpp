@@ -0,0 +1,16 @@
+#include "sound.h"
+#include "wav.h"
+
+bool LoadSound(const void *file, size_t size, Sound &sound)
+{
+    WavInfo info;
+    if (!ParseWav(file, size, info) || info.channels > 2)
+        return false;
+
+    sound.channels = info.channels;
+    sound.sampleRate = info.sampleRate;
+    sound.frames = (int)info.frames;
+    sound.samples.assign(((size_t)info.frames + 1) * info.channels, 0.0f);
+    WavToFloat(info, info.data, info.frames, sound.samples.data());
+    return true;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <vector>
+
+// A whole clip decoded to float samples in memory, for short sounds that
+// are played often. Mono or stereo, interleaved.
+struct Sound
+{
+    // Followed by one silent frame, so the mixer can interpolate past the
+    // last frame without checking for the end
+    std::vector<float> samples;
+
+    int channels = 0;
+    int sampleRate = 0;
+    int frames = 0;
+
+    // Voices playing it, queued plays included. The mixer takes one in
+    // play() and gives it back when the voice is released; the asset
+    // cache does not free a sound while any are left.
+    mutable std::atomic<int> voices{0};
+};
+
+// Decodes a WAV file held in memory. Returns false if it is not a WAV file
+// in a supported format, or has more than two channels.
+bool LoadSound(const void *file, size_t size, Sound &sound);
@@ -0,0 +1,179 @@
+#include "stream.h"
+#include "mixer.h"
+
+#include <algorithm>
+#include <string.h>
+
+AudioStream::AudioStream(AudioDecoder *decoder, bool loop, float prefetchSeconds) : decoder(decoder), loop(loop)
+{
+    // At least two chunks, so one can be decoded while the other plays
+    uint32_t frames = std::max((uint32_t)(prefetchSeconds * decoder->sampleRate), (uint32_t)AUDIO_STREAM_CHUNK_FRAMES * 2);
+    capacity = 1;
+    while (capacity < frames)
+        capacity *= 2;
+    ring.resize((size_t)capacity * decoder->channels);
+
+    // Enough for a buffer at the output rate; the mixer grows it if a
+    // high pitch or sample rate needs more
+    window.resize((size_t)(AUDIO_FRAMES_PER_BUFFER * 2 + 2) * decoder->channels);
+}
+
+AudioStream::~AudioStream()
+{
+    delete decoder;
+    if (file)
+        platform->UnmapFile(file, fileSize);
+}
+
+void AudioStream::fill(std::vector<float> &chunk)
+{
+    int channels = decoder->channels;
+    while (!ended)
+    {
+        uint32_t write = writeFrame.load(std::memory_order_relaxed);
+        uint32_t space = capacity - (write - readFrame.load(std::memory_order_acquire));
+        if (space < AUDIO_STREAM_CHUNK_FRAMES)
+            return;
+
+        int count = decoder->read(chunk.data(), AUDIO_STREAM_CHUNK_FRAMES);
+        if (count == 0 && loop)
+            count = decoder->rewind() ? decoder->read(chunk.data(), AUDIO_STREAM_CHUNK_FRAMES) : -1;
+        if (count <= 0)
+        {
+            ended = true;
+            primed = true;
+            return;
+        }
+
+        uint32_t start = write & (capacity - 1);
+        uint32_t first = std::min((uint32_t)count, capacity - start);
+        memcpy(&ring[(size_t)start * channels], chunk.data(), (size_t)first * channels * sizeof(float));
+        memcpy(&ring[0], chunk.data() + (size_t)first * channels, (size_t)(count - first) * channels * sizeof(float));
+
+        writeFrame.store(write + (uint32_t)count, std::memory_order_release);
+        primed = true;
+    }
+}
+
+int AudioStream::pull(float *out, int frames)
+{
+    int channels = decoder->channels;
+    uint32_t read = readFrame.load(std::memory_order_relaxed);
+    uint32_t available = writeFrame.load(std::memory_order_acquire) - read;
+    uint32_t count = std::min((uint32_t)frames, available);
+
+    uint32_t start = read & (capacity - 1);
+    uint32_t first = std::min(count, capacity - start);
+    memcpy(out, &ring[(size_t)start * channels], (size_t)first * channels * sizeof(float));
+    memcpy(out + (size_t)first * channels, &ring[0], (size_t)(count - first) * channels * sizeof(float));
+
+    readFrame.store(read + count, std::memory_order_release);
+    return (int)count;
+}
+
+AudioStreamer::AudioStreamer(Platform *platform) : platform(platform)
+{
+    thread = std::thread(&AudioStreamer::run, this);
+}
+
+AudioStreamer::~AudioStreamer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    wake.notify_one();
+    thread.join();
+
+    for (AudioStream *stream : streams)
+        delete stream;
+    for (AudioStream *stream : pending)
+        delete stream;
+}
+
+AudioStream *AudioStreamer::add(AudioStream *stream)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(stream);
+    }
+
+    // Start decoding now rather than at the next wakeup
+    wake.notify_one();
+    return stream;
+}
+
+AudioStream *AudioStreamer::open(const std::string &path, bool loop, float prefetchSeconds)
+{
+    size_t size;
+    const void *data = platform->MapFile(path, &size);
+    if (!data)
+        return nullptr;
+
+    AudioDecoder *decoder = OpenAudioDecoder(data, size);
+    if (!decoder)
+    {
+        platform->Log("Error: '%s' is not a supported audio file\n", path.c_str());
+        platform->UnmapFile(data, size);
+        return nullptr;
+    }
+
+    AudioStream *stream = new AudioStream(decoder, loop, prefetchSeconds);
+    stream->platform = platform;
+    stream->file = data;
+    stream->fileSize = size;
+    return add(stream);
+}
+
+AudioStream *AudioStreamer::openMemory(const void *data, size_t size, bool loop, float prefetchSeconds)
+{
+    AudioDecoder *decoder = OpenAudioDecoder(data, size);
+    if (!decoder)
+    {
+        platform->Log("Error: not a supported audio file\n");
+        return nullptr;
+    }
+
+    return add(new AudioStream(decoder, loop, prefetchSeconds));
+}
+
+void AudioStreamer::close(AudioStream *stream)
+{
+    stream->references--;
+}
+
+void AudioStreamer::run()
+{
+    std::vector<float> chunk((size_t)AUDIO_STREAM_CHUNK_FRAMES * 2);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running)
+    {
+        streams.insert(streams.end(), pending.begin(), pending.end());
+        pending.clear();
+        lock.unlock();
+
+        // Wake often enough that the stream with the shallowest prefetch
+        // is topped up well before it could run dry
+        float interval = AUDIO_STREAM_PREFETCH_SECONDS;
+        for (size_t i = 0; i < streams.size();)
+        {
+            AudioStream *stream = streams[i];
+            if (stream->references == 0)
+            {
+                delete stream;
+                streams[i] = streams.back();
+                streams.pop_back();
+                continue;
+            }
+
+            stream->fill(chunk);
+            interval = std::min(interval, (float)stream->capacity / stream->decoder->sampleRate);
+            i++;
+        }
+
+        lock.lock();
+        if (pending.empty() && running)
+            wake.wait_for(lock, std::chrono::duration<float>(interval * 0.25f));
+    }
+}
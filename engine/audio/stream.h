@@ -0,0 +1,127 @@
+#pragma once
+
+#include "decoder.h"
+#include "../platform.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Audio decoded ahead of the mixer, by default
+#define AUDIO_STREAM_PREFETCH_SECONDS 0.5f
+
+// Frames decoded at a time
+#define AUDIO_STREAM_CHUNK_FRAMES 4096
+
+// A long track played without decoding it all up front. A background
+// thread (AudioStreamer) decodes it a chunk at a time into a ring buffer,
+// staying up to the prefetch depth ahead of the mixer, which takes frames
+// out as it plays. The ring is single producer, single consumer and lock
+// free, so neither thread ever waits for the other.
+//
+// A stream is played by one voice, once (or looping). Open another to
+// play the track again.
+class AudioStream
+{
+    friend class AudioStreamer;
+    friend class AudioMixer;
+
+private:
+    AudioDecoder *decoder;
+    bool loop;
+
+    // The file mapping, if the streamer made it
+    Platform *platform = nullptr;
+    const void *file = nullptr;
+    size_t fileSize = 0;
+
+    // Decoded frames, interleaved; 'capacity' frames, a power of two.
+    // The frame counters run freely and are wrapped when indexing.
+    std::vector<float> ring;
+    uint32_t capacity;
+    std::atomic<uint32_t> readFrame{0}, writeFrame{0};
+
+    // The first chunk is in, so playback can begin without underrunning
+    std::atomic<bool> primed{false};
+
+    // The decoder has reached the end (not looping) or failed; nothing
+    // more will be written
+    std::atomic<bool> ended{false};
+
+    // The game's handle and the voice playing the stream each hold a
+    // reference; the streamer deletes the stream once both are gone
+    std::atomic<int> references{1};
+
+    // Mixer thread only: frames taken from the ring and not yet played.
+    // Resampling reads a frame or two ahead of the one it is on.
+    std::vector<float> window;
+    int windowFrames = 0;
+    bool padded = false;
+
+    std::atomic<unsigned int> underruns{0};
+
+    AudioStream(AudioDecoder *decoder, bool loop, float prefetchSeconds);
+
+    // Streamer thread: decode until the ring has no room for another
+    // chunk. 'chunk' is scratch space for one chunk.
+    void fill(std::vector<float> &chunk);
+
+    // Mixer thread: copy up to 'frames' frames out of the ring
+    int pull(float *out, int frames);
+
+public:
+    ~AudioStream();
+
+    int getChannels() const { return decoder->channels; }
+    int getSampleRate() const { return decoder->sampleRate; }
+
+    // Times the mixer found the ring empty before the end of the track
+    unsigned int getUnderrunCount() const { return underruns; }
+
+    // Frames decoded but not yet played, against the ring's capacity
+    int getBufferedFrames() const { return (int)(writeFrame - readFrame); }
+    int getCapacity() const { return (int)capacity; }
+
+    // Played to the end (never true when looping)
+    bool isFinished() const { return ended && writeFrame == readFrame; }
+};
+
+// Owns the decode thread for all open streams
+class AudioStreamer
+{
+private:
+    Platform *platform;
+
+    // Streams the decode thread services. New ones are handed over
+    // through 'pending', so the game thread only ever holds the lock for
+    // a push_back, never while decoding.
+    std::vector<AudioStream *> streams;
+    std::vector<AudioStream *> pending;
+    std::mutex mutex;
+    std::condition_variable wake;
+
+    std::thread thread;
+    bool running = true; // guarded by 'mutex'
+
+    AudioStream *add(AudioStream *stream);
+    void run();
+
+public:
+    explicit AudioStreamer(Platform *platform);
+    ~AudioStreamer();
+
+    // Maps the file and starts decoding it. Returns nullptr, having
+    // logged why, if it cannot be read or decoded.
+    AudioStream *open(const std::string &path, bool loop, float prefetchSeconds = AUDIO_STREAM_PREFETCH_SECONDS);
+
+    // As open(), for a file already in memory that outlives the stream
+    AudioStream *openMemory(const void *data, size_t size, bool loop, float prefetchSeconds = AUDIO_STREAM_PREFETCH_SECONDS);
+
+    // Gives up the game's handle. Stop the voice playing the stream
+    // first; the stream is freed once the mixer has let go of it too.
+    void close(AudioStream *stream);
+};
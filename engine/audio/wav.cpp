@@ -0,0 +1,186 @@
+#include "wav.h"
+
+#include <string.h>
+
+#define WAV_FORMAT_PCM 1
+#define WAV_FORMAT_FLOAT 3
+#define WAV_FORMAT_EXTENSIBLE 0xfffe
+
+static uint32_t Read16(const unsigned char *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8;
+}
+
+static uint32_t Read32(const unsigned char *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+bool ParseWav(const void *file, size_t size, WavInfo &info)
+{
+    const unsigned char *bytes = (const unsigned char *)file;
+    if (size < 12 || memcmp(bytes, "RIFF", 4) != 0 || memcmp(bytes + 8, "WAVE", 4) != 0)
+        return false;
+
+    bool haveFormat = false;
+    size_t offset = 12;
+    while (offset + 8 <= size)
+    {
+        const unsigned char *chunk = bytes + offset;
+        size_t length = Read32(chunk + 4);
+        const unsigned char *body = chunk + 8;
+        size_t available = size - offset - 8;
+
+        if (memcmp(chunk, "fmt ", 4) == 0)
+        {
+            if (length < 16 || length > available)
+                return false;
+
+            uint32_t tag = Read16(body);
+            info.channels = (int)Read16(body + 2);
+            info.sampleRate = (int)Read32(body + 4);
+            info.bytesPerFrame = (int)Read16(body + 12);
+            uint32_t bits = Read16(body + 14);
+
+            // Extensible files keep the real format tag at the start of
+            // their sub-format GUID
+            if (tag == WAV_FORMAT_EXTENSIBLE && length >= 26)
+                tag = Read16(body + 24);
+
+            if (tag == WAV_FORMAT_PCM && bits == 8)
+                info.format = WAV_PCM_U8;
+            else if (tag == WAV_FORMAT_PCM && bits == 16)
+                info.format = WAV_PCM_S16;
+            else if (tag == WAV_FORMAT_PCM && bits == 24)
+                info.format = WAV_PCM_S24;
+            else if (tag == WAV_FORMAT_PCM && bits == 32)
+                info.format = WAV_PCM_S32;
+            else if (tag == WAV_FORMAT_FLOAT && bits == 32)
+                info.format = WAV_FLOAT32;
+            else
+                return false;
+
+            if (info.channels <= 0 || info.sampleRate <= 0 || info.bytesPerFrame != info.channels * (int)bits / 8)
+                return false;
+            haveFormat = true;
+        }
+        else if (memcmp(chunk, "data", 4) == 0)
+        {
+            if (!haveFormat)
+                return false;
+
+            // Truncated files play what they have
+            if (length > available)
+                length = available;
+            info.frames = (uint32_t)(length / info.bytesPerFrame);
+            info.data = body;
+            return true;
+        }
+
+        // Chunks are padded to an even length
+        offset += 8 + length + (length & 1);
+    }
+
+    return false;
+}
+
+void WavToFloat(const WavInfo &info, const unsigned char *data, uint32_t frames, float *out)
+{
+    size_t count = (size_t)frames * info.channels;
+    switch (info.format)
+    {
+    case WAV_PCM_U8:
+        for (size_t i = 0; i < count; i++)
+            out[i] = ((int)data[i] - 128) * (1.0f / 128.0f);
+        break;
+
+    case WAV_PCM_S16:
+        for (size_t i = 0; i < count; i++)
+            out[i] = (int16_t)Read16(data + i * 2) * (1.0f / 32768.0f);
+        break;
+
+    case WAV_PCM_S24:
+        for (size_t i = 0; i < count; i++)
+        {
+            const unsigned char *p = data + i * 3;
+            int32_t value = (int32_t)((uint32_t)p[0] << 8 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 24) >> 8;
+            out[i] = value * (1.0f / 8388608.0f);
+        }
+        break;
+
+    case WAV_PCM_S32:
+        for (size_t i = 0; i < count; i++)
+            out[i] = (int32_t)Read32(data + i * 4) * (1.0f / 2147483648.0f);
+        break;
+
+    case WAV_FLOAT32:
+        for (size_t i = 0; i < count; i++)
+        {
+            uint32_t bits = Read32(data + i * 4);
+            memcpy(&out[i], &bits, sizeof(float));
+        }
+        break;
+    }
+}
+
+static void Write16(FILE *file, uint32_t value)
+{
+    unsigned char bytes[2] = { (unsigned char)value, (unsigned char)(value >> 8) };
+    fwrite(bytes, 1, 2, file);
+}
+
+static void Write32(FILE *file, uint32_t value)
+{
+    unsigned char bytes[4] = { (unsigned char)value, (unsigned char)(value >> 8),
+                               (unsigned char)(value >> 16), (unsigned char)(value >> 24) };
+    fwrite(bytes, 1, 4, file);
+}
+
+bool BeginWavFile(FILE *file, int sampleRate)
+{
+    fwrite("RIFF", 1, 4, file);
+    Write32(file, 0);
+    fwrite("WAVEfmt ", 1, 8, file);
+    Write32(file, 16);
+    Write16(file, WAV_FORMAT_PCM);
+    Write16(file, 2);
+    Write32(file, (uint32_t)sampleRate);
+    Write32(file, (uint32_t)sampleRate * 4);
+    Write16(file, 4);
+    Write16(file, 16);
+    fwrite("data", 1, 4, file);
+    Write32(file, 0);
+    return !ferror(file);
+}
+
+void WriteWavFrames(FILE *file, const float *interleaved, int frames)
+{
+    int16_t samples[512];
+    for (int i = 0; i < frames * 2; i += 512)
+    {
+        int count = frames * 2 - i < 512 ? frames * 2 - i : 512;
+        for (int j = 0; j < count; j++)
+        {
+            float value = interleaved[i + j];
+            value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+            int16_t sample = (int16_t)(value * 32767.0f);
+            unsigned char *bytes = (unsigned char *)&samples[j];
+            bytes[0] = (unsigned char)sample;
+            bytes[1] = (unsigned char)((uint16_t)sample >> 8);
+        }
+        fwrite(samples, sizeof(int16_t), count, file);
+    }
+}
+
+void FinishWavFile(FILE *file)
+{
+    long size = ftell(file);
+    if (size < 44)
+        return;
+
+    fseek(file, 4, SEEK_SET);
+    Write32(file, (uint32_t)size - 8);
+    fseek(file, 40, SEEK_SET);
+    Write32(file, (uint32_t)size - 44);
+    fseek(file, size, SEEK_SET);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// RIFF WAVE files: PCM at 8, 16, 24 or 32 bits, or 32-bit float, with
+// any number of channels (the mixer plays mono and stereo).
+
+enum WavSampleFormat
+{
+    WAV_PCM_U8,
+    WAV_PCM_S16,
+    WAV_PCM_S24,
+    WAV_PCM_S32,
+    WAV_FLOAT32
+};
+
+struct WavInfo
+{
+    WavSampleFormat format;
+    int channels;
+    int sampleRate;
+    int bytesPerFrame;
+    uint32_t frames;
+
+    // The sample data, within the buffer that was parsed
+    const unsigned char *data;
+};
+
+// Finds the format and data chunks of a WAV file held in memory. Returns
+// false if it is not a WAV file or uses an unsupported format.
+bool ParseWav(const void *file, size_t size, WavInfo &info);
+
+// Converts 'frames' frames at 'data' to interleaved floats in [-1, 1]
+void WavToFloat(const WavInfo &info, const unsigned char *data, uint32_t frames, float *out);
+
+// Writes 16-bit PCM stereo; the sizes in the header are filled in by
+// FinishWavFile once the length is known
+bool BeginWavFile(FILE *file, int sampleRate);
+void WriteWavFrames(FILE *file, const float *interleaved, int frames);
+void FinishWavFile(FILE *file);
@@ -0,0 +1,104 @@
+#include "archetype.h"
+
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static size_t AlignUp(size_t value, size_t align)
+{
+    return (value + align - 1) & ~(align - 1);
+}
+
+Archetype::Archetype(ComponentMask mask)
+{
+    this->mask = mask;
+
+    memset(columnOf, -1, sizeof(columnOf));
+    for (ComponentId id = 0; id < ECS_MAX_COMPONENTS; id++)
+    {
+        if ((mask >> id) & 1)
+        {
+            columnOf[id] = (signed char)components.size();
+            components.push_back(id);
+        }
+    }
+
+    // Worst case every column wastes a cache line to alignment
+    size_t rowSize = sizeof(Entity);
+    for (ComponentId id : components)
+        rowSize += GetComponentInfo(id).size;
+
+    // Chunks are never bigger than ECS_CHUNK_SIZE, so an entity that does
+    // not fit in one can not be stored at all
+    size_t padding = ECS_COLUMN_ALIGN * (components.size() + 1);
+    if (padding + rowSize > ECS_CHUNK_SIZE)
+    {
+        fprintf(stderr, "Error: an entity of %zu bytes in %zu components does not fit in a %d byte chunk\n",
+                rowSize, components.size(), ECS_CHUNK_SIZE);
+        abort();
+    }
+    chunkCapacity = (int)((ECS_CHUNK_SIZE - padding) / rowSize);
+
+    size_t offset = AlignUp(chunkCapacity * sizeof(Entity), ECS_COLUMN_ALIGN);
+    for (ComponentId id : components)
+    {
+        const ComponentInfo &info = GetComponentInfo(id);
+        offset = AlignUp(offset, ECS_COLUMN_ALIGN);
+        columnOffsets.push_back(offset);
+        offset += chunkCapacity * info.size;
+    }
+}
+
+Archetype::~Archetype()
+{
+    for (Chunk &chunk : chunks)
+        ::operator delete(chunk.data, std::align_val_t(ECS_COLUMN_ALIGN));
+}
+
+unsigned int Archetype::allocate(Entity entity)
+{
+    if (chunks.empty() || chunks.back().count == chunkCapacity)
+    {
+        Chunk chunk;
+        chunk.data = (unsigned char *)::operator new(ECS_CHUNK_SIZE, std::align_val_t(ECS_COLUMN_ALIGN));
+        chunk.count = 0;
+        chunks.push_back(chunk);
+    }
+
+    Chunk &chunk = chunks.back();
+    getEntities(chunk)[chunk.count++] = entity;
+    return rowCount++;
+}
+
+Entity Archetype::remove(unsigned int row)
+{
+    unsigned int last = --rowCount;
+    Chunk &lastChunk = chunks.back();
+    int lastSlot = --lastChunk.count;
+
+    Entity moved = INVALID_ENTITY;
+    if (row != last)
+    {
+        Chunk &chunk = chunks[row / chunkCapacity];
+        int slot = row % chunkCapacity;
+
+        moved = getEntities(lastChunk)[lastSlot];
+        getEntities(chunk)[slot] = moved;
+
+        for (size_t column = 0; column < components.size(); column++)
+        {
+            size_t size = GetComponentInfo(components[column]).size;
+            memcpy((unsigned char *)getColumn(chunk, (int)column) + slot * size,
+                   (unsigned char *)getColumn(lastChunk, (int)column) + lastSlot * size, size);
+        }
+    }
+
+    if (lastChunk.count == 0)
+    {
+        ::operator delete(lastChunk.data, std::align_val_t(ECS_COLUMN_ALIGN));
+        chunks.pop_back();
+    }
+
+    return moved;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "entity.h"
+
+#include <vector>
+
+// Every chunk is the same size, so chunks can be recycled between
+// archetypes and a chunk's columns stay within a few pages. Creating an
+// archetype whose entities do not fit in one chunk is a fatal error.
+#define ECS_CHUNK_SIZE (16 * 1024)
+
+// Columns start on cache line boundaries. Components may not need more;
+// registering one that does is a fatal error.
+#define ECS_COLUMN_ALIGN 64
+
+// Fixed-size block holding up to 'capacity' entities of one archetype.
+// Each component gets its own contiguous column (structure of arrays),
+// preceded by a column of entity handles.
+struct Chunk
+{
+    unsigned char *data;
+    int count;
+};
+
+// Storage for all entities with exactly the same set of components.
+// Entities are packed: only the last chunk can be partially filled, so a
+// row number maps directly to chunk (row / capacity) and slot.
+class Archetype
+{
+private:
+    int rowCount = 0;
+
+    // Archetypes reached by adding or removing one component, filled in
+    // by the world as transitions happen
+    Archetype *addEdges[ECS_MAX_COMPONENTS] = {};
+    Archetype *removeEdges[ECS_MAX_COMPONENTS] = {};
+
+    friend class World;
+
+public:
+    ComponentMask mask;
+    std::vector<ComponentId> components;   // ascending
+    std::vector<size_t> columnOffsets;     // per component, from chunk start
+    signed char columnOf[ECS_MAX_COMPONENTS]; // component -> column, or -1
+    int chunkCapacity;
+    std::vector<Chunk> chunks;
+
+    Archetype(ComponentMask mask);
+    ~Archetype();
+
+    Archetype(const Archetype &) = delete;
+    Archetype &operator=(const Archetype &) = delete;
+
+    int getCount() const { return rowCount; }
+    bool hasComponent(ComponentId id) const { return (mask >> id) & 1; }
+
+    Entity *getEntities(const Chunk &chunk) const { return (Entity *)chunk.data; }
+    void *getColumn(const Chunk &chunk, int column) const { return chunk.data + columnOffsets[column]; }
+
+    void *getComponent(unsigned int row, ComponentId id) const
+    {
+        const Chunk &chunk = chunks[row / chunkCapacity];
+        size_t size = GetComponentInfo(id).size;
+        return chunk.data + columnOffsets[columnOf[id]] + (row % chunkCapacity) * size;
+    }
+
+    // Appends an entity with uninitialised components and returns its row
+    unsigned int allocate(Entity entity);
+
+    // Removes a row by moving the last row into it. Returns the entity that
+    // moved, or INVALID_ENTITY if the removed row was the last one.
+    Entity remove(unsigned int row);
+};
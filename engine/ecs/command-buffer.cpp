@@ -0,0 +1,65 @@
+#include "command-buffer.h"
+
+#include <string.h>
+
+// Placeholders from create() use a generation no real entity reaches
+#define PENDING_GENERATION (~0u)
+
+Entity CommandBuffer::create()
+{
+    Entity placeholder = Entity{pendingCount++, PENDING_GENERATION};
+    commands.push_back(Command{COMMAND_CREATE, placeholder, 0, 0});
+    return placeholder;
+}
+
+void CommandBuffer::destroy(Entity entity)
+{
+    commands.push_back(Command{COMMAND_DESTROY, entity, 0, 0});
+}
+
+void CommandBuffer::addComponent(Entity entity, ComponentId id, const void *value, size_t size)
+{
+    size_t offset = data.size();
+    data.resize(offset + size);
+    memcpy(data.data() + offset, value, size);
+
+    commands.push_back(Command{COMMAND_ADD, entity, id, offset});
+}
+
+void CommandBuffer::apply(World *world)
+{
+    std::vector<Entity> created(pendingCount, INVALID_ENTITY);
+
+    for (const Command &command : commands)
+    {
+        Entity entity = command.entity;
+        if (entity.generation == PENDING_GENERATION)
+            entity = command.type == COMMAND_CREATE ? INVALID_ENTITY : created[entity.index];
+
+        switch (command.type)
+        {
+        case COMMAND_CREATE:
+            created[command.entity.index] = world->create();
+            break;
+        case COMMAND_DESTROY:
+            world->destroy(entity);
+            break;
+        case COMMAND_ADD:
+            // Stored unaligned; addComponent copies it with memcpy
+            world->addComponent(entity, command.component, data.data() + command.dataOffset);
+            break;
+        case COMMAND_REMOVE:
+            world->removeComponent(entity, command.component);
+            break;
+        }
+    }
+
+    clear();
+}
+
+void CommandBuffer::clear()
+{
+    commands.clear();
+    data.clear();
+    pendingCount = 0;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "world.h"
+
+#include <vector>
+
+// Records structural changes (creating and destroying entities, adding and
+// removing components) so they can be made while a query is iterating and
+// applied once it has finished. Commands apply in the order recorded.
+//
+// A buffer is not thread safe; give each thread of a parallel query its
+// own and apply them one after another.
+class CommandBuffer
+{
+private:
+    enum CommandType
+    {
+        COMMAND_CREATE,
+        COMMAND_DESTROY,
+        COMMAND_ADD,
+        COMMAND_REMOVE
+    };
+
+    struct Command
+    {
+        CommandType type;
+        Entity entity;
+        ComponentId component;
+        size_t dataOffset; // into 'data', for COMMAND_ADD
+    };
+
+    std::vector<Command> commands;
+    std::vector<unsigned char> data;
+    unsigned int pendingCount = 0;
+
+    void addComponent(Entity entity, ComponentId id, const void *value, size_t size);
+
+public:
+    // Returns a placeholder that later commands in this buffer can use;
+    // it becomes a real entity when the buffer is applied
+    Entity create();
+
+    void destroy(Entity entity);
+
+    template <typename T>
+    void add(Entity entity, const T &value) { addComponent(entity, ComponentType<T>(), &value, sizeof(T)); }
+
+    template <typename T>
+    void remove(Entity entity) { commands.push_back(Command{COMMAND_REMOVE, entity, ComponentType<T>(), 0}); }
+
+    bool isEmpty() const { return commands.empty(); }
+
+    // Commands on entities that are dead by the time they run are skipped,
+    // so two systems destroying the same entity is harmless
+    void apply(World *world);
+    void clear();
+};
@@ -0,0 +1,39 @@
+#include "entity.h"
+#include "archetype.h"
+
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+
+static ComponentInfo componentInfos[ECS_MAX_COMPONENTS];
+static unsigned int componentCount = 0;
+static std::mutex registryMutex;
+
+ComponentId RegisterComponent(size_t size, size_t align)
+{
+    // Each type registers once, but different types may do so concurrently
+    std::lock_guard<std::mutex> lock(registryMutex);
+
+    if (componentCount == ECS_MAX_COMPONENTS)
+    {
+        fprintf(stderr, "Error: more than %d component types registered\n", ECS_MAX_COMPONENTS);
+        abort();
+    }
+
+    // Chunks are only allocated to the column alignment, so nothing more
+    // could be honoured
+    if (align > ECS_COLUMN_ALIGN)
+    {
+        fprintf(stderr, "Error: component alignment %zu is over the %d bytes chunks are aligned to\n",
+                align, ECS_COLUMN_ALIGN);
+        abort();
+    }
+
+    componentInfos[componentCount] = ComponentInfo{size, align};
+    return componentCount++;
+}
+
+const ComponentInfo &GetComponentInfo(ComponentId id)
+{
+    return componentInfos[id];
+}
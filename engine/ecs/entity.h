@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+
+// Entities are an index into the world's entity table plus the generation
+// of that slot when the entity was created. Destroying an entity bumps the
+// slot's generation, so stale handles are detected rather than silently
+// aliasing whatever reuses the slot.
+struct Entity
+{
+    unsigned int index;
+    unsigned int generation;
+
+    bool operator==(const Entity &other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const Entity &other) const { return !(*this == other); }
+};
+
+#define INVALID_ENTITY (Entity{~0u, 0})
+
+// Component types are numbered on first use. A mask of them identifies an
+// archetype, which caps the number of distinct component types.
+typedef unsigned int ComponentId;
+typedef uint64_t ComponentMask;
+
+#define ECS_MAX_COMPONENTS 64
+
+struct ComponentInfo
+{
+    size_t size;
+    size_t align;
+};
+
+ComponentId RegisterComponent(size_t size, size_t align);
+const ComponentInfo &GetComponentInfo(ComponentId id);
+
+// Components are moved between chunks with memcpy and never constructed
+// or destroyed, so they must be plain data.
+template <typename T>
+ComponentId RegisteredComponentType()
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Components must be trivially copyable");
+
+    static const ComponentId id = RegisterComponent(sizeof(T), alignof(T));
+    return id;
+}
+
+// const T and T name the same component
+template <typename T>
+ComponentId ComponentType()
+{
+    return RegisteredComponentType<typename std::remove_cv<T>::type>();
+}
+
+template <typename... T>
+ComponentMask ComponentMaskOf()
+{
+    return (ComponentMask(0) | ... | (ComponentMask(1) << ComponentType<T>()));
+}
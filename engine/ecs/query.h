@@ -0,0 +1,170 @@
+#pragma once
+
+#include "world.h"
+
+#include <atomic>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Iterates every entity that has all of the components T (and none of the
+// excluded ones). Matching is done once per archetype and cached along
+// with each component's column, so iteration itself is a linear walk over
+// chunk columns. Keep queries around between frames; they pick up new
+// archetypes incrementally.
+//
+// Declare read-only components const, e.g. Query<const Velocity, Position>.
+template <typename... T>
+class Query
+{
+private:
+    struct Match
+    {
+        Archetype *archetype;
+        int columns[sizeof...(T) > 0 ? sizeof...(T) : 1];
+    };
+
+    World *world;
+    ComponentMask required;
+    ComponentMask excluded = 0;
+    std::vector<Match> matches;
+    size_t archetypesSeen = 0;
+
+    void refresh()
+    {
+        const std::vector<Archetype *> &archetypes = world->getArchetypes();
+        for (; archetypesSeen < archetypes.size(); archetypesSeen++)
+        {
+            Archetype *archetype = archetypes[archetypesSeen];
+            if ((archetype->mask & required) != required || (archetype->mask & excluded))
+                continue;
+
+            Match match;
+            match.archetype = archetype;
+            int column = 0;
+            ((match.columns[column++] = archetype->columnOf[ComponentType<T>()]), ...);
+            matches.push_back(match);
+        }
+    }
+
+    template <typename F, size_t... I>
+    static void runChunk(F &fn, const Match &match, const Chunk &chunk, std::index_sequence<I...>)
+    {
+        fn(chunk.count, (const Entity *)match.archetype->getEntities(chunk),
+           (T *)match.archetype->getColumn(chunk, match.columns[I])...);
+    }
+
+public:
+    Query(World *world)
+    {
+        this->world = world;
+        required = ComponentMaskOf<T...>();
+    }
+
+    template <typename... U>
+    Query &without()
+    {
+        excluded |= ComponentMaskOf<U...>();
+        matches.clear();
+        archetypesSeen = 0;
+        return *this;
+    }
+
+    // fn(int count, const Entity *entities, T *...columns) once per chunk
+    template <typename F>
+    void forEachChunk(F fn)
+    {
+        refresh();
+        for (const Match &match : matches)
+        {
+            for (const Chunk &chunk : match.archetype->chunks)
+                runChunk(fn, match, chunk, std::index_sequence_for<T...>());
+        }
+    }
+
+    // fn(T &...components) once per entity
+    template <typename F>
+    void forEach(F fn)
+    {
+        forEachChunk([&](int count, const Entity *, T *...columns) {
+            for (int i = 0; i < count; i++)
+                fn(columns[i]...);
+        });
+    }
+
+    // fn(Entity entity, T &...components) once per entity
+    template <typename F>
+    void forEachEntity(F fn)
+    {
+        forEachChunk([&](int count, const Entity *entities, T *...columns) {
+            for (int i = 0; i < count; i++)
+                fn(entities[i], columns[i]...);
+        });
+    }
+
+    // As forEachChunk, but chunks are handed out to 'threadCount' threads
+    // (default: one per core), with the caller acting as thread 0. fn
+    // receives the thread number first, e.g. to pick a per-thread
+    // CommandBuffer, and must be safe to run concurrently.
+    template <typename F>
+    void parallelForEachChunk(F fn, int threadCount = 0)
+    {
+        refresh();
+
+        std::vector<std::pair<const Match *, const Chunk *>> work;
+        for (const Match &match : matches)
+        {
+            for (const Chunk &chunk : match.archetype->chunks)
+                work.push_back(std::make_pair(&match, &chunk));
+        }
+
+        if (threadCount <= 0)
+            threadCount = (int)std::thread::hardware_concurrency();
+        if (threadCount > (int)work.size())
+            threadCount = (int)work.size();
+        if (threadCount <= 1)
+        {
+            auto single = [&](int count, const Entity *entities, T *...columns) { fn(0, count, entities, columns...); };
+            for (auto &item : work)
+                runChunk(single, *item.first, *item.second, std::index_sequence_for<T...>());
+            return;
+        }
+
+        // Chunks can hold very different counts, so threads pull them one
+        // at a time rather than taking fixed ranges
+        std::atomic<size_t> next(0);
+        auto worker = [&](int thread) {
+            auto withThread = [&](int count, const Entity *entities, T *...columns) { fn(thread, count, entities, columns...); };
+            for (size_t i = next++; i < work.size(); i = next++)
+                runChunk(withThread, *work[i].first, *work[i].second, std::index_sequence_for<T...>());
+        };
+
+        std::vector<std::thread> threads;
+        for (int thread = 1; thread < threadCount; thread++)
+            threads.emplace_back(worker, thread);
+
+        worker(0);
+
+        for (std::thread &thread : threads)
+            thread.join();
+    }
+
+    // fn(int thread, T &...components) once per entity, across threads
+    template <typename F>
+    void parallelForEach(F fn, int threadCount = 0)
+    {
+        parallelForEachChunk([&](int thread, int count, const Entity *, T *...columns) {
+            for (int i = 0; i < count; i++)
+                fn(thread, columns[i]...);
+        }, threadCount);
+    }
+
+    int count()
+    {
+        refresh();
+        int total = 0;
+        for (const Match &match : matches)
+            total += match.archetype->getCount();
+        return total;
+    }
+};
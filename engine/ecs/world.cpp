@@ -0,0 +1,162 @@
+#include "world.h"
+
+#include <string.h>
+
+World::World()
+{
+    emptyArchetype = getArchetype(0);
+}
+
+World::~World()
+{
+    for (Archetype *archetype : archetypes)
+        delete archetype;
+}
+
+Archetype *World::getArchetype(ComponentMask mask)
+{
+    auto found = archetypeByMask.find(mask);
+    if (found != archetypeByMask.end())
+        return found->second;
+
+    Archetype *archetype = new Archetype(mask);
+    archetypes.push_back(archetype);
+    archetypeByMask[mask] = archetype;
+    return archetype;
+}
+
+Entity World::allocateEntity(Archetype *archetype)
+{
+    unsigned int index;
+    if (!freeIndices.empty())
+    {
+        index = freeIndices.back();
+        freeIndices.pop_back();
+    }
+    else
+    {
+        index = (unsigned int)records.size();
+        records.push_back(EntityRecord{nullptr, 0, 0});
+    }
+
+    Entity entity = Entity{index, records[index].generation};
+    records[index].archetype = archetype;
+    records[index].row = archetype->allocate(entity);
+    entityCount++;
+    return entity;
+}
+
+Entity World::create()
+{
+    return allocateEntity(emptyArchetype);
+}
+
+void World::destroy(Entity entity)
+{
+    if (!isAlive(entity))
+        return;
+
+    EntityRecord &record = records[entity.index];
+    Entity moved = record.archetype->remove(record.row);
+    if (moved != INVALID_ENTITY)
+        records[moved.index].row = record.row;
+
+    record.archetype = nullptr;
+    record.generation++;
+    freeIndices.push_back(entity.index);
+    entityCount--;
+}
+
+bool World::isAlive(Entity entity) const
+{
+    return entity.index < records.size() &&
+           records[entity.index].generation == entity.generation &&
+           records[entity.index].archetype != nullptr;
+}
+
+void World::storeComponent(Archetype *archetype, unsigned int row, ComponentId id, const void *value)
+{
+    memcpy(archetype->getComponent(row, id), value, GetComponentInfo(id).size);
+}
+
+// Copies the components both archetypes share into a new row of 'to'.
+// Components only in 'to' are left for the caller to fill in.
+void World::moveEntity(Entity entity, Archetype *to)
+{
+    EntityRecord &record = records[entity.index];
+    Archetype *from = record.archetype;
+
+    unsigned int oldRow = record.row;
+    unsigned int newRow = to->allocate(entity);
+
+    for (ComponentId id : from->components)
+    {
+        if (to->hasComponent(id))
+            memcpy(to->getComponent(newRow, id), from->getComponent(oldRow, id), GetComponentInfo(id).size);
+    }
+
+    Entity moved = from->remove(oldRow);
+    if (moved != INVALID_ENTITY)
+        records[moved.index].row = oldRow;
+
+    record.archetype = to;
+    record.row = newRow;
+}
+
+void World::addComponent(Entity entity, ComponentId id, const void *value)
+{
+    if (!isAlive(entity))
+        return;
+
+    Archetype *from = records[entity.index].archetype;
+    if (!from->hasComponent(id))
+    {
+        Archetype *to = from->addEdges[id];
+        if (!to)
+        {
+            to = getArchetype(from->mask | (ComponentMask(1) << id));
+            from->addEdges[id] = to;
+            to->removeEdges[id] = from;
+        }
+        moveEntity(entity, to);
+    }
+
+    const EntityRecord &record = records[entity.index];
+    storeComponent(record.archetype, record.row, id, value);
+}
+
+void World::removeComponent(Entity entity, ComponentId id)
+{
+    if (!isAlive(entity))
+        return;
+
+    Archetype *from = records[entity.index].archetype;
+    if (!from->hasComponent(id))
+        return;
+
+    Archetype *to = from->removeEdges[id];
+    if (!to)
+    {
+        to = getArchetype(from->mask & ~(ComponentMask(1) << id));
+        from->removeEdges[id] = to;
+        to->addEdges[id] = from;
+    }
+    moveEntity(entity, to);
+}
+
+void *World::getComponent(Entity entity, ComponentId id) const
+{
+    if (!isAlive(entity))
+        return nullptr;
+
+    const EntityRecord &record = records[entity.index];
+    if (!record.archetype->hasComponent(id))
+        return nullptr;
+
+    return record.archetype->getComponent(record.row, id);
+}
+
+bool World::hasComponent(Entity entity, ComponentId id) const
+{
+    return isAlive(entity) && records[entity.index].archetype->hasComponent(id);
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "entity.h"
+#include "archetype.h"
+
+#include <unordered_map>
+#include <vector>
+
+template <typename... T>
+class Query;
+
+// Owns every entity and its components. Entities with the same set of
+// components share an archetype, so iterating a query walks contiguous
+// columns instead of chasing pointers.
+//
+// Adding or removing components moves the entity to another archetype,
+// which invalidates component pointers and would corrupt an iteration in
+// progress. Record such changes in a CommandBuffer while iterating and
+// apply it afterwards.
+class World
+{
+private:
+    struct EntityRecord
+    {
+        Archetype *archetype;
+        unsigned int row;
+        unsigned int generation;
+    };
+
+    std::vector<EntityRecord> records;
+    std::vector<unsigned int> freeIndices;
+    int entityCount = 0;
+
+    // Append-only, so queries can match just the archetypes added since
+    // they last looked
+    std::vector<Archetype *> archetypes;
+    std::unordered_map<ComponentMask, Archetype *> archetypeByMask;
+    Archetype *emptyArchetype;
+
+    Archetype *getArchetype(ComponentMask mask);
+    Entity allocateEntity(Archetype *archetype);
+    void moveEntity(Entity entity, Archetype *to);
+
+public:
+    World();
+    ~World();
+
+    World(const World &) = delete;
+    World &operator=(const World &) = delete;
+
+    Entity create();
+    void destroy(Entity entity);
+    bool isAlive(Entity entity) const;
+    int getEntityCount() const { return entityCount; }
+
+    // Creates an entity directly in its final archetype, skipping the
+    // intermediate moves that adding the components one by one would cost
+    template <typename... T>
+    Entity create(const T &...components)
+    {
+        Archetype *archetype = getArchetype(ComponentMaskOf<T...>());
+        Entity entity = allocateEntity(archetype);
+        unsigned int row = records[entity.index].row;
+        (storeComponent(archetype, row, ComponentType<T>(), &components), ...);
+        return entity;
+    }
+
+    // Type-erased forms, used by the templates and by CommandBuffer
+    void addComponent(Entity entity, ComponentId id, const void *value);
+    void removeComponent(Entity entity, ComponentId id);
+    void *getComponent(Entity entity, ComponentId id) const;
+    bool hasComponent(Entity entity, ComponentId id) const;
+
+    // Adding a component the entity already has overwrites it
+    template <typename T>
+    void add(Entity entity, const T &value) { addComponent(entity, ComponentType<T>(), &value); }
+
+    template <typename T>
+    void remove(Entity entity) { removeComponent(entity, ComponentType<T>()); }
+
+    // Returns nullptr if the entity is dead or lacks the component. The
+    // pointer is only valid until the next structural change.
+    template <typename T>
+    T *get(Entity entity) const { return (T *)getComponent(entity, ComponentType<T>()); }
+
+    template <typename T>
+    bool has(Entity entity) const { return hasComponent(entity, ComponentType<T>()); }
+
+    template <typename... T>
+    Query<T...> query() { return Query<T...>(this); }
+
+    const std::vector<Archetype *> &getArchetypes() const { return archetypes; }
+
+private:
+    static void storeComponent(Archetype *archetype, unsigned int row, ComponentId id, const void *value);
+};
+
+#include "query.h"
@@ -2,6 +2,11 @@
 
 #include "opengl.h"
 #include "platform.h"
+#include "ecs/world.h"
+#include "audio/mixer.h"
+#include "input/input.h"
+#include "profiler/profiler.h"
+#include "assets/asset-cache.h"
 
 // Global game variable
 
@@ -13,6 +18,13 @@ public:
     virtual ~Game() {}
 
     Platform *platform;
+
+    // Created by the platform before Setup()
+    World *world;
+    AudioMixer *audio;
+    Input *input; // updated before every Frame()
+    Profiler *profiler;
+    AssetCache *assets; // loaders for GL assets are up to the game
 };
 
 // You must implement this function
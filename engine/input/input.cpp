@@ -0,0 +1,122 @@
+#include "input.h"
+
+#include <string.h>
+
+bool Input::push(const InputEvent &event)
+{
+    if (queue.push(event))
+        return true;
+
+    droppedEvents.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void Input::releaseAll()
+{
+    memset(keys, 0, sizeof(keys));
+    memset(buttons, 0, sizeof(buttons));
+    for (Touch &touch : touches)
+        touch.down = false;
+}
+
+void Input::apply(const InputEvent &event)
+{
+    switch (event.type)
+    {
+    case INPUT_KEY:
+        if (event.code >= 0 && event.code < INPUT_MAX_KEYS)
+        {
+            keys[event.code] = event.pressed;
+            if (event.pressed)
+                keysPressed[event.code] = true;
+        }
+        break;
+
+    case INPUT_POINTER_MOTION:
+        pointerX = event.x;
+        pointerY = event.y;
+        break;
+
+    case INPUT_POINTER_BUTTON:
+        if (event.code >= 0 && event.code < INPUT_BUTTON_COUNT)
+            buttons[event.code] = event.pressed;
+        break;
+
+    case INPUT_POINTER_SCROLL:
+        scrollX += event.x;
+        scrollY += event.y;
+        break;
+
+    case INPUT_TOUCH_DOWN:
+    case INPUT_TOUCH_MOTION:
+    case INPUT_TOUCH_UP:
+        if (event.device >= 0 && event.device < INPUT_MAX_TOUCHES)
+            touches[event.device] = Touch{ event.type != INPUT_TOUCH_UP, event.x, event.y };
+        break;
+
+    case INPUT_GAMEPAD_CONNECTED:
+    case INPUT_GAMEPAD_DISCONNECTED:
+        if (event.device >= 0 && event.device < INPUT_MAX_GAMEPADS)
+        {
+            gamepads[event.device] = Gamepad{};
+            gamepads[event.device].connected = event.type == INPUT_GAMEPAD_CONNECTED;
+        }
+        break;
+
+    case INPUT_GAMEPAD_BUTTON:
+        if (isGamepadConnected(event.device) && event.code >= 0 && event.code < INPUT_PAD_BUTTON_COUNT)
+            gamepads[event.device].buttons[event.code] = event.pressed;
+        break;
+
+    case INPUT_GAMEPAD_AXIS:
+        if (isGamepadConnected(event.device) && event.code >= 0 && event.code < INPUT_PAD_AXIS_COUNT)
+            gamepads[event.device].axes[event.code] = event.x;
+        break;
+
+    case INPUT_FOCUS_LOST:
+        releaseAll();
+        break;
+    }
+}
+
+void Input::beginFrame()
+{
+    events.clear();
+    memset(keysPressed, 0, sizeof(keysPressed));
+    scrollX = scrollY = 0.0f;
+    frameInputTime = 0;
+
+    InputEvent event;
+    while (queue.pop(event))
+    {
+        apply(event);
+        events.push_back(event);
+
+        // Latency is measured from the oldest input this frame answers
+        if (!frameInputTime || event.time < frameInputTime)
+            frameInputTime = event.time;
+    }
+}
+
+void Input::frameDisplayed(uint64_t inputTime, uint64_t displayTime)
+{
+    if (!inputTime || displayTime < inputTime)
+        return;
+
+    float ms = (float)((displayTime - inputTime) * 1e-6);
+    lastLatencyMs = ms;
+    averageLatencyMs = averageLatencyMs ? averageLatencyMs * 0.95f + ms * 0.05f : ms;
+    if (ms > peakLatencyMs)
+        peakLatencyMs = ms;
+}
+
+InputStats Input::getStats() const
+{
+    InputStats stats;
+    stats.lastLatencyMs = lastLatencyMs;
+    stats.averageLatencyMs = averageLatencyMs;
+    stats.peakLatencyMs = peakLatencyMs;
+    stats.eventsLastFrame = (unsigned int)events.size();
+    stats.droppedEvents = droppedEvents.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,222 @@
+#pragma once
+
+#include "../spsc-queue.h"
+
+#include <atomic>
+#include <stdint.h>
+#include <vector>
+
+#define INPUT_QUEUE_SIZE 1024
+#define INPUT_MAX_KEYS 256
+#define INPUT_MAX_GAMEPADS 4
+#define INPUT_MAX_TOUCHES 10
+
+// Physical key positions, numbered as Linux evdev numbers them (which for
+// the main block is also the PC scancode). Keys are reported by position
+// rather than by what the layout prints on them, so WASD stays WASD.
+// Codes without a name here are still reported, up to INPUT_MAX_KEYS.
+enum InputKey
+{
+    INPUT_KEY_ESCAPE = 1,
+    INPUT_KEY_1 = 2, INPUT_KEY_2, INPUT_KEY_3, INPUT_KEY_4, INPUT_KEY_5,
+    INPUT_KEY_6, INPUT_KEY_7, INPUT_KEY_8, INPUT_KEY_9, INPUT_KEY_0,
+    INPUT_KEY_BACKSPACE = 14,
+    INPUT_KEY_TAB = 15,
+    INPUT_KEY_Q = 16, INPUT_KEY_W, INPUT_KEY_E, INPUT_KEY_R, INPUT_KEY_T,
+    INPUT_KEY_Y, INPUT_KEY_U, INPUT_KEY_I, INPUT_KEY_O, INPUT_KEY_P,
+    INPUT_KEY_ENTER = 28,
+    INPUT_KEY_LEFT_CTRL = 29,
+    INPUT_KEY_A = 30, INPUT_KEY_S, INPUT_KEY_D, INPUT_KEY_F, INPUT_KEY_G,
+    INPUT_KEY_H, INPUT_KEY_J, INPUT_KEY_K, INPUT_KEY_L,
+    INPUT_KEY_LEFT_SHIFT = 42,
+    INPUT_KEY_Z = 44, INPUT_KEY_X, INPUT_KEY_C, INPUT_KEY_V, INPUT_KEY_B,
+    INPUT_KEY_N, INPUT_KEY_M,
+    INPUT_KEY_RIGHT_SHIFT = 54,
+    INPUT_KEY_LEFT_ALT = 56,
+    INPUT_KEY_SPACE = 57,
+    INPUT_KEY_F1 = 59, INPUT_KEY_F2, INPUT_KEY_F3, INPUT_KEY_F4, INPUT_KEY_F5,
+    INPUT_KEY_F6, INPUT_KEY_F7, INPUT_KEY_F8, INPUT_KEY_F9, INPUT_KEY_F10,
+    INPUT_KEY_F11 = 87,
+    INPUT_KEY_F12 = 88,
+    INPUT_KEY_RIGHT_CTRL = 97,
+    INPUT_KEY_RIGHT_ALT = 100,
+    INPUT_KEY_HOME = 102,
+    INPUT_KEY_UP = 103,
+    INPUT_KEY_PAGE_UP = 104,
+    INPUT_KEY_LEFT = 105,
+    INPUT_KEY_RIGHT = 106,
+    INPUT_KEY_END = 107,
+    INPUT_KEY_DOWN = 108,
+    INPUT_KEY_PAGE_DOWN = 109,
+    INPUT_KEY_INSERT = 110,
+    INPUT_KEY_DELETE = 111
+};
+
+enum InputButton
+{
+    INPUT_BUTTON_LEFT,
+    INPUT_BUTTON_RIGHT,
+    INPUT_BUTTON_MIDDLE,
+    INPUT_BUTTON_COUNT
+};
+
+// Laid out like an Xbox pad; "south" is A on Xbox and cross on PlayStation
+enum InputGamepadButton
+{
+    INPUT_PAD_SOUTH,
+    INPUT_PAD_EAST,
+    INPUT_PAD_WEST,
+    INPUT_PAD_NORTH,
+    INPUT_PAD_LEFT_SHOULDER,
+    INPUT_PAD_RIGHT_SHOULDER,
+    INPUT_PAD_SELECT,
+    INPUT_PAD_START,
+    INPUT_PAD_GUIDE,
+    INPUT_PAD_LEFT_STICK,
+    INPUT_PAD_RIGHT_STICK,
+    INPUT_PAD_DPAD_UP,
+    INPUT_PAD_DPAD_DOWN,
+    INPUT_PAD_DPAD_LEFT,
+    INPUT_PAD_DPAD_RIGHT,
+    INPUT_PAD_BUTTON_COUNT
+};
+
+// Sticks run from -1 to 1, positive right and down; triggers from 0 to 1
+enum InputGamepadAxis
+{
+    INPUT_PAD_LEFT_X,
+    INPUT_PAD_LEFT_Y,
+    INPUT_PAD_RIGHT_X,
+    INPUT_PAD_RIGHT_Y,
+    INPUT_PAD_LEFT_TRIGGER,
+    INPUT_PAD_RIGHT_TRIGGER,
+    INPUT_PAD_AXIS_COUNT
+};
+
+enum InputEventType
+{
+    INPUT_KEY,            // code: InputKey
+    INPUT_POINTER_MOTION, // x, y: window pixels
+    INPUT_POINTER_BUTTON, // code: InputButton
+    INPUT_POINTER_SCROLL, // x, y: horizontal and vertical, in lines
+    INPUT_TOUCH_DOWN,     // device: touch point, x, y: window pixels
+    INPUT_TOUCH_MOTION,
+    INPUT_TOUCH_UP,
+    INPUT_GAMEPAD_CONNECTED, // device: gamepad slot
+    INPUT_GAMEPAD_DISCONNECTED,
+    INPUT_GAMEPAD_BUTTON, // code: InputGamepadButton
+    INPUT_GAMEPAD_AXIS,   // code: InputGamepadAxis, x: value
+    INPUT_FOCUS_LOST      // everything held is released
+};
+
+struct InputEvent
+{
+    InputEventType type;
+
+    // When the event happened (as stamped by the OS where it provides
+    // that, otherwise when the platform received it), in nanoseconds on
+    // the platform's monotonic clock
+    uint64_t time;
+
+    int device;
+    int code;
+    float x, y;
+    bool pressed;
+};
+
+// Time from input to the frame that first reacted to it reaching the
+// screen, in milliseconds. Until the platform knows when frames are
+// actually displayed, "reaching the screen" is the buffer swap.
+struct InputStats
+{
+    float lastLatencyMs;
+    float averageLatencyMs;
+    float peakLatencyMs;
+    unsigned int eventsLastFrame;
+    unsigned int droppedEvents; // the queue was full
+};
+
+// Input from the platform, collected as it arrives and handed to the game
+// once per frame.
+//
+// The platform pushes timestamped events from whichever thread receives
+// them (on Linux, a dedicated input thread) onto a lock-free queue, so
+// input is never held up by a long frame. beginFrame() drains the queue
+// on the game thread before Frame() runs and updates the state the query
+// functions report. Events must come from one thread only.
+class Input
+{
+private:
+    SpscQueue<InputEvent, INPUT_QUEUE_SIZE> queue;
+    std::atomic<unsigned int> droppedEvents{0};
+
+    // Game thread only from here on
+    std::vector<InputEvent> events;
+    uint64_t frameInputTime = 0;
+
+    bool keys[INPUT_MAX_KEYS] = {};
+    bool keysPressed[INPUT_MAX_KEYS] = {}; // went down this frame
+
+    float pointerX = 0.0f, pointerY = 0.0f;
+    float scrollX = 0.0f, scrollY = 0.0f; // this frame
+    bool buttons[INPUT_BUTTON_COUNT] = {};
+
+    struct Touch
+    {
+        bool down;
+        float x, y;
+    };
+    Touch touches[INPUT_MAX_TOUCHES] = {};
+
+    struct Gamepad
+    {
+        bool connected;
+        bool buttons[INPUT_PAD_BUTTON_COUNT];
+        float axes[INPUT_PAD_AXIS_COUNT];
+    };
+    Gamepad gamepads[INPUT_MAX_GAMEPADS] = {};
+
+    float lastLatencyMs = 0.0f, averageLatencyMs = 0.0f, peakLatencyMs = 0.0f;
+
+    void apply(const InputEvent &event);
+    void releaseAll();
+
+public:
+    // Platform, on its input thread. Returns false, and counts the event
+    // as dropped, if the queue is full.
+    bool push(const InputEvent &event);
+
+    // Platform, on the game thread: before Frame(), take everything that
+    // has arrived since the last frame
+    void beginFrame();
+
+    // Timestamp of the oldest event taken by the last beginFrame(), or 0
+    // if there were none. The platform holds on to it until it knows when
+    // that frame was displayed, then calls frameDisplayed().
+    uint64_t getFrameInputTime() const { return frameInputTime; }
+    void frameDisplayed(uint64_t inputTime, uint64_t displayTime);
+
+    // This frame's events in the order they happened, for anything that
+    // needs more than the current state (typing, or clicks shorter than a
+    // frame)
+    const std::vector<InputEvent> &getEvents() const { return events; }
+
+    bool isKeyDown(int key) const { return key >= 0 && key < INPUT_MAX_KEYS && keys[key]; }
+    bool wasKeyPressed(int key) const { return key >= 0 && key < INPUT_MAX_KEYS && keysPressed[key]; }
+
+    float getPointerX() const { return pointerX; }
+    float getPointerY() const { return pointerY; }
+    float getScrollX() const { return scrollX; }
+    float getScrollY() const { return scrollY; }
+    bool isButtonDown(InputButton button) const { return buttons[button]; }
+
+    bool isTouchDown(int touch) const { return touch >= 0 && touch < INPUT_MAX_TOUCHES && touches[touch].down; }
+    float getTouchX(int touch) const { return touches[touch].x; }
+    float getTouchY(int touch) const { return touches[touch].y; }
+
+    bool isGamepadConnected(int pad) const { return pad >= 0 && pad < INPUT_MAX_GAMEPADS && gamepads[pad].connected; }
+    bool isGamepadButtonDown(int pad, InputGamepadButton button) const { return isGamepadConnected(pad) && gamepads[pad].buttons[button]; }
+    float getGamepadAxis(int pad, InputGamepadAxis axis) const { return isGamepadConnected(pad) ? gamepads[pad].axes[axis] : 0.0f; }
+
+    InputStats getStats() const;
+};
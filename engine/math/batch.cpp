@@ -0,0 +1,265 @@
+#include "batch.h"
+#include "simd.h"
+
+// Scalar reference implementations
+
+void transformPointsScalar(const mat4 &m, const vec3 *in, vec3 *out, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        vec3 p = in[i];
+        out[i] = vec3(m[0].x * p.x + m[1].x * p.y + m[2].x * p.z + m[3].x,
+                      m[0].y * p.x + m[1].y * p.y + m[2].y * p.z + m[3].y,
+                      m[0].z * p.x + m[1].z * p.y + m[2].z * p.z + m[3].z);
+    }
+}
+
+void transformPointsSoAScalar(const mat4 &m, SoAVec3 in, SoAVec3 out, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        float x = in.x[i], y = in.y[i], z = in.z[i];
+        out.x[i] = m[0].x * x + m[1].x * y + m[2].x * z + m[3].x;
+        out.y[i] = m[0].y * x + m[1].y * y + m[2].y * z + m[3].y;
+        out.z[i] = m[0].z * x + m[1].z * y + m[2].z * z + m[3].z;
+    }
+}
+
+int cullSpheresSoAScalar(const Frustum &frustum, SoASpheres spheres, unsigned char *visible, int count)
+{
+    int visibleCount = 0;
+    for (int i = 0; i < count; i++)
+    {
+        bool inside = frustum.containsSphere(vec3(spheres.x[i], spheres.y[i], spheres.z[i]), spheres.radius[i]);
+        visible[i] = inside;
+        visibleCount += inside;
+    }
+    return visibleCount;
+}
+
+#ifdef TONIC_SSE2
+
+#ifdef TONIC_AVX2
+
+// AVX2 paths. Each handles as many whole groups of 8 as it can and
+// returns how many elements it processed, leaving the rest to SSE2.
+
+TONIC_TARGET_AVX2
+static int TransformPointsSoAAVX2(const mat4 &m, SoAVec3 in, SoAVec3 out, int count)
+{
+    __m256 m00 = _mm256_set1_ps(m[0].x), m01 = _mm256_set1_ps(m[0].y), m02 = _mm256_set1_ps(m[0].z);
+    __m256 m10 = _mm256_set1_ps(m[1].x), m11 = _mm256_set1_ps(m[1].y), m12 = _mm256_set1_ps(m[1].z);
+    __m256 m20 = _mm256_set1_ps(m[2].x), m21 = _mm256_set1_ps(m[2].y), m22 = _mm256_set1_ps(m[2].z);
+    __m256 m30 = _mm256_set1_ps(m[3].x), m31 = _mm256_set1_ps(m[3].y), m32 = _mm256_set1_ps(m[3].z);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(in.x + i);
+        __m256 y = _mm256_loadu_ps(in.y + i);
+        __m256 z = _mm256_loadu_ps(in.z + i);
+
+        __m256 ox = _mm256_fmadd_ps(m20, z, _mm256_fmadd_ps(m10, y, _mm256_fmadd_ps(m00, x, m30)));
+        __m256 oy = _mm256_fmadd_ps(m21, z, _mm256_fmadd_ps(m11, y, _mm256_fmadd_ps(m01, x, m31)));
+        __m256 oz = _mm256_fmadd_ps(m22, z, _mm256_fmadd_ps(m12, y, _mm256_fmadd_ps(m02, x, m32)));
+
+        _mm256_storeu_ps(out.x + i, ox);
+        _mm256_storeu_ps(out.y + i, oy);
+        _mm256_storeu_ps(out.z + i, oz);
+    }
+    return i;
+}
+
+TONIC_TARGET_AVX2
+static int CullSpheresSoAAVX2(const Frustum &frustum, SoASpheres spheres, unsigned char *visible, int count, int *visibleCount)
+{
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(spheres.x + i);
+        __m256 y = _mm256_loadu_ps(spheres.y + i);
+        __m256 z = _mm256_loadu_ps(spheres.z + i);
+        __m256 negRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(spheres.radius + i));
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; p++)
+        {
+            const Plane &plane = frustum.planes[p];
+            __m256 distance = _mm256_fmadd_ps(_mm256_set1_ps(plane.normal.x), x,
+                              _mm256_fmadd_ps(_mm256_set1_ps(plane.normal.y), y,
+                              _mm256_fmadd_ps(_mm256_set1_ps(plane.normal.z), z, _mm256_set1_ps(plane.d))));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negRadius, _CMP_GE_OQ));
+        }
+
+        int mask = _mm256_movemask_ps(inside);
+        for (int lane = 0; lane < 8; lane++)
+        {
+            visible[i + lane] = (mask >> lane) & 1;
+            *visibleCount += (mask >> lane) & 1;
+        }
+    }
+    return i;
+}
+
+TONIC_TARGET_AVX2
+static void MulBatchAVX2(const mat4 *a, const mat4 *b, mat4 *out, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        // Each 256-bit register holds two columns, so every step works on
+        // two result columns at once
+        __m256 a0 = _mm256_broadcast_ps((const __m128 *)&a[i][0].x);
+        __m256 a1 = _mm256_broadcast_ps((const __m128 *)&a[i][1].x);
+        __m256 a2 = _mm256_broadcast_ps((const __m128 *)&a[i][2].x);
+        __m256 a3 = _mm256_broadcast_ps((const __m128 *)&a[i][3].x);
+
+        // Load all of b before storing, in case out aliases b
+        __m256 b01 = _mm256_loadu_ps(&b[i][0].x);
+        __m256 b23 = _mm256_loadu_ps(&b[i][2].x);
+
+        __m256 r01 = _mm256_mul_ps(a0, _mm256_permute_ps(b01, 0x00));
+        r01 = _mm256_fmadd_ps(a1, _mm256_permute_ps(b01, 0x55), r01);
+        r01 = _mm256_fmadd_ps(a2, _mm256_permute_ps(b01, 0xAA), r01);
+        r01 = _mm256_fmadd_ps(a3, _mm256_permute_ps(b01, 0xFF), r01);
+
+        __m256 r23 = _mm256_mul_ps(a0, _mm256_permute_ps(b23, 0x00));
+        r23 = _mm256_fmadd_ps(a1, _mm256_permute_ps(b23, 0x55), r23);
+        r23 = _mm256_fmadd_ps(a2, _mm256_permute_ps(b23, 0xAA), r23);
+        r23 = _mm256_fmadd_ps(a3, _mm256_permute_ps(b23, 0xFF), r23);
+
+        _mm256_storeu_ps(&out[i][0].x, r01);
+        _mm256_storeu_ps(&out[i][2].x, r23);
+    }
+}
+
+#endif
+
+void transformPoints(const mat4 &m, const vec3 *in, vec3 *out, int count)
+{
+    __m128 c0 = _mm_load_ps(&m[0].x);
+    __m128 c1 = _mm_load_ps(&m[1].x);
+    __m128 c2 = _mm_load_ps(&m[2].x);
+    __m128 c3 = _mm_load_ps(&m[3].x);
+
+    for (int i = 0; i < count; i++)
+    {
+        __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(in[i].x)),
+                                         _mm_mul_ps(c1, _mm_set1_ps(in[i].y))),
+                              _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(in[i].z)), c3));
+
+        // vec3 is 12 bytes, so store xy and z separately to stay in bounds
+        _mm_storel_pi((__m64 *)&out[i].x, r);
+        _mm_store_ss(&out[i].z, _mm_movehl_ps(r, r));
+    }
+}
+
+void transformPointsSoA(const mat4 &m, SoAVec3 in, SoAVec3 out, int count)
+{
+    int i = 0;
+#ifdef TONIC_AVX2
+    if (CpuHasAVX2())
+        i = TransformPointsSoAAVX2(m, in, out, count);
+#endif
+
+    __m128 m00 = _mm_set1_ps(m[0].x), m01 = _mm_set1_ps(m[0].y), m02 = _mm_set1_ps(m[0].z);
+    __m128 m10 = _mm_set1_ps(m[1].x), m11 = _mm_set1_ps(m[1].y), m12 = _mm_set1_ps(m[1].z);
+    __m128 m20 = _mm_set1_ps(m[2].x), m21 = _mm_set1_ps(m[2].y), m22 = _mm_set1_ps(m[2].z);
+    __m128 m30 = _mm_set1_ps(m[3].x), m31 = _mm_set1_ps(m[3].y), m32 = _mm_set1_ps(m[3].z);
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(in.x + i);
+        __m128 y = _mm_loadu_ps(in.y + i);
+        __m128 z = _mm_loadu_ps(in.z + i);
+
+        __m128 ox = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m00, x), _mm_mul_ps(m10, y)), _mm_add_ps(_mm_mul_ps(m20, z), m30));
+        __m128 oy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m01, x), _mm_mul_ps(m11, y)), _mm_add_ps(_mm_mul_ps(m21, z), m31));
+        __m128 oz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m02, x), _mm_mul_ps(m12, y)), _mm_add_ps(_mm_mul_ps(m22, z), m32));
+
+        _mm_storeu_ps(out.x + i, ox);
+        _mm_storeu_ps(out.y + i, oy);
+        _mm_storeu_ps(out.z + i, oz);
+    }
+
+    SoAVec3 inTail = { in.x + i, in.y + i, in.z + i };
+    SoAVec3 outTail = { out.x + i, out.y + i, out.z + i };
+    transformPointsSoAScalar(m, inTail, outTail, count - i);
+}
+
+void mulBatch(const mat4 *a, const mat4 *b, mat4 *out, int count)
+{
+#ifdef TONIC_AVX2
+    if (CpuHasAVX2())
+    {
+        MulBatchAVX2(a, b, out, count);
+        return;
+    }
+#endif
+
+    for (int i = 0; i < count; i++)
+        out[i] = a[i] * b[i];
+}
+
+int cullSpheresSoA(const Frustum &frustum, SoASpheres spheres, unsigned char *visible, int count)
+{
+    int visibleCount = 0;
+    int i = 0;
+#ifdef TONIC_AVX2
+    if (CpuHasAVX2())
+        i = CullSpheresSoAAVX2(frustum, spheres, visible, count, &visibleCount);
+#endif
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(spheres.x + i);
+        __m128 y = _mm_loadu_ps(spheres.y + i);
+        __m128 z = _mm_loadu_ps(spheres.z + i);
+        __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(spheres.radius + i));
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; p++)
+        {
+            const Plane &plane = frustum.planes[p];
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.normal.x), x),
+                                                    _mm_mul_ps(_mm_set1_ps(plane.normal.y), y)),
+                                         _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.normal.z), z),
+                                                    _mm_set1_ps(plane.d)));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negRadius));
+        }
+
+        int mask = _mm_movemask_ps(inside);
+        for (int lane = 0; lane < 4; lane++)
+        {
+            visible[i + lane] = (mask >> lane) & 1;
+            visibleCount += (mask >> lane) & 1;
+        }
+    }
+
+    SoASpheres tail = { spheres.x + i, spheres.y + i, spheres.z + i, spheres.radius + i };
+    return visibleCount + cullSpheresSoAScalar(frustum, tail, visible + i, count - i);
+}
+
+#else
+
+void transformPoints(const mat4 &m, const vec3 *in, vec3 *out, int count)
+{
+    transformPointsScalar(m, in, out, count);
+}
+
+void transformPointsSoA(const mat4 &m, SoAVec3 in, SoAVec3 out, int count)
+{
+    transformPointsSoAScalar(m, in, out, count);
+}
+
+void mulBatch(const mat4 *a, const mat4 *b, mat4 *out, int count)
+{
+    for (int i = 0; i < count; i++)
+        out[i] = a[i] * b[i];
+}
+
+int cullSpheresSoA(const Frustum &frustum, SoASpheres spheres, unsigned char *visible, int count)
+{
+    return cullSpheresSoAScalar(frustum, spheres, visible, count);
+}
+
+#endif
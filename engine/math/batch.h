@@ -0,0 +1,43 @@
+#pragma once
+
+#include "vec.h"
+#include "mat.h"
+#include "geometry.h"
+
+// Batch routines over arrays of points, spheres and matrices. These pick
+// the widest available implementation at runtime (AVX2, SSE2, scalar).
+//
+// The SoA variants take one array per component. They are the fast path:
+// each SIMD lane handles a different element, with no shuffling. Arrays do
+// not need any particular alignment.
+
+struct SoAVec3
+{
+    float *x;
+    float *y;
+    float *z;
+};
+
+struct SoASpheres
+{
+    const float *x;
+    const float *y;
+    const float *z;
+    const float *radius;
+};
+
+// out[i] = m * (in[i], 1)
+void transformPoints(const mat4 &m, const vec3 *in, vec3 *out, int count);
+void transformPointsScalar(const mat4 &m, const vec3 *in, vec3 *out, int count);
+
+// SoA version of transformPoints. 'in' and 'out' may be the same arrays.
+void transformPointsSoA(const mat4 &m, SoAVec3 in, SoAVec3 out, int count);
+void transformPointsSoAScalar(const mat4 &m, SoAVec3 in, SoAVec3 out, int count);
+
+// out[i] = a[i] * b[i]. 'out' may alias 'b' (but not 'a').
+void mulBatch(const mat4 *a, const mat4 *b, mat4 *out, int count);
+
+// Writes 1 to visible[i] if sphere i intersects the frustum, 0 otherwise.
+// Returns the number of visible spheres.
+int cullSpheresSoA(const Frustum &frustum, SoASpheres spheres, unsigned char *visible, int count);
+int cullSpheresSoAScalar(const Frustum &frustum, SoASpheres spheres, unsigned char *visible, int count);
@@ -0,0 +1,133 @@
+#include "geometry.h"
+#include "simd.h"
+
+AABB transformAABB(const mat4 &m, const AABB &box)
+{
+    // Start from the translation and add the extreme contribution of each
+    // matrix element along each axis
+    vec3 min = m[3].xyz();
+    vec3 max = min;
+
+    for (int col = 0; col < 3; col++)
+    {
+        for (int row = 0; row < 3; row++)
+        {
+            float a = m[col][row] * box.min[col];
+            float b = m[col][row] * box.max[col];
+            min[row] += a < b ? a : b;
+            max[row] += a < b ? b : a;
+        }
+    }
+
+    return AABB(min, max);
+}
+
+static Frustum NormalizePlanes(const vec4 planes[6])
+{
+    Frustum frustum;
+    for (int i = 0; i < 6; i++)
+    {
+        float invLength = 1.0f / length(planes[i].xyz());
+        frustum.planes[i] = Plane(planes[i].xyz() * invLength, planes[i].w * invLength);
+    }
+    return frustum;
+}
+
+#ifdef TONIC_SSE2
+
+// Normalises four planes at once by transposing them so each register
+// holds one component of all four
+static void NormalizePlanes4(__m128 &a, __m128 &b, __m128 &c, __m128 &d)
+{
+    __m128 x = a, y = b, z = c, w = d;
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+
+    __m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+    __m128 invLength = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(lengthSq));
+
+    a = _mm_mul_ps(a, _mm_shuffle_ps(invLength, invLength, _MM_SHUFFLE(0, 0, 0, 0)));
+    b = _mm_mul_ps(b, _mm_shuffle_ps(invLength, invLength, _MM_SHUFFLE(1, 1, 1, 1)));
+    c = _mm_mul_ps(c, _mm_shuffle_ps(invLength, invLength, _MM_SHUFFLE(2, 2, 2, 2)));
+    d = _mm_mul_ps(d, _mm_shuffle_ps(invLength, invLength, _MM_SHUFFLE(3, 3, 3, 3)));
+}
+
+Frustum extractFrustum(const mat4 &viewProj)
+{
+    // Transposing gives the rows of the matrix, which the planes are sums
+    // and differences of
+    __m128 r0 = _mm_load_ps(&viewProj[0].x);
+    __m128 r1 = _mm_load_ps(&viewProj[1].x);
+    __m128 r2 = _mm_load_ps(&viewProj[2].x);
+    __m128 r3 = _mm_load_ps(&viewProj[3].x);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+    __m128 left = _mm_add_ps(r3, r0);
+    __m128 right = _mm_sub_ps(r3, r0);
+    __m128 bottom = _mm_add_ps(r3, r1);
+    __m128 top = _mm_sub_ps(r3, r1);
+    __m128 nearPlane = _mm_add_ps(r3, r2);
+    __m128 farPlane = _mm_sub_ps(r3, r2);
+
+    // The second group only has two planes; the spare lanes are ignored
+    __m128 spare0 = nearPlane, spare1 = farPlane;
+    NormalizePlanes4(left, right, bottom, top);
+    NormalizePlanes4(nearPlane, farPlane, spare0, spare1);
+
+    // Plane is a vec3 and a float, so it has the layout of a vec4
+    Frustum frustum;
+    _mm_storeu_ps(&frustum.planes[FRUSTUM_LEFT].normal.x, left);
+    _mm_storeu_ps(&frustum.planes[FRUSTUM_RIGHT].normal.x, right);
+    _mm_storeu_ps(&frustum.planes[FRUSTUM_BOTTOM].normal.x, bottom);
+    _mm_storeu_ps(&frustum.planes[FRUSTUM_TOP].normal.x, top);
+    _mm_storeu_ps(&frustum.planes[FRUSTUM_NEAR].normal.x, nearPlane);
+    _mm_storeu_ps(&frustum.planes[FRUSTUM_FAR].normal.x, farPlane);
+    return frustum;
+}
+
+#else
+
+Frustum extractFrustum(const mat4 &viewProj)
+{
+    return extractFrustumScalar(viewProj);
+}
+
+#endif
+
+Frustum extractFrustumScalar(const mat4 &m)
+{
+    vec4 rows[4];
+    for (int row = 0; row < 4; row++)
+        rows[row] = vec4(m[0][row], m[1][row], m[2][row], m[3][row]);
+
+    vec4 planes[6];
+    planes[FRUSTUM_LEFT] = rows[3] + rows[0];
+    planes[FRUSTUM_RIGHT] = rows[3] - rows[0];
+    planes[FRUSTUM_BOTTOM] = rows[3] + rows[1];
+    planes[FRUSTUM_TOP] = rows[3] - rows[1];
+    planes[FRUSTUM_NEAR] = rows[3] + rows[2];
+    planes[FRUSTUM_FAR] = rows[3] - rows[2];
+
+    return NormalizePlanes(planes);
+}
+
+// Point where three planes meet; they must not be parallel
+static vec3 IntersectPlanes(const Plane &a, const Plane &b, const Plane &c)
+{
+    vec3 bc = cross(b.normal, c.normal);
+    vec3 ca = cross(c.normal, a.normal);
+    vec3 ab = cross(a.normal, b.normal);
+    return (bc * -a.d + ca * -b.d + ab * -c.d) / dot(a.normal, bc);
+}
+
+AABB frustumBounds(const Frustum &frustum)
+{
+    AABB bounds;
+    for (int corner = 0; corner < 8; corner++)
+    {
+        const Plane &x = frustum.planes[corner & 1 ? FRUSTUM_RIGHT : FRUSTUM_LEFT];
+        const Plane &y = frustum.planes[corner & 2 ? FRUSTUM_TOP : FRUSTUM_BOTTOM];
+        const Plane &z = frustum.planes[corner & 4 ? FRUSTUM_FAR : FRUSTUM_NEAR];
+        bounds.expand(IntersectPlanes(x, y, z));
+    }
+    return bounds;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "vec.h"
+#include "mat.h"
+
+struct AABB
+{
+    vec3 min, max;
+
+    // An empty box that grows to fit the first point added to it
+    AABB() : min(INFINITY), max(-INFINITY) {}
+    AABB(const vec3 &min, const vec3 &max) : min(min), max(max) {}
+
+    vec3 center() const { return (min + max) * 0.5f; }
+    vec3 extents() const { return (max - min) * 0.5f; }
+
+    void expand(const vec3 &p)
+    {
+        min = vmin(min, p);
+        max = vmax(max, p);
+    }
+
+    bool contains(const vec3 &p) const
+    {
+        return p.x >= min.x && p.y >= min.y && p.z >= min.z &&
+               p.x <= max.x && p.y <= max.y && p.z <= max.z;
+    }
+};
+
+inline AABB merge(const AABB &a, const AABB &b)
+{
+    return AABB(vmin(a.min, b.min), vmax(a.max, b.max));
+}
+
+inline bool overlaps(const AABB &a, const AABB &b)
+{
+    return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+           a.min.y <= b.max.y && a.max.y >= b.min.y &&
+           a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+inline float surfaceArea(const AABB &box)
+{
+    vec3 d = box.max - box.min;
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+// Box enclosing 'box' after transformation by 'm' (Arvo's method)
+AABB transformAABB(const mat4 &m, const AABB &box);
+
+// Points p where dot(normal, p) + d == 0
+struct Plane
+{
+    vec3 normal;
+    float d;
+
+    Plane() : normal(0.0f, 1.0f, 0.0f), d(0.0f) {}
+    Plane(const vec3 &normal, float d) : normal(normal), d(d) {}
+
+    static Plane fromPointNormal(const vec3 &point, const vec3 &normal)
+    {
+        vec3 n = normalize(normal);
+        return Plane(n, -dot(n, point));
+    }
+
+    // Signed distance, positive on the side the normal points to
+    float distance(const vec3 &p) const { return dot(normal, p) + d; }
+};
+
+enum FrustumPlane
+{
+    FRUSTUM_LEFT,
+    FRUSTUM_RIGHT,
+    FRUSTUM_BOTTOM,
+    FRUSTUM_TOP,
+    FRUSTUM_NEAR,
+    FRUSTUM_FAR
+};
+
+// Six inward-facing planes, indexed by FrustumPlane
+struct Frustum
+{
+    Plane planes[6];
+
+    bool containsSphere(const vec3 &center, float radius) const
+    {
+        for (int i = 0; i < 6; i++)
+        {
+            if (planes[i].distance(center) < -radius)
+                return false;
+        }
+        return true;
+    }
+
+    bool containsAABB(const AABB &box) const
+    {
+        vec3 center = box.center();
+        vec3 extents = box.extents();
+        for (int i = 0; i < 6; i++)
+        {
+            const Plane &plane = planes[i];
+            float radius = extents.x * fabsf(plane.normal.x) +
+                           extents.y * fabsf(plane.normal.y) +
+                           extents.z * fabsf(plane.normal.z);
+            if (plane.distance(center) < -radius)
+                return false;
+        }
+        return true;
+    }
+};
+
+// Gribb/Hartmann extraction of normalised planes from a (column-major,
+// OpenGL clip space) view-projection matrix
+Frustum extractFrustum(const mat4 &viewProj);
+Frustum extractFrustumScalar(const mat4 &viewProj);
+
+// Box around the eight corners where the frustum's planes meet
+AABB frustumBounds(const Frustum &frustum);
@@ -0,0 +1,265 @@
+#include "mat.h"
+#include "simd.h"
+
+// Construction
+
+mat4 mat4::translate(const vec3 &offset)
+{
+    mat4 m;
+    m[3] = vec4(offset, 1.0f);
+    return m;
+}
+
+mat4 mat4::scale(const vec3 &factors)
+{
+    mat4 m;
+    m[0].x = factors.x;
+    m[1].y = factors.y;
+    m[2].z = factors.z;
+    return m;
+}
+
+mat4 mat4::rotate(float radians, const vec3 &axis)
+{
+    vec3 n = normalize(axis);
+    float c = cosf(radians);
+    float s = sinf(radians);
+    float t = 1.0f - c;
+
+    return mat4(vec4(t * n.x * n.x + c,       t * n.x * n.y + s * n.z, t * n.x * n.z - s * n.y, 0.0f),
+                vec4(t * n.x * n.y - s * n.z, t * n.y * n.y + c,       t * n.y * n.z + s * n.x, 0.0f),
+                vec4(t * n.x * n.z + s * n.y, t * n.y * n.z - s * n.x, t * n.z * n.z + c,       0.0f),
+                vec4(0.0f, 0.0f, 0.0f, 1.0f));
+}
+
+// OpenGL conventions: right-handed view space, clip z in [-w, w]
+mat4 mat4::perspective(float fovY, float aspect, float zNear, float zFar)
+{
+    float f = 1.0f / tanf(fovY * 0.5f);
+
+    mat4 m(0.0f);
+    m[0].x = f / aspect;
+    m[1].y = f;
+    m[2].z = (zFar + zNear) / (zNear - zFar);
+    m[2].w = -1.0f;
+    m[3].z = 2.0f * zFar * zNear / (zNear - zFar);
+    return m;
+}
+
+mat4 mat4::ortho(float left, float right, float bottom, float top, float zNear, float zFar)
+{
+    mat4 m;
+    m[0].x = 2.0f / (right - left);
+    m[1].y = 2.0f / (top - bottom);
+    m[2].z = -2.0f / (zFar - zNear);
+    m[3] = vec4(-(right + left) / (right - left),
+                -(top + bottom) / (top - bottom),
+                -(zFar + zNear) / (zFar - zNear),
+                1.0f);
+    return m;
+}
+
+mat4 mat4::lookAt(const vec3 &eye, const vec3 &target, const vec3 &up)
+{
+    vec3 f = normalize(target - eye);
+    vec3 s = normalize(cross(f, up));
+    vec3 u = cross(s, f);
+
+    return mat4(vec4(s.x, u.x, -f.x, 0.0f),
+                vec4(s.y, u.y, -f.y, 0.0f),
+                vec4(s.z, u.z, -f.z, 0.0f),
+                vec4(-dot(s, eye), -dot(u, eye), dot(f, eye), 1.0f));
+}
+
+// mat3
+
+mat3 transpose(const mat3 &m)
+{
+    return mat3(vec3(m[0].x, m[1].x, m[2].x),
+                vec3(m[0].y, m[1].y, m[2].y),
+                vec3(m[0].z, m[1].z, m[2].z));
+}
+
+mat3 inverse(const mat3 &m)
+{
+    // Rows of the inverse are the cross products of the columns
+    vec3 r0 = cross(m[1], m[2]);
+    vec3 r1 = cross(m[2], m[0]);
+    vec3 r2 = cross(m[0], m[1]);
+    float invDet = 1.0f / dot(r2, m[2]);
+
+    return transpose(mat3(r0 * invDet, r1 * invDet, r2 * invDet));
+}
+
+// mat4
+
+#ifdef TONIC_SSE2
+
+static inline __m128 Load(const vec4 &v) { return _mm_load_ps(&v.x); }
+static inline void Store(vec4 &v, __m128 value) { _mm_store_ps(&v.x, value); }
+
+#define SHUFFLE(a, b, x, y, z, w) _mm_shuffle_ps(a, b, _MM_SHUFFLE(w, z, y, x))
+#define SWIZZLE(v, x, y, z, w) SHUFFLE(v, v, x, y, z, w)
+
+mat4 transpose(const mat4 &m)
+{
+    __m128 c0 = Load(m[0]), c1 = Load(m[1]), c2 = Load(m[2]), c3 = Load(m[3]);
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+    mat4 result;
+    Store(result[0], c0);
+    Store(result[1], c1);
+    Store(result[2], c2);
+    Store(result[3], c3);
+    return result;
+}
+
+// 2x2 matrices packed as (m00, m01, m10, m11)
+static inline __m128 Mat2Mul(__m128 a, __m128 b)
+{
+    return _mm_add_ps(_mm_mul_ps(a, SWIZZLE(b, 0, 3, 0, 3)),
+                      _mm_mul_ps(SWIZZLE(a, 1, 0, 3, 2), SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+// adj(a) * b
+static inline __m128 Mat2AdjMul(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(SWIZZLE(a, 3, 3, 0, 0), b),
+                      _mm_mul_ps(SWIZZLE(a, 1, 1, 2, 2), SWIZZLE(b, 2, 3, 0, 1)));
+}
+
+// a * adj(b)
+static inline __m128 Mat2MulAdj(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(a, SWIZZLE(b, 3, 0, 3, 0)),
+                      _mm_mul_ps(SWIZZLE(a, 1, 0, 3, 2), SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+// Blockwise inversion: split the matrix into four 2x2 blocks and invert it
+// using their adjugates and determinants. Works on the columns as if they
+// were rows, which is fine since inverse(transpose(M)) = transpose(inverse(M)).
+mat4 inverse(const mat4 &m)
+{
+    __m128 r0 = Load(m[0]), r1 = Load(m[1]), r2 = Load(m[2]), r3 = Load(m[3]);
+
+    __m128 A = _mm_movelh_ps(r0, r1);
+    __m128 B = _mm_movehl_ps(r1, r0);
+    __m128 C = _mm_movelh_ps(r2, r3);
+    __m128 D = _mm_movehl_ps(r3, r2);
+
+    // Determinants of A, B, C and D in one go
+    __m128 detSub = _mm_sub_ps(
+        _mm_mul_ps(SHUFFLE(r0, r2, 0, 2, 0, 2), SHUFFLE(r1, r3, 1, 3, 1, 3)),
+        _mm_mul_ps(SHUFFLE(r0, r2, 1, 3, 1, 3), SHUFFLE(r1, r3, 0, 2, 0, 2)));
+    __m128 detA = SWIZZLE(detSub, 0, 0, 0, 0);
+    __m128 detB = SWIZZLE(detSub, 1, 1, 1, 1);
+    __m128 detC = SWIZZLE(detSub, 2, 2, 2, 2);
+    __m128 detD = SWIZZLE(detSub, 3, 3, 3, 3);
+
+    __m128 D_C = Mat2AdjMul(D, C);
+    __m128 A_B = Mat2AdjMul(A, B);
+    __m128 X = _mm_sub_ps(_mm_mul_ps(detD, A), Mat2Mul(B, D_C));
+    __m128 W = _mm_sub_ps(_mm_mul_ps(detA, D), Mat2Mul(C, A_B));
+    __m128 Y = _mm_sub_ps(_mm_mul_ps(detB, C), Mat2MulAdj(D, A_B));
+    __m128 Z = _mm_sub_ps(_mm_mul_ps(detC, B), Mat2MulAdj(A, D_C));
+
+    __m128 detM = _mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC));
+
+    // Subtract trace(A_B * D_C), summed across lanes without SSE3
+    __m128 tr = _mm_mul_ps(A_B, SWIZZLE(D_C, 0, 2, 1, 3));
+    tr = _mm_add_ps(tr, SWIZZLE(tr, 2, 3, 0, 1));
+    tr = _mm_add_ps(tr, SWIZZLE(tr, 1, 0, 3, 2));
+    detM = _mm_sub_ps(detM, tr);
+
+    __m128 rcpDet = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), detM);
+    X = _mm_mul_ps(X, rcpDet);
+    Y = _mm_mul_ps(Y, rcpDet);
+    Z = _mm_mul_ps(Z, rcpDet);
+    W = _mm_mul_ps(W, rcpDet);
+
+    mat4 result;
+    Store(result[0], SHUFFLE(X, Y, 3, 1, 3, 1));
+    Store(result[1], SHUFFLE(X, Y, 2, 0, 2, 0));
+    Store(result[2], SHUFFLE(Z, W, 3, 1, 3, 1));
+    Store(result[3], SHUFFLE(Z, W, 2, 0, 2, 0));
+    return result;
+}
+
+#undef SWIZZLE
+#undef SHUFFLE
+
+#else
+
+mat4 transpose(const mat4 &m)
+{
+    mat4 result;
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++)
+            result[i][j] = m[j][i];
+    return result;
+}
+
+mat4 inverse(const mat4 &m)
+{
+    return inverseScalar(m);
+}
+
+#endif
+
+mat4 inverseAffine(const mat4 &m)
+{
+    // inverse([R t]) = [inverse(R), -inverse(R) t]
+    mat3 r = inverse(toMat3(m));
+    vec3 t = r * -m[3].xyz();
+
+    mat4 result(r);
+    result[3] = vec4(t, 1.0f);
+    return result;
+}
+
+mat3 toMat3(const mat4 &m)
+{
+    return mat3(m[0].xyz(), m[1].xyz(), m[2].xyz());
+}
+
+mat4 mulScalar(const mat4 &a, const mat4 &b)
+{
+    mat4 result(0.0f);
+    for (int col = 0; col < 4; col++)
+        for (int row = 0; row < 4; row++)
+            for (int k = 0; k < 4; k++)
+                result[col][row] += a[k][row] * b[col][k];
+    return result;
+}
+
+// Cofactor expansion, as in the MESA GLU implementation
+mat4 inverseScalar(const mat4 &mat)
+{
+    const float *m = mat.data();
+    float inv[16];
+
+    inv[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] + m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+    inv[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] - m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+    inv[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] + m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+    inv[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] - m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+    inv[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] - m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+    inv[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] + m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+    inv[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] - m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+    inv[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] + m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+    inv[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15] + m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+    inv[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15] - m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+    inv[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15] + m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+    inv[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14] - m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+    inv[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11] - m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+    inv[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11] + m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+    inv[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] - m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+    inv[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] + m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+
+    float invDet = 1.0f / (m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12]);
+
+    mat4 result;
+    float *out = result.data();
+    for (int i = 0; i < 16; i++)
+        out[i] = inv[i] * invDet;
+    return result;
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "vec.h"
+#include "simd.h"
+
+// Column-major matrices, matching OpenGL's default layout, so data() can be
+// handed directly to glUniformMatrix4fv with transpose = GL_FALSE.
+
+struct mat3
+{
+    vec3 cols[3];
+
+    mat3() : mat3(1.0f) {}
+    explicit mat3(float diagonal)
+    {
+        cols[0] = vec3(diagonal, 0.0f, 0.0f);
+        cols[1] = vec3(0.0f, diagonal, 0.0f);
+        cols[2] = vec3(0.0f, 0.0f, diagonal);
+    }
+    mat3(const vec3 &c0, const vec3 &c1, const vec3 &c2)
+    {
+        cols[0] = c0;
+        cols[1] = c1;
+        cols[2] = c2;
+    }
+
+    vec3 &operator[](int i) { return cols[i]; }
+    const vec3 &operator[](int i) const { return cols[i]; }
+
+    const float *data() const { return &cols[0].x; }
+};
+
+struct alignas(16) mat4
+{
+    vec4 cols[4];
+
+    mat4() : mat4(1.0f) {}
+    explicit mat4(float diagonal)
+    {
+        cols[0] = vec4(diagonal, 0.0f, 0.0f, 0.0f);
+        cols[1] = vec4(0.0f, diagonal, 0.0f, 0.0f);
+        cols[2] = vec4(0.0f, 0.0f, diagonal, 0.0f);
+        cols[3] = vec4(0.0f, 0.0f, 0.0f, diagonal);
+    }
+    mat4(const vec4 &c0, const vec4 &c1, const vec4 &c2, const vec4 &c3)
+    {
+        cols[0] = c0;
+        cols[1] = c1;
+        cols[2] = c2;
+        cols[3] = c3;
+    }
+    explicit mat4(const mat3 &m)
+    {
+        cols[0] = vec4(m[0], 0.0f);
+        cols[1] = vec4(m[1], 0.0f);
+        cols[2] = vec4(m[2], 0.0f);
+        cols[3] = vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+
+    vec4 &operator[](int i) { return cols[i]; }
+    const vec4 &operator[](int i) const { return cols[i]; }
+
+    float *data() { return &cols[0].x; }
+    const float *data() const { return &cols[0].x; }
+
+    static mat4 translate(const vec3 &offset);
+    static mat4 scale(const vec3 &factors);
+    static mat4 rotate(float radians, const vec3 &axis);
+    static mat4 perspective(float fovY, float aspect, float zNear, float zFar);
+    static mat4 ortho(float left, float right, float bottom, float top, float zNear, float zFar);
+    static mat4 lookAt(const vec3 &eye, const vec3 &target, const vec3 &up);
+};
+
+// mat3
+
+inline vec3 operator*(const mat3 &m, const vec3 &v)
+{
+    return m[0] * v.x + m[1] * v.y + m[2] * v.z;
+}
+
+inline mat3 operator*(const mat3 &a, const mat3 &b)
+{
+    return mat3(a * b[0], a * b[1], a * b[2]);
+}
+
+mat3 transpose(const mat3 &m);
+mat3 inverse(const mat3 &m);
+
+// mat4 hot paths, with SSE2 implementations where available. The products
+// are inline so chains of them (e.g. transform hierarchies) stay in
+// registers.
+
+#ifdef TONIC_SSE2
+
+// Linear combination of columns c0-c3 weighted by the lanes of 'v'
+inline __m128 Mat4Combine(__m128 v, __m128 c0, __m128 c1, __m128 c2, __m128 c3)
+{
+    __m128 r = _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)), c0);
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)), c1));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2)), c2));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3)), c3));
+    return r;
+}
+
+inline mat4 operator*(const mat4 &a, const mat4 &b)
+{
+    __m128 c0 = _mm_load_ps(&a[0].x), c1 = _mm_load_ps(&a[1].x);
+    __m128 c2 = _mm_load_ps(&a[2].x), c3 = _mm_load_ps(&a[3].x);
+
+    mat4 result;
+    for (int i = 0; i < 4; i++)
+        _mm_store_ps(&result[i].x, Mat4Combine(_mm_load_ps(&b[i].x), c0, c1, c2, c3));
+    return result;
+}
+
+inline vec4 operator*(const mat4 &m, const vec4 &v)
+{
+    vec4 result;
+    _mm_store_ps(&result.x, Mat4Combine(_mm_load_ps(&v.x),
+                                        _mm_load_ps(&m[0].x), _mm_load_ps(&m[1].x),
+                                        _mm_load_ps(&m[2].x), _mm_load_ps(&m[3].x)));
+    return result;
+}
+
+#else
+
+mat4 mulScalar(const mat4 &a, const mat4 &b);
+
+inline mat4 operator*(const mat4 &a, const mat4 &b)
+{
+    return mulScalar(a, b);
+}
+
+inline vec4 operator*(const mat4 &m, const vec4 &v)
+{
+    return m[0] * v.x + m[1] * v.y + m[2] * v.z + m[3] * v.w;
+}
+
+#endif
+
+mat4 transpose(const mat4 &m);
+mat4 inverse(const mat4 &m);
+
+// Inverse of a matrix made only of rotation, scale and translation, which
+// is much cheaper than the general case
+mat4 inverseAffine(const mat4 &m);
+
+// Upper-left 3x3, e.g. for normal matrices
+mat3 toMat3(const mat4 &m);
+
+inline vec3 transformPoint(const mat4 &m, const vec3 &p)
+{
+    return (m * vec4(p, 1.0f)).xyz();
+}
+
+inline vec3 transformVector(const mat4 &m, const vec3 &v)
+{
+    return (m * vec4(v, 0.0f)).xyz();
+}
+
+// Scalar reference implementations, used as the fallback when SIMD is not
+// available and by the benchmarks to measure the SIMD paths against
+mat4 mulScalar(const mat4 &a, const mat4 &b);
+mat4 inverseScalar(const mat4 &m);
@@ -0,0 +1,49 @@
+#include "quat.h"
+
+quat slerp(const quat &a, const quat &b, float t)
+{
+    // Take the shorter way round
+    quat end = b;
+    float cosTheta = dot(a, b);
+    if (cosTheta < 0.0f)
+    {
+        end = quat(-b.x, -b.y, -b.z, -b.w);
+        cosTheta = -cosTheta;
+    }
+
+    float wa, wb;
+    if (cosTheta > 0.9995f)
+    {
+        // Nearly parallel, so linear interpolation is accurate and stable
+        wa = 1.0f - t;
+        wb = t;
+    }
+    else
+    {
+        float theta = acosf(cosTheta);
+        float sinTheta = sinf(theta);
+        wa = sinf((1.0f - t) * theta) / sinTheta;
+        wb = sinf(t * theta) / sinTheta;
+    }
+
+    return normalize(quat(a.x * wa + end.x * wb,
+                          a.y * wa + end.y * wb,
+                          a.z * wa + end.z * wb,
+                          a.w * wa + end.w * wb));
+}
+
+mat3 toMat3(const quat &q)
+{
+    float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+    return mat3(vec3(1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy)),
+                vec3(2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx)),
+                vec3(2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy)));
+}
+
+mat4 toMat4(const quat &q)
+{
+    return mat4(toMat3(q));
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "vec.h"
+#include "mat.h"
+
+// Unit quaternion for rotations. w is the scalar part.
+struct alignas(16) quat
+{
+    float x, y, z, w;
+
+    quat() : x(0.0f), y(0.0f), z(0.0f), w(1.0f) {}
+    quat(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+
+    static quat axisAngle(const vec3 &axis, float radians)
+    {
+        vec3 n = normalize(axis);
+        float s = sinf(radians * 0.5f);
+        return quat(n.x * s, n.y * s, n.z * s, cosf(radians * 0.5f));
+    }
+};
+
+inline quat operator*(const quat &a, const quat &b)
+{
+    return quat(a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+                a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+                a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+                a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z);
+}
+
+inline float dot(const quat &a, const quat &b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+
+inline quat normalize(const quat &q)
+{
+    float inv = 1.0f / sqrtf(dot(q, q));
+    return quat(q.x * inv, q.y * inv, q.z * inv, q.w * inv);
+}
+
+inline quat conjugate(const quat &q)
+{
+    return quat(-q.x, -q.y, -q.z, q.w);
+}
+
+// Rotates v by q (assumed unit length)
+inline vec3 operator*(const quat &q, const vec3 &v)
+{
+    vec3 u(q.x, q.y, q.z);
+    vec3 t = cross(u, v) * 2.0f;
+    return v + t * q.w + cross(u, t);
+}
+
+quat slerp(const quat &a, const quat &b, float t);
+mat3 toMat3(const quat &q);
+mat4 toMat4(const quat &q);
+
+// Translation * rotation * scale, the usual way to build a model matrix.
+// This is toMat3 with each column scaled, written out so the compiler can
+// keep everything in registers; scene graphs call it once per dirty node.
+inline mat4 composeTransform(const vec3 &translation, const quat &rotation, const vec3 &scale)
+{
+    float xx = rotation.x * rotation.x, yy = rotation.y * rotation.y, zz = rotation.z * rotation.z;
+    float xy = rotation.x * rotation.y, xz = rotation.x * rotation.z, yz = rotation.y * rotation.z;
+    float wx = rotation.w * rotation.x, wy = rotation.w * rotation.y, wz = rotation.w * rotation.z;
+
+#ifdef TONIC_SSE2
+    // Build the columns in registers. Writing them as scalars and then
+    // reading them back as vectors would stall on store forwarding.
+    mat4 m;
+    _mm_store_ps(&m[0].x, _mm_mul_ps(_mm_setr_ps(1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f), _mm_set1_ps(scale.x)));
+    _mm_store_ps(&m[1].x, _mm_mul_ps(_mm_setr_ps(2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0.0f), _mm_set1_ps(scale.y)));
+    _mm_store_ps(&m[2].x, _mm_mul_ps(_mm_setr_ps(2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0.0f), _mm_set1_ps(scale.z)));
+    _mm_store_ps(&m[3].x, _mm_setr_ps(translation.x, translation.y, translation.z, 1.0f));
+    return m;
+#else
+    return mat4(vec4((1.0f - 2.0f * (yy + zz)) * scale.x, 2.0f * (xy + wz) * scale.x, 2.0f * (xz - wy) * scale.x, 0.0f),
+                vec4(2.0f * (xy - wz) * scale.y, (1.0f - 2.0f * (xx + zz)) * scale.y, 2.0f * (yz + wx) * scale.y, 0.0f),
+                vec4(2.0f * (xz + wy) * scale.z, 2.0f * (yz - wx) * scale.z, (1.0f - 2.0f * (xx + yy)) * scale.z, 0.0f),
+                vec4(translation, 1.0f));
+#endif
+}
@@ -0,0 +1,40 @@
+#include "simd.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+static bool DetectAVX2()
+{
+#if !defined(TONIC_AVX2)
+    return false;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+
+    // OSXSAVE and FMA (leaf 1), then AVX2 (leaf 7)
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool fma = (info[2] & (1 << 12)) != 0;
+    if (!osxsave || !fma)
+        return false;
+
+    // The OS must save the YMM registers on context switch
+    if ((_xgetbv(0) & 6) != 6)
+        return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+
+bool CpuHasAVX2()
+{
+    static bool hasAVX2 = DetectAVX2();
+    return hasAVX2;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+// SIMD feature selection for the math module.
+//
+// SSE2 is part of the x86-64 baseline, so it is used whenever the compiler
+// targets x86-64. AVX2 is not, so AVX2 paths are compiled with a per-function
+// target attribute and only called after a runtime CPU check. Define
+// TONIC_MATH_SCALAR to force the scalar fallbacks everywhere.
+
+#if !defined(TONIC_MATH_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define TONIC_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(TONIC_SSE2) && (defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER))
+#define TONIC_AVX2 1
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TONIC_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define TONIC_TARGET_AVX2
+#endif
+
+// True when the running CPU supports AVX2 and FMA. Cached after first call.
+bool CpuHasAVX2();
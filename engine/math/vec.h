@@ -0,0 +1,120 @@
+#pragma once
+
+#include <math.h>
+
+// Small vector types laid out like their GLSL counterparts, so they can be
+// copied straight into vertex, uniform and storage buffers.
+
+struct vec2
+{
+    static const int size = 2;
+
+    float x, y;
+
+    vec2() : x(0.0f), y(0.0f) {}
+    vec2(float s) : x(s), y(s) {}
+    vec2(float x, float y) : x(x), y(y) {}
+
+    float &operator[](int i) { return (&x)[i]; }
+    float operator[](int i) const { return (&x)[i]; }
+};
+
+struct vec3
+{
+    static const int size = 3;
+
+    float x, y, z;
+
+    vec3() : x(0.0f), y(0.0f), z(0.0f) {}
+    vec3(float s) : x(s), y(s), z(s) {}
+    vec3(float x, float y, float z) : x(x), y(y), z(z) {}
+
+    float &operator[](int i) { return (&x)[i]; }
+    float operator[](int i) const { return (&x)[i]; }
+};
+
+struct alignas(16) vec4
+{
+    static const int size = 4;
+
+    float x, y, z, w;
+
+    vec4() : x(0.0f), y(0.0f), z(0.0f), w(0.0f) {}
+    vec4(float s) : x(s), y(s), z(s), w(s) {}
+    vec4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+    vec4(const vec3 &v, float w) : x(v.x), y(v.y), z(v.z), w(w) {}
+
+    vec3 xyz() const { return vec3(x, y, z); }
+
+    float &operator[](int i) { return (&x)[i]; }
+    float operator[](int i) const { return (&x)[i]; }
+};
+
+// Component-wise operators and common functions, generated for each
+// vector type. Loops over T::size are fully unrolled by the compiler.
+// min/max are named vmin/vmax so they survive <Windows.h>'s macros.
+
+#define VEC_OPERATORS(T)                                        \
+    inline T operator+(T a, const T &b)                         \
+    {                                                           \
+        for (int i = 0; i < T::size; i++) a[i] += b[i];         \
+        return a;                                               \
+    }                                                           \
+    inline T operator-(T a, const T &b)                         \
+    {                                                           \
+        for (int i = 0; i < T::size; i++) a[i] -= b[i];         \
+        return a;                                               \
+    }                                                           \
+    inline T operator*(T a, const T &b)                         \
+    {                                                           \
+        for (int i = 0; i < T::size; i++) a[i] *= b[i];         \
+        return a;                                               \
+    }                                                           \
+    inline T operator/(T a, const T &b)                         \
+    {                                                           \
+        for (int i = 0; i < T::size; i++) a[i] /= b[i];         \
+        return a;                                               \
+    }                                                           \
+    inline T operator*(T a, float s)                            \
+    {                                                           \
+        for (int i = 0; i < T::size; i++) a[i] *= s;            \
+        return a;                                               \
+    }                                                           \
+    inline T operator*(float s, const T &a) { return a * s; }   \
+    inline T operator/(const T &a, float s) { return a * (1.0f / s); } \
+    inline T operator-(const T &a) { return a * -1.0f; }        \
+    inline T &operator+=(T &a, const T &b) { return a = a + b; } \
+    inline T &operator-=(T &a, const T &b) { return a = a - b; } \
+    inline T &operator*=(T &a, float s) { return a = a * s; }   \
+    inline float dot(const T &a, const T &b)                    \
+    {                                                           \
+        float sum = 0.0f;                                       \
+        for (int i = 0; i < T::size; i++) sum += a[i] * b[i];   \
+        return sum;                                             \
+    }                                                           \
+    inline float length(const T &v) { return sqrtf(dot(v, v)); } \
+    inline T normalize(const T &v) { return v / length(v); }    \
+    inline T vmin(T a, const T &b)                               \
+    {                                                           \
+        for (int i = 0; i < T::size; i++) a[i] = fminf(a[i], b[i]); \
+        return a;                                               \
+    }                                                           \
+    inline T vmax(T a, const T &b)                               \
+    {                                                           \
+        for (int i = 0; i < T::size; i++) a[i] = fmaxf(a[i], b[i]); \
+        return a;                                               \
+    }                                                           \
+    inline T lerp(const T &a, const T &b, float t) { return a + (b - a) * t; }
+
+VEC_OPERATORS(vec2)
+VEC_OPERATORS(vec3)
+VEC_OPERATORS(vec4)
+
+#undef VEC_OPERATORS
+
+inline vec3 cross(const vec3 &a, const vec3 &b)
+{
+    return vec3(a.y * b.z - a.z * b.y,
+                a.z * b.x - a.x * b.z,
+                a.x * b.y - a.y * b.x);
+}
@@ -52,9 +52,82 @@ public:
     GLDefineFunc(glEnableVertexAttribArray, GLENABLEVERTEXATTRIBARRAY);
     GLDefineFunc(glUseProgram, GLUSEPROGRAM);
     GLDefineFunc(glGetUniformLocation, GLGETUNIFORMLOCATION);
+    GLDefineFunc(glGetActiveUniform, GLGETACTIVEUNIFORM);
     GLDefineFunc(glUniform4f, GLUNIFORM4F);
     GLDefineFunc(glUniform1f, GLUNIFORM1F);
     GLDefineFunc(glUniform1i, GLUNIFORM1I);
+
+    // Instancing
+    GLDefineFunc(glBufferSubData, GLBUFFERSUBDATA);
+    GLDefineFunc(glVertexAttribDivisor, GLVERTEXATTRIBDIVISOR);
+    GLDefineFunc(glDrawArraysInstanced, GLDRAWARRAYSINSTANCED);
+    GLDefineFunc(glDrawElementsInstanced, GLDRAWELEMENTSINSTANCED);
+    GLDefineFunc(glUniformMatrix4fv, GLUNIFORMMATRIX4FV);
+
+    // Multi-draw indirect
+    GLDefineFunc(glVertexAttribIPointer, GLVERTEXATTRIBIPOINTER);
+    GLDefineFunc(glBufferStorage, GLBUFFERSTORAGE);
+    GLDefineFunc(glMapBufferRange, GLMAPBUFFERRANGE);
+    GLDefineFunc(glBindBufferBase, GLBINDBUFFERBASE);
+    GLDefineFunc(glBindBufferRange, GLBINDBUFFERRANGE);
+    GLDefineFunc(glMultiDrawElementsIndirect, GLMULTIDRAWELEMENTSINDIRECT);
+    GLDefineFunc(glFenceSync, GLFENCESYNC);
+    GLDefineFunc(glClientWaitSync, GLCLIENTWAITSYNC);
+    GLDefineFunc(glDeleteSync, GLDELETESYNC);
+
+    // Compute
+    GLDefineFunc(glDispatchCompute, GLDISPATCHCOMPUTE);
+    GLDefineFunc(glMemoryBarrier, GLMEMORYBARRIER);
+    GLDefineFunc(glBindImageTexture, GLBINDIMAGETEXTURE);
+    GLDefineFunc(glTexStorage2D, GLTEXSTORAGE2D);
+    GLDefineFunc(glActiveTexture, GLACTIVETEXTURE);
+    GLDefineFunc(glUniform2f, GLUNIFORM2F);
+    GLDefineFunc(glUniform4fv, GLUNIFORM4FV);
+
+    // Uniform buffers
+    GLDefineFunc(glGetUniformBlockIndex, GLGETUNIFORMBLOCKINDEX);
+    GLDefineFunc(glUniformBlockBinding, GLUNIFORMBLOCKBINDING);
+
+    // Freeing objects
+    GLDefineFunc(glDeleteProgram, GLDELETEPROGRAM);
+    GLDefineFunc(glDeleteBuffers, GLDELETEBUFFERS);
+    GLDefineFunc(glDeleteVertexArrays, GLDELETEVERTEXARRAYS);
+
+    // Framebuffers
+    GLDefineFunc(glGenFramebuffers, GLGENFRAMEBUFFERS);
+    GLDefineFunc(glDeleteFramebuffers, GLDELETEFRAMEBUFFERS);
+    GLDefineFunc(glBindFramebuffer, GLBINDFRAMEBUFFER);
+    GLDefineFunc(glFramebufferTexture2D, GLFRAMEBUFFERTEXTURE2D);
+    GLDefineFunc(glCheckFramebufferStatus, GLCHECKFRAMEBUFFERSTATUS);
+    GLDefineFunc(glDrawBuffers, GLDRAWBUFFERS);
+    GLDefineFunc(glClearBufferfv, GLCLEARBUFFERFV);
+    GLDefineFunc(glGenRenderbuffers, GLGENRENDERBUFFERS);
+    GLDefineFunc(glDeleteRenderbuffers, GLDELETERENDERBUFFERS);
+    GLDefineFunc(glBindRenderbuffer, GLBINDRENDERBUFFER);
+    GLDefineFunc(glRenderbufferStorage, GLRENDERBUFFERSTORAGE);
+    GLDefineFunc(glFramebufferRenderbuffer, GLFRAMEBUFFERRENDERBUFFER);
+    GLDefineFunc(glBlitFramebuffer, GLBLITFRAMEBUFFER);
+
+    // Timer queries
+    GLDefineFunc(glGenQueries, GLGENQUERIES);
+    GLDefineFunc(glDeleteQueries, GLDELETEQUERIES);
+    GLDefineFunc(glQueryCounter, GLQUERYCOUNTER);
+    GLDefineFunc(glGetQueryObjectiv, GLGETQUERYOBJECTIV);
+    GLDefineFunc(glGetQueryObjectui64v, GLGETQUERYOBJECTUI64V);
+
+    // Texture arrays
+    GLDefineFunc(glTexStorage3D, GLTEXSTORAGE3D);
+    GLDefineFunc(glFramebufferTextureLayer, GLFRAMEBUFFERTEXTURELAYER);
+
+    // Indirect draws and dispatches
+    GLDefineFunc(glDrawArraysIndirect, GLDRAWARRAYSINDIRECT);
+    GLDefineFunc(glDispatchComputeIndirect, GLDISPATCHCOMPUTEINDIRECT);
+    GLDefineFunc(glGetStringi, GLGETSTRINGI);
+
+    // Optional: null unless the context is GL 4.6 or has
+    // ARB_indirect_parameters, which has the same signature
+    GLDefineFunc(glMultiDrawElementsIndirectCount, GLMULTIDRAWELEMENTSINDIRECTCOUNT);
+
 protected:
     OpenGL() {}
 };
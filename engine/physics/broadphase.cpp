@@ -0,0 +1,30 @@
+#include "broadphase.h"
+
+int SweepAndPrune::add(const Bounds2D &box, int owner)
+{
+    int proxy;
+    if (!freeProxies.empty())
+    {
+        proxy = freeProxies.back();
+        freeProxies.pop_back();
+        bounds[proxy] = box;
+        owners[proxy] = owner;
+    }
+    else
+    {
+        proxy = (int)bounds.size();
+        bounds.push_back(box);
+        owners.push_back(owner);
+    }
+
+    // Appended at the end; the next sort moves it into place
+    sorted.push_back(Entry{box.min.x, proxy});
+    return proxy;
+}
+
+void SweepAndPrune::remove(int proxy)
+{
+    // Dropped from the sorted array lazily, at the next findPairs()
+    owners[proxy] = -1;
+    removedProxies.push_back(proxy);
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "shape.h"
+
+#include <vector>
+
+// Sweep and prune along x. Proxies are kept in an array sorted by the
+// left edge of their bounds; bodies move little between steps, so the
+// array stays nearly sorted and an insertion sort puts it right again in
+// close to linear time. Pairs are then found in one sweep: each proxy
+// only needs checking against those that start before it ends.
+class SweepAndPrune
+{
+private:
+    struct Entry
+    {
+        float minX; // copy of bounds[proxy].min.x, for a compact sort
+        int proxy;
+    };
+
+    std::vector<Bounds2D> bounds;
+    std::vector<int> owners;     // per proxy, or -1 once removed
+    std::vector<int> freeProxies;
+    std::vector<Entry> sorted;
+
+    // Still in 'sorted', so not reusable until the next findPairs()
+    std::vector<int> removedProxies;
+
+public:
+    // 'owner' is passed back with each pair
+    int add(const Bounds2D &box, int owner);
+    void remove(int proxy);
+    void setBounds(int proxy, const Bounds2D &box) { bounds[proxy] = box; }
+    const Bounds2D &getBounds(int proxy) const { return bounds[proxy]; }
+
+    // Re-sorts, then calls fn(ownerA, ownerB) for every pair of proxies
+    // whose bounds overlap
+    template <typename F>
+    void findPairs(F &&fn);
+};
+
+template <typename F>
+void SweepAndPrune::findPairs(F &&fn)
+{
+    if (!removedProxies.empty())
+    {
+        size_t kept = 0;
+        for (const Entry &entry : sorted)
+        {
+            if (owners[entry.proxy] >= 0)
+                sorted[kept++] = entry;
+        }
+        sorted.resize(kept);
+        freeProxies.insert(freeProxies.end(), removedProxies.begin(), removedProxies.end());
+        removedProxies.clear();
+    }
+
+    Entry *entries = sorted.data();
+    int count = (int)sorted.size();
+    for (int i = 0; i < count; i++)
+    {
+        entries[i].minX = bounds[entries[i].proxy].min.x;
+
+        Entry entry = entries[i];
+        int j = i - 1;
+        while (j >= 0 && entries[j].minX > entry.minX)
+        {
+            entries[j + 1] = entries[j];
+            j--;
+        }
+        entries[j + 1] = entry;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        const Bounds2D &a = bounds[entries[i].proxy];
+        for (int j = i + 1; j < count && entries[j].minX <= a.max.x; j++)
+        {
+            const Bounds2D &b = bounds[entries[j].proxy];
+            if (a.min.y <= b.max.y && a.max.y >= b.min.y)
+                fn(owners[entries[i].proxy], owners[entries[j].proxy]);
+        }
+    }
+}
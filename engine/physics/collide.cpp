@@ -0,0 +1,343 @@
+#include "collide.h"
+
+#include "../math/simd.h"
+
+// Reference face choice prefers A unless B's is clearly better, which
+// keeps the choice from flip-flopping between steps
+#define REFERENCE_FACE_TOLERANCE 0.0005f
+
+// Manifold point ids: the feature on the incident shape, the reference
+// edge, and whether B provided the reference face
+#define CONTACT_ID(flip, referenceEdge, feature) (((flip) << 16) | ((referenceEdge) << 8) | (feature))
+#define CLIPPED_FEATURE 0x80
+
+// Minimum over a polygon's vertices of dot((nx, ny), vertex)
+static inline float MinProjection(const Shape &polygon, float nx, float ny)
+{
+#ifdef TONIC_SSE2
+    __m128 x = _mm_set1_ps(nx), y = _mm_set1_ps(ny);
+    __m128 best = _mm_add_ps(_mm_mul_ps(x, _mm_load_ps(polygon.vx)), _mm_mul_ps(y, _mm_load_ps(polygon.vy)));
+    if (polygon.count > 4)
+    {
+        __m128 upper = _mm_add_ps(_mm_mul_ps(x, _mm_load_ps(polygon.vx + 4)), _mm_mul_ps(y, _mm_load_ps(polygon.vy + 4)));
+        best = _mm_min_ps(best, upper);
+    }
+    best = _mm_min_ps(best, _mm_shuffle_ps(best, best, _MM_SHUFFLE(1, 0, 3, 2)));
+    best = _mm_min_ps(best, _mm_shuffle_ps(best, best, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(best);
+#else
+    float best = nx * polygon.vx[0] + ny * polygon.vy[0];
+    for (int i = 1; i < polygon.count; i++)
+        best = fminf(best, nx * polygon.vx[i] + ny * polygon.vy[i]);
+    return best;
+#endif
+}
+
+// Largest separation of 'b' along the edge normals of 'a', and the edge
+static void FindMaxSeparation(const Shape &a, const Transform2D &xfA, const Shape &b, const Transform2D &xfB,
+                              int *edge, float *separation)
+{
+    // Work in b's frame, where its vertices already are
+    float bestSeparation = -INFINITY;
+    int bestEdge = 0;
+    for (int i = 0; i < a.count; i++)
+    {
+        vec2 n = xfB.inverseRotate(xfA.rotate(a.normal(i)));
+        vec2 v = xfB.inverseApply(xfA.apply(a.vertex(i)));
+        float s = MinProjection(b, n.x, n.y) - dot(n, v);
+        if (s > bestSeparation)
+        {
+            bestSeparation = s;
+            bestEdge = i;
+        }
+    }
+    *edge = bestEdge;
+    *separation = bestSeparation;
+}
+
+void CollideCircles(const Shape &a, const Transform2D &xfA, const Shape &b, const Transform2D &xfB,
+                    float margin, Manifold &manifold)
+{
+    manifold.count = 0;
+
+    vec2 d = xfB.position - xfA.position;
+    float radius = a.radius + b.radius;
+    float distanceSq = dot(d, d);
+    if (distanceSq > (radius + margin) * (radius + margin))
+        return;
+
+    float distance = sqrtf(distanceSq);
+    vec2 normal = distance > 1e-6f ? d / distance : vec2(0.0f, 1.0f);
+    float separation = distance - radius;
+
+    manifold.normal = normal;
+    manifold.points[0].point = xfA.position + normal * (a.radius + 0.5f * separation);
+    manifold.points[0].separation = separation;
+    manifold.points[0].id = 0;
+    manifold.count = 1;
+}
+
+void CollideCircles4(const float *ax, const float *ay, const float *ar,
+                     const float *bx, const float *by, const float *br,
+                     float margin, Manifold manifolds[4])
+{
+#ifdef TONIC_SSE2
+    __m128 dx = _mm_sub_ps(_mm_loadu_ps(bx), _mm_loadu_ps(ax));
+    __m128 dy = _mm_sub_ps(_mm_loadu_ps(by), _mm_loadu_ps(ay));
+    __m128 radiusA = _mm_loadu_ps(ar);
+    __m128 radius = _mm_add_ps(radiusA, _mm_loadu_ps(br));
+    __m128 reach = _mm_add_ps(radius, _mm_set1_ps(margin));
+
+    __m128 distanceSq = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+    int touching = _mm_movemask_ps(_mm_cmple_ps(distanceSq, _mm_mul_ps(reach, reach)));
+    if (!touching)
+    {
+        for (int i = 0; i < 4; i++)
+            manifolds[i].count = 0;
+        return;
+    }
+
+    // Coincident centres get an arbitrary upward normal
+    __m128 distance = _mm_sqrt_ps(distanceSq);
+    __m128 apart = _mm_cmpgt_ps(distance, _mm_set1_ps(1e-6f));
+    __m128 invDistance = _mm_div_ps(_mm_set1_ps(1.0f), _mm_max_ps(distance, _mm_set1_ps(1e-6f)));
+    __m128 normalX = _mm_and_ps(apart, _mm_mul_ps(dx, invDistance));
+    __m128 normalY = _mm_or_ps(_mm_and_ps(apart, _mm_mul_ps(dy, invDistance)),
+                               _mm_andnot_ps(apart, _mm_set1_ps(1.0f)));
+
+    __m128 separation = _mm_sub_ps(distance, radius);
+    __m128 offset = _mm_add_ps(radiusA, _mm_mul_ps(separation, _mm_set1_ps(0.5f)));
+    __m128 pointX = _mm_add_ps(_mm_loadu_ps(ax), _mm_mul_ps(normalX, offset));
+    __m128 pointY = _mm_add_ps(_mm_loadu_ps(ay), _mm_mul_ps(normalY, offset));
+
+    alignas(16) float nx[4], ny[4], px[4], py[4], s[4];
+    _mm_store_ps(nx, normalX);
+    _mm_store_ps(ny, normalY);
+    _mm_store_ps(px, pointX);
+    _mm_store_ps(py, pointY);
+    _mm_store_ps(s, separation);
+
+    for (int i = 0; i < 4; i++)
+    {
+        Manifold &manifold = manifolds[i];
+        manifold.count = (touching >> i) & 1;
+        manifold.normal = vec2(nx[i], ny[i]);
+        manifold.points[0].point = vec2(px[i], py[i]);
+        manifold.points[0].separation = s[i];
+        manifold.points[0].id = 0;
+    }
+#else
+    for (int i = 0; i < 4; i++)
+    {
+        Shape a = MakeCircle(ar[i]), b = MakeCircle(br[i]);
+        CollideCircles(a, Transform2D(vec2(ax[i], ay[i]), 0.0f), b, Transform2D(vec2(bx[i], by[i]), 0.0f),
+                       margin, manifolds[i]);
+    }
+#endif
+}
+
+void CollidePolygonCircle(const Shape &polygon, const Transform2D &xfA, const Shape &circle, const Transform2D &xfB,
+                          float margin, Manifold &manifold)
+{
+    manifold.count = 0;
+
+    // Circle centre in the polygon's frame, and its distance in front of
+    // every edge
+    vec2 c = xfA.inverseApply(xfB.position);
+    // Must stay zeroed: the edge search below reads separations[0]
+    // whatever the vertex count, and neither the SSE nor the scalar loop
+    // writes it for a polygon without vertices
+    alignas(16) float separations[PHYSICS_MAX_POLYGON_VERTICES] = {};
+#ifdef TONIC_SSE2
+    __m128 cx = _mm_set1_ps(c.x), cy = _mm_set1_ps(c.y);
+    for (int i = 0; i < polygon.count; i += 4)
+    {
+        __m128 x = _mm_mul_ps(_mm_load_ps(polygon.nx + i), _mm_sub_ps(cx, _mm_load_ps(polygon.vx + i)));
+        __m128 y = _mm_mul_ps(_mm_load_ps(polygon.ny + i), _mm_sub_ps(cy, _mm_load_ps(polygon.vy + i)));
+        _mm_store_ps(separations + i, _mm_add_ps(x, y));
+    }
+#else
+    for (int i = 0; i < polygon.count; i++)
+        separations[i] = dot(polygon.normal(i), c - polygon.vertex(i));
+#endif
+
+    int edge = 0;
+    for (int i = 1; i < polygon.count; i++)
+    {
+        if (separations[i] > separations[edge])
+            edge = i;
+    }
+    if (separations[edge] > circle.radius + margin)
+        return;
+
+    vec2 v1 = polygon.vertex(edge);
+    vec2 v2 = polygon.vertex((edge + 1) % polygon.count);
+
+    // Nearest feature: a vertex if the centre lies outside the polygon
+    // and beyond either end of the edge, the edge itself otherwise
+    float faceSeparation = separations[edge];
+    vec2 normal = polygon.normal(edge), surface;
+    bool vertexRegion = false;
+    if (faceSeparation > 0.0f && dot(c - v1, v2 - v1) <= 0.0f)
+    {
+        surface = v1;
+        vertexRegion = true;
+    }
+    else if (faceSeparation > 0.0f && dot(c - v2, v1 - v2) <= 0.0f)
+    {
+        surface = v2;
+        vertexRegion = true;
+    }
+
+    if (vertexRegion)
+    {
+        float distance = length(c - surface);
+        if (distance > circle.radius + margin)
+            return;
+        if (distance > 1e-6f)
+            normal = (c - surface) / distance;
+    }
+    else
+    {
+        surface = c - normal * faceSeparation;
+    }
+
+    float separation = dot(c - surface, normal) - circle.radius;
+    vec2 point = surface + normal * (0.5f * separation);
+
+    manifold.normal = xfA.rotate(normal);
+    manifold.points[0].point = xfA.apply(point);
+    manifold.points[0].separation = separation;
+    manifold.points[0].id = 0;
+    manifold.count = 1;
+}
+
+struct ClipVertex
+{
+    vec2 v;
+    unsigned int id;
+};
+
+// Keeps the part of segment 'in' behind the line dot(normal, p) = offset
+static int ClipSegment(ClipVertex out[2], const ClipVertex in[2], const vec2 &normal, float offset, unsigned int id)
+{
+    float d0 = dot(normal, in[0].v) - offset;
+    float d1 = dot(normal, in[1].v) - offset;
+
+    int count = 0;
+    if (d0 <= 0.0f)
+        out[count++] = in[0];
+    if (d1 <= 0.0f)
+        out[count++] = in[1];
+
+    if (d0 * d1 < 0.0f)
+    {
+        float t = d0 / (d0 - d1);
+        out[count].v = in[0].v + (in[1].v - in[0].v) * t;
+        out[count].id = id;
+        count++;
+    }
+    return count;
+}
+
+void CollidePolygons(const Shape &a, const Transform2D &xfA, const Shape &b, const Transform2D &xfB,
+                     float margin, Manifold &manifold)
+{
+    manifold.count = 0;
+
+    int edgeA, edgeB;
+    float separationA, separationB;
+    FindMaxSeparation(a, xfA, b, xfB, &edgeA, &separationA);
+    if (separationA > margin)
+        return;
+    FindMaxSeparation(b, xfB, a, xfA, &edgeB, &separationB);
+    if (separationB > margin)
+        return;
+
+    // The reference face is the one with the larger separation; the
+    // incident shape's edge facing it is clipped against its sides
+    const Shape *reference = &a, *incident = &b;
+    const Transform2D *xfReference = &xfA, *xfIncident = &xfB;
+    int edge = edgeA;
+    unsigned int flip = 0;
+    if (separationB > separationA + REFERENCE_FACE_TOLERANCE)
+    {
+        reference = &b;
+        incident = &a;
+        xfReference = &xfB;
+        xfIncident = &xfA;
+        edge = edgeB;
+        flip = 1;
+    }
+
+    // Incident edge: the one most opposed to the reference normal
+    vec2 referenceNormal = xfIncident->inverseRotate(xfReference->rotate(reference->normal(edge)));
+    int incidentEdge = 0;
+    float minDot = INFINITY;
+    for (int i = 0; i < incident->count; i++)
+    {
+        float d = dot(referenceNormal, incident->normal(i));
+        if (d < minDot)
+        {
+            minDot = d;
+            incidentEdge = i;
+        }
+    }
+
+    int next = (incidentEdge + 1) % incident->count;
+    ClipVertex incidentVertices[2];
+    incidentVertices[0].v = xfIncident->apply(incident->vertex(incidentEdge));
+    incidentVertices[0].id = CONTACT_ID(flip, (unsigned int)edge, (unsigned int)incidentEdge);
+    incidentVertices[1].v = xfIncident->apply(incident->vertex(next));
+    incidentVertices[1].id = CONTACT_ID(flip, (unsigned int)edge, (unsigned int)next);
+
+    vec2 v1 = xfReference->apply(reference->vertex(edge));
+    vec2 v2 = xfReference->apply(reference->vertex((edge + 1) % reference->count));
+    vec2 tangent = normalize(v2 - v1);
+    vec2 normal(tangent.y, -tangent.x);
+
+    ClipVertex clipped1[2], clipped2[2];
+    if (ClipSegment(clipped1, incidentVertices, -tangent, -dot(tangent, v1),
+                    CONTACT_ID(flip, (unsigned int)edge, CLIPPED_FEATURE)) < 2)
+        return;
+    if (ClipSegment(clipped2, clipped1, tangent, dot(tangent, v2),
+                    CONTACT_ID(flip, (unsigned int)edge, CLIPPED_FEATURE + 1)) < 2)
+        return;
+
+    float frontOffset = dot(normal, v1);
+    for (int i = 0; i < 2; i++)
+    {
+        float separation = dot(normal, clipped2[i].v) - frontOffset;
+        if (separation > margin)
+            continue;
+
+        ManifoldPoint &point = manifold.points[manifold.count++];
+        point.point = clipped2[i].v - normal * (0.5f * separation);
+        point.separation = separation;
+        point.id = clipped2[i].id;
+    }
+
+    manifold.normal = flip ? -normal : normal;
+}
+
+void Collide(const Shape &a, const Transform2D &xfA, const Shape &b, const Transform2D &xfB,
+             float margin, Manifold &manifold)
+{
+    if (a.type == SHAPE_CIRCLE && b.type == SHAPE_CIRCLE)
+    {
+        CollideCircles(a, xfA, b, xfB, margin, manifold);
+    }
+    else if (a.type == SHAPE_POLYGON && b.type == SHAPE_CIRCLE)
+    {
+        CollidePolygonCircle(a, xfA, b, xfB, margin, manifold);
+    }
+    else if (a.type == SHAPE_CIRCLE)
+    {
+        CollidePolygonCircle(b, xfB, a, xfA, margin, manifold);
+        manifold.normal = -manifold.normal;
+    }
+    else
+    {
+        CollidePolygons(a, xfA, b, xfB, margin, manifold);
+    }
+}
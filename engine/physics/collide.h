@@ -0,0 +1,43 @@
+#pragma once
+
+#include "shape.h"
+
+#define MAX_MANIFOLD_POINTS 2
+
+struct ManifoldPoint
+{
+    vec2 point;       // world space, halfway between the two surfaces
+    float separation; // negative when penetrating
+
+    // Identifies the pair of features that produced the point, so its
+    // impulse can carry over from the previous step
+    unsigned int id;
+};
+
+// Contact points between two shapes. Points are reported while the
+// shapes are closer than the margin passed in, not only when they
+// overlap, so the solver can stop bodies before they touch.
+struct Manifold
+{
+    vec2 normal; // world space, from A towards B
+    ManifoldPoint points[MAX_MANIFOLD_POINTS];
+    int count;
+};
+
+void CollideCircles(const Shape &a, const Transform2D &xfA, const Shape &b, const Transform2D &xfB,
+                    float margin, Manifold &manifold);
+void CollidePolygonCircle(const Shape &polygon, const Transform2D &xfA, const Shape &circle, const Transform2D &xfB,
+                          float margin, Manifold &manifold);
+void CollidePolygons(const Shape &a, const Transform2D &xfA, const Shape &b, const Transform2D &xfB,
+                     float margin, Manifold &manifold);
+
+// Dispatches on the shape types
+void Collide(const Shape &a, const Transform2D &xfA, const Shape &b, const Transform2D &xfB,
+             float margin, Manifold &manifold);
+
+// Four circle pairs at once. Centres and radii are given as separate
+// arrays, pair i being circle (ax[i], ay[i], ar[i]) against (bx[i], by[i],
+// br[i]).
+void CollideCircles4(const float *ax, const float *ay, const float *ar,
+                     const float *bx, const float *by, const float *br,
+                     float margin, Manifold manifolds[4]);
@@ -0,0 +1,587 @@
+#include "physics-world.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+PhysicsWorld::PhysicsWorld(const vec2 &gravity) : gravity(gravity)
+{
+}
+
+BodyId PhysicsWorld::create(const BodyDef &def)
+{
+    Body body;
+    body.transform = Transform2D(def.position, def.angle);
+    body.angle = def.angle;
+    body.type = def.type;
+    body.friction = def.friction;
+    body.restitution = def.restitution;
+    body.sleepTime = 0.0f;
+    body.alive = true;
+    body.userData = def.userData;
+
+    if (def.type == BODY_DYNAMIC)
+    {
+        MassData mass = ComputeMass(def.shape, def.density);
+        body.invMass = mass.mass > 0.0f ? 1.0f / mass.mass : 0.0f;
+        body.invInertia = mass.inertia > 0.0f ? 1.0f / mass.inertia : 0.0f;
+        body.velocity = def.velocity;
+        body.angularVelocity = def.angularVelocity;
+        body.awake = true;
+    }
+    else
+    {
+        // Static bodies are never awake, so contacts between a sleeping
+        // body and the ground are skipped like those between two sleepers
+        body.invMass = 0.0f;
+        body.invInertia = 0.0f;
+        body.velocity = vec2(0.0f);
+        body.angularVelocity = 0.0f;
+        body.awake = false;
+    }
+
+    BodyId id;
+    if (!freeBodies.empty())
+    {
+        id = freeBodies.back();
+        freeBodies.pop_back();
+        bodies[id] = body;
+        shapes[id] = def.shape;
+    }
+    else
+    {
+        id = (BodyId)bodies.size();
+        bodies.push_back(body);
+        shapes.push_back(def.shape);
+    }
+
+    bodies[id].proxy = broadphase.add(ComputeBounds(def.shape, body.transform, PHYSICS_CONTACT_MARGIN), id);
+    return id;
+}
+
+void PhysicsWorld::destroy(BodyId body)
+{
+    // Whatever rested on the body has to fall now
+    size_t kept = 0;
+    for (const Contact &contact : contacts)
+    {
+        if (contact.a == body || contact.b == body)
+        {
+            wakeBody(contact.a == body ? contact.b : contact.a);
+            continue;
+        }
+        contacts[kept++] = contact;
+    }
+    contacts.resize(kept);
+
+    broadphase.remove(bodies[body].proxy);
+    bodies[body].alive = false;
+    bodies[body].awake = false;
+    freeBodies.push_back(body);
+}
+
+void PhysicsWorld::wakeBody(int body)
+{
+    Body &b = bodies[body];
+    if (b.type == BODY_DYNAMIC && !b.awake)
+    {
+        b.awake = true;
+        b.sleepTime = 0.0f;
+    }
+}
+
+void PhysicsWorld::setTransform(BodyId body, const vec2 &position, float angle)
+{
+    Body &b = bodies[body];
+    b.transform = Transform2D(position, angle);
+    b.angle = angle;
+    broadphase.setBounds(b.proxy, ComputeBounds(shapes[body], b.transform, PHYSICS_CONTACT_MARGIN));
+
+    if (b.type == BODY_DYNAMIC)
+    {
+        wakeBody(body);
+        return;
+    }
+
+    // A static body is in no island, so wake what it touched directly
+    for (const Contact &contact : contacts)
+    {
+        if (contact.a == body || contact.b == body)
+            wakeBody(contact.a == body ? contact.b : contact.a);
+    }
+}
+
+void PhysicsWorld::setVelocity(BodyId body, const vec2 &velocity, float angularVelocity)
+{
+    Body &b = bodies[body];
+    if (b.type != BODY_DYNAMIC)
+        return;
+
+    b.velocity = velocity;
+    b.angularVelocity = angularVelocity;
+    wakeBody(body);
+}
+
+void PhysicsWorld::applyImpulse(BodyId body, const vec2 &impulse, const vec2 &worldPoint)
+{
+    Body &b = bodies[body];
+    if (b.type != BODY_DYNAMIC)
+        return;
+
+    b.velocity += impulse * b.invMass;
+    b.angularVelocity += b.invInertia * cross(worldPoint - b.transform.position, impulse);
+    wakeBody(body);
+}
+
+int PhysicsWorld::getAwakeBodyCount() const
+{
+    int count = 0;
+    for (const Body &body : bodies)
+    {
+        if (body.alive && body.awake)
+            count++;
+    }
+    return count;
+}
+
+void PhysicsWorld::collide()
+{
+    pairs.clear();
+    broadphase.findPairs([this](int a, int b) {
+        if (bodies[a].type == BODY_STATIC && bodies[b].type == BODY_STATIC)
+            return;
+        if (a > b)
+            std::swap(a, b);
+        pairs.push_back((uint64_t)a << 32 | (uint32_t)b);
+    });
+    std::sort(pairs.begin(), pairs.end());
+
+    contacts.swap(previousContacts);
+    contacts.resize(pairs.size());
+    previousIndex.assign(pairs.size(), -1);
+    circlePairs.clear();
+
+    // Both lists are sorted by key, so last step's contact for each pair
+    // is found by walking them together
+    size_t previous = 0;
+    for (size_t i = 0; i < pairs.size(); i++)
+    {
+        Contact &contact = contacts[i];
+        contact.key = pairs[i];
+        contact.a = (int)(pairs[i] >> 32);
+        contact.b = (int)(uint32_t)pairs[i];
+
+        while (previous < previousContacts.size() && previousContacts[previous].key < contact.key)
+            previous++;
+        if (previous < previousContacts.size() && previousContacts[previous].key == contact.key)
+            previousIndex[i] = (int)previous;
+
+        const Body &a = bodies[contact.a];
+        const Body &b = bodies[contact.b];
+        if (!a.awake && !b.awake)
+        {
+            // Neither body moved, so the old contact still holds, and
+            // keeps the sleeping island together
+            if (previousIndex[i] >= 0)
+                contact = previousContacts[previousIndex[i]];
+            else
+                contact.manifold.count = 0;
+            continue;
+        }
+
+        if (shapes[contact.a].type == SHAPE_CIRCLE && shapes[contact.b].type == SHAPE_CIRCLE)
+            circlePairs.push_back((int)i);
+        else
+            Collide(shapes[contact.a], a.transform, shapes[contact.b], b.transform, PHYSICS_CONTACT_MARGIN, contact.manifold);
+    }
+
+    for (size_t i = 0; i < circlePairs.size(); i += 4)
+    {
+        int count = (int)std::min<size_t>(4, circlePairs.size() - i);
+
+        // A short last batch repeats its final pair
+        alignas(16) float ax[4], ay[4], ar[4], bx[4], by[4], br[4];
+        for (int j = 0; j < 4; j++)
+        {
+            const Contact &contact = contacts[circlePairs[i + std::min(j, count - 1)]];
+            vec2 a = bodies[contact.a].transform.position;
+            vec2 b = bodies[contact.b].transform.position;
+            ax[j] = a.x;
+            ay[j] = a.y;
+            ar[j] = shapes[contact.a].radius;
+            bx[j] = b.x;
+            by[j] = b.y;
+            br[j] = shapes[contact.b].radius;
+        }
+
+        Manifold manifolds[4];
+        CollideCircles4(ax, ay, ar, bx, by, br, PHYSICS_CONTACT_MARGIN, manifolds);
+        for (int j = 0; j < count; j++)
+            contacts[circlePairs[i + j]].manifold = manifolds[j];
+    }
+
+    // Warm start: points made by the same features as last step begin
+    // with the impulses they ended with
+    for (size_t i = 0; i < contacts.size(); i++)
+    {
+        Contact &contact = contacts[i];
+        if (!bodies[contact.a].awake && !bodies[contact.b].awake)
+            continue;
+
+        const Contact *old = previousIndex[i] >= 0 ? &previousContacts[previousIndex[i]] : nullptr;
+        for (int p = 0; p < MAX_MANIFOLD_POINTS; p++)
+        {
+            contact.normalImpulse[p] = 0.0f;
+            contact.tangentImpulse[p] = 0.0f;
+            for (int q = 0; old && p < contact.manifold.count && q < old->manifold.count; q++)
+            {
+                if (old->manifold.points[q].id == contact.manifold.points[p].id)
+                {
+                    contact.normalImpulse[p] = old->normalImpulse[q];
+                    contact.tangentImpulse[p] = old->tangentImpulse[q];
+                    break;
+                }
+            }
+        }
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < contacts.size(); i++)
+    {
+        if (contacts[i].manifold.count > 0)
+            contacts[kept++] = contacts[i];
+    }
+    contacts.resize(kept);
+}
+
+int PhysicsWorld::findRoot(int body)
+{
+    while (unionParent[body] != body)
+    {
+        unionParent[body] = unionParent[unionParent[body]];
+        body = unionParent[body];
+    }
+    return body;
+}
+
+void PhysicsWorld::buildIslands()
+{
+    int bodyCount = (int)bodies.size();
+    unionParent.resize(bodyCount);
+    for (int i = 0; i < bodyCount; i++)
+        unionParent[i] = i;
+
+    // Static bodies join nothing; otherwise everything on the ground would
+    // be one island
+    for (const Contact &contact : contacts)
+    {
+        if (bodies[contact.a].type == BODY_DYNAMIC && bodies[contact.b].type == BODY_DYNAMIC)
+        {
+            int a = findRoot(contact.a);
+            int b = findRoot(contact.b);
+            if (a != b)
+                unionParent[a] = b;
+        }
+    }
+
+    islands.clear();
+    islandOf.assign(bodyCount, -1);
+    for (int i = 0; i < bodyCount; i++)
+    {
+        if (!bodies[i].alive || bodies[i].type != BODY_DYNAMIC)
+            continue;
+
+        int root = findRoot(i);
+        if (islandOf[root] < 0)
+        {
+            islandOf[root] = (int)islands.size();
+            islands.push_back(Island{0, 0, 0, 0});
+        }
+        islandOf[i] = islandOf[root];
+        islands[islandOf[i]].bodyCount++;
+    }
+
+    std::vector<int> contactIsland(contacts.size());
+    for (size_t i = 0; i < contacts.size(); i++)
+    {
+        const Contact &contact = contacts[i];
+        contactIsland[i] = islandOf[bodies[contact.a].type == BODY_DYNAMIC ? contact.a : contact.b];
+        islands[contactIsland[i]].contactCount++;
+    }
+
+    // Counts to offsets, then fill in order
+    int firstBody = 0, firstContact = 0;
+    for (Island &island : islands)
+    {
+        island.firstBody = firstBody;
+        island.firstContact = firstContact;
+        firstBody += island.bodyCount;
+        firstContact += island.contactCount;
+        island.bodyCount = 0;
+        island.contactCount = 0;
+    }
+
+    islandBodies.resize(firstBody);
+    islandContacts.resize(firstContact);
+    localIndex.assign(bodyCount, -1);
+    for (int i = 0; i < bodyCount; i++)
+    {
+        if (islandOf[i] < 0)
+            continue;
+        Island &island = islands[islandOf[i]];
+        localIndex[i] = island.bodyCount;
+        islandBodies[island.firstBody + island.bodyCount++] = i;
+    }
+    for (size_t i = 0; i < contacts.size(); i++)
+    {
+        Island &island = islands[contactIsland[i]];
+        islandContacts[island.firstContact + island.contactCount++] = (int)i;
+    }
+
+    // An island with any awake body wakes as a whole: something moving
+    // has touched it
+    activeIslands.clear();
+    for (int i = 0; i < (int)islands.size(); i++)
+    {
+        const Island &island = islands[i];
+        bool awake = false;
+        for (int j = 0; j < island.bodyCount && !awake; j++)
+            awake = bodies[islandBodies[island.firstBody + j]].awake;
+        if (!awake)
+            continue;
+
+        for (int j = 0; j < island.bodyCount; j++)
+            wakeBody(islandBodies[island.firstBody + j]);
+        activeIslands.push_back(i);
+    }
+}
+
+void PhysicsWorld::solveIsland(const Island &island, float dt, SolverScratch &scratch)
+{
+    const int *islandBody = &islandBodies[island.firstBody];
+    const int *islandContact = &islandContacts[island.firstContact];
+    float invDt = 1.0f / dt;
+
+    // Velocities are copied into the island's own arrays, so static
+    // bodies shared between islands are never written
+    std::vector<vec2> &v = scratch.velocities;
+    std::vector<float> &w = scratch.angularVelocities;
+    v.resize(island.bodyCount);
+    w.resize(island.bodyCount);
+    for (int i = 0; i < island.bodyCount; i++)
+    {
+        const Body &body = bodies[islandBody[i]];
+        v[i] = body.velocity + gravity * dt;
+        w[i] = body.angularVelocity;
+    }
+
+    std::vector<Constraint> &constraints = scratch.constraints;
+    constraints.resize(island.contactCount);
+    for (int i = 0; i < island.contactCount; i++)
+    {
+        const Contact &contact = contacts[islandContact[i]];
+        const Body &bodyA = bodies[contact.a];
+        const Body &bodyB = bodies[contact.b];
+
+        Constraint &c = constraints[i];
+        c.contact = islandContact[i];
+        c.a = localIndex[contact.a];
+        c.b = localIndex[contact.b];
+        c.invMassA = bodyA.invMass;
+        c.invInertiaA = bodyA.invInertia;
+        c.invMassB = bodyB.invMass;
+        c.invInertiaB = bodyB.invInertia;
+        c.friction = sqrtf(bodyA.friction * bodyB.friction);
+        c.normal = contact.manifold.normal;
+        c.count = contact.manifold.count;
+
+        float restitution = std::max(bodyA.restitution, bodyB.restitution);
+        vec2 vA = c.a >= 0 ? v[c.a] : vec2(0.0f);
+        vec2 vB = c.b >= 0 ? v[c.b] : vec2(0.0f);
+        float wA = c.a >= 0 ? w[c.a] : 0.0f;
+        float wB = c.b >= 0 ? w[c.b] : 0.0f;
+        vec2 tangent = cross(c.normal, 1.0f);
+
+        for (int p = 0; p < c.count; p++)
+        {
+            const ManifoldPoint &point = contact.manifold.points[p];
+            c.rA[p] = point.point - bodyA.transform.position;
+            c.rB[p] = point.point - bodyB.transform.position;
+
+            float rnA = cross(c.rA[p], c.normal), rnB = cross(c.rB[p], c.normal);
+            float k = c.invMassA + c.invMassB + c.invInertiaA * rnA * rnA + c.invInertiaB * rnB * rnB;
+            c.normalMass[p] = k > 0.0f ? 1.0f / k : 0.0f;
+
+            float rtA = cross(c.rA[p], tangent), rtB = cross(c.rB[p], tangent);
+            k = c.invMassA + c.invMassB + c.invInertiaA * rtA * rtA + c.invInertiaB * rtB * rtB;
+            c.tangentMass[p] = k > 0.0f ? 1.0f / k : 0.0f;
+
+            // Apart: let the bodies close the gap this step but no more.
+            // Overlapping: push out part of the penetration past the slop.
+            if (point.separation > 0.0f)
+                c.bias[p] = -point.separation * invDt;
+            else
+                c.bias[p] = PHYSICS_BAUMGARTE * invDt * std::max(0.0f, -point.separation - PHYSICS_LINEAR_SLOP);
+
+            float closing = dot(vB + cross(wB, c.rB[p]) - vA - cross(wA, c.rA[p]), c.normal);
+            if (closing < -PHYSICS_RESTITUTION_THRESHOLD)
+                c.bias[p] = std::max(c.bias[p], -restitution * closing);
+        }
+
+        for (int p = 0; p < c.count; p++)
+        {
+            vec2 impulse = c.normal * contact.normalImpulse[p] + tangent * contact.tangentImpulse[p];
+            if (c.a >= 0)
+            {
+                v[c.a] -= impulse * c.invMassA;
+                w[c.a] -= c.invInertiaA * cross(c.rA[p], impulse);
+            }
+            if (c.b >= 0)
+            {
+                v[c.b] += impulse * c.invMassB;
+                w[c.b] += c.invInertiaB * cross(c.rB[p], impulse);
+            }
+        }
+    }
+
+    // Stand-ins for static bodies; with no inverse mass they stay zero
+    vec2 zero(0.0f);
+    float noSpin = 0.0f;
+    for (int iteration = 0; iteration < PHYSICS_VELOCITY_ITERATIONS; iteration++)
+    {
+        for (Constraint &c : constraints)
+        {
+            Contact &contact = contacts[c.contact];
+            vec2 &vA = c.a >= 0 ? v[c.a] : zero;
+            vec2 &vB = c.b >= 0 ? v[c.b] : zero;
+            float &wA = c.a >= 0 ? w[c.a] : noSpin;
+            float &wB = c.b >= 0 ? w[c.b] : noSpin;
+            vec2 tangent = cross(c.normal, 1.0f);
+
+            // Friction first, so the normal impulses are the last word on
+            // penetration
+            for (int p = 0; p < c.count; p++)
+            {
+                vec2 dv = vB + cross(wB, c.rB[p]) - vA - cross(wA, c.rA[p]);
+                float lambda = -c.tangentMass[p] * dot(dv, tangent);
+                float limit = c.friction * contact.normalImpulse[p];
+                float total = std::max(-limit, std::min(contact.tangentImpulse[p] + lambda, limit));
+                lambda = total - contact.tangentImpulse[p];
+                contact.tangentImpulse[p] = total;
+
+                vec2 impulse = tangent * lambda;
+                vA -= impulse * c.invMassA;
+                wA -= c.invInertiaA * cross(c.rA[p], impulse);
+                vB += impulse * c.invMassB;
+                wB += c.invInertiaB * cross(c.rB[p], impulse);
+            }
+
+            for (int p = 0; p < c.count; p++)
+            {
+                vec2 dv = vB + cross(wB, c.rB[p]) - vA - cross(wA, c.rA[p]);
+                float lambda = c.normalMass[p] * (c.bias[p] - dot(dv, c.normal));
+                float total = std::max(contact.normalImpulse[p] + lambda, 0.0f);
+                lambda = total - contact.normalImpulse[p];
+                contact.normalImpulse[p] = total;
+
+                vec2 impulse = c.normal * lambda;
+                vA -= impulse * c.invMassA;
+                wA -= c.invInertiaA * cross(c.rA[p], impulse);
+                vB += impulse * c.invMassB;
+                wB += c.invInertiaB * cross(c.rB[p], impulse);
+            }
+        }
+    }
+
+    float minSleepTime = PHYSICS_TIME_TO_SLEEP;
+    for (int i = 0; i < island.bodyCount; i++)
+    {
+        int id = islandBody[i];
+        Body &body = bodies[id];
+        body.velocity = v[i];
+        body.angularVelocity = w[i];
+        body.angle += w[i] * dt;
+        body.transform = Transform2D(body.transform.position + v[i] * dt, body.angle);
+        broadphase.setBounds(body.proxy, ComputeBounds(shapes[id], body.transform, PHYSICS_CONTACT_MARGIN));
+
+        if (dot(v[i], v[i]) > PHYSICS_SLEEP_LINEAR_SPEED * PHYSICS_SLEEP_LINEAR_SPEED ||
+            w[i] * w[i] > PHYSICS_SLEEP_ANGULAR_SPEED * PHYSICS_SLEEP_ANGULAR_SPEED)
+            body.sleepTime = 0.0f;
+        else
+            body.sleepTime += dt;
+        minSleepTime = std::min(minSleepTime, body.sleepTime);
+    }
+
+    if (minSleepTime >= PHYSICS_TIME_TO_SLEEP)
+    {
+        for (int i = 0; i < island.bodyCount; i++)
+        {
+            Body &body = bodies[islandBody[i]];
+            body.awake = false;
+            body.velocity = vec2(0.0f);
+            body.angularVelocity = 0.0f;
+        }
+    }
+}
+
+void PhysicsWorld::step(float dt)
+{
+    if (dt <= 0.0f)
+        return;
+
+    collide();
+    buildIslands();
+
+    // Islands vary wildly in size; starting on the largest keeps one big
+    // pile from being picked up last and holding up the step
+    std::sort(activeIslands.begin(), activeIslands.end(), [this](int a, int b) {
+        return islands[a].bodyCount > islands[b].bodyCount;
+    });
+
+    int threads = threadCount > 0 ? threadCount : (int)std::thread::hardware_concurrency();
+    if (threads > (int)activeIslands.size())
+        threads = (int)activeIslands.size();
+    if ((int)scratch.size() < std::max(threads, 1))
+        scratch.resize(std::max(threads, 1));
+
+    if (threads <= 1)
+    {
+        for (int island : activeIslands)
+            solveIsland(islands[island], dt, scratch[0]);
+        return;
+    }
+
+    // Islands share no dynamic bodies or contacts, so each is solved
+    // without locks
+    std::atomic<size_t> next(0);
+    auto worker = [&](int thread) {
+        for (size_t i = next++; i < activeIslands.size(); i = next++)
+            solveIsland(islands[activeIslands[i]], dt, scratch[thread]);
+    };
+
+    std::vector<std::thread> workers;
+    for (int thread = 1; thread < threads; thread++)
+        workers.emplace_back(worker, thread);
+
+    worker(0);
+
+    for (std::thread &thread : workers)
+        thread.join();
+}
+
+int PhysicsWorld::update(float deltaTime)
+{
+    accumulator += deltaTime;
+
+    int steps = 0;
+    while (accumulator >= PHYSICS_TIME_STEP && steps < PHYSICS_MAX_STEPS)
+    {
+        step(PHYSICS_TIME_STEP);
+        accumulator -= PHYSICS_TIME_STEP;
+        steps++;
+    }
+
+    if (accumulator >= PHYSICS_TIME_STEP)
+        accumulator = fmodf(accumulator, PHYSICS_TIME_STEP);
+    return steps;
+}
@@ -0,0 +1,202 @@
+#pragma once
+
+#include "shape.h"
+#include "collide.h"
+#include "broadphase.h"
+
+#include <stdint.h>
+#include <vector>
+
+// Handle to a body, reused once the body is destroyed
+typedef int BodyId;
+
+#define INVALID_BODY (-1)
+
+// Fixed time step taken by update()
+#define PHYSICS_TIME_STEP (1.0f / 60.0f)
+
+// Steps update() may take in one call before dropping time, so a long
+// frame cannot snowball into ever longer ones
+#define PHYSICS_MAX_STEPS 4
+
+#define PHYSICS_VELOCITY_ITERATIONS 8
+
+// Contacts are created this far before shapes touch, so fast bodies are
+// slowed before they can pass through each other
+#define PHYSICS_CONTACT_MARGIN 0.02f
+
+// Penetration allowed before it is pushed out, which keeps resting
+// contacts from jittering, and the fraction of the rest removed per step
+#define PHYSICS_LINEAR_SLOP 0.005f
+#define PHYSICS_BAUMGARTE 0.2f
+
+// Closing speed below which contacts do not bounce
+#define PHYSICS_RESTITUTION_THRESHOLD 1.0f
+
+// An island sleeps once all of its bodies have moved slower than this for
+// PHYSICS_TIME_TO_SLEEP seconds
+#define PHYSICS_SLEEP_LINEAR_SPEED 0.01f
+#define PHYSICS_SLEEP_ANGULAR_SPEED 0.035f
+#define PHYSICS_TIME_TO_SLEEP 0.5f
+
+enum BodyType
+{
+    BODY_STATIC,
+    BODY_DYNAMIC
+};
+
+struct BodyDef
+{
+    BodyType type = BODY_DYNAMIC;
+    Shape shape = MakeCircle(0.5f);
+    vec2 position;
+    float angle = 0.0f;
+    vec2 velocity;
+    float angularVelocity = 0.0f;
+    float density = 1.0f;
+    float friction = 0.6f;
+    float restitution = 0.0f;
+    unsigned int userData = 0;
+};
+
+// 2D rigid body simulation: circles and convex polygons, one shape per
+// body.
+//
+// Each step finds overlapping bounds with sweep and prune, builds contact
+// manifolds (circle pairs four at a time with SIMD), and groups bodies
+// that touch into islands. Islands are independent of each other, so
+// they are solved in parallel on worker threads with sequential impulses,
+// warm started from the previous step's impulses. An island whose bodies
+// have all been nearly still for a while goes to sleep and costs nothing
+// until something awake touches it.
+class PhysicsWorld
+{
+private:
+    struct Body
+    {
+        Transform2D transform;
+        float angle;
+        vec2 velocity;
+        float angularVelocity;
+        float invMass, invInertia;
+        float friction, restitution;
+        float sleepTime;
+        int proxy;
+        BodyType type;
+        bool awake;
+        bool alive;
+        unsigned int userData;
+    };
+
+    struct Contact
+    {
+        uint64_t key; // lower body index in the high half
+        int a, b;
+        Manifold manifold;
+        float normalImpulse[MAX_MANIFOLD_POINTS];
+        float tangentImpulse[MAX_MANIFOLD_POINTS];
+    };
+
+    struct Island
+    {
+        int firstBody, bodyCount;
+        int firstContact, contactCount;
+    };
+
+    // Per contact data the solver works from, with bodies given by their
+    // position in the island, or -1 for static bodies
+    struct Constraint
+    {
+        int contact;
+        int a, b;
+        float invMassA, invInertiaA, invMassB, invInertiaB;
+        float friction;
+        vec2 normal;
+        int count;
+        vec2 rA[MAX_MANIFOLD_POINTS], rB[MAX_MANIFOLD_POINTS];
+        float normalMass[MAX_MANIFOLD_POINTS], tangentMass[MAX_MANIFOLD_POINTS];
+        float bias[MAX_MANIFOLD_POINTS];
+    };
+
+    // Working memory of one solver thread, kept between steps
+    struct SolverScratch
+    {
+        std::vector<vec2> velocities;
+        std::vector<float> angularVelocities;
+        std::vector<Constraint> constraints;
+    };
+
+    vec2 gravity;
+    int threadCount = 0;
+    float accumulator = 0.0f;
+
+    std::vector<Body> bodies;
+    std::vector<Shape> shapes; // per body, apart from the hot data
+    std::vector<BodyId> freeBodies;
+    SweepAndPrune broadphase;
+
+    // Sorted by key, so a step's contacts can be matched to the last's
+    std::vector<Contact> contacts, previousContacts;
+    std::vector<uint64_t> pairs;
+    std::vector<int> previousIndex; // per pair, into previousContacts or -1
+    std::vector<int> circlePairs;   // pairs left for the batched circle test
+
+    // Rebuilt every step; island bodies and contacts are indices into
+    // 'bodies' and 'contacts', grouped by island
+    std::vector<int> unionParent;
+    std::vector<int> islandOf;
+    std::vector<int> localIndex; // position of a body within its island
+    std::vector<Island> islands;
+    std::vector<int> islandBodies, islandContacts;
+    std::vector<int> activeIslands;
+    std::vector<SolverScratch> scratch;
+
+    int findRoot(int body);
+    void collide();
+    void buildIslands();
+    void solveIsland(const Island &island, float dt, SolverScratch &scratch);
+    void wakeBody(int body);
+
+public:
+    explicit PhysicsWorld(const vec2 &gravity = vec2(0.0f, -9.81f));
+
+    BodyId create(const BodyDef &def);
+    void destroy(BodyId body);
+
+    // Advances the simulation by one step of 'dt' seconds
+    void step(float dt);
+
+    // Advances by whole PHYSICS_TIME_STEPs, carrying the remainder over to
+    // the next call. Returns the number of steps taken.
+    int update(float deltaTime);
+
+    // How far update() is into the next step, from 0 to 1, for
+    // interpolating rendered positions between the last two steps
+    float getInterpolationAlpha() const { return accumulator / PHYSICS_TIME_STEP; }
+
+    // Threads used to solve islands; 0, the default, uses every core
+    void setThreadCount(int count) { threadCount = count; }
+    void setGravity(const vec2 &value) { gravity = value; }
+
+    vec2 getPosition(BodyId body) const { return bodies[body].transform.position; }
+    float getAngle(BodyId body) const { return bodies[body].angle; }
+    const Transform2D &getTransform(BodyId body) const { return bodies[body].transform; }
+    vec2 getVelocity(BodyId body) const { return bodies[body].velocity; }
+    float getAngularVelocity(BodyId body) const { return bodies[body].angularVelocity; }
+    const Shape &getShape(BodyId body) const { return shapes[body]; }
+    unsigned int getUserData(BodyId body) const { return bodies[body].userData; }
+    bool isAwake(BodyId body) const { return bodies[body].awake; }
+
+    // These wake the body
+    void setTransform(BodyId body, const vec2 &position, float angle);
+    void setVelocity(BodyId body, const vec2 &velocity, float angularVelocity);
+    void applyImpulse(BodyId body, const vec2 &impulse, const vec2 &worldPoint);
+    void wake(BodyId body) { wakeBody(body); }
+
+    int getBodyCount() const { return (int)(bodies.size() - freeBodies.size()); }
+    int getContactCount() const { return (int)contacts.size(); }
+    int getAwakeBodyCount() const;
+
+    // Islands solved in the last step
+    int getActiveIslandCount() const { return (int)activeIslands.size(); }
+};
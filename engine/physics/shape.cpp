@@ -0,0 +1,117 @@
+#include "shape.h"
+
+#include <string.h>
+
+Shape MakeCircle(float radius)
+{
+    Shape shape;
+    memset(&shape, 0, sizeof(shape));
+    shape.type = SHAPE_CIRCLE;
+    shape.radius = radius;
+    return shape;
+}
+
+Shape MakeBox(float halfWidth, float halfHeight)
+{
+    const vec2 points[4] = {
+        vec2(-halfWidth, -halfHeight),
+        vec2(halfWidth, -halfHeight),
+        vec2(halfWidth, halfHeight),
+        vec2(-halfWidth, halfHeight)
+    };
+    return MakePolygon(points, 4);
+}
+
+Shape MakePolygon(const vec2 *points, int count, vec2 *centroid)
+{
+    Shape shape;
+    memset(&shape, 0, sizeof(shape));
+    shape.type = SHAPE_POLYGON;
+    count = count > PHYSICS_MAX_POLYGON_VERTICES ? PHYSICS_MAX_POLYGON_VERTICES : count;
+    shape.count = count;
+
+    // Area-weighted centroid of the fan of triangles from the first point
+    vec2 center(0.0f);
+    float area = 0.0f;
+    for (int i = 1; i + 1 < count; i++)
+    {
+        float triangleArea = 0.5f * cross(points[i] - points[0], points[i + 1] - points[0]);
+        center += (points[0] + points[i] + points[i + 1]) * (triangleArea / 3.0f);
+        area += triangleArea;
+    }
+    center = area > 0.0f ? center / area : points[0];
+    if (centroid)
+        *centroid = center;
+
+    for (int i = 0; i < count; i++)
+    {
+        vec2 p = points[i] - center;
+        vec2 edge = points[(i + 1) % count] - points[i];
+        vec2 n = normalize(vec2(edge.y, -edge.x));
+        shape.vx[i] = p.x;
+        shape.vy[i] = p.y;
+        shape.nx[i] = n.x;
+        shape.ny[i] = n.y;
+    }
+
+    // Padding repeats the last entry, which changes no minimum or maximum
+    for (int i = count; i < PHYSICS_MAX_POLYGON_VERTICES; i++)
+    {
+        shape.vx[i] = shape.vx[count - 1];
+        shape.vy[i] = shape.vy[count - 1];
+        shape.nx[i] = shape.nx[count - 1];
+        shape.ny[i] = shape.ny[count - 1];
+    }
+
+    return shape;
+}
+
+MassData ComputeMass(const Shape &shape, float density)
+{
+    MassData data;
+    if (shape.type == SHAPE_CIRCLE)
+    {
+        float r2 = shape.radius * shape.radius;
+        data.mass = density * 3.14159265f * r2;
+        data.inertia = 0.5f * data.mass * r2;
+        return data;
+    }
+
+    // Sum over the triangles from the centroid, which is the origin
+    float area = 0.0f, inertia = 0.0f;
+    for (int i = 0; i < shape.count; i++)
+    {
+        vec2 a = shape.vertex(i);
+        vec2 b = shape.vertex((i + 1) % shape.count);
+        float d = cross(a, b);
+        area += 0.5f * d;
+        inertia += d * (dot(a, a) + dot(a, b) + dot(b, b)) / 12.0f;
+    }
+
+    data.mass = density * area;
+    data.inertia = density * inertia;
+    return data;
+}
+
+Bounds2D ComputeBounds(const Shape &shape, const Transform2D &transform, float margin)
+{
+    Bounds2D bounds;
+    if (shape.type == SHAPE_CIRCLE)
+    {
+        vec2 extent(shape.radius + margin);
+        bounds.min = transform.position - extent;
+        bounds.max = transform.position + extent;
+        return bounds;
+    }
+
+    bounds.min = bounds.max = transform.apply(shape.vertex(0));
+    for (int i = 1; i < shape.count; i++)
+    {
+        vec2 p = transform.apply(shape.vertex(i));
+        bounds.min = vmin(bounds.min, p);
+        bounds.max = vmax(bounds.max, p);
+    }
+    bounds.min -= vec2(margin);
+    bounds.max += vec2(margin);
+    return bounds;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "../math/vec.h"
+
+// Polygons are limited so their vertices fit in two SIMD registers
+#define PHYSICS_MAX_POLYGON_VERTICES 8
+
+// 2D cross products: the scalar z of a x b, and the cross products of a
+// vector with an angular velocity along z
+inline float cross(const vec2 &a, const vec2 &b) { return a.x * b.y - a.y * b.x; }
+inline vec2 cross(const vec2 &v, float s) { return vec2(s * v.y, -s * v.x); }
+inline vec2 cross(float s, const vec2 &v) { return vec2(-s * v.y, s * v.x); }
+
+// Rotation followed by translation in the plane
+struct Transform2D
+{
+    vec2 position;
+    float c, s; // cosine and sine of the angle
+
+    Transform2D() : position(0.0f), c(1.0f), s(0.0f) {}
+    Transform2D(const vec2 &position, float angle) : position(position), c(cosf(angle)), s(sinf(angle)) {}
+
+    vec2 rotate(const vec2 &v) const { return vec2(c * v.x - s * v.y, s * v.x + c * v.y); }
+    vec2 inverseRotate(const vec2 &v) const { return vec2(c * v.x + s * v.y, -s * v.x + c * v.y); }
+    vec2 apply(const vec2 &p) const { return rotate(p) + position; }
+    vec2 inverseApply(const vec2 &p) const { return inverseRotate(p - position); }
+};
+
+struct Bounds2D
+{
+    vec2 min, max;
+};
+
+inline bool overlaps(const Bounds2D &a, const Bounds2D &b)
+{
+    return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+           a.min.y <= b.max.y && a.max.y >= b.min.y;
+}
+
+enum ShapeType
+{
+    SHAPE_CIRCLE,
+    SHAPE_POLYGON
+};
+
+// Collision shape in body space, centred on the body's centre of mass.
+//
+// Polygons are convex and wound counter-clockwise. Their vertices and
+// edge normals are stored as separate x and y arrays, padded to a
+// multiple of four with copies of the last entry, so the narrowphase can
+// process four of them per SIMD instruction. Normal i belongs to the edge
+// from vertex i to vertex i + 1.
+struct Shape
+{
+    ShapeType type;
+    float radius; // circles only
+    int count;    // polygon vertices
+
+    alignas(16) float vx[PHYSICS_MAX_POLYGON_VERTICES];
+    alignas(16) float vy[PHYSICS_MAX_POLYGON_VERTICES];
+    alignas(16) float nx[PHYSICS_MAX_POLYGON_VERTICES];
+    alignas(16) float ny[PHYSICS_MAX_POLYGON_VERTICES];
+
+    vec2 vertex(int i) const { return vec2(vx[i], vy[i]); }
+    vec2 normal(int i) const { return vec2(nx[i], ny[i]); }
+};
+
+Shape MakeCircle(float radius);
+Shape MakeBox(float halfWidth, float halfHeight);
+
+// Builds a polygon from up to PHYSICS_MAX_POLYGON_VERTICES points forming
+// a convex, counter-clockwise loop. The points are moved so their centroid
+// is at the origin; 'centroid' receives the offset if it is not null, so
+// the caller can place the body there instead.
+Shape MakePolygon(const vec2 *points, int count, vec2 *centroid = nullptr);
+
+struct MassData
+{
+    float mass;
+    float inertia; // about the centre of mass
+};
+
+MassData ComputeMass(const Shape &shape, float density);
+
+// World-space bounds of a shape, grown by 'margin' on every side
+Bounds2D ComputeBounds(const Shape &shape, const Transform2D &transform, float margin);
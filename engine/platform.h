@@ -1,11 +1,38 @@
 #pragma once
 
+#include <functional>
+#include <stddef.h>
 #include <string>
 
+class AudioSink;
+
+// Called with the file's contents, or false and nothing if it could not
+// be read
+typedef std::function<void(bool ok, std::string &contents)> FileCallback;
+
 class Platform
 {
 public:
     // Add some game-visible services here as vfuncs
     virtual std::string ReadFileToString (const std::string& path) = 0;
     virtual void Log(const char *fmt, ...) = 0;
+
+    // Maps a whole file read-only into memory, so assets laid out for the
+    // GPU can be uploaded straight from the mapping. Returns nullptr on
+    // failure. Release the mapping with UnmapFile.
+    virtual const void *MapFile(const std::string &path, size_t *size) = 0;
+    virtual void UnmapFile(const void *data, size_t size) = 0;
+
+    // Reads a whole file without blocking the game thread. The callback
+    // runs on the game thread between frames once the read completes.
+    virtual void ReadFileAsync(const std::string &path, FileCallback callback) = 0;
+
+    // Opens the default sound output for interleaved stereo floats. Falls
+    // back to a NullAudioSink, never nullptr, when there is no device.
+    virtual AudioSink *OpenAudioSink(int sampleRate, int framesPerBuffer) = 0;
+
+    // Size of the window's drawable area in pixels, which follows resizes.
+    // The platform sets the viewport to match; draws to the window should
+    // use this rather than a fixed size.
+    virtual void GetWindowSize(int *width, int *height) = 0;
 };
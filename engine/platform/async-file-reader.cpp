@@ -0,0 +1,61 @@
+#include "async-file-reader.h"
+
+#include <memory>
+#include <stdio.h>
+
+AsyncFileReader::AsyncFileReader(Poster post) : post(post)
+{
+    thread = std::thread(&AsyncFileReader::run, this);
+}
+
+AsyncFileReader::~AsyncFileReader()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    wake.notify_one();
+    thread.join();
+}
+
+void AsyncFileReader::read(const std::string &path, FileCallback callback)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        requests.push_back(Request{ path, callback });
+    }
+    wake.notify_one();
+}
+
+void AsyncFileReader::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        wake.wait(lock, [this] { return !requests.empty() || !running; });
+        if (!running)
+            return;
+
+        Request request = requests.front();
+        requests.erase(requests.begin());
+        lock.unlock();
+
+        // A shared_ptr, as std::function needs a copyable callable
+        std::shared_ptr<std::string> contents = std::make_shared<std::string>();
+        bool ok = false;
+        FILE *file = fopen(request.path.c_str(), "rb");
+        if (file)
+        {
+            char buffer[64 * 1024];
+            size_t size;
+            while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0)
+                contents->append(buffer, size);
+            ok = !ferror(file);
+            fclose(file);
+        }
+
+        FileCallback callback = request.callback;
+        post([callback, contents, ok] { callback(ok, *contents); });
+        lock.lock();
+    }
+}
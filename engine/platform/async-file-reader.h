@@ -0,0 +1,41 @@
+#pragma once
+
+#include "../platform.h"
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Reads whole files on a worker thread, for Platform::ReadFileAsync. Each
+// completion is handed to 'post', which must get it onto the game thread
+// (the Linux event loop, or a list the Windows loop drains).
+class AsyncFileReader
+{
+public:
+    typedef std::function<void(std::function<void()>)> Poster;
+
+private:
+    struct Request
+    {
+        std::string path;
+        FileCallback callback;
+    };
+
+    Poster post;
+    std::vector<Request> requests; // guarded by 'mutex'
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool running = true;
+    std::thread thread;
+
+    void run();
+
+public:
+    explicit AsyncFileReader(Poster post);
+    ~AsyncFileReader();
+
+    void read(const std::string &path, FileCallback callback);
+};
@@ -0,0 +1,58 @@
+#include "linux-audio.h"
+
+// Device buffer, in mixer buffers: enough to ride out a late wakeup of
+// the mixer thread without adding much latency
+#define ALSA_BUFFERS 3
+
+AlsaAudioSink *AlsaAudioSink::Open(int sampleRate, int framesPerBuffer, const char **error)
+{
+    snd_pcm_t *pcm;
+    int result = snd_pcm_open(&pcm, "default", SND_PCM_STREAM_PLAYBACK, 0);
+    if (result < 0)
+    {
+        *error = snd_strerror(result);
+        return nullptr;
+    }
+
+    // Let ALSA convert and resample if the device cannot take float
+    // stereo at our rate
+    unsigned int latency = (unsigned int)((long long)framesPerBuffer * ALSA_BUFFERS * 1000000 / sampleRate);
+    result = snd_pcm_set_params(pcm, SND_PCM_FORMAT_FLOAT_LE, SND_PCM_ACCESS_RW_INTERLEAVED,
+                                2, (unsigned int)sampleRate, 1, latency);
+    if (result < 0)
+    {
+        *error = snd_strerror(result);
+        snd_pcm_close(pcm);
+        return nullptr;
+    }
+
+    return new AlsaAudioSink(pcm, sampleRate, framesPerBuffer);
+}
+
+AlsaAudioSink::~AlsaAudioSink()
+{
+    snd_pcm_drain(pcm);
+    snd_pcm_close(pcm);
+}
+
+bool AlsaAudioSink::write(const float *samples, int frames)
+{
+    while (frames > 0)
+    {
+        snd_pcm_sframes_t written = snd_pcm_writei(pcm, samples, (snd_pcm_uframes_t)frames);
+        if (written < 0)
+        {
+            // -EPIPE is an underrun; recover restarts the stream and the
+            // write is retried
+            if (written == -EPIPE)
+                underruns++;
+            if (snd_pcm_recover(pcm, (int)written, 1) < 0)
+                return false;
+            continue;
+        }
+
+        samples += written * 2;
+        frames -= (int)written;
+    }
+    return true;
+}
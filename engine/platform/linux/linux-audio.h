@@ -0,0 +1,31 @@
+#pragma once
+
+#include "../../audio/audio-sink.h"
+
+#include <alsa/asoundlib.h>
+#include <atomic>
+
+// Sound output through ALSA's default device. On desktops running
+// PipeWire or PulseAudio that device is their ALSA plugin, so this also
+// covers them.
+class AlsaAudioSink : public AudioSink
+{
+private:
+    snd_pcm_t *pcm;
+    int sampleRate, framesPerBuffer;
+    std::atomic<unsigned int> underruns{0};
+
+    AlsaAudioSink(snd_pcm_t *pcm, int sampleRate, int framesPerBuffer)
+        : pcm(pcm), sampleRate(sampleRate), framesPerBuffer(framesPerBuffer) {}
+
+public:
+    // Returns nullptr, with the reason in 'error', if the device cannot
+    // be opened
+    static AlsaAudioSink *Open(int sampleRate, int framesPerBuffer, const char **error);
+    ~AlsaAudioSink();
+
+    int getSampleRate() const override { return sampleRate; }
+    int getFramesPerBuffer() const override { return framesPerBuffer; }
+    bool write(const float *samples, int frames) override;
+    unsigned int getUnderrunCount() const override { return underruns; }
+};
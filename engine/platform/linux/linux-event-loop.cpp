@@ -0,0 +1,191 @@
+#include "linux-event-loop.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#define MAX_EPOLL_EVENTS 32
+
+struct EventSource
+{
+    int fd;
+    bool timer;
+    bool removed;
+    FdCallback callback;
+};
+
+// epoll hands back a pointer per fd; these two stand in for the display
+// and the wakeup eventfd, which are handled by the loop itself
+static EventSource displayMarker;
+static EventSource wakeMarker;
+
+EventLoop::EventLoop(wl_display *display) : display(display)
+{
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = &displayMarker;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wl_display_get_fd(display), &event);
+
+    event.data.ptr = &wakeMarker;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+}
+
+EventLoop::~EventLoop()
+{
+    while (!sources.empty())
+        remove(sources.back());
+    for (EventSource *source : removed)
+        delete source;
+
+    close(wakeFd);
+    close(epollFd);
+}
+
+EventSource *EventLoop::add(int fd, uint32_t events, bool timer, FdCallback callback)
+{
+    EventSource *source = new EventSource{ fd, timer, false, callback };
+
+    epoll_event event = {};
+    event.events = events;
+    event.data.ptr = source;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+
+    sources.push_back(source);
+    return source;
+}
+
+EventSource *EventLoop::addFd(int fd, uint32_t events, FdCallback callback)
+{
+    return add(fd, events, false, callback);
+}
+
+EventSource *EventLoop::addTimer(uint64_t delayNs, uint64_t intervalNs, EventCallback callback)
+{
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (fd < 0)
+        return nullptr;
+
+    // A zero it_value would disarm the timer rather than fire it at once
+    delayNs = std::max<uint64_t>(delayNs, 1);
+
+    itimerspec spec = {};
+    spec.it_value.tv_sec = (time_t)(delayNs / 1000000000);
+    spec.it_value.tv_nsec = (long)(delayNs % 1000000000);
+    spec.it_interval.tv_sec = (time_t)(intervalNs / 1000000000);
+    spec.it_interval.tv_nsec = (long)(intervalNs % 1000000000);
+    timerfd_settime(fd, 0, &spec, NULL);
+
+    // Read the expiry count so the fd stops being readable. A timer that
+    // fired several times while the loop was busy runs its callback once.
+    return add(fd, EPOLLIN, true, [fd, callback](uint32_t) {
+        uint64_t expirations;
+        if (read(fd, &expirations, sizeof(expirations)) == sizeof(expirations))
+            callback();
+    });
+}
+
+void EventLoop::remove(EventSource *source)
+{
+    if (!source || source->removed)
+        return;
+
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, source->fd, NULL);
+    if (source->timer)
+        close(source->fd);
+
+    // The events being dispatched may still point at it
+    source->removed = true;
+    sources.erase(std::find(sources.begin(), sources.end(), source));
+    removed.push_back(source);
+}
+
+void EventLoop::post(EventCallback callback)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        posted.push_back(callback);
+    }
+
+    uint64_t one = 1;
+    if (write(wakeFd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+        perror("eventfd write");
+}
+
+// When the socket is full, the rest is sent once epoll says it has room;
+// meanwhile the loop keeps running rather than blocking on it
+void EventLoop::flushDisplay()
+{
+    bool wantsWrite = wl_display_flush(display) < 0 && errno == EAGAIN;
+    if (wantsWrite == displayWantsWrite)
+        return;
+
+    epoll_event event = {};
+    event.events = wantsWrite ? EPOLLIN | EPOLLOUT : EPOLLIN;
+    event.data.ptr = &displayMarker;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, wl_display_get_fd(display), &event);
+    displayWantsWrite = wantsWrite;
+}
+
+void EventLoop::dispatch(int timeoutMs)
+{
+    // Events already read off the socket (by EGL, say) must be handled
+    // before sleeping, or the wait could miss them entirely
+    while (wl_display_prepare_read(display) != 0)
+        wl_display_dispatch_pending(display);
+    flushDisplay();
+
+    epoll_event events[MAX_EPOLL_EVENTS];
+    int count = epoll_wait(epollFd, events, MAX_EPOLL_EVENTS, timeoutMs);
+
+    bool displayReadable = false;
+    for (int i = 0; i < count; i++)
+    {
+        if (events[i].data.ptr == &displayMarker)
+            displayReadable = events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP);
+    }
+
+    if (displayReadable)
+        wl_display_read_events(display);
+    else
+        wl_display_cancel_read(display);
+    wl_display_dispatch_pending(display);
+
+    for (int i = 0; i < count; i++)
+    {
+        EventSource *source = (EventSource *) events[i].data.ptr;
+        if (source == &displayMarker)
+        {
+            if (events[i].events & EPOLLOUT)
+                flushDisplay();
+        }
+        else if (source == &wakeMarker)
+        {
+            uint64_t value;
+            if (read(wakeFd, &value, sizeof(value)) < 0 && errno != EAGAIN)
+                perror("eventfd read");
+        }
+        else if (!source->removed)
+        {
+            source->callback(events[i].events);
+        }
+    }
+
+    // Swap the list out so callbacks can post more; those run next time
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running.swap(posted);
+    }
+    for (EventCallback &callback : running)
+        callback();
+    running.clear();
+
+    for (EventSource *source : removed)
+        delete source;
+    removed.clear();
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+#include <vector>
+#include <wayland-client.h>
+
+struct EventSource;
+
+typedef std::function<void()> EventCallback;
+typedef std::function<void(uint32_t events)> FdCallback;
+
+// The main thread's event loop: sleeps in epoll until the Wayland socket,
+// a timer, a watched fd or another thread has something for it, then runs
+// the handlers on the main thread.
+//
+// Wayland is read with the prepare_read/read_events protocol, so it
+// cooperates with the input thread and EGL reading the same socket for
+// their own queues, and everything queued for the default queue is
+// dispatched before the loop goes back to sleep.
+class EventLoop
+{
+private:
+    wl_display *display;
+    int epollFd;
+    int wakeFd; // eventfd; written by other threads to interrupt the wait
+    bool displayWantsWrite = false;
+
+    std::vector<EventSource *> sources;
+    std::vector<EventSource *> removed; // freed once dispatching is done
+
+    std::mutex mutex;
+    std::vector<EventCallback> posted; // guarded by 'mutex'
+    std::vector<EventCallback> running;
+
+    EventSource *add(int fd, uint32_t events, bool timer, FdCallback callback);
+    void flushDisplay();
+
+public:
+    explicit EventLoop(wl_display *display);
+    ~EventLoop();
+
+    // Calls 'callback' with the epoll events whenever 'fd' is ready
+    EventSource *addFd(int fd, uint32_t events, FdCallback callback);
+
+    // A timerfd firing 'delayNs' from now, then every 'intervalNs' (or
+    // just once if that is 0)
+    EventSource *addTimer(uint64_t delayNs, uint64_t intervalNs, EventCallback callback);
+
+    // Safe from inside a callback. Closes the fd for timers only.
+    void remove(EventSource *source);
+
+    // Any thread: run 'callback' on the main thread at its next dispatch,
+    // waking it if it is asleep
+    void post(EventCallback callback);
+
+    // Waits up to 'timeoutMs' (-1 for as long as it takes) for anything
+    // to happen, then handles everything that has
+    void dispatch(int timeoutMs);
+};
@@ -0,0 +1,599 @@
+#include "linux-input.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BIT_SET(bits, bit) ((bits)[(bit) / 8] & (1 << ((bit) % 8)))
+
+// Wheel clicks arrive as about 10 pixels of scrolling
+#define POINTER_SCROLL_PIXELS_PER_LINE 10.0f
+
+// evdev codes for each InputGamepadButton
+static const int padButtonCodes[INPUT_PAD_BUTTON_COUNT] = {
+    BTN_SOUTH, BTN_EAST, BTN_WEST, BTN_NORTH,
+    BTN_TL, BTN_TR, BTN_SELECT, BTN_START, BTN_MODE, BTN_THUMBL, BTN_THUMBR,
+    BTN_DPAD_UP, BTN_DPAD_DOWN, BTN_DPAD_LEFT, BTN_DPAD_RIGHT
+};
+
+// and for each InputGamepadAxis
+static const int padAxisCodes[INPUT_PAD_AXIS_COUNT] = {
+    ABS_X, ABS_Y, ABS_RX, ABS_RY, ABS_Z, ABS_RZ
+};
+
+uint64_t MonotonicNanoseconds()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+}
+
+LinuxInput::LinuxInput(wl_display *display, Input *input) : display(display), input(input)
+{
+    queue = wl_display_create_queue(display);
+    for (int32_t &id : touchIds)
+        id = -1;
+}
+
+LinuxInput::~LinuxInput()
+{
+    if (thread.joinable())
+    {
+        uint64_t one = 1;
+        if (write(wakeFd, &one, sizeof(one)) != sizeof(one))
+            perror("eventfd write");
+        thread.join();
+    }
+
+    while (!gamepads.empty())
+        closeGamepad(gamepads.size() - 1);
+    if (notifyFd >= 0)
+        close(notifyFd);
+    if (wakeFd >= 0)
+        close(wakeFd);
+
+    if (keyboard)
+        wl_keyboard_destroy(keyboard);
+    if (pointer)
+        wl_pointer_destroy(pointer);
+    if (touch)
+        wl_touch_destroy(touch);
+    if (seat)
+        wl_seat_destroy(seat);
+    wl_event_queue_destroy(queue);
+}
+
+void LinuxInput::push(InputEventType type, uint64_t time, int device, int code, float x, float y, bool pressed)
+{
+    input->push(InputEvent{ type, time, device, code, x, y, pressed });
+}
+
+// Wayland stamps events in milliseconds on a clock that wraps every 49
+// days; compositors use CLOCK_MONOTONIC for it, so the missing high bits
+// can be taken from the current time
+uint64_t LinuxInput::waylandTime(uint32_t milliseconds)
+{
+    uint64_t now = MonotonicNanoseconds();
+    uint32_t age = (uint32_t)(now / 1000000) - milliseconds;
+
+    // Anything claiming to be more than a few seconds old is on some
+    // other clock; fall back to the time it was received
+    if (age > 5000)
+        return now;
+    return (now / 1000000 - age) * 1000000;
+}
+
+static const wl_seat_listener seatListener = {
+    &LinuxInput::seatCapabilities,
+    &LinuxInput::seatName
+};
+
+void LinuxInput::bindSeat(wl_registry *registry, uint32_t name, uint32_t version)
+{
+    if (seat)
+        return;
+
+    // Version 4 has everything used here; later versions only add events
+    seat = (wl_seat *) wl_registry_bind(registry, name, &wl_seat_interface, version < 4 ? version : 4);
+
+    // The keyboard, pointer and touch objects created from the seat
+    // inherit its queue, so the input thread handles all of them
+    wl_proxy_set_queue((wl_proxy *) seat, queue);
+    wl_seat_add_listener(seat, &seatListener, this);
+}
+
+void LinuxInput::start()
+{
+    wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+    // Gamepads plugged in later show up as new device nodes. The node is
+    // created before udev makes it readable, so watch attribute changes
+    // too.
+    notifyFd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (notifyFd >= 0 && inotify_add_watch(notifyFd, "/dev/input", IN_CREATE | IN_ATTRIB) < 0)
+    {
+        close(notifyFd);
+        notifyFd = -1;
+    }
+
+    DIR *directory = opendir("/dev/input");
+    if (directory)
+    {
+        while (dirent *entry = readdir(directory))
+        {
+            if (strncmp(entry->d_name, "event", 5) == 0)
+                openGamepad(std::string("/dev/input/") + entry->d_name);
+        }
+        closedir(directory);
+    }
+
+    thread = std::thread(&LinuxInput::run, this);
+}
+
+void LinuxInput::run()
+{
+    std::vector<pollfd> fds;
+    while (true)
+    {
+        // Standard multi-threaded reading: announce the intent to read,
+        // then either read or cancel, so the game thread (and EGL) can
+        // read the same socket for their own queues
+        while (wl_display_prepare_read_queue(display, queue) != 0)
+            wl_display_dispatch_queue_pending(display, queue);
+        wl_display_flush(display);
+
+        fds.clear();
+        fds.push_back(pollfd{ wl_display_get_fd(display), POLLIN, 0 });
+        fds.push_back(pollfd{ wakeFd, POLLIN, 0 });
+        fds.push_back(pollfd{ notifyFd, POLLIN, 0 });
+        for (Gamepad &pad : gamepads)
+            fds.push_back(pollfd{ pad.fd, POLLIN, 0 });
+
+        if (poll(fds.data(), fds.size(), -1) < 0)
+        {
+            wl_display_cancel_read(display);
+            continue;
+        }
+
+        if (fds[0].revents & POLLIN)
+            wl_display_read_events(display);
+        else
+            wl_display_cancel_read(display);
+        wl_display_dispatch_queue_pending(display, queue);
+
+        if (fds[1].revents & POLLIN)
+            break;
+
+        // Read the gamepads before looking for new ones, as 'fds' lines
+        // up with the current list
+        for (size_t i = gamepads.size(); i-- > 0;)
+        {
+            if (fds[3 + i].revents & (POLLERR | POLLHUP | POLLNVAL))
+                closeGamepad(i);
+            else if (fds[3 + i].revents & POLLIN)
+                readGamepad(gamepads[i]);
+        }
+
+        if (fds[2].revents & POLLIN)
+        {
+            alignas(inotify_event) char buffer[4096];
+            ssize_t size;
+            while ((size = read(notifyFd, buffer, sizeof(buffer))) > 0)
+            {
+                for (char *p = buffer; p < buffer + size;)
+                {
+                    inotify_event *event = (inotify_event *) p;
+                    if (event->len && strncmp(event->name, "event", 5) == 0)
+                        openGamepad(std::string("/dev/input/") + event->name);
+                    p += sizeof(inotify_event) + event->len;
+                }
+            }
+        }
+    }
+}
+
+void LinuxInput::openGamepad(const std::string &path)
+{
+    for (Gamepad &pad : gamepads)
+    {
+        if (pad.path == path)
+            return;
+    }
+    if (gamepads.size() == INPUT_MAX_GAMEPADS)
+        return;
+
+    // Most nodes are keyboards, mice and so on, and many are not readable
+    // by the user at all; both are skipped quietly
+    int fd = open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+        return;
+
+    unsigned char keys[KEY_MAX / 8 + 1] = {};
+    if (ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(keys)), keys) < 0 || !BIT_SET(keys, BTN_GAMEPAD))
+    {
+        close(fd);
+        return;
+    }
+
+    // Stamp events on the same clock as everything else
+    int clock = CLOCK_MONOTONIC;
+    ioctl(fd, EVIOCSCLOCKID, &clock);
+
+    Gamepad pad = {};
+    pad.fd = fd;
+    pad.path = path;
+    for (int axis = 0; axis < INPUT_PAD_AXIS_COUNT; axis++)
+        pad.hasAxis[axis] = ioctl(fd, EVIOCGABS(padAxisCodes[axis]), &pad.axes[axis]) == 0 && pad.axes[axis].maximum > pad.axes[axis].minimum;
+
+    // Lowest free slot, so a pad that is unplugged and plugged back in
+    // usually gets its old number
+    for (pad.slot = 0;; pad.slot++)
+    {
+        bool used = false;
+        for (Gamepad &other : gamepads)
+            used |= other.slot == pad.slot;
+        if (!used)
+            break;
+    }
+
+    gamepads.push_back(pad);
+    uint64_t now = MonotonicNanoseconds();
+    push(INPUT_GAMEPAD_CONNECTED, now, pad.slot, 0, 0.0f, 0.0f, false);
+    syncGamepad(gamepads.back(), now);
+}
+
+void LinuxInput::closeGamepad(size_t index)
+{
+    Gamepad &pad = gamepads[index];
+    close(pad.fd);
+    push(INPUT_GAMEPAD_DISCONNECTED, MonotonicNanoseconds(), pad.slot, 0, 0.0f, 0.0f, false);
+
+    gamepads[index] = gamepads.back();
+    gamepads.pop_back();
+}
+
+void LinuxInput::gamepadAxis(Gamepad &pad, int axis, int value, uint64_t time)
+{
+    const input_absinfo &info = pad.axes[axis];
+    float range = (float)(info.maximum - info.minimum);
+
+    float normalised;
+    if (axis >= INPUT_PAD_LEFT_TRIGGER)
+    {
+        normalised = (value - info.minimum) / range;
+    }
+    else
+    {
+        // The driver's 'flat' is the stick's dead zone around the centre
+        float centre = (info.minimum + info.maximum) * 0.5f;
+        normalised = (value - centre) * 2.0f / range;
+        if (value - centre <= info.flat && centre - value <= info.flat)
+            normalised = 0.0f;
+    }
+
+    push(INPUT_GAMEPAD_AXIS, time, pad.slot, axis, normalised, 0.0f, false);
+}
+
+// Some pads report the d-pad as a hat axis rather than buttons
+void LinuxInput::gamepadHat(Gamepad &pad, int &hat, int value, int negative, int positive, uint64_t time)
+{
+    if ((hat < 0) != (value < 0))
+        push(INPUT_GAMEPAD_BUTTON, time, pad.slot, negative, 0.0f, 0.0f, value < 0);
+    if ((hat > 0) != (value > 0))
+        push(INPUT_GAMEPAD_BUTTON, time, pad.slot, positive, 0.0f, 0.0f, value > 0);
+    hat = value;
+}
+
+// Reports the whole state of the pad, on connecting and after the kernel
+// has had to drop events
+void LinuxInput::syncGamepad(Gamepad &pad, uint64_t time)
+{
+    unsigned char keys[KEY_MAX / 8 + 1] = {};
+    if (ioctl(pad.fd, EVIOCGKEY(sizeof(keys)), keys) >= 0)
+    {
+        for (int button = 0; button < INPUT_PAD_BUTTON_COUNT; button++)
+            push(INPUT_GAMEPAD_BUTTON, time, pad.slot, button, 0.0f, 0.0f, BIT_SET(keys, padButtonCodes[button]) != 0);
+    }
+
+    for (int axis = 0; axis < INPUT_PAD_AXIS_COUNT; axis++)
+    {
+        if (pad.hasAxis[axis] && ioctl(pad.fd, EVIOCGABS(padAxisCodes[axis]), &pad.axes[axis]) == 0)
+            gamepadAxis(pad, axis, pad.axes[axis].value, time);
+    }
+
+    input_absinfo hat;
+    if (ioctl(pad.fd, EVIOCGABS(ABS_HAT0X), &hat) == 0)
+        gamepadHat(pad, pad.hatX, hat.value, INPUT_PAD_DPAD_LEFT, INPUT_PAD_DPAD_RIGHT, time);
+    if (ioctl(pad.fd, EVIOCGABS(ABS_HAT0Y), &hat) == 0)
+        gamepadHat(pad, pad.hatY, hat.value, INPUT_PAD_DPAD_UP, INPUT_PAD_DPAD_DOWN, time);
+}
+
+void LinuxInput::readGamepad(Gamepad &pad)
+{
+    input_event events[64];
+    ssize_t size;
+    while ((size = read(pad.fd, events, sizeof(events))) > 0)
+    {
+        for (size_t i = 0; i < (size_t)size / sizeof(input_event); i++)
+        {
+            const input_event &event = events[i];
+            uint64_t time = (uint64_t)event.input_event_sec * 1000000000 + (uint64_t)event.input_event_usec * 1000;
+
+            if (event.type == EV_SYN)
+            {
+                // After a drop, ignore everything up to the next report
+                // and then read the current state directly
+                if (event.code == SYN_DROPPED)
+                {
+                    pad.dropped = true;
+                }
+                else if (event.code == SYN_REPORT && pad.dropped)
+                {
+                    pad.dropped = false;
+                    syncGamepad(pad, time);
+                }
+                continue;
+            }
+            if (pad.dropped)
+                continue;
+
+            if (event.type == EV_KEY)
+            {
+                for (int button = 0; button < INPUT_PAD_BUTTON_COUNT; button++)
+                {
+                    if (event.code == padButtonCodes[button])
+                        push(INPUT_GAMEPAD_BUTTON, time, pad.slot, button, 0.0f, 0.0f, event.value != 0);
+                }
+            }
+            else if (event.type == EV_ABS)
+            {
+                if (event.code == ABS_HAT0X)
+                    gamepadHat(pad, pad.hatX, event.value, INPUT_PAD_DPAD_LEFT, INPUT_PAD_DPAD_RIGHT, time);
+                else if (event.code == ABS_HAT0Y)
+                    gamepadHat(pad, pad.hatY, event.value, INPUT_PAD_DPAD_UP, INPUT_PAD_DPAD_DOWN, time);
+
+                for (int axis = 0; axis < INPUT_PAD_AXIS_COUNT; axis++)
+                {
+                    if (event.code == padAxisCodes[axis] && pad.hasAxis[axis])
+                        gamepadAxis(pad, axis, event.value, time);
+                }
+            }
+        }
+    }
+}
+
+// Seat
+
+static wl_keyboard_listener MakeKeyboardListener()
+{
+    wl_keyboard_listener listener = {};
+    listener.keymap = &LinuxInput::keyboardKeymap;
+    listener.enter = &LinuxInput::keyboardEnter;
+    listener.leave = &LinuxInput::keyboardLeave;
+    listener.key = &LinuxInput::keyboardKey;
+    listener.modifiers = &LinuxInput::keyboardModifiers;
+    listener.repeat_info = &LinuxInput::keyboardRepeatInfo;
+    return listener;
+}
+
+// Only the events of the version bound are ever sent, so the rest of
+// these listeners can be left empty
+static wl_pointer_listener MakePointerListener()
+{
+    wl_pointer_listener listener = {};
+    listener.enter = &LinuxInput::pointerEnter;
+    listener.leave = &LinuxInput::pointerLeave;
+    listener.motion = &LinuxInput::pointerMotion;
+    listener.button = &LinuxInput::pointerButton;
+    listener.axis = &LinuxInput::pointerAxis;
+    return listener;
+}
+
+static wl_touch_listener MakeTouchListener()
+{
+    wl_touch_listener listener = {};
+    listener.down = &LinuxInput::touchDown;
+    listener.up = &LinuxInput::touchUp;
+    listener.motion = &LinuxInput::touchMotion;
+    listener.frame = &LinuxInput::touchFrame;
+    listener.cancel = &LinuxInput::touchCancel;
+    return listener;
+}
+
+static const wl_keyboard_listener keyboardListener = MakeKeyboardListener();
+static const wl_pointer_listener pointerListener = MakePointerListener();
+static const wl_touch_listener touchListener = MakeTouchListener();
+
+void LinuxInput::seatCapabilities(void *data, wl_seat *seat, uint32_t capabilities)
+{
+    LinuxInput *self = (LinuxInput *) data;
+
+    bool hasKeyboard = capabilities & WL_SEAT_CAPABILITY_KEYBOARD;
+    if (hasKeyboard && !self->keyboard)
+    {
+        self->keyboard = wl_seat_get_keyboard(seat);
+        wl_keyboard_add_listener(self->keyboard, &keyboardListener, self);
+    }
+    else if (!hasKeyboard && self->keyboard)
+    {
+        wl_keyboard_destroy(self->keyboard);
+        self->keyboard = nullptr;
+        self->push(INPUT_FOCUS_LOST, MonotonicNanoseconds(), 0, 0, 0.0f, 0.0f, false);
+    }
+
+    bool hasPointer = capabilities & WL_SEAT_CAPABILITY_POINTER;
+    if (hasPointer && !self->pointer)
+    {
+        self->pointer = wl_seat_get_pointer(seat);
+        wl_pointer_add_listener(self->pointer, &pointerListener, self);
+    }
+    else if (!hasPointer && self->pointer)
+    {
+        wl_pointer_destroy(self->pointer);
+        self->pointer = nullptr;
+    }
+
+    bool hasTouch = capabilities & WL_SEAT_CAPABILITY_TOUCH;
+    if (hasTouch && !self->touch)
+    {
+        self->touch = wl_seat_get_touch(seat);
+        wl_touch_add_listener(self->touch, &touchListener, self);
+    }
+    else if (!hasTouch && self->touch)
+    {
+        wl_touch_destroy(self->touch);
+        self->touch = nullptr;
+    }
+}
+
+void LinuxInput::seatName(void *data, wl_seat *seat, const char *name)
+{
+}
+
+// Keyboard
+
+void LinuxInput::keyboardKeymap(void *data, wl_keyboard *keyboard, uint32_t format, int32_t fd, uint32_t size)
+{
+    // Keys are reported by position, so the layout is not needed
+    close(fd);
+}
+
+void LinuxInput::keyboardEnter(void *data, wl_keyboard *keyboard, uint32_t serial, wl_surface *surface, wl_array *keys)
+{
+    LinuxInput *self = (LinuxInput *) data;
+    uint64_t now = MonotonicNanoseconds();
+
+    // Keys already held down as the window gains focus
+    uint32_t *key = (uint32_t *) keys->data;
+    for (size_t i = 0; i < keys->size / sizeof(uint32_t); i++)
+        self->push(INPUT_KEY, now, 0, (int)key[i], 0.0f, 0.0f, true);
+}
+
+void LinuxInput::keyboardLeave(void *data, wl_keyboard *keyboard, uint32_t serial, wl_surface *surface)
+{
+    LinuxInput *self = (LinuxInput *) data;
+    self->push(INPUT_FOCUS_LOST, MonotonicNanoseconds(), 0, 0, 0.0f, 0.0f, false);
+}
+
+void LinuxInput::keyboardKey(void *data, wl_keyboard *keyboard, uint32_t serial, uint32_t time, uint32_t key, uint32_t state)
+{
+    LinuxInput *self = (LinuxInput *) data;
+    self->push(INPUT_KEY, self->waylandTime(time), 0, (int)key, 0.0f, 0.0f, state == WL_KEYBOARD_KEY_STATE_PRESSED);
+}
+
+void LinuxInput::keyboardModifiers(void *data, wl_keyboard *keyboard, uint32_t serial, uint32_t depressed, uint32_t latched, uint32_t locked, uint32_t group)
+{
+}
+
+void LinuxInput::keyboardRepeatInfo(void *data, wl_keyboard *keyboard, int32_t rate, int32_t delay)
+{
+}
+
+// Pointer
+
+void LinuxInput::pointerEnter(void *data, wl_pointer *pointer, uint32_t serial, wl_surface *surface, wl_fixed_t x, wl_fixed_t y)
+{
+    LinuxInput *self = (LinuxInput *) data;
+    self->push(INPUT_POINTER_MOTION, MonotonicNanoseconds(), 0, 0, (float)wl_fixed_to_double(x), (float)wl_fixed_to_double(y), false);
+}
+
+void LinuxInput::pointerLeave(void *data, wl_pointer *pointer, uint32_t serial, wl_surface *surface)
+{
+}
+
+void LinuxInput::pointerMotion(void *data, wl_pointer *pointer, uint32_t time, wl_fixed_t x, wl_fixed_t y)
+{
+    LinuxInput *self = (LinuxInput *) data;
+    self->push(INPUT_POINTER_MOTION, self->waylandTime(time), 0, 0, (float)wl_fixed_to_double(x), (float)wl_fixed_to_double(y), false);
+}
+
+void LinuxInput::pointerButton(void *data, wl_pointer *pointer, uint32_t serial, uint32_t time, uint32_t button, uint32_t state)
+{
+    LinuxInput *self = (LinuxInput *) data;
+
+    int code;
+    if (button == BTN_LEFT)
+        code = INPUT_BUTTON_LEFT;
+    else if (button == BTN_RIGHT)
+        code = INPUT_BUTTON_RIGHT;
+    else if (button == BTN_MIDDLE)
+        code = INPUT_BUTTON_MIDDLE;
+    else
+        return;
+
+    self->push(INPUT_POINTER_BUTTON, self->waylandTime(time), 0, code, 0.0f, 0.0f, state == WL_POINTER_BUTTON_STATE_PRESSED);
+}
+
+void LinuxInput::pointerAxis(void *data, wl_pointer *pointer, uint32_t time, uint32_t axis, wl_fixed_t value)
+{
+    LinuxInput *self = (LinuxInput *) data;
+    float lines = (float)wl_fixed_to_double(value) / POINTER_SCROLL_PIXELS_PER_LINE;
+    if (axis == WL_POINTER_AXIS_HORIZONTAL_SCROLL)
+        self->push(INPUT_POINTER_SCROLL, self->waylandTime(time), 0, 0, lines, 0.0f, false);
+    else
+        self->push(INPUT_POINTER_SCROLL, self->waylandTime(time), 0, 0, 0.0f, lines, false);
+}
+
+// Touch
+
+void LinuxInput::touchDown(void *data, wl_touch *touch, uint32_t serial, uint32_t time, wl_surface *surface, int32_t id, wl_fixed_t x, wl_fixed_t y)
+{
+    LinuxInput *self = (LinuxInput *) data;
+    for (int slot = 0; slot < INPUT_MAX_TOUCHES; slot++)
+    {
+        if (self->touchIds[slot] == -1)
+        {
+            self->touchIds[slot] = id;
+            self->push(INPUT_TOUCH_DOWN, self->waylandTime(time), slot, 0, (float)wl_fixed_to_double(x), (float)wl_fixed_to_double(y), true);
+            return;
+        }
+    }
+}
+
+void LinuxInput::touchUp(void *data, wl_touch *touch, uint32_t serial, uint32_t time, int32_t id)
+{
+    LinuxInput *self = (LinuxInput *) data;
+    for (int slot = 0; slot < INPUT_MAX_TOUCHES; slot++)
+    {
+        if (self->touchIds[slot] == id)
+        {
+            self->touchIds[slot] = -1;
+            self->push(INPUT_TOUCH_UP, self->waylandTime(time), slot, 0, 0.0f, 0.0f, false);
+        }
+    }
+}
+
+void LinuxInput::touchMotion(void *data, wl_touch *touch, uint32_t time, int32_t id, wl_fixed_t x, wl_fixed_t y)
+{
+    LinuxInput *self = (LinuxInput *) data;
+    for (int slot = 0; slot < INPUT_MAX_TOUCHES; slot++)
+    {
+        if (self->touchIds[slot] == id)
+            self->push(INPUT_TOUCH_MOTION, self->waylandTime(time), slot, 0, (float)wl_fixed_to_double(x), (float)wl_fixed_to_double(y), true);
+    }
+}
+
+void LinuxInput::touchFrame(void *data, wl_touch *touch)
+{
+}
+
+// The compositor took the touches over, e.g. for a gesture
+void LinuxInput::touchCancel(void *data, wl_touch *touch)
+{
+    LinuxInput *self = (LinuxInput *) data;
+    uint64_t now = MonotonicNanoseconds();
+    for (int slot = 0; slot < INPUT_MAX_TOUCHES; slot++)
+    {
+        if (self->touchIds[slot] != -1)
+        {
+            self->touchIds[slot] = -1;
+            self->push(INPUT_TOUCH_UP, now, slot, 0, 0.0f, 0.0f, false);
+        }
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "../../input/input.h"
+
+#include <linux/input.h>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include <wayland-client.h>
+
+// CLOCK_MONOTONIC in nanoseconds, the clock input timestamps are on
+uint64_t MonotonicNanoseconds();
+
+// Collects keyboard, pointer and touch input from the Wayland seat and
+// gamepads from evdev on a thread of its own, and pushes it to Input as
+// it happens.
+//
+// The seat's objects live on a separate Wayland event queue which only
+// this thread dispatches, so input is read off the socket while the game
+// thread is busy rendering rather than once a frame. The thread sleeps in
+// poll() on the display, the gamepads and /dev/input (for hotplugging)
+// until something arrives.
+class LinuxInput
+{
+private:
+    wl_display *display;
+    wl_event_queue *queue;
+    Input *input;
+
+    wl_seat *seat = nullptr;
+    wl_keyboard *keyboard = nullptr;
+    wl_pointer *pointer = nullptr;
+    wl_touch *touch = nullptr;
+
+    // Wayland touch ids, by the slot Input knows them as; -1 if free
+    int32_t touchIds[INPUT_MAX_TOUCHES];
+
+    struct Gamepad
+    {
+        int fd;
+        int slot;
+        std::string path;
+        input_absinfo axes[INPUT_PAD_AXIS_COUNT];
+        bool hasAxis[INPUT_PAD_AXIS_COUNT];
+        int hatX, hatY;
+        bool dropped; // events were lost; resynchronise at the next report
+    };
+    std::vector<Gamepad> gamepads;
+
+    int wakeFd = -1;   // eventfd, to stop the thread
+    int notifyFd = -1; // inotify on /dev/input
+    std::thread thread;
+
+    void push(InputEventType type, uint64_t time, int device, int code, float x, float y, bool pressed);
+    uint64_t waylandTime(uint32_t milliseconds);
+
+    void openGamepad(const std::string &path);
+    void closeGamepad(size_t index);
+    void readGamepad(Gamepad &pad);
+    void syncGamepad(Gamepad &pad, uint64_t time);
+    void gamepadAxis(Gamepad &pad, int axis, int value, uint64_t time);
+    void gamepadHat(Gamepad &pad, int &hat, int value, int negative, int positive, uint64_t time);
+
+    void run();
+
+public:
+    LinuxInput(wl_display *display, Input *input);
+    ~LinuxInput();
+
+    // From the registry listener, for each wl_seat global. Only the first
+    // seat is used.
+    void bindSeat(wl_registry *registry, uint32_t name, uint32_t version);
+
+    // Once the registry has been read
+    void start();
+
+    // Listener callbacks, run on the input thread
+    static void seatCapabilities(void *data, wl_seat *seat, uint32_t capabilities);
+    static void seatName(void *data, wl_seat *seat, const char *name);
+
+    static void keyboardKeymap(void *data, wl_keyboard *keyboard, uint32_t format, int32_t fd, uint32_t size);
+    static void keyboardEnter(void *data, wl_keyboard *keyboard, uint32_t serial, wl_surface *surface, wl_array *keys);
+    static void keyboardLeave(void *data, wl_keyboard *keyboard, uint32_t serial, wl_surface *surface);
+    static void keyboardKey(void *data, wl_keyboard *keyboard, uint32_t serial, uint32_t time, uint32_t key, uint32_t state);
+    static void keyboardModifiers(void *data, wl_keyboard *keyboard, uint32_t serial, uint32_t depressed, uint32_t latched, uint32_t locked, uint32_t group);
+    static void keyboardRepeatInfo(void *data, wl_keyboard *keyboard, int32_t rate, int32_t delay);
+
+    static void pointerEnter(void *data, wl_pointer *pointer, uint32_t serial, wl_surface *surface, wl_fixed_t x, wl_fixed_t y);
+    static void pointerLeave(void *data, wl_pointer *pointer, uint32_t serial, wl_surface *surface);
+    static void pointerMotion(void *data, wl_pointer *pointer, uint32_t time, wl_fixed_t x, wl_fixed_t y);
+    static void pointerButton(void *data, wl_pointer *pointer, uint32_t serial, uint32_t time, uint32_t button, uint32_t state);
+    static void pointerAxis(void *data, wl_pointer *pointer, uint32_t time, uint32_t axis, wl_fixed_t value);
+
+    static void touchDown(void *data, wl_touch *touch, uint32_t serial, uint32_t time, wl_surface *surface, int32_t id, wl_fixed_t x, wl_fixed_t y);
+    static void touchUp(void *data, wl_touch *touch, uint32_t serial, uint32_t time, int32_t id);
+    static void touchMotion(void *data, wl_touch *touch, uint32_t time, int32_t id, wl_fixed_t x, wl_fixed_t y);
+    static void touchFrame(void *data, wl_touch *touch);
+    static void touchCancel(void *data, wl_touch *touch);
+};
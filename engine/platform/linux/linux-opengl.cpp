@@ -26,6 +26,7 @@
 
 #include <assert.h>
 #include <stdio.h>
+#include <string.h>
 
 void AssertProc(bool exp, const char *proc)
 {
@@ -37,15 +38,38 @@ void AssertProc(bool exp, const char *proc)
 
 #define LinuxGLGetProcAddress(Name, NAME) this->Name = (PFN##NAME##PROC) eglGetProcAddress(#Name); AssertProc(this->Name != NULL, #Name)
 
-// Returns 0 if successful, 1 if unsuccessful
+// Returns nullptr if the current context is older than OpenGL 4.5
 LinuxOpenGL *LinuxOpenGL::Load()
 {
+    // EGL may hand out an entry point for any name at all, so the asserts
+    // below only mean something once the context is known to be new enough
+    GLint major = 0, minor = 0;
+    glGetIntegerv (GL_MAJOR_VERSION, &major);
+    glGetIntegerv (GL_MINOR_VERSION, &minor);
+    if (major < 4 || (major == 4 && minor < 5))
+    {
+        printf ("Error: OpenGL 4.5 is required, but the context is %d.%d\n", major, minor);
+        return nullptr;
+    }
+
     // Use this context to query OpenGL/EGL Extensions
     auto loader = new LinuxOpenGL();
     loader->RetrieveExtensions();
     return loader;
 }
 
+bool LinuxOpenGL::HasExtension(const char *name)
+{
+    GLint count = 0;
+    glGetIntegerv (GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++)
+    {
+        if (strcmp ((const char *) glGetStringi (GL_EXTENSIONS, i), name) == 0)
+            return true;
+    }
+    return false;
+}
+
 void LinuxOpenGL::RetrieveExtensions()
 {
 #pragma GCC diagnostic ignored "-Wcast-function-type"
@@ -70,9 +94,84 @@ void LinuxOpenGL::RetrieveExtensions()
     LinuxGLGetProcAddress(glEnableVertexAttribArray, GLENABLEVERTEXATTRIBARRAY);
     LinuxGLGetProcAddress(glUseProgram, GLUSEPROGRAM);
     LinuxGLGetProcAddress(glGetUniformLocation, GLGETUNIFORMLOCATION);
+    LinuxGLGetProcAddress(glGetActiveUniform, GLGETACTIVEUNIFORM);
     LinuxGLGetProcAddress(glUniform4f, GLUNIFORM4F);
     LinuxGLGetProcAddress(glUniform1f, GLUNIFORM1F);
     LinuxGLGetProcAddress(glUniform1i, GLUNIFORM1I);
 
+    // Instancing
+    LinuxGLGetProcAddress(glBufferSubData, GLBUFFERSUBDATA);
+    LinuxGLGetProcAddress(glVertexAttribDivisor, GLVERTEXATTRIBDIVISOR);
+    LinuxGLGetProcAddress(glDrawArraysInstanced, GLDRAWARRAYSINSTANCED);
+    LinuxGLGetProcAddress(glDrawElementsInstanced, GLDRAWELEMENTSINSTANCED);
+    LinuxGLGetProcAddress(glUniformMatrix4fv, GLUNIFORMMATRIX4FV);
+
+    // Multi-draw indirect
+    LinuxGLGetProcAddress(glVertexAttribIPointer, GLVERTEXATTRIBIPOINTER);
+    LinuxGLGetProcAddress(glBufferStorage, GLBUFFERSTORAGE);
+    LinuxGLGetProcAddress(glMapBufferRange, GLMAPBUFFERRANGE);
+    LinuxGLGetProcAddress(glBindBufferBase, GLBINDBUFFERBASE);
+    LinuxGLGetProcAddress(glBindBufferRange, GLBINDBUFFERRANGE);
+    LinuxGLGetProcAddress(glMultiDrawElementsIndirect, GLMULTIDRAWELEMENTSINDIRECT);
+    LinuxGLGetProcAddress(glFenceSync, GLFENCESYNC);
+    LinuxGLGetProcAddress(glClientWaitSync, GLCLIENTWAITSYNC);
+    LinuxGLGetProcAddress(glDeleteSync, GLDELETESYNC);
+
+    // Compute
+    LinuxGLGetProcAddress(glDispatchCompute, GLDISPATCHCOMPUTE);
+    LinuxGLGetProcAddress(glMemoryBarrier, GLMEMORYBARRIER);
+    LinuxGLGetProcAddress(glBindImageTexture, GLBINDIMAGETEXTURE);
+    LinuxGLGetProcAddress(glTexStorage2D, GLTEXSTORAGE2D);
+    LinuxGLGetProcAddress(glActiveTexture, GLACTIVETEXTURE);
+    LinuxGLGetProcAddress(glUniform2f, GLUNIFORM2F);
+    LinuxGLGetProcAddress(glUniform4fv, GLUNIFORM4FV);
+
+    // Uniform buffers
+    LinuxGLGetProcAddress(glGetUniformBlockIndex, GLGETUNIFORMBLOCKINDEX);
+    LinuxGLGetProcAddress(glUniformBlockBinding, GLUNIFORMBLOCKBINDING);
+
+    // Freeing objects
+    LinuxGLGetProcAddress(glDeleteProgram, GLDELETEPROGRAM);
+    LinuxGLGetProcAddress(glDeleteBuffers, GLDELETEBUFFERS);
+    LinuxGLGetProcAddress(glDeleteVertexArrays, GLDELETEVERTEXARRAYS);
+
+    // Framebuffers
+    LinuxGLGetProcAddress(glGenFramebuffers, GLGENFRAMEBUFFERS);
+    LinuxGLGetProcAddress(glDeleteFramebuffers, GLDELETEFRAMEBUFFERS);
+    LinuxGLGetProcAddress(glBindFramebuffer, GLBINDFRAMEBUFFER);
+    LinuxGLGetProcAddress(glFramebufferTexture2D, GLFRAMEBUFFERTEXTURE2D);
+    LinuxGLGetProcAddress(glCheckFramebufferStatus, GLCHECKFRAMEBUFFERSTATUS);
+    LinuxGLGetProcAddress(glDrawBuffers, GLDRAWBUFFERS);
+    LinuxGLGetProcAddress(glClearBufferfv, GLCLEARBUFFERFV);
+    LinuxGLGetProcAddress(glGenRenderbuffers, GLGENRENDERBUFFERS);
+    LinuxGLGetProcAddress(glDeleteRenderbuffers, GLDELETERENDERBUFFERS);
+    LinuxGLGetProcAddress(glBindRenderbuffer, GLBINDRENDERBUFFER);
+    LinuxGLGetProcAddress(glRenderbufferStorage, GLRENDERBUFFERSTORAGE);
+    LinuxGLGetProcAddress(glFramebufferRenderbuffer, GLFRAMEBUFFERRENDERBUFFER);
+    LinuxGLGetProcAddress(glBlitFramebuffer, GLBLITFRAMEBUFFER);
+
+    LinuxGLGetProcAddress(glGenQueries, GLGENQUERIES);
+    LinuxGLGetProcAddress(glDeleteQueries, GLDELETEQUERIES);
+    LinuxGLGetProcAddress(glQueryCounter, GLQUERYCOUNTER);
+    LinuxGLGetProcAddress(glGetQueryObjectiv, GLGETQUERYOBJECTIV);
+    LinuxGLGetProcAddress(glGetQueryObjectui64v, GLGETQUERYOBJECTUI64V);
+
+    LinuxGLGetProcAddress(glTexStorage3D, GLTEXSTORAGE3D);
+    LinuxGLGetProcAddress(glFramebufferTextureLayer, GLFRAMEBUFFERTEXTURELAYER);
+
+    LinuxGLGetProcAddress(glDrawArraysIndirect, GLDRAWARRAYSINDIRECT);
+    LinuxGLGetProcAddress(glDispatchComputeIndirect, GLDISPATCHCOMPUTEINDIRECT);
+    LinuxGLGetProcAddress(glGetStringi, GLGETSTRINGI);
+
+    // Optional. EGL may hand out an entry point for any name at all, so
+    // ask the context whether it really has it.
+    GLint major = 0, minor = 0;
+    glGetIntegerv (GL_MAJOR_VERSION, &major);
+    glGetIntegerv (GL_MINOR_VERSION, &minor);
+    if (major > 4 || (major == 4 && minor >= 6))
+        glMultiDrawElementsIndirectCount = (PFNGLMULTIDRAWELEMENTSINDIRECTCOUNTPROC) eglGetProcAddress ("glMultiDrawElementsIndirectCount");
+    else if (HasExtension ("GL_ARB_indirect_parameters"))
+        glMultiDrawElementsIndirectCount = (PFNGLMULTIDRAWELEMENTSINDIRECTCOUNTPROC) eglGetProcAddress ("glMultiDrawElementsIndirectCountARB");
+
 #pragma GCC diagnostic pop
 }
@@ -39,4 +39,7 @@ public:
 
 private:
     LinuxOpenGL() {}
+
+    // Whether the current context lists the extension
+    bool HasExtension(const char *name);
 };
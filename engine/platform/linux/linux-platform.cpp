@@ -7,28 +7,136 @@
 #include <EGL/egl.h>
 
 #include <time.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "game.h"
 
 #include "linux-platform.h"
 #include "linux-opengl.h"
+#include "linux-audio.h"
+#include "linux-input.h"
+#include "linux-event-loop.h"
+#include "../async-file-reader.h"
+
+// Generated by wayland-scanner
+#include "platform/linux/xdg-shell-client-protocol.h"
+#include "platform/linux/presentation-time-client-protocol.h"
 
 
 // Special thanks to:
 // https://github.com/eyelash/tutorials/blob/master/wayland-egl.c
 // For setting up an EGL context on Wayland
 
+// Log frame timings this often when TONIC_PROFILE is set
+#define PROFILE_LOG_SECONDS 5
+
+// Frames that may be waiting for presentation feedback at once
+#define MAX_PENDING_FEEDBACK 8
+
+// Longest step handed to the game, e.g. after the window was hidden and
+// no frames were drawn for a while
+#define MAX_FRAME_DELTA 0.25f
+
 static wl_compositor *compositor = NULL;
-static struct wl_shell *shell = NULL;
+static struct xdg_wm_base *wm_base = NULL;
+static struct wp_presentation *presentation = NULL;
+static clockid_t presentation_clock = CLOCK_MONOTONIC;
 static struct wl_egl_window *egl_window = NULL;
 
+static bool running = true;
+static bool configured = false;
+static bool frame_ready = true;
+static int32_t window_width = 800, window_height = 600;
+
+static void
+wm_base_ping (void *data, struct xdg_wm_base *base, uint32_t serial)
+{
+    xdg_wm_base_pong (base, serial);
+}
+
+static struct xdg_wm_base_listener wm_base_listener = { &wm_base_ping };
+
+// The new size arrives in the toplevel's configure and takes effect with
+// the surface's configure, which ends the sequence
+static void
+xdg_surface_configure (void *data, struct xdg_surface *xdg_surface, uint32_t serial)
+{
+    xdg_surface_ack_configure (xdg_surface, serial);
+    configured = true;
+
+    if (egl_window)
+    {
+        wl_egl_window_resize (egl_window, window_width, window_height, 0, 0);
+        glViewport (0, 0, window_width, window_height);
+    }
+}
+
+static struct xdg_surface_listener xdg_surface_listener = { &xdg_surface_configure };
+
+static void
+xdg_toplevel_configure (void *data, struct xdg_toplevel *toplevel, int32_t width, int32_t height, struct wl_array *states)
+{
+    // Zero means the compositor leaves the size to us
+    if (width > 0 && height > 0)
+    {
+        window_width = width;
+        window_height = height;
+    }
+}
+
+static void
+xdg_toplevel_close (void *data, struct xdg_toplevel *toplevel)
+{
+    running = false;
+}
+
+// Later versions of the protocol add events only sent to clients that
+// bind them, so the rest of the listener is left empty
+static xdg_toplevel_listener
+make_toplevel_listener ()
+{
+    xdg_toplevel_listener listener = {};
+    listener.configure = &xdg_toplevel_configure;
+    listener.close = &xdg_toplevel_close;
+    return listener;
+}
+
+static const xdg_toplevel_listener toplevel_listener = make_toplevel_listener ();
+
+
+
+static void
+presentation_clock_id (void *data, struct wp_presentation *presentation, uint32_t clock)
+{
+    presentation_clock = (clockid_t) clock;
+}
+
+static struct wp_presentation_listener presentation_listener = { &presentation_clock_id };
+
 static void
 on_registry_add_object (void *data, struct wl_registry *registry, uint32_t name, const char *interface, uint32_t version)
 {
+    LinuxInput *input = (LinuxInput *) data;
+
     if (strcmp (interface, "wl_compositor") == 0)
         compositor = (wl_compositor *) wl_registry_bind (registry, name, &wl_compositor_interface, 1);
-    else if (strcmp (interface, "wl_shell") == 0)
-        shell = (wl_shell *) wl_registry_bind (registry, name, &wl_shell_interface, 1);
+    else if (strcmp (interface, xdg_wm_base_interface.name) == 0)
+    {
+        wm_base = (xdg_wm_base *) wl_registry_bind (registry, name, &xdg_wm_base_interface, 1);
+        xdg_wm_base_add_listener (wm_base, &wm_base_listener, NULL);
+    }
+    else if (strcmp (interface, wp_presentation_interface.name) == 0)
+    {
+        // The clock it uses is announced straight away
+        presentation = (wp_presentation *) wl_registry_bind (registry, name, &wp_presentation_interface, 1);
+        wp_presentation_add_listener (presentation, &presentation_listener, NULL);
+    }
+    else if (strcmp (interface, "wl_seat") == 0)
+        input->bindSeat (registry, name, version);
 }
 
 static void
@@ -40,25 +148,90 @@ static struct wl_registry_listener registry_listener = { &on_registry_add_object
 
 
 
+// A frame handed to the compositor, waiting to hear when it was shown
+struct FrameFeedback
+{
+    struct wp_presentation_feedback *feedback;
+    uint64_t swapTime;
+    uint64_t inputTime;
+    Game *game;
+};
+
+static FrameFeedback pending_feedback[MAX_PENDING_FEEDBACK];
+
 static void
-shell_surface_ping (void *data, struct wl_shell_surface *shell_surface, uint32_t serial)
+feedback_sync_output (void *data, struct wp_presentation_feedback *feedback, struct wl_output *output)
 {
-	wl_shell_surface_pong (shell_surface, serial);
 }
 
 static void
-shell_surface_configure (void *data, struct wl_shell_surface *shell_surface, uint32_t edges, int32_t width, int32_t height)
+feedback_presented (void *data, struct wp_presentation_feedback *feedback, uint32_t tv_sec_hi, uint32_t tv_sec_lo,
+                    uint32_t tv_nsec, uint32_t refresh, uint32_t seq_hi, uint32_t seq_lo, uint32_t flags)
 {
-	wl_egl_window_resize (egl_window, width, height, 0, 0);
-	glViewport (0, 0, width, height);
+    FrameFeedback *frame = (FrameFeedback *) data;
+
+    // Timings on any other clock cannot be compared with ours
+    if (presentation_clock == CLOCK_MONOTONIC)
+    {
+        uint64_t presentTime = (((uint64_t) tv_sec_hi << 32) | tv_sec_lo) * 1000000000 + tv_nsec;
+        uint64_t sequence = (flags & WP_PRESENTATION_FEEDBACK_KIND_VSYNC) ? (((uint64_t) seq_hi << 32) | seq_lo) : 0;
+        frame->game->profiler->framePresented (frame->swapTime, presentTime, refresh, sequence);
+        frame->game->input->frameDisplayed (frame->inputTime, presentTime);
+    }
+
+    wp_presentation_feedback_destroy (feedback);
+    frame->feedback = NULL;
 }
 
 static void
-shell_surface_popup_done (void *data, struct wl_shell_surface *shell_surface)
+feedback_discarded (void *data, struct wp_presentation_feedback *feedback)
 {
+    FrameFeedback *frame = (FrameFeedback *) data;
+    frame->game->profiler->frameDiscarded ();
+
+    wp_presentation_feedback_destroy (feedback);
+    frame->feedback = NULL;
+}
+
+static struct wp_presentation_feedback_listener feedback_listener = { &feedback_sync_output, &feedback_presented, &feedback_discarded };
+
+// Asks to be told when the next commit reaches the screen. Must come
+// before the swap, which makes the commit.
+static FrameFeedback *
+request_feedback (struct wl_surface *surface, Game *game)
+{
+    if (!presentation)
+        return NULL;
+
+    for (FrameFeedback &frame : pending_feedback)
+    {
+        if (!frame.feedback)
+        {
+            frame.feedback = wp_presentation_feedback (presentation, surface);
+            frame.game = game;
+            frame.swapTime = 0;
+            frame.inputTime = game->input->getFrameInputTime ();
+            wp_presentation_feedback_add_listener (frame.feedback, &feedback_listener, &frame);
+            return &frame;
+        }
+    }
+
+    // The compositor has stopped answering (e.g. the window is hidden);
+    // skip measuring until it catches up
+    return NULL;
+}
 
+// The compositor is ready for another frame. Drawing is paced by these
+// rather than by blocking in eglSwapBuffers, so the loop sleeps while the
+// window is hidden and stays free to handle everything else meanwhile.
+static void
+frame_done (void *data, struct wl_callback *callback, uint32_t time)
+{
+    wl_callback_destroy (callback);
+    frame_ready = true;
 }
-static struct wl_shell_surface_listener shell_surface_listener = {&shell_surface_ping, &shell_surface_configure, &shell_surface_popup_done};
+
+static struct wl_callback_listener frame_listener = { &frame_done };
 
 // TODO: Rewrite using linux APIs
 #include <string>
@@ -82,6 +255,72 @@ std::string LinuxPlatform::ReadFileToString (const std::string& path)
     return contents;
 }
 
+const void *LinuxPlatform::MapFile(const std::string &path, size_t *size)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        Log ("Unable to open file at path: '%s'\n", path.c_str());
+        return nullptr;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        Log ("Unable to map file at path: '%s'\n", path.c_str());
+        close(fd);
+        return nullptr;
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    void *data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED) {
+        Log ("Unable to map file at path: '%s'\n", path.c_str());
+        return nullptr;
+    }
+
+    *size = (size_t)info.st_size;
+    return data;
+}
+
+void LinuxPlatform::UnmapFile(const void *data, size_t size)
+{
+    munmap((void *)data, size);
+}
+
+AudioSink *LinuxPlatform::OpenAudioSink(int sampleRate, int framesPerBuffer)
+{
+    // For running without speakers, e.g. on a test machine, the output
+    // can be recorded to a file instead
+    const char *wavPath = getenv("TONIC_AUDIO_WAV");
+    if (wavPath) {
+        WavFileSink *sink = new WavFileSink(wavPath, sampleRate, framesPerBuffer);
+        if (sink->isOpen())
+            return sink;
+        Log ("Unable to write audio to file at path: '%s'\n", wavPath);
+        delete sink;
+    }
+
+    const char *error = "";
+    AlsaAudioSink *alsa = AlsaAudioSink::Open(sampleRate, framesPerBuffer, &error);
+    if (alsa)
+        return alsa;
+
+    Log ("Unable to open audio device, playing silence: %s\n", error);
+    return new NullAudioSink(sampleRate, framesPerBuffer);
+}
+
+void LinuxPlatform::GetWindowSize(int *width, int *height)
+{
+    *width = window_width;
+    *height = window_height;
+}
+
+void LinuxPlatform::ReadFileAsync(const std::string &path, FileCallback callback)
+{
+    files->read(path, callback);
+}
+
 // Wrap logging so the Game can use it
 void LinuxPlatform::Log(const char *fmt, ...)
 {
@@ -96,9 +335,23 @@ int LinuxPlatform::Run()
     printf("This is project '%s' - linux.\n", PROJECT_NAME);
 
     struct wl_display *display = wl_display_connect (NULL);
+    EventLoop *loop = new EventLoop (display);
+    files = new AsyncFileReader ([loop] (std::function<void()> done) { loop->post (done); });
+
+    // Input is gathered from the start, on its own thread
+    Input *input = new Input();
+    LinuxInput *linuxInput = new LinuxInput (display, input);
+
     struct wl_registry *registry = wl_display_get_registry (display);
-	wl_registry_add_listener (registry, &registry_listener, NULL);
+	wl_registry_add_listener (registry, &registry_listener, linuxInput);
     wl_display_roundtrip (display);
+    linuxInput->start ();
+
+    if (!compositor || !wm_base)
+    {
+        printf("The compositor does not support xdg_shell\n");
+        return -1;
+    }
 
     EGLDisplay egl_display = eglGetDisplay (display);
 
@@ -114,6 +367,7 @@ int LinuxPlatform::Run()
         EGL_RED_SIZE, 8,
         EGL_GREEN_SIZE, 8,
         EGL_BLUE_SIZE, 8,
+        EGL_DEPTH_SIZE, 24,
         EGL_NONE
     };
 
@@ -121,39 +375,117 @@ int LinuxPlatform::Run()
     EGLint num_config;
 
     eglChooseConfig(egl_display, attributes, &config, 1, &num_config);
-    EGLContext egl_context = eglCreateContext(egl_display, config, EGL_NO_CONTEXT, NULL);
 
-    // TODO: Use xdg_surface instead
-    wl_surface *surface = wl_compositor_create_surface (compositor);
-    wl_shell_surface * shell_surface = wl_shell_get_shell_surface(shell, surface);
-    wl_shell_surface_add_listener(shell_surface, &shell_surface_listener, NULL);
-    wl_shell_surface_set_toplevel (shell_surface);
+    // The renderer needs direct state access, buffer storage and compute
+    EGLint context_attributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 5,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext egl_context = eglCreateContext(egl_display, config, EGL_NO_CONTEXT, context_attributes);
+    if (egl_context == EGL_NO_CONTEXT)
+    {
+        printf("Could not create an OpenGL 4.5 core context\n");
+        eglTerminate (egl_display);
+        return -1;
+    }
 
-    egl_window = wl_egl_window_create (surface, 800, 600);
+    wl_surface *surface = wl_compositor_create_surface (compositor);
+    struct xdg_surface *xdg_surface = xdg_wm_base_get_xdg_surface (wm_base, surface);
+    xdg_surface_add_listener (xdg_surface, &xdg_surface_listener, NULL);
+    struct xdg_toplevel *toplevel = xdg_surface_get_toplevel (xdg_surface);
+    xdg_toplevel_add_listener (toplevel, &toplevel_listener, NULL);
+    xdg_toplevel_set_title (toplevel, PROJECT_NAME);
+    xdg_toplevel_set_app_id (toplevel, PROJECT_NAME);
+
+    // Nothing may be drawn until the compositor has sent the first
+    // configure, answering this empty commit
+    wl_surface_commit (surface);
+    while (!configured && wl_display_roundtrip (display) >= 0)
+        ;
+
+    egl_window = wl_egl_window_create (surface, window_width, window_height);
     EGLSurface egl_surface = eglCreateWindowSurface (egl_display, config, egl_window, NULL);
     eglMakeCurrent (egl_display, egl_surface, egl_surface, egl_context);
 
+    // Frame callbacks do the pacing; see frame_done
+    eglSwapInterval (egl_display, 0);
+
+    LinuxOpenGL *gl = LinuxOpenGL::Load();
+    if (!gl)
+    {
+        eglMakeCurrent (egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroySurface (egl_display, egl_surface);
+        wl_egl_window_destroy (egl_window);
+        eglDestroyContext (egl_display, egl_context);
+        eglTerminate (egl_display);
+        return -1;
+    }
+
     // Run game setup
-    auto game = Initialize(LinuxOpenGL::Load());
+    auto game = Initialize(gl);
     game->platform = this;
+    game->world = new World();
+    game->audio = new AudioMixer(OpenAudioSink(AUDIO_SAMPLE_RATE, AUDIO_FRAMES_PER_BUFFER));
+    game->audio->startThread();
+    game->input = input;
+    game->profiler = new Profiler();
+    game->assets = new AssetCache(this);
     game->Setup ();
 
+    if (getenv("TONIC_PROFILE"))
+    {
+        uint64_t interval = (uint64_t) PROFILE_LOG_SECONDS * 1000000000;
+        loop->addTimer (interval, interval, [this, game, input] {
+            game->profiler->log (this);
+            game->assets->log ();
+            InputStats inputStats = input->getStats ();
+            Log ("  input latency %.2f ms average, %.2f ms peak\n", inputStats.averageLatencyMs, inputStats.peakLatencyMs);
+        });
+    }
+
     struct timespec prevFrameTime;
     clock_gettime(CLOCK_MONOTONIC, &prevFrameTime);
 
     float deltaTime = 0.0f;
 
     // Run
-    while (true)
+    while (running)
     {
-        // Handle events
-        wl_display_dispatch_pending (display);
+        // Handle events, sleeping until there are some unless a frame is
+        // due
+        loop->dispatch (frame_ready ? 0 : -1);
+        if (!frame_ready || !running)
+            continue;
+        frame_ready = false;
 
-        // Next frame
-        game->Frame (deltaTime);
+        game->profiler->beginFrame ();
+        input->beginFrame ();
 
-        // Finally swap buffers
-        eglSwapBuffers (egl_display, egl_surface);
+        // Next frame
+        {
+            ProfileScope scope (game->profiler, "game");
+            game->Frame (deltaTime);
+        }
+        game->assets->update ();
+
+        // Finally swap buffers. Without presentation feedback, the swap
+        // is as close as we can get to when the frame is shown.
+        FrameFeedback *feedback = request_feedback (surface, game);
+        struct wl_callback *frame_callback = wl_surface_frame (surface);
+        wl_callback_add_listener (frame_callback, &frame_listener, NULL);
+        {
+            ProfileScope scope (game->profiler, "swap");
+            eglSwapBuffers (egl_display, egl_surface);
+        }
+        uint64_t swapTime = MonotonicNanoseconds ();
+        if (feedback)
+            feedback->swapTime = swapTime;
+        else if (!presentation)
+            input->frameDisplayed (input->getFrameInputTime (), swapTime);
+
+        game->profiler->endFrame ();
 
         // Get current frame timestamp
         struct timespec curFrameTime;
@@ -163,20 +495,47 @@ int LinuxPlatform::Run()
         float nanosecs = (float)(curFrameTime.tv_nsec - prevFrameTime.tv_nsec);
         float secs = (float)(curFrameTime.tv_sec - prevFrameTime.tv_sec);
         deltaTime = secs + (nanosecs * 1e-9f);
+        if (deltaTime > MAX_FRAME_DELTA)
+            deltaTime = MAX_FRAME_DELTA;
 
         // Update variables accordingly
         prevFrameTime = curFrameTime;
     }
 
-    // Cleanup
+    // Cleanup. The game, then what it loaded, while the GL context is
+    // current. The mixer goes first so no voice is left playing a cached
+    // sound.
+    delete game->audio;
+    AssetCache *assets = game->assets;
+    World *world = game->world;
+    Profiler *profiler = game->profiler;
+    delete game;
+    delete assets;
+    delete world;
+
+    delete linuxInput;
+    delete files;
+    files = nullptr;
+    for (FrameFeedback &frame : pending_feedback)
+    {
+        if (frame.feedback)
+            wp_presentation_feedback_destroy (frame.feedback);
+    }
     eglDestroySurface (egl_display, egl_surface);
 	wl_egl_window_destroy (egl_window);
-	wl_shell_surface_destroy (shell_surface);
+	xdg_toplevel_destroy (toplevel);
+	xdg_surface_destroy (xdg_surface);
 	wl_surface_destroy (surface);
 	eglDestroyContext (egl_display, egl_context);
 
     eglTerminate (egl_display);
+    if (presentation)
+        wp_presentation_destroy (presentation);
+    xdg_wm_base_destroy (wm_base);
+    delete loop;
     wl_display_disconnect (display);
+    delete profiler;
+    delete input;
 
     return 0;
 }
@@ -1,9 +1,19 @@
 #include "../../platform.h"
 
+class AsyncFileReader;
+
 class LinuxPlatform : Platform
 {
+private:
+    AsyncFileReader *files = nullptr;
+
 public:
     int Run();
     std::string ReadFileToString (const std::string& path) override;
     virtual void Log(const char *fmt, ...) override;
+    const void *MapFile(const std::string &path, size_t *size) override;
+    void UnmapFile(const void *data, size_t size) override;
+    void ReadFileAsync(const std::string &path, FileCallback callback) override;
+    AudioSink *OpenAudioSink(int sampleRate, int framesPerBuffer) override;
+    void GetWindowSize(int *width, int *height) override;
 };
@@ -160,9 +160,79 @@ void Win32OpenGL::RetrieveExtensions()
     Win32GLGetProcAddress(glEnableVertexAttribArray, GLENABLEVERTEXATTRIBARRAY);
     Win32GLGetProcAddress(glUseProgram, GLUSEPROGRAM);
     Win32GLGetProcAddress(glGetUniformLocation, GLGETUNIFORMLOCATION);
+    Win32GLGetProcAddress(glGetActiveUniform, GLGETACTIVEUNIFORM);
     Win32GLGetProcAddress(glUniform4f, GLUNIFORM4F);
     Win32GLGetProcAddress(glUniform1f, GLUNIFORM1F);
     Win32GLGetProcAddress(glUniform1i, GLUNIFORM1I);
 
+    // Instancing
+    Win32GLGetProcAddress(glBufferSubData, GLBUFFERSUBDATA);
+    Win32GLGetProcAddress(glVertexAttribDivisor, GLVERTEXATTRIBDIVISOR);
+    Win32GLGetProcAddress(glDrawArraysInstanced, GLDRAWARRAYSINSTANCED);
+    Win32GLGetProcAddress(glDrawElementsInstanced, GLDRAWELEMENTSINSTANCED);
+    Win32GLGetProcAddress(glUniformMatrix4fv, GLUNIFORMMATRIX4FV);
+
+    // Multi-draw indirect
+    Win32GLGetProcAddress(glVertexAttribIPointer, GLVERTEXATTRIBIPOINTER);
+    Win32GLGetProcAddress(glBufferStorage, GLBUFFERSTORAGE);
+    Win32GLGetProcAddress(glMapBufferRange, GLMAPBUFFERRANGE);
+    Win32GLGetProcAddress(glBindBufferBase, GLBINDBUFFERBASE);
+    Win32GLGetProcAddress(glBindBufferRange, GLBINDBUFFERRANGE);
+    Win32GLGetProcAddress(glMultiDrawElementsIndirect, GLMULTIDRAWELEMENTSINDIRECT);
+    Win32GLGetProcAddress(glFenceSync, GLFENCESYNC);
+    Win32GLGetProcAddress(glClientWaitSync, GLCLIENTWAITSYNC);
+    Win32GLGetProcAddress(glDeleteSync, GLDELETESYNC);
+
+    // Compute
+    Win32GLGetProcAddress(glDispatchCompute, GLDISPATCHCOMPUTE);
+    Win32GLGetProcAddress(glMemoryBarrier, GLMEMORYBARRIER);
+    Win32GLGetProcAddress(glBindImageTexture, GLBINDIMAGETEXTURE);
+    Win32GLGetProcAddress(glTexStorage2D, GLTEXSTORAGE2D);
+    Win32GLGetProcAddress(glActiveTexture, GLACTIVETEXTURE);
+    Win32GLGetProcAddress(glUniform2f, GLUNIFORM2F);
+    Win32GLGetProcAddress(glUniform4fv, GLUNIFORM4FV);
+
+    // Uniform buffers
+    Win32GLGetProcAddress(glGetUniformBlockIndex, GLGETUNIFORMBLOCKINDEX);
+    Win32GLGetProcAddress(glUniformBlockBinding, GLUNIFORMBLOCKBINDING);
+
+    // Freeing objects
+    Win32GLGetProcAddress(glDeleteProgram, GLDELETEPROGRAM);
+    Win32GLGetProcAddress(glDeleteBuffers, GLDELETEBUFFERS);
+    Win32GLGetProcAddress(glDeleteVertexArrays, GLDELETEVERTEXARRAYS);
+
+    // Framebuffers
+    Win32GLGetProcAddress(glGenFramebuffers, GLGENFRAMEBUFFERS);
+    Win32GLGetProcAddress(glDeleteFramebuffers, GLDELETEFRAMEBUFFERS);
+    Win32GLGetProcAddress(glBindFramebuffer, GLBINDFRAMEBUFFER);
+    Win32GLGetProcAddress(glFramebufferTexture2D, GLFRAMEBUFFERTEXTURE2D);
+    Win32GLGetProcAddress(glCheckFramebufferStatus, GLCHECKFRAMEBUFFERSTATUS);
+    Win32GLGetProcAddress(glDrawBuffers, GLDRAWBUFFERS);
+    Win32GLGetProcAddress(glClearBufferfv, GLCLEARBUFFERFV);
+    Win32GLGetProcAddress(glGenRenderbuffers, GLGENRENDERBUFFERS);
+    Win32GLGetProcAddress(glDeleteRenderbuffers, GLDELETERENDERBUFFERS);
+    Win32GLGetProcAddress(glBindRenderbuffer, GLBINDRENDERBUFFER);
+    Win32GLGetProcAddress(glRenderbufferStorage, GLRENDERBUFFERSTORAGE);
+    Win32GLGetProcAddress(glFramebufferRenderbuffer, GLFRAMEBUFFERRENDERBUFFER);
+    Win32GLGetProcAddress(glBlitFramebuffer, GLBLITFRAMEBUFFER);
+
+    Win32GLGetProcAddress(glGenQueries, GLGENQUERIES);
+    Win32GLGetProcAddress(glDeleteQueries, GLDELETEQUERIES);
+    Win32GLGetProcAddress(glQueryCounter, GLQUERYCOUNTER);
+    Win32GLGetProcAddress(glGetQueryObjectiv, GLGETQUERYOBJECTIV);
+    Win32GLGetProcAddress(glGetQueryObjectui64v, GLGETQUERYOBJECTUI64V);
+
+    Win32GLGetProcAddress(glTexStorage3D, GLTEXSTORAGE3D);
+    Win32GLGetProcAddress(glFramebufferTextureLayer, GLFRAMEBUFFERTEXTURELAYER);
+
+    Win32GLGetProcAddress(glDrawArraysIndirect, GLDRAWARRAYSINDIRECT);
+    Win32GLGetProcAddress(glDispatchComputeIndirect, GLDISPATCHCOMPUTEINDIRECT);
+    Win32GLGetProcAddress(glGetStringi, GLGETSTRINGI);
+
+    // Optional; wglGetProcAddress returns null for what the driver lacks
+    this->glMultiDrawElementsIndirectCount = (PFNGLMULTIDRAWELEMENTSINDIRECTCOUNTPROC)wglGetProcAddress("glMultiDrawElementsIndirectCount");
+    if (!this->glMultiDrawElementsIndirectCount)
+        this->glMultiDrawElementsIndirectCount = (PFNGLMULTIDRAWELEMENTSINDIRECTCOUNTPROC)wglGetProcAddress("glMultiDrawElementsIndirectCountARB");
+
 #pragma GCC diagnostic pop
 }
@@ -29,13 +29,74 @@
 
 #include "../../internal.h"
 #include "../../game.h"
+#include "../async-file-reader.h"
 
 #define SUBSYSTEM WINDOWS
 
 #include <gl/GL.h>
+#include <stdlib.h>
+
+// Log frame timings this often when TONIC_PROFILE is set
+#define PROFILE_LOG_SECONDS 5
 
 static bool running = true;
 
+// Finished file reads, run on the game thread at the start of each frame
+static std::mutex completionMutex;
+static std::vector<std::function<void()>> completions;
+
+// Window messages are handled on the game thread, between frames, so this
+// is both ends of the queue; it is still drained all at once each frame
+static Input *input = NULL;
+
+// Client area size, kept up to date by WM_SIZE
+static int window_width = 800, window_height = 600;
+
+// The performance counter in nanoseconds, the clock input is stamped with
+static uint64_t CounterNanoseconds()
+{
+    static LARGE_INTEGER frequency;
+    if (!frequency.QuadPart)
+        QueryPerformanceFrequency(&frequency);
+
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return (uint64_t)(now.QuadPart / frequency.QuadPart) * 1000000000 +
+           (uint64_t)(now.QuadPart % frequency.QuadPart) * 1000000000 / frequency.QuadPart;
+}
+
+// Input numbers keys as evdev does, which is the scancode for the main
+// block. Extended (0xE0-prefixed) scancodes differ.
+static int KeyFromScancode(LPARAM lparam)
+{
+    int scancode = (lparam >> 16) & 0xFF;
+    if (!(lparam & (1 << 24)))
+        return scancode;
+
+    switch (scancode)
+    {
+    case 0x1D: return INPUT_KEY_RIGHT_CTRL;
+    case 0x38: return INPUT_KEY_RIGHT_ALT;
+    case 0x47: return INPUT_KEY_HOME;
+    case 0x48: return INPUT_KEY_UP;
+    case 0x49: return INPUT_KEY_PAGE_UP;
+    case 0x4B: return INPUT_KEY_LEFT;
+    case 0x4D: return INPUT_KEY_RIGHT;
+    case 0x4F: return INPUT_KEY_END;
+    case 0x50: return INPUT_KEY_DOWN;
+    case 0x51: return INPUT_KEY_PAGE_DOWN;
+    case 0x52: return INPUT_KEY_INSERT;
+    case 0x53: return INPUT_KEY_DELETE;
+    default: return 0;
+    }
+}
+
+static void PushInput(InputEventType type, int code, float x, float y, bool pressed)
+{
+    if (input)
+        input->push(InputEvent{ type, CounterNanoseconds(), 0, code, x, y, pressed });
+}
+
 static LRESULT CALLBACK WindowProc(HWND handle, UINT msg, WPARAM wparam, LPARAM lparam)
 {
     LRESULT result = 0;
@@ -47,11 +108,69 @@ static LRESULT CALLBACK WindowProc(HWND handle, UINT msg, WPARAM wparam, LPARAM
         break;
     }
 
+    case WM_KEYDOWN:
+    case WM_KEYUP:
+    case WM_SYSKEYDOWN:
+    case WM_SYSKEYUP:
+    {
+        // Skip auto-repeat; Input reports keys held, not typed
+        bool pressed = msg == WM_KEYDOWN || msg == WM_SYSKEYDOWN;
+        bool repeat = pressed && (lparam & (1 << 30));
+        int key = KeyFromScancode(lparam);
+        if (key && !repeat)
+            PushInput(INPUT_KEY, key, 0.0f, 0.0f, pressed);
+
+        // Leave Alt+F4 and friends to Windows
+        if (msg == WM_SYSKEYDOWN || msg == WM_SYSKEYUP)
+            result = DefWindowProc(handle, msg, wparam, lparam);
+        break;
+    }
+
+    case WM_MOUSEMOVE:
+    {
+        PushInput(INPUT_POINTER_MOTION, 0, (float)(short)LOWORD(lparam), (float)(short)HIWORD(lparam), false);
+        break;
+    }
+
+    case WM_LBUTTONDOWN:
+    case WM_LBUTTONUP:
+        PushInput(INPUT_POINTER_BUTTON, INPUT_BUTTON_LEFT, 0.0f, 0.0f, msg == WM_LBUTTONDOWN);
+        break;
+    case WM_RBUTTONDOWN:
+    case WM_RBUTTONUP:
+        PushInput(INPUT_POINTER_BUTTON, INPUT_BUTTON_RIGHT, 0.0f, 0.0f, msg == WM_RBUTTONDOWN);
+        break;
+    case WM_MBUTTONDOWN:
+    case WM_MBUTTONUP:
+        PushInput(INPUT_POINTER_BUTTON, INPUT_BUTTON_MIDDLE, 0.0f, 0.0f, msg == WM_MBUTTONDOWN);
+        break;
+
+    case WM_MOUSEWHEEL:
+    {
+        // Positive is away from the user, i.e. scrolling up
+        float lines = -(float)GET_WHEEL_DELTA_WPARAM(wparam) / WHEEL_DELTA;
+        PushInput(INPUT_POINTER_SCROLL, 0, 0.0f, lines, false);
+        break;
+    }
+
+    case WM_KILLFOCUS:
+    {
+        PushInput(INPUT_FOCUS_LOST, 0, 0.0f, 0.0f, false);
+        break;
+    }
+
     case WM_SIZE:
     {
         UINT width = LOWORD(lparam);
         UINT height = HIWORD(lparam);
         glViewport(0, 0, width, height);
+
+        // Minimising reports 0x0; keep drawing at the last real size
+        if (width > 0 && height > 0)
+        {
+            window_width = (int)width;
+            window_height = (int)height;
+        }
         break;
     }
 
@@ -88,6 +207,58 @@ std::string Win32Platform::ReadFileToString (const std::string& path)
     return contents;
 }
 
+const void *Win32Platform::MapFile(const std::string &path, size_t *size)
+{
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        Log ("Unable to open file at path: '%s'\n", path.c_str());
+        return nullptr;
+    }
+
+    LARGE_INTEGER fileSize;
+    HANDLE mapping = NULL;
+    if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+    // The view keeps the file and mapping alive once both are closed
+    void *data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (mapping)
+        CloseHandle(mapping);
+    CloseHandle(file);
+
+    if (!data) {
+        Log ("Unable to map file at path: '%s'\n", path.c_str());
+        return nullptr;
+    }
+
+    *size = (size_t)fileSize.QuadPart;
+    return data;
+}
+
+void Win32Platform::UnmapFile(const void *data, size_t size)
+{
+    UnmapViewOfFile(data);
+}
+
+AudioSink *Win32Platform::OpenAudioSink(int sampleRate, int framesPerBuffer)
+{
+    // There is no WASAPI sink yet, so the mixer runs against a silent
+    // sink at the real rate. Opened once, at startup.
+    Log("No audio output on Windows yet; playing silence\n");
+    return new NullAudioSink(sampleRate, framesPerBuffer);
+}
+
+void Win32Platform::GetWindowSize(int *width, int *height)
+{
+    *width = window_width;
+    *height = window_height;
+}
+
+void Win32Platform::ReadFileAsync(const std::string &path, FileCallback callback)
+{
+    files->read(path, callback);
+}
+
 // Wrap logging so the Game can use it
 void Win32Platform::Log(const char *fmt, ...)
 {
@@ -213,10 +384,30 @@ int Win32Platform::Run(HINSTANCE instance, int show_code)
     // And, we're done!
     ShowWindow(handle, show_code);
 
+    files = new AsyncFileReader([](std::function<void()> done) {
+        std::lock_guard<std::mutex> lock(completionMutex);
+        completions.push_back(done);
+    });
+
     auto game = Initialize(loader);
     game->platform = this;
+    game->world = new World();
+    game->audio = new AudioMixer(OpenAudioSink(AUDIO_SAMPLE_RATE, AUDIO_FRAMES_PER_BUFFER));
+    game->audio->startThread();
+    input = new Input();
+    game->input = input;
+    game->profiler = new Profiler();
+    game->assets = new AssetCache(this);
     game->Setup();
 
+    bool logProfile = getenv("TONIC_PROFILE") != NULL;
+    uint64_t lastProfileLog = CounterNanoseconds();
+
+    // Without DXGI frame statistics the swap stands in for when frames
+    // are shown, so presentation numbers stay empty
+    if (logProfile)
+        Log("No presentation feedback on Windows; frame pacing is measured at the swap\n");
+
     LARGE_INTEGER prevFrameTime, frequency;
     QueryPerformanceFrequency(&frequency);
     QueryPerformanceCounter(&prevFrameTime);
@@ -225,17 +416,34 @@ int Win32Platform::Run(HINSTANCE instance, int show_code)
 
     while (running)
     {
+        game->profiler->beginFrame();
+
+        // Handle every message waiting, not one a frame, so input does
+        // not back up behind slow frames
         MSG message;
-        if (PeekMessage(&message, handle, 0, 0, PM_REMOVE))
+        while (PeekMessage(&message, handle, 0, 0, PM_REMOVE))
         {
             TranslateMessage(&message);
             DispatchMessage(&message);
         }
+        input->beginFrame();
+
+        std::vector<std::function<void()>> finished;
+        {
+            std::lock_guard<std::mutex> lock(completionMutex);
+            finished.swap(completions);
+        }
+        for (auto &done : finished)
+            done();
 
         // Do frame code
         // glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
         // glClear(GL_COLOR_BUFFER_BIT);
-        game->Frame(deltaTime);
+        {
+            ProfileScope scope(game->profiler, "game");
+            game->Frame(deltaTime);
+        }
+        game->assets->update();
 
         // Get current frame timestamp
         LARGE_INTEGER curFrameTime, elapsed;
@@ -250,9 +458,40 @@ int Win32Platform::Run(HINSTANCE instance, int show_code)
         prevFrameTime.QuadPart = curFrameTime.QuadPart;
         deltaTime = (float)(elapsed.QuadPart / 1000000.0f); // deltaTime is in seconds
 
-        SwapBuffers(deviceContext);
+        {
+            ProfileScope scope(game->profiler, "swap");
+            SwapBuffers(deviceContext);
+        }
+        uint64_t swapTime = CounterNanoseconds();
+        input->frameDisplayed(input->getFrameInputTime(), swapTime);
+
+        game->profiler->endFrame();
+        if (logProfile && swapTime - lastProfileLog > (uint64_t)PROFILE_LOG_SECONDS * 1000000000)
+        {
+            game->profiler->log(this);
+            game->assets->log();
+            InputStats inputStats = input->getStats();
+            Log("  input latency %.2f ms average, %.2f ms peak\n", inputStats.averageLatencyMs, inputStats.peakLatencyMs);
+            lastProfileLog = swapTime;
+        }
     }
 
+    // The game, then what it loaded, while the GL context is current.
+    // The mixer goes first so no voice is left playing a cached sound.
+    delete game->audio;
+    AssetCache *assets = game->assets;
+    World *world = game->world;
+    Profiler *profiler = game->profiler;
+    delete game;
+    delete assets;
+    delete world;
+
+    delete files;
+    files = nullptr;
+    delete input;
+    input = NULL;
+    delete profiler;
+
     wglMakeCurrent(NULL, NULL);
     ReleaseDC(handle, deviceContext);
     wglDeleteContext(glContext);
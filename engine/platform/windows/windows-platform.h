@@ -28,10 +28,20 @@
 #include <Windows.h>
 #include <stdio.h>
 
+class AsyncFileReader;
+
 class Win32Platform : Platform
 {
+private:
+    AsyncFileReader *files = nullptr;
+
 public:
     int Run(HINSTANCE instance, int show_code);
     std::string ReadFileToString (const std::string& path) override;
     virtual void Log(const char *fmt, ...) override;
+    const void *MapFile(const std::string &path, size_t *size) override;
+    void UnmapFile(const void *data, size_t size) override;
+    void ReadFileAsync(const std::string &path, FileCallback callback) override;
+    AudioSink *OpenAudioSink(int sampleRate, int framesPerBuffer) override;
+    void GetWindowSize(int *width, int *height) override;
 };
@@ -0,0 +1,147 @@
+#include "profiler.h"
+#include "../platform.h"
+
+#include <string.h>
+
+static float MillisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void ProfileStat::add(float ms)
+{
+    last = ms;
+    average = average ? average * 0.95f + ms * 0.05f : ms;
+    if (ms > peak)
+        peak = ms;
+}
+
+Profiler::Section *Profiler::find(const char *name)
+{
+    for (Section &section : sections)
+    {
+        if (section.name == name)
+            return &section;
+    }
+
+    // The same name from another translation unit may be another pointer
+    for (Section &section : sections)
+    {
+        if (strcmp(section.name, name) == 0)
+            return &section;
+    }
+
+    if (sections.size() == PROFILER_MAX_SECTIONS)
+        return nullptr;
+
+    sections.push_back(Section{ name, ProfileStat{}, {}, 0.0f, false });
+    return &sections.back();
+}
+
+void Profiler::beginFrame()
+{
+    frameStart = std::chrono::steady_clock::now();
+    frameStarted = true;
+}
+
+void Profiler::endFrame()
+{
+    if (!frameStarted)
+        return;
+    frameTime.add(MillisecondsSince(frameStart));
+
+    for (Section &section : sections)
+    {
+        if (section.ran)
+            section.time.add(section.frameMs);
+        section.frameMs = 0.0f;
+        section.ran = false;
+    }
+}
+
+void Profiler::begin(const char *name)
+{
+    Section *section = find(name);
+    if (section)
+        section->start = std::chrono::steady_clock::now();
+}
+
+void Profiler::end(const char *name)
+{
+    Section *section = find(name);
+    if (section)
+    {
+        section->frameMs += MillisecondsSince(section->start);
+        section->ran = true;
+    }
+}
+
+void Profiler::record(const char *name, float ms)
+{
+    Section *section = find(name);
+    if (section)
+    {
+        section->frameMs += ms;
+        section->ran = true;
+    }
+}
+
+void Profiler::framePresented(uint64_t swapTime, uint64_t presentTime, uint64_t refreshNs, uint64_t sequence)
+{
+    if (refreshNs)
+        present.refreshMs = refreshNs * 1e-6f;
+    if (presentTime > swapTime)
+        present.swapToPresent.add((presentTime - swapTime) * 1e-6f);
+
+    if (lastPresentTime && presentTime > lastPresentTime)
+    {
+        uint64_t interval = presentTime - lastPresentTime;
+        present.presentInterval.add(interval * 1e-6f);
+
+        // Every refresh between two frames showed the older one again.
+        // Count them from the vblank counter if there is one, otherwise
+        // from the time between the two, rounded to whole refreshes.
+        uint64_t refreshes = 0;
+        if (sequence && lastSequence && sequence > lastSequence)
+            refreshes = sequence - lastSequence;
+        else if (refreshNs)
+            refreshes = (interval + refreshNs / 2) / refreshNs;
+        if (refreshes > 1)
+            present.missedVblanks += (unsigned int)(refreshes - 1);
+    }
+
+    lastPresentTime = presentTime;
+    lastSequence = sequence;
+    present.presentedFrames++;
+}
+
+void Profiler::frameDiscarded()
+{
+    present.discardedFrames++;
+}
+
+const ProfileStat *Profiler::getSection(const char *name) const
+{
+    for (const Section &section : sections)
+    {
+        if (section.name == name || strcmp(section.name, name) == 0)
+            return &section.time;
+    }
+    return nullptr;
+}
+
+void Profiler::log(Platform *platform) const
+{
+    platform->Log("Profile (ms: last / average / peak)\n");
+    platform->Log("  %-24s %7.2f %7.2f %7.2f\n", "frame", frameTime.last, frameTime.average, frameTime.peak);
+    for (const Section &section : sections)
+        platform->Log("  %-24s %7.2f %7.2f %7.2f\n", section.name, section.time.last, section.time.average, section.time.peak);
+
+    if (present.presentedFrames)
+    {
+        platform->Log("  %-24s %7.2f %7.2f %7.2f\n", "swap to present", present.swapToPresent.last, present.swapToPresent.average, present.swapToPresent.peak);
+        platform->Log("  %-24s %7.2f %7.2f %7.2f\n", "present interval", present.presentInterval.last, present.presentInterval.average, present.presentInterval.peak);
+        platform->Log("  refresh %.2f ms, %u frames presented, %u discarded, %u missed vblanks\n",
+                      present.refreshMs, present.presentedFrames, present.discardedFrames, present.missedVblanks);
+    }
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <chrono>
+#include <stdint.h>
+#include <vector>
+
+class Platform;
+
+#define PROFILER_MAX_SECTIONS 64
+
+// One timing, in milliseconds
+struct ProfileStat
+{
+    float last = 0.0f;
+    float average = 0.0f; // exponential, over roughly the last 20 samples
+    float peak = 0.0f;
+
+    void add(float ms);
+};
+
+// How frames have been reaching the screen. Only filled in where the
+// platform can tell when a frame was actually displayed (Wayland with
+// wp_presentation); elsewhere 'presentedFrames' stays 0.
+struct PresentStats
+{
+    float refreshMs;             // the display's refresh interval, 0 if unknown
+    ProfileStat swapToPresent;   // buffer swap to first light on screen
+    ProfileStat presentInterval; // between consecutive presented frames
+    unsigned int presentedFrames;
+    unsigned int discardedFrames; // replaced before they were shown
+    unsigned int missedVblanks;   // refreshes that showed a stale frame
+};
+
+// Minimal CPU profiler for the game thread: named sections timed with
+// ProfileScope, plus frame pacing as reported by the platform. Everything
+// is averaged as it goes; nothing is stored per frame.
+//
+// Not thread safe. Sections are looked up by name pointer first, so pass
+// string literals.
+class Profiler
+{
+private:
+    struct Section
+    {
+        const char *name;
+        ProfileStat time;
+        std::chrono::steady_clock::time_point start;
+        float frameMs; // summed over the current frame
+        bool ran;      // this frame
+    };
+    std::vector<Section> sections;
+
+    ProfileStat frameTime;
+    std::chrono::steady_clock::time_point frameStart;
+    bool frameStarted = false;
+
+    PresentStats present = {};
+    uint64_t lastPresentTime = 0;
+    uint64_t lastSequence = 0;
+
+    Section *find(const char *name);
+
+public:
+    Profiler() { sections.reserve(PROFILER_MAX_SECTIONS); }
+
+    // Platform: around each frame, swap included
+    void beginFrame();
+    void endFrame();
+
+    void begin(const char *name);
+    void end(const char *name);
+
+    // Adds time measured some other way, e.g. on the GPU, to a section
+    // for the current frame
+    void record(const char *name, float ms);
+
+    // Platform, once it knows when a frame reached the screen. Times are
+    // nanoseconds on the same clock as 'swapTime'; 'sequence' is the
+    // display's vblank counter, or 0 if it has none.
+    void framePresented(uint64_t swapTime, uint64_t presentTime, uint64_t refreshNs, uint64_t sequence);
+    void frameDiscarded();
+
+    // Per-frame CPU time of a section, or nullptr if it has never run
+    const ProfileStat *getSection(const char *name) const;
+    const ProfileStat &getFrameTime() const { return frameTime; }
+    const PresentStats &getPresentStats() const { return present; }
+
+    // Writes every section and the pacing figures through Platform::Log
+    void log(Platform *platform) const;
+};
+
+// Times the enclosing block as the named section
+class ProfileScope
+{
+private:
+    Profiler *profiler;
+    const char *name;
+
+public:
+    ProfileScope(Profiler *profiler, const char *name) : profiler(profiler), name(name) { profiler->begin(name); }
+    ~ProfileScope() { profiler->end(name); }
+};
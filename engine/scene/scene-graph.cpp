@@ -0,0 +1,403 @@
+#include "scene-graph.h"
+
+#include "../math/simd.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#define NO_PARENT (~0u)
+
+// Index of the lowest set bit; 'bits' must not be 0
+static inline unsigned int LowestBit(uint64_t bits)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return (unsigned int)index;
+#else
+    return (unsigned int)__builtin_ctzll(bits);
+#endif
+}
+
+// Reorders 'values' so that values[k] becomes values[order[k]]. Elements
+// not named in 'order' are dropped.
+template <typename T>
+static void Reorder(std::vector<T> &values, const std::vector<unsigned int> &order)
+{
+    std::vector<T> reordered(order.size());
+    for (size_t k = 0; k < order.size(); k++)
+        reordered[k] = values[order[k]];
+    values.swap(reordered);
+}
+
+// world = parentWorld * compose(translation, rotation, scale). The SSE2
+// path never builds the local matrix: its columns have w = 0 (w = 1 for
+// the translation), so each world column is a sum of three (four) parent
+// columns scaled by one element of the local matrix, broadcast from a
+// scalar. Neither the local matrix nor any temporary touches memory.
+static inline void ComputeWorld(const mat4 *parentWorld, const vec3 &t, const quat &r, const vec3 &s, mat4 &world)
+{
+#ifdef TONIC_SSE2
+    float xx = r.x * r.x, yy = r.y * r.y, zz = r.z * r.z;
+    float xy = r.x * r.y, xz = r.x * r.z, yz = r.y * r.z;
+    float wx = r.w * r.x, wy = r.w * r.y, wz = r.w * r.z;
+
+    float m00 = (1.0f - 2.0f * (yy + zz)) * s.x, m01 = 2.0f * (xy + wz) * s.x, m02 = 2.0f * (xz - wy) * s.x;
+    float m10 = 2.0f * (xy - wz) * s.y, m11 = (1.0f - 2.0f * (xx + zz)) * s.y, m12 = 2.0f * (yz + wx) * s.y;
+    float m20 = 2.0f * (xz + wy) * s.z, m21 = 2.0f * (yz - wx) * s.z, m22 = (1.0f - 2.0f * (xx + yy)) * s.z;
+
+    if (parentWorld)
+    {
+        __m128 p0 = _mm_load_ps(&(*parentWorld)[0].x), p1 = _mm_load_ps(&(*parentWorld)[1].x);
+        __m128 p2 = _mm_load_ps(&(*parentWorld)[2].x), p3 = _mm_load_ps(&(*parentWorld)[3].x);
+
+        _mm_store_ps(&world[0].x, _mm_add_ps(_mm_add_ps(_mm_mul_ps(p0, _mm_set1_ps(m00)), _mm_mul_ps(p1, _mm_set1_ps(m01))), _mm_mul_ps(p2, _mm_set1_ps(m02))));
+        _mm_store_ps(&world[1].x, _mm_add_ps(_mm_add_ps(_mm_mul_ps(p0, _mm_set1_ps(m10)), _mm_mul_ps(p1, _mm_set1_ps(m11))), _mm_mul_ps(p2, _mm_set1_ps(m12))));
+        _mm_store_ps(&world[2].x, _mm_add_ps(_mm_add_ps(_mm_mul_ps(p0, _mm_set1_ps(m20)), _mm_mul_ps(p1, _mm_set1_ps(m21))), _mm_mul_ps(p2, _mm_set1_ps(m22))));
+        _mm_store_ps(&world[3].x, _mm_add_ps(_mm_add_ps(_mm_mul_ps(p0, _mm_set1_ps(t.x)), _mm_mul_ps(p1, _mm_set1_ps(t.y))),
+                                             _mm_add_ps(_mm_mul_ps(p2, _mm_set1_ps(t.z)), p3)));
+    }
+    else
+    {
+        _mm_store_ps(&world[0].x, _mm_setr_ps(m00, m01, m02, 0.0f));
+        _mm_store_ps(&world[1].x, _mm_setr_ps(m10, m11, m12, 0.0f));
+        _mm_store_ps(&world[2].x, _mm_setr_ps(m20, m21, m22, 0.0f));
+        _mm_store_ps(&world[3].x, _mm_setr_ps(t.x, t.y, t.z, 1.0f));
+    }
+#else
+    mat4 local = composeTransform(t, r, s);
+    world = parentWorld ? *parentWorld * local : local;
+#endif
+}
+
+NodeId SceneGraph::create(NodeId parent)
+{
+    unsigned int index = (unsigned int)parents.size();
+
+    NodeId handle;
+    if (!freeHandles.empty())
+    {
+        handle = freeHandles.back();
+        freeHandles.pop_back();
+        handleToIndex[handle] = index;
+    }
+    else
+    {
+        handle = (NodeId)handleToIndex.size();
+        handleToIndex.push_back(index);
+    }
+
+    parents.push_back(parent == INVALID_NODE ? NO_PARENT : handleToIndex[parent]);
+    positions.push_back(vec3(0.0f));
+    rotations.push_back(quat());
+    scales.push_back(vec3(1.0f));
+    worlds.push_back(mat4());
+    flags.push_back(0);
+    indexToHandle.push_back(handle);
+    dirtyBits.resize(index / 64 + 1);
+    markDirty(index);
+    needsChildren = true;
+
+    return handle;
+}
+
+void SceneGraph::destroy(NodeId node)
+{
+    // Descendants are found and removed in compact(), which needs the
+    // parent-before-child ordering to do it in one pass
+    flags[handleToIndex[node]] |= DEAD;
+    needsCompact = true;
+}
+
+bool SceneGraph::isAncestor(unsigned int ancestor, unsigned int index) const
+{
+    for (unsigned int i = parents[index]; i != NO_PARENT; i = parents[i])
+    {
+        if (i == ancestor)
+            return true;
+    }
+    return false;
+}
+
+bool SceneGraph::setParent(NodeId node, NodeId parent)
+{
+    unsigned int index = handleToIndex[node];
+    unsigned int parentIndex = parent == INVALID_NODE ? NO_PARENT : handleToIndex[parent];
+
+    if (parentIndex != NO_PARENT && (parentIndex == index || isAncestor(index, parentIndex)))
+        return false;
+
+    parents[index] = parentIndex;
+    markDirty(index);
+    needsChildren = true;
+
+    // A parent later in the arrays breaks the ordering until the next sort
+    if (parentIndex != NO_PARENT && parentIndex > index)
+        needsSort = true;
+
+    return true;
+}
+
+NodeId SceneGraph::getParent(NodeId node) const
+{
+    unsigned int parentIndex = parents[handleToIndex[node]];
+    return parentIndex == NO_PARENT ? INVALID_NODE : indexToHandle[parentIndex];
+}
+
+void SceneGraph::setPosition(NodeId node, const vec3 &position)
+{
+    unsigned int index = handleToIndex[node];
+    positions[index] = position;
+    markDirty(index);
+}
+
+void SceneGraph::setRotation(NodeId node, const quat &rotation)
+{
+    unsigned int index = handleToIndex[node];
+    rotations[index] = rotation;
+    markDirty(index);
+}
+
+void SceneGraph::setScale(NodeId node, const vec3 &scale)
+{
+    unsigned int index = handleToIndex[node];
+    scales[index] = scale;
+    markDirty(index);
+}
+
+void SceneGraph::setTransform(NodeId node, const vec3 &position, const quat &rotation, const vec3 &scale)
+{
+    unsigned int index = handleToIndex[node];
+    positions[index] = position;
+    rotations[index] = rotation;
+    scales[index] = scale;
+    markDirty(index);
+}
+
+void SceneGraph::permute(const std::vector<unsigned int> &order)
+{
+    std::vector<unsigned int> oldToNew(parents.size(), NO_PARENT);
+    for (size_t k = 0; k < order.size(); k++)
+        oldToNew[order[k]] = (unsigned int)k;
+
+    for (unsigned int &parent : parents)
+    {
+        if (parent != NO_PARENT)
+            parent = oldToNew[parent];
+    }
+
+    Reorder(parents, order);
+    Reorder(positions, order);
+    Reorder(rotations, order);
+    Reorder(scales, order);
+    Reorder(worlds, order);
+    Reorder(flags, order);
+    Reorder(indexToHandle, order);
+
+    for (size_t k = 0; k < indexToHandle.size(); k++)
+        handleToIndex[indexToHandle[k]] = (unsigned int)k;
+
+    // Indices moved, so find the flagged nodes again
+    dirtyBits.assign(flags.size() / 64 + 1, 0);
+    for (size_t k = 0; k < flags.size(); k++)
+    {
+        if (flags[k] & DIRTY)
+            dirtyBits[k >> 6] |= (uint64_t)1 << (k & 63);
+    }
+    needsChildren = true;
+}
+
+// Restores parent-before-child order with a breadth-first walk from the
+// roots, which also keeps each depth level contiguous
+void SceneGraph::sort()
+{
+    unsigned int count = (unsigned int)parents.size();
+
+    // Children of each node, packed into one array
+    std::vector<unsigned int> childStart(count + 1, 0);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        if (parents[i] != NO_PARENT)
+            childStart[parents[i] + 1]++;
+    }
+    for (unsigned int i = 0; i < count; i++)
+        childStart[i + 1] += childStart[i];
+
+    std::vector<unsigned int> children(childStart[count]);
+    std::vector<unsigned int> fill(childStart.begin(), childStart.end() - 1);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        if (parents[i] != NO_PARENT)
+            children[fill[parents[i]]++] = i;
+    }
+
+    std::vector<unsigned int> order;
+    order.reserve(count);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        if (parents[i] == NO_PARENT)
+            order.push_back(i);
+    }
+
+    // 'order' doubles as the BFS queue
+    for (size_t head = 0; head < order.size(); head++)
+    {
+        unsigned int node = order[head];
+        for (unsigned int c = childStart[node]; c < childStart[node + 1]; c++)
+            order.push_back(children[c]);
+    }
+
+    permute(order);
+    needsSort = false;
+}
+
+void SceneGraph::compact()
+{
+    unsigned int count = (unsigned int)parents.size();
+
+    // Parents come first, so one pass spreads DEAD to whole subtrees
+    std::vector<unsigned int> order;
+    order.reserve(count);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        if (parents[i] != NO_PARENT && (flags[parents[i]] & DEAD))
+            flags[i] |= DEAD;
+
+        if (flags[i] & DEAD)
+            freeHandles.push_back(indexToHandle[i]);
+        else
+            order.push_back(i);
+    }
+
+    permute(order);
+    needsCompact = false;
+}
+
+// Fills childStart, or returns false if the ordering is not breadth first
+// enough for it
+bool SceneGraph::buildChildren()
+{
+    unsigned int count = (unsigned int)parents.size();
+    childStart.resize(count + 1);
+
+    unsigned int next = 0; // first node whose children have not started
+    for (unsigned int i = 0; i < count; i++)
+    {
+        unsigned int parent = parents[i];
+        if (parent == NO_PARENT)
+            continue;
+        if (parent + 1 < next)
+            return false;
+
+        while (next <= parent)
+            childStart[next++] = i;
+    }
+    while (next <= count)
+        childStart[next++] = count;
+
+    needsChildren = false;
+    return true;
+}
+
+// Sets bits [begin, end)
+static void SetBits(uint64_t *bits, unsigned int begin, unsigned int end)
+{
+    unsigned int first = begin >> 6, last = (end - 1) >> 6;
+    uint64_t firstMask = ~(uint64_t)0 << (begin & 63);
+    uint64_t lastMask = ~(uint64_t)0 >> (63 - ((end - 1) & 63));
+    if (first == last)
+    {
+        bits[first] |= firstMask & lastMask;
+        return;
+    }
+
+    bits[first] |= firstMask;
+    for (unsigned int word = first + 1; word < last; word++)
+        bits[word] = ~(uint64_t)0;
+    bits[last] |= lastMask;
+}
+
+// Marks the node and its descendants in updateBits, a level at a time.
+// Roots between the children are marked too, which only recomputes them.
+void SceneGraph::markSubtree(unsigned int index)
+{
+    uint64_t *bits = updateBits.data();
+    const unsigned int *nodeChildren = childStart.data();
+
+    bits[index >> 6] |= (uint64_t)1 << (index & 63);
+
+    unsigned int begin = nodeChildren[index], end = nodeChildren[index + 1];
+    while (begin < end)
+    {
+        SetBits(bits, begin, end);
+
+        unsigned int nextBegin = nodeChildren[begin];
+        end = nodeChildren[end];
+        begin = nextBegin;
+    }
+}
+
+void SceneGraph::update()
+{
+    // Sort first: compact() relies on the ordering
+    if (needsSort)
+        sort();
+    if (needsCompact)
+        compact();
+
+    // Nodes created or reparented out of order; put them back in order
+    // once rather than scanning everything from now on
+    if (needsChildren && !buildChildren())
+    {
+        sort();
+        buildChildren();
+    }
+
+    // Lowest index first, so a flagged node already marked as part of an
+    // ancestor's subtree is skipped
+    updateBits.assign(dirtyBits.size(), 0);
+    bool any = false;
+    for (size_t word = 0; word < dirtyBits.size(); word++)
+    {
+        uint64_t bits = dirtyBits[word];
+        if (!bits)
+            continue;
+        dirtyBits[word] = 0;
+        any = true;
+
+        do
+        {
+            unsigned int index = (unsigned int)(word * 64) + LowestBit(bits);
+            bits &= bits - 1;
+
+            flags[index] &= ~DIRTY;
+            if (!(updateBits[index >> 6] & ((uint64_t)1 << (index & 63))))
+                markSubtree(index);
+        } while (bits);
+    }
+    if (!any)
+        return;
+
+    // Raw pointers: stores through mat4 would otherwise force the vector
+    // data pointers to be reloaded on every iteration
+    const unsigned int *nodeParents = parents.data();
+    const vec3 *nodePositions = positions.data();
+    const quat *nodeRotations = rotations.data();
+    const vec3 *nodeScales = scales.data();
+    mat4 *nodeWorlds = worlds.data();
+
+    // Parents come first, so theirs are final by the time a node is reached
+    for (size_t word = 0; word < updateBits.size(); word++)
+    {
+        uint64_t bits = updateBits[word];
+        while (bits)
+        {
+            unsigned int i = (unsigned int)(word * 64) + LowestBit(bits);
+            bits &= bits - 1;
+
+            unsigned int parent = nodeParents[i];
+            ComputeWorld(parent == NO_PARENT ? nullptr : &nodeWorlds[parent], nodePositions[i], nodeRotations[i], nodeScales[i], nodeWorlds[i]);
+        }
+    }
+}
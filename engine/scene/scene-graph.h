@@ -0,0 +1,125 @@
+#pragma once
+
+#include "../math/vec.h"
+#include "../math/mat.h"
+#include "../math/quat.h"
+
+#include <stdint.h>
+#include <vector>
+
+// Stable handle to a scene node. Nodes move around inside the graph's
+// arrays, so always refer to them by handle.
+typedef unsigned int NodeId;
+
+#define INVALID_NODE ((NodeId)~0u)
+
+// Transform hierarchy stored as parallel arrays (structure of arrays),
+// ordered so every parent comes before its children. That ordering lets
+// update() compute world matrices in a single forward pass: by the time a
+// node is reached, its parent's world matrix is already final.
+//
+// Changing a node's local transform only flags it. update() then rebuilds
+// the world matrices of flagged nodes and their descendants, leaving
+// everything else untouched. Local matrices are not stored: they are cheap
+// to rebuild from position/rotation/scale, and skipping them halves the
+// memory traffic of an update.
+//
+// The ordering is normally kept breadth first, as sort() leaves it: apart
+// from roots, which may sit anywhere, each node's parent is at or after
+// the previous node's. Children of consecutive nodes are then consecutive
+// too, so each flagged subtree is one contiguous range per level. update()
+// marks those ranges in a bitmap, then recomputes the marked nodes in one
+// forward sweep, skipping clean ones without reading them. Creating or
+// reparenting nodes out of that order costs one sort() at the next
+// update().
+class SceneGraph
+{
+private:
+    enum NodeFlags : unsigned char
+    {
+        DIRTY = 1 << 0, // world matrix is stale
+        DEAD = 1 << 1   // destroyed, removed at the next update()
+    };
+
+    // Per-node arrays, indexed by position in the ordering
+    std::vector<unsigned int> parents; // index of parent, or ~0u for roots
+    std::vector<vec3> positions;
+    std::vector<quat> rotations;
+    std::vector<vec3> scales;
+    std::vector<mat4> worlds;
+    std::vector<unsigned char> flags;
+    std::vector<NodeId> indexToHandle;
+
+    // Handle indirection, so indices can change on reordering
+    std::vector<unsigned int> handleToIndex;
+    std::vector<NodeId> freeHandles;
+
+    bool needsCompact = false;
+    bool needsSort = false;
+
+    // One bit per index flagged since the last update, so update() finds
+    // them in order without touching the nodes in between
+    std::vector<uint64_t> dirtyBits;
+
+    // Scratch for update(): the flagged nodes and all their descendants
+    std::vector<uint64_t> updateBits;
+
+    // Children of node i are the non-roots in [childStart[i], childStart[i + 1]).
+    // Rebuilt by update() after the hierarchy changes.
+    std::vector<unsigned int> childStart;
+    bool needsChildren = false;
+
+    void markDirty(unsigned int index)
+    {
+        if (flags[index] & DIRTY)
+            return;
+        flags[index] |= DIRTY;
+        dirtyBits[index >> 6] |= (uint64_t)1 << (index & 63);
+    }
+
+    void compact();
+    void sort();
+    void permute(const std::vector<unsigned int> &order);
+    bool buildChildren();
+    void markSubtree(unsigned int index);
+    bool isAncestor(unsigned int ancestor, unsigned int index) const;
+
+public:
+    // Parents must already exist, which keeps the ordering valid for free
+    NodeId create(NodeId parent = INVALID_NODE);
+
+    // Destroys the node and all of its descendants
+    void destroy(NodeId node);
+
+    // Moves the node (and its subtree) under a new parent. Fails and
+    // returns false if that would create a cycle.
+    bool setParent(NodeId node, NodeId parent);
+    NodeId getParent(NodeId node) const;
+
+    void setPosition(NodeId node, const vec3 &position);
+    void setRotation(NodeId node, const quat &rotation);
+    void setScale(NodeId node, const vec3 &scale);
+    void setTransform(NodeId node, const vec3 &position, const quat &rotation, const vec3 &scale);
+
+    const vec3 &getPosition(NodeId node) const { return positions[handleToIndex[node]]; }
+    const quat &getRotation(NodeId node) const { return rotations[handleToIndex[node]]; }
+    const vec3 &getScale(NodeId node) const { return scales[handleToIndex[node]]; }
+
+    mat4 getLocalMatrix(NodeId node) const
+    {
+        unsigned int index = handleToIndex[node];
+        return composeTransform(positions[index], rotations[index], scales[index]);
+    }
+
+    // Valid after update()
+    const mat4 &getWorldMatrix(NodeId node) const { return worlds[handleToIndex[node]]; }
+
+    // Applies pending destroys and reparents, then recomputes the world
+    // matrices of everything that changed since the last update
+    void update();
+
+    int getNodeCount() const { return (int)parents.size(); }
+
+    // World matrices in hierarchy order, e.g. for uploading in bulk
+    const mat4 *getWorldMatrices() const { return worlds.data(); }
+};
@@ -0,0 +1,542 @@
+#include "bvh.h"
+
+#include <algorithm>
+
+// Buckets per axis when evaluating SAH splits in build()
+#define SAH_BINS 16
+
+// Below this depth build() stops looking for SAH splits and halves ranges
+// by count, which bounds the depth of degenerate inputs
+#define SAH_MAX_DEPTH 64
+
+BVH::BVH(float margin)
+{
+    this->margin = margin;
+}
+
+int BVH::allocateNode()
+{
+    int node;
+    if (freeList >= 0)
+    {
+        node = freeList;
+        freeList = nodes[node].parent;
+    }
+    else
+    {
+        node = (int)nodes.size();
+        nodes.push_back(BVHNode());
+    }
+
+    BVHNode &n = nodes[node];
+    n.parent = -1;
+    n.left = n.right = -1;
+    n.height = 0;
+    n.userData = 0;
+    return node;
+}
+
+void BVH::freeNode(int node)
+{
+    nodes[node].parent = freeList;
+    nodes[node].height = -1;
+    freeList = node;
+}
+
+void BVH::clear()
+{
+    nodes.clear();
+    root = -1;
+    freeList = -1;
+    leafCount = 0;
+    refitOrderStale = true;
+}
+
+ProxyId BVH::insert(const AABB &box, unsigned int userData)
+{
+    int leaf = allocateNode();
+    nodes[leaf].box = AABB(box.min - vec3(margin), box.max + vec3(margin));
+    nodes[leaf].userData = userData;
+
+    insertLeaf(leaf);
+    leafCount++;
+    refitOrderStale = true;
+    return leaf;
+}
+
+void BVH::remove(ProxyId proxy)
+{
+    removeLeaf(proxy);
+    freeNode(proxy);
+    leafCount--;
+    refitOrderStale = true;
+}
+
+bool BVH::update(ProxyId proxy, const AABB &box, const vec3 &displacement)
+{
+    const AABB &fat = nodes[proxy].box;
+    if (fat.contains(box.min) && fat.contains(box.max))
+        return false;
+
+    removeLeaf(proxy);
+
+    AABB grown(box.min - vec3(margin), box.max + vec3(margin));
+    grown.min = grown.min + vmin(displacement, vec3(0.0f));
+    grown.max = grown.max + vmax(displacement, vec3(0.0f));
+    nodes[proxy].box = grown;
+
+    insertLeaf(proxy);
+    refitOrderStale = true;
+    return true;
+}
+
+// Branch and bound search for the node that, paired with a new leaf under
+// a new parent, adds the least surface area to the tree. Pairing with a
+// node costs the new parent's area plus the growth of every ancestor;
+// nothing below a node can cost less than the leaf's own area plus that
+// ancestor growth, which prunes most of the tree.
+int BVH::findBestSibling(const AABB &leafBox)
+{
+    float leafArea = surfaceArea(leafBox);
+    int best = root;
+    float bestCost = surfaceArea(merge(nodes[root].box, leafBox));
+
+    searchHeap.clear();
+    searchHeap.push_back(SiblingCandidate{root, 0.0f, leafArea});
+
+    while (!searchHeap.empty())
+    {
+        std::pop_heap(searchHeap.begin(), searchHeap.end());
+        SiblingCandidate candidate = searchHeap.back();
+        searchHeap.pop_back();
+
+        if (candidate.bound >= bestCost)
+            break;
+
+        const BVHNode &node = nodes[candidate.node];
+        float direct = surfaceArea(merge(node.box, leafBox));
+        float cost = direct + candidate.inherited;
+        if (cost < bestCost)
+        {
+            bestCost = cost;
+            best = candidate.node;
+        }
+
+        if (node.isLeaf())
+            continue;
+
+        float inherited = cost - surfaceArea(node.box);
+        float bound = leafArea + inherited;
+        if (bound < bestCost)
+        {
+            searchHeap.push_back(SiblingCandidate{node.left, inherited, bound});
+            std::push_heap(searchHeap.begin(), searchHeap.end());
+            searchHeap.push_back(SiblingCandidate{node.right, inherited, bound});
+            std::push_heap(searchHeap.begin(), searchHeap.end());
+        }
+    }
+
+    return best;
+}
+
+void BVH::insertLeaf(int leaf)
+{
+    if (root < 0)
+    {
+        root = leaf;
+        nodes[leaf].parent = -1;
+        return;
+    }
+
+    AABB leafBox = nodes[leaf].box;
+    int index = findBestSibling(leafBox);
+
+    int sibling = index;
+    int oldParent = nodes[sibling].parent;
+    int newParent = allocateNode();
+
+    BVHNode &parent = nodes[newParent];
+    parent.parent = oldParent;
+    parent.box = merge(leafBox, nodes[sibling].box);
+    parent.height = nodes[sibling].height + 1;
+    parent.left = sibling;
+    parent.right = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if (oldParent >= 0)
+    {
+        if (nodes[oldParent].left == sibling)
+            nodes[oldParent].left = newParent;
+        else
+            nodes[oldParent].right = newParent;
+    }
+    else
+    {
+        root = newParent;
+    }
+
+    // From the new parent itself: when the sibling was the root, it is
+    // the new root and would otherwise never be balanced
+    fixUpwards(newParent);
+}
+
+void BVH::removeLeaf(int leaf)
+{
+    if (leaf == root)
+    {
+        root = -1;
+        return;
+    }
+
+    // The leaf's parent goes too, its other child taking its place
+    int parent = nodes[leaf].parent;
+    int grandParent = nodes[parent].parent;
+    int sibling = nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left;
+
+    if (grandParent >= 0)
+    {
+        if (nodes[grandParent].left == parent)
+            nodes[grandParent].left = sibling;
+        else
+            nodes[grandParent].right = sibling;
+        nodes[sibling].parent = grandParent;
+        freeNode(parent);
+        fixUpwards(grandParent);
+    }
+    else
+    {
+        root = sibling;
+        nodes[sibling].parent = -1;
+        freeNode(parent);
+    }
+}
+
+// Refits, improves and rebalances from 'node' up to the root
+void BVH::fixUpwards(int node)
+{
+    while (node >= 0)
+    {
+        rotate(node);
+        node = balance(node);
+
+        BVHNode &n = nodes[node];
+        const BVHNode &left = nodes[n.left];
+        const BVHNode &right = nodes[n.right];
+        n.height = 1 + std::max(left.height, right.height);
+        n.box = merge(left.box, right.box);
+
+        node = n.parent;
+    }
+}
+
+// Swaps one child of 'a' with a grandchild on the other side if that
+// shrinks the child it moves into (Kopta et al., "Fast, Effective BVH
+// Updates for Animated Scenes"). a's own box does not change.
+void BVH::rotate(int a)
+{
+    BVHNode &A = nodes[a];
+    if (A.isLeaf())
+        return;
+
+    int b = A.left, c = A.right;
+    int bestChild = -1, bestGrandchild = -1;
+    float bestGain = 0.0f;
+
+    // Child 'child' trades places with a grandchild under 'other'
+    auto consider = [&](int child, int other) {
+        const BVHNode &O = nodes[other];
+        if (O.isLeaf())
+            return;
+
+        float area = surfaceArea(O.box);
+        int grandchildren[2] = { O.left, O.right };
+        for (int k = 0; k < 2; k++)
+        {
+            // 'other' would hold 'child' and the grandchild not moved
+            float gain = area - surfaceArea(merge(nodes[child].box, nodes[grandchildren[1 - k]].box));
+            if (gain > bestGain)
+            {
+                bestGain = gain;
+                bestChild = child;
+                bestGrandchild = grandchildren[k];
+            }
+        }
+    };
+    consider(b, c);
+    consider(c, b);
+
+    if (bestChild < 0)
+        return;
+
+    int other = bestChild == b ? c : b;
+    BVHNode &O = nodes[other];
+
+    if (A.left == bestChild)
+        A.left = bestGrandchild;
+    else
+        A.right = bestGrandchild;
+    if (O.left == bestGrandchild)
+        O.left = bestChild;
+    else
+        O.right = bestChild;
+    nodes[bestGrandchild].parent = a;
+    nodes[bestChild].parent = other;
+
+    O.box = merge(nodes[O.left].box, nodes[O.right].box);
+    O.height = 1 + std::max(nodes[O.left].height, nodes[O.right].height);
+}
+
+// Area-driven choices alone can leave the tree lopsided. If one child of
+// 'a' is more than BVH_MAX_IMBALANCE levels taller than the other, it is
+// rotated up into a's place. Returns the node now at a's position.
+int BVH::balance(int a)
+{
+    BVHNode &A = nodes[a];
+    if (A.isLeaf())
+        return a;
+
+    int b = A.left, c = A.right;
+    int difference = nodes[c].height - nodes[b].height;
+    if (difference >= -BVH_MAX_IMBALANCE && difference <= BVH_MAX_IMBALANCE)
+        return a;
+
+    // Name the taller child 'up' and the shorter 'down'
+    int up = difference > 0 ? c : b;
+    int down = difference > 0 ? b : c;
+    BVHNode &U = nodes[up];
+
+    int f = U.left, g = U.right;
+
+    // 'up' takes a's place under a's parent
+    U.left = a;
+    U.parent = A.parent;
+    A.parent = up;
+    if (U.parent >= 0)
+    {
+        if (nodes[U.parent].left == a)
+            nodes[U.parent].left = up;
+        else
+            nodes[U.parent].right = up;
+    }
+    else
+    {
+        root = up;
+    }
+
+    // The taller of up's children stays with it; the other moves under a
+    // next to 'down'
+    int keep = nodes[f].height > nodes[g].height ? f : g;
+    int move = keep == f ? g : f;
+
+    U.right = keep;
+    A.left = down;
+    A.right = move;
+    nodes[move].parent = a;
+
+    A.box = merge(nodes[down].box, nodes[move].box);
+    A.height = 1 + std::max(nodes[down].height, nodes[move].height);
+
+    // 'down' may be far shorter than 'move', as when a new leaf was paired
+    // with a whole subtree, so carry on down until a is balanced too
+    int lower = balance(a);
+    U.box = merge(nodes[lower].box, nodes[keep].box);
+    U.height = 1 + std::max(nodes[lower].height, nodes[keep].height);
+    return up;
+}
+
+void BVH::refit()
+{
+    if (refitOrderStale)
+    {
+        // Preorder puts every parent before its children, so reversed it
+        // visits children first
+        refitOrder.clear();
+        if (root >= 0 && !nodes[root].isLeaf())
+        {
+            std::vector<int> stack(1, root);
+            while (!stack.empty())
+            {
+                int node = stack.back();
+                stack.pop_back();
+                refitOrder.push_back(node);
+
+                const BVHNode &n = nodes[node];
+                if (!nodes[n.left].isLeaf())
+                    stack.push_back(n.left);
+                if (!nodes[n.right].isLeaf())
+                    stack.push_back(n.right);
+            }
+            std::reverse(refitOrder.begin(), refitOrder.end());
+        }
+        refitOrderStale = false;
+    }
+
+    BVHNode *n = nodes.data();
+    for (int node : refitOrder)
+        n[node].box = merge(n[n[node].left].box, n[n[node].right].box);
+}
+
+float BVH::getCost() const
+{
+    if (root < 0 || nodes[root].isLeaf())
+        return 0.0f;
+
+    float total = 0.0f;
+    for (const BVHNode &node : nodes)
+    {
+        if (node.height > 0)
+            total += surfaceArea(node.box);
+    }
+    return total / surfaceArea(nodes[root].box);
+}
+
+struct BuildTask
+{
+    int start, end; // range of the reference array
+    int parent;
+    bool isLeft;
+    int depth;
+};
+
+void BVH::build(const AABB *boxes, const unsigned int *userData, int count, ProxyId *proxies)
+{
+    clear();
+    if (count <= 0)
+        return;
+
+    nodes.reserve(2 * (size_t)count - 1);
+    leafCount = count;
+
+    std::vector<int> refs(count);
+    std::vector<vec3> centroids(count);
+    for (int i = 0; i < count; i++)
+    {
+        refs[i] = i;
+        centroids[i] = boxes[i].center();
+    }
+
+    // Ranges are split depth first, left before right, so nodes come out
+    // in preorder: a node's left child is right next to it in memory
+    std::vector<BuildTask> tasks;
+    tasks.push_back(BuildTask{0, count, -1, false, 0});
+
+    while (!tasks.empty())
+    {
+        BuildTask task = tasks.back();
+        tasks.pop_back();
+
+        int node = allocateNode();
+        nodes[node].parent = task.parent;
+        if (task.parent < 0)
+            root = node;
+        else if (task.isLeft)
+            nodes[task.parent].left = node;
+        else
+            nodes[task.parent].right = node;
+
+        if (task.end - task.start == 1)
+        {
+            int object = refs[task.start];
+            nodes[node].box = boxes[object];
+            nodes[node].userData = userData ? userData[object] : (unsigned int)object;
+            if (proxies)
+                proxies[object] = node;
+            continue;
+        }
+
+        AABB bounds, centroidBounds;
+        for (int i = task.start; i < task.end; i++)
+        {
+            bounds = merge(bounds, boxes[refs[i]]);
+            centroidBounds.expand(centroids[refs[i]]);
+        }
+        nodes[node].box = bounds;
+
+        // Bin centroids along each axis and sweep the bin boundaries for
+        // the split with the lowest count-weighted surface area
+        int bestAxis = -1, bestSplit = 0;
+        float bestCost = INFINITY;
+        vec3 extent = centroidBounds.max - centroidBounds.min;
+
+        for (int axis = 0; axis < 3 && task.depth < SAH_MAX_DEPTH; axis++)
+        {
+            if (extent[axis] <= 0.0f)
+                continue;
+
+            AABB binBounds[SAH_BINS];
+            int binCounts[SAH_BINS] = {};
+            float binScale = SAH_BINS / extent[axis];
+            for (int i = task.start; i < task.end; i++)
+            {
+                int bin = (int)((centroids[refs[i]][axis] - centroidBounds.min[axis]) * binScale);
+                bin = std::min(bin, SAH_BINS - 1);
+                binCounts[bin]++;
+                binBounds[bin] = merge(binBounds[bin], boxes[refs[i]]);
+            }
+
+            // Right-hand sweep first, then the left one evaluates costs
+            float rightArea[SAH_BINS];
+            int rightCount[SAH_BINS];
+            AABB accumulated;
+            int accumulatedCount = 0;
+            for (int bin = SAH_BINS - 1; bin > 0; bin--)
+            {
+                accumulated = merge(accumulated, binBounds[bin]);
+                accumulatedCount += binCounts[bin];
+                rightArea[bin] = accumulatedCount ? surfaceArea(accumulated) : 0.0f;
+                rightCount[bin] = accumulatedCount;
+            }
+
+            accumulated = AABB();
+            accumulatedCount = 0;
+            for (int split = 1; split < SAH_BINS; split++)
+            {
+                accumulated = merge(accumulated, binBounds[split - 1]);
+                accumulatedCount += binCounts[split - 1];
+                if (accumulatedCount == 0 || rightCount[split] == 0)
+                    continue;
+
+                float cost = accumulatedCount * surfaceArea(accumulated) + rightCount[split] * rightArea[split];
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = split;
+                }
+            }
+        }
+
+        int mid;
+        if (bestAxis >= 0)
+        {
+            float binScale = SAH_BINS / extent[bestAxis];
+            float axisMin = centroidBounds.min[bestAxis];
+            int *split = std::partition(refs.data() + task.start, refs.data() + task.end, [&](int object) {
+                int bin = (int)((centroids[object][bestAxis] - axisMin) * binScale);
+                return std::min(bin, SAH_BINS - 1) < bestSplit;
+            });
+            mid = (int)(split - refs.data());
+        }
+        else
+        {
+            // Coincident centroids or too deep: halve by count along the
+            // longest axis
+            int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+            mid = (task.start + task.end) / 2;
+            std::nth_element(refs.data() + task.start, refs.data() + mid, refs.data() + task.end,
+                             [&](int a, int b) { return centroids[a][axis] < centroids[b][axis]; });
+        }
+
+        tasks.push_back(BuildTask{mid, task.end, node, false, task.depth + 1});
+        tasks.push_back(BuildTask{task.start, mid, node, true, task.depth + 1});
+    }
+
+    // Children follow their parents, so a backwards pass sees them first
+    for (int node = (int)nodes.size() - 1; node >= 0; node--)
+    {
+        BVHNode &n = nodes[node];
+        if (!n.isLeaf())
+            n.height = 1 + std::max(nodes[n.left].height, nodes[n.right].height);
+    }
+}
@@ -0,0 +1,327 @@
+#pragma once
+
+#include "../math/geometry.h"
+
+#include <vector>
+
+// Handle to an object in a BVH. It stays valid until the object is
+// removed or the tree is rebuilt with build().
+typedef int ProxyId;
+
+#define INVALID_PROXY (-1)
+
+// Depth the queries' traversal stacks hold without allocating. build()
+// falls back to median splits long before this and inserts rebalance as
+// they go, but a deeper tree is still walked, with a stack on the heap.
+#define BVH_MAX_DEPTH 128
+
+// How much taller one child may grow than its sibling before incremental
+// updates rebalance the tree at the expense of its surface area
+#define BVH_MAX_IMBALANCE 4
+
+// One node of the flat node array. Leaves hold one object each.
+struct BVHNode
+{
+    AABB box;
+    int parent;      // or the next free node while on the free list
+    int left, right; // -1 for leaves
+    int height;      // 0 for leaves, -1 while free
+    unsigned int userData;
+
+    bool isLeaf() const { return left < 0; }
+};
+
+// Bounding volume hierarchy over axis-aligned boxes, for frustum culling,
+// ray casts and overlap queries.
+//
+// Static sets are best built in one go with build(), which splits by the
+// surface area heuristic (SAH). Dynamic objects are inserted and removed
+// one at a time: an insert searches for the sibling that grows the total
+// surface area least, and rotations on the way back up tidy the tree
+// further while keeping its height in check.
+//
+// Leaves of inserted objects are fattened by a margin, so update() only
+// touches the tree once an object leaves its fat box. When most objects
+// move a little every frame, setBox() followed by a single refit() is
+// cheaper still: the topology is kept and only the boxes are recomputed,
+// at the cost of the tree slowly degrading as objects drift apart.
+//
+// Nodes live in one array and refer to each other by index, and proxies
+// are leaf indices, so nothing moves when the tree changes shape.
+class BVH
+{
+private:
+    std::vector<BVHNode> nodes;
+    int root = -1;
+    int freeList = -1;
+    int leafCount = 0;
+    float margin;
+
+    // Search state for findBestSibling(), ordered so the heap's top has
+    // the lowest bound
+    struct SiblingCandidate
+    {
+        int node;
+        float inherited; // growth of the node's ancestors
+        float bound;     // lowest total cost anything in the subtree can have
+
+        bool operator<(const SiblingCandidate &other) const { return bound > other.bound; }
+    };
+    std::vector<SiblingCandidate> searchHeap;
+
+    // Internal nodes children-first, for refit(); rebuilt when stale
+    std::vector<int> refitOrder;
+    bool refitOrderStale = true;
+
+    int allocateNode();
+    void freeNode(int node);
+    void insertLeaf(int leaf);
+    void removeLeaf(int leaf);
+    int findBestSibling(const AABB &leafBox);
+    void rotate(int node);
+    int balance(int node);
+    void fixUpwards(int node);
+
+public:
+    explicit BVH(float margin = 0.1f);
+
+    // Replaces the contents of the tree with 'count' objects, built top
+    // down with binned SAH. Boxes are stored as given, without margin.
+    // The proxy of object i is written to proxies[i] if it is not null.
+    void build(const AABB *boxes, const unsigned int *userData, int count, ProxyId *proxies = nullptr);
+
+    void clear();
+
+    ProxyId insert(const AABB &box, unsigned int userData);
+    void remove(ProxyId proxy);
+
+    // Moves an object. Returns true if the tree had to be changed, which
+    // only happens when 'box' leaves the fat box. 'displacement' is the
+    // expected movement over the next frame; the fat box is stretched in
+    // that direction so fast objects are reinserted less often.
+    bool update(ProxyId proxy, const AABB &box, const vec3 &displacement = vec3(0.0f));
+
+    // Overwrites an object's box without touching its ancestors. Call
+    // refit() once all boxes are set and before querying.
+    void setBox(ProxyId proxy, const AABB &box) { nodes[proxy].box = box; }
+
+    // Recomputes every internal box from its children, bottom up
+    void refit();
+
+    const AABB &getBox(ProxyId proxy) const { return nodes[proxy].box; }
+    unsigned int getUserData(ProxyId proxy) const { return nodes[proxy].userData; }
+    int getCount() const { return leafCount; }
+    int getHeight() const { return root < 0 ? 0 : nodes[root].height; }
+
+    // Sum of internal node surface areas over the root's. Lower is a
+    // better tree; useful to decide when a rebuild is worthwhile.
+    float getCost() const;
+
+    // Calls fn(userData) for every object whose box overlaps 'box'
+    template <typename F>
+    void queryAABB(const AABB &box, F &&fn) const;
+
+    // Calls fn(userData) for every object whose box intersects the
+    // frustum. Subtrees entirely inside it are reported without testing.
+    template <typename F>
+    void queryFrustum(const Frustum &frustum, F &&fn) const;
+
+    // Walks the boxes hit by the ray from 'origin' before 'maxDistance',
+    // roughly nearest first, calling fn(userData, entryDistance) for each.
+    // The direction need not be normalised; distances are in units of its
+    // length. fn returns the new maximum distance: that of an exact hit
+    // against the object to clip the ray, or the current maximum to keep
+    // going. Returning 0 stops the cast.
+    template <typename F>
+    void raycast(const vec3 &origin, const vec3 &direction, float maxDistance, F &&fn) const;
+};
+
+// Storage for a query's traversal stack. A depth first walk that pushes
+// both children never holds more than the tree's height plus one entries,
+// so the fixed array does unless the tree is deeper than BVH_MAX_DEPTH.
+template <typename T>
+struct BVHStack
+{
+    T fixed[BVH_MAX_DEPTH];
+    std::vector<T> spill;
+    T *data;
+
+    explicit BVHStack(int height)
+    {
+        if (height < BVH_MAX_DEPTH)
+        {
+            data = fixed;
+        }
+        else
+        {
+            spill.resize(height + 1);
+            data = spill.data();
+        }
+    }
+};
+
+// Distance along the ray to where it enters 'box', or INFINITY if it
+// misses it before 'maxDistance'. 'invDirection' is 1 / direction.
+inline float RayBoxDistance(const vec3 &origin, const vec3 &invDirection, const AABB &box, float maxDistance)
+{
+    float tx0 = (box.min.x - origin.x) * invDirection.x, tx1 = (box.max.x - origin.x) * invDirection.x;
+    float ty0 = (box.min.y - origin.y) * invDirection.y, ty1 = (box.max.y - origin.y) * invDirection.y;
+    float tz0 = (box.min.z - origin.z) * invDirection.z, tz1 = (box.max.z - origin.z) * invDirection.z;
+
+    float tmin = fmaxf(fmaxf(fminf(tx0, tx1), fminf(ty0, ty1)), fmaxf(fminf(tz0, tz1), 0.0f));
+    float tmax = fminf(fminf(fmaxf(tx0, tx1), fmaxf(ty0, ty1)), fminf(fmaxf(tz0, tz1), maxDistance));
+    return tmin <= tmax ? tmin : INFINITY;
+}
+
+template <typename F>
+void BVH::queryAABB(const AABB &box, F &&fn) const
+{
+    if (root < 0)
+        return;
+
+    BVHStack<int> storage(getHeight());
+    int *stack = storage.data;
+    int top = 0;
+    stack[top++] = root;
+
+    while (top > 0)
+    {
+        const BVHNode &node = nodes[stack[--top]];
+        if (!overlaps(node.box, box))
+            continue;
+
+        if (node.isLeaf())
+        {
+            fn(node.userData);
+        }
+        else
+        {
+            stack[top++] = node.right;
+            stack[top++] = node.left;
+        }
+    }
+}
+
+template <typename F>
+void BVH::queryFrustum(const Frustum &frustum, F &&fn) const
+{
+    if (root < 0)
+        return;
+
+    // Each entry carries the planes its box still straddles; a box inside
+    // a plane has all of its descendants inside it too
+    struct Entry
+    {
+        int node;
+        int planeMask;
+    };
+    BVHStack<Entry> storage(getHeight());
+    Entry *stack = storage.data;
+    int top = 0;
+    stack[top++] = Entry{root, 0x3f};
+
+    while (top > 0)
+    {
+        Entry entry = stack[--top];
+        const BVHNode &node = nodes[entry.node];
+
+        int planeMask = entry.planeMask;
+        if (planeMask)
+        {
+            vec3 center = node.box.center();
+            vec3 extents = node.box.extents();
+
+            bool outside = false;
+            for (int i = 0; i < 6; i++)
+            {
+                if (!(planeMask & (1 << i)))
+                    continue;
+
+                const Plane &plane = frustum.planes[i];
+                float radius = extents.x * fabsf(plane.normal.x) +
+                               extents.y * fabsf(plane.normal.y) +
+                               extents.z * fabsf(plane.normal.z);
+                float distance = plane.distance(center);
+                if (distance < -radius)
+                {
+                    outside = true;
+                    break;
+                }
+                if (distance >= radius)
+                    planeMask &= ~(1 << i);
+            }
+            if (outside)
+                continue;
+        }
+
+        if (node.isLeaf())
+        {
+            fn(node.userData);
+        }
+        else
+        {
+            stack[top++] = Entry{node.right, planeMask};
+            stack[top++] = Entry{node.left, planeMask};
+        }
+    }
+}
+
+template <typename F>
+void BVH::raycast(const vec3 &origin, const vec3 &direction, float maxDistance, F &&fn) const
+{
+    if (root < 0)
+        return;
+
+    vec3 invDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+    struct Entry
+    {
+        int node;
+        float distance;
+    };
+    BVHStack<Entry> storage(getHeight());
+    Entry *stack = storage.data;
+    int top = 0;
+
+    float rootDistance = RayBoxDistance(origin, invDirection, nodes[root].box, maxDistance);
+    if (rootDistance == INFINITY)
+        return;
+    stack[top++] = Entry{root, rootDistance};
+
+    while (top > 0)
+    {
+        Entry entry = stack[--top];
+
+        // The ray may have been clipped since this was pushed
+        if (entry.distance > maxDistance)
+            continue;
+
+        const BVHNode &node = nodes[entry.node];
+        if (node.isLeaf())
+        {
+            maxDistance = fn(node.userData, entry.distance);
+            if (maxDistance <= 0.0f)
+                return;
+            continue;
+        }
+
+        float leftDistance = RayBoxDistance(origin, invDirection, nodes[node.left].box, maxDistance);
+        float rightDistance = RayBoxDistance(origin, invDirection, nodes[node.right].box, maxDistance);
+
+        // Push the farther child first so the nearer one is visited first
+        int nearChild = node.left, farChild = node.right;
+        if (rightDistance < leftDistance)
+        {
+            float swapDistance = leftDistance;
+            leftDistance = rightDistance;
+            rightDistance = swapDistance;
+            nearChild = node.right;
+            farChild = node.left;
+        }
+
+        if (rightDistance != INFINITY)
+            stack[top++] = Entry{farChild, rightDistance};
+        if (leftDistance != INFINITY)
+            stack[top++] = Entry{nearChild, leftDistance};
+    }
+}
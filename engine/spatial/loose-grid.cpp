@@ -0,0 +1,117 @@
+#include "loose-grid.h"
+
+#define OVERFLOW_CELL (-1)
+#define FREED_CELL (-2)
+
+LooseGrid::LooseGrid(const AABB &region, float cellSize)
+{
+    this->cellSize = cellSize;
+    invCellSize = 1.0f / cellSize;
+
+    vec3 size = region.max - region.min;
+    for (int k = 0; k < 3; k++)
+    {
+        dims[k] = (int)ceilf(size[k] * invCellSize);
+        dims[k] = dims[k] < 1 ? 1 : dims[k];
+    }
+    this->region = AABB(region.min, region.min + vec3((float)dims[0], (float)dims[1], (float)dims[2]) * cellSize);
+
+    cells.resize((size_t)dims[0] * dims[1] * dims[2]);
+    cellStamps.assign(cells.size(), 0u);
+}
+
+void LooseGrid::cellCoords(const vec3 &p, int coords[3]) const
+{
+    for (int k = 0; k < 3; k++)
+    {
+        int c = (int)floorf((p[k] - region.min[k]) * invCellSize);
+        coords[k] = c < 0 ? 0 : (c >= dims[k] ? dims[k] - 1 : c);
+    }
+}
+
+int LooseGrid::cellFor(const AABB &box) const
+{
+    vec3 center = box.center();
+    vec3 extents = box.extents();
+    float halfCell = 0.5f * cellSize;
+    if (extents.x > halfCell || extents.y > halfCell || extents.z > halfCell || !region.contains(center))
+        return OVERFLOW_CELL;
+
+    int coords[3];
+    cellCoords(center, coords);
+    return cellIndex(coords[0], coords[1], coords[2]);
+}
+
+void LooseGrid::link(int object, int cell)
+{
+    Object &o = objects[object];
+    o.cell = cell;
+    o.prev = -1;
+
+    int &head = cell == OVERFLOW_CELL ? overflowHead : cells[cell].head;
+    o.next = head;
+    if (head >= 0)
+        objects[head].prev = object;
+    head = object;
+
+    if (cell != OVERFLOW_CELL)
+        cells[cell].count++;
+}
+
+void LooseGrid::unlink(int object)
+{
+    Object &o = objects[object];
+    int &head = o.cell == OVERFLOW_CELL ? overflowHead : cells[o.cell].head;
+
+    if (o.prev >= 0)
+        objects[o.prev].next = o.next;
+    else
+        head = o.next;
+    if (o.next >= 0)
+        objects[o.next].prev = o.prev;
+
+    if (o.cell != OVERFLOW_CELL)
+        cells[o.cell].count--;
+}
+
+GridProxy LooseGrid::insert(const AABB &box, unsigned int userData)
+{
+    int object;
+    if (freeList >= 0)
+    {
+        object = freeList;
+        freeList = objects[object].next;
+    }
+    else
+    {
+        object = (int)objects.size();
+        objects.push_back(Object());
+    }
+
+    objects[object].box = box;
+    objects[object].userData = userData;
+    link(object, cellFor(box));
+    count++;
+    return object;
+}
+
+void LooseGrid::remove(GridProxy proxy)
+{
+    unlink(proxy);
+    objects[proxy].cell = FREED_CELL;
+    objects[proxy].next = freeList;
+    freeList = proxy;
+    count--;
+}
+
+void LooseGrid::update(GridProxy proxy, const AABB &box)
+{
+    objects[proxy].box = box;
+
+    int cell = cellFor(box);
+    if (cell == objects[proxy].cell)
+        return;
+
+    unlink(proxy);
+    link(proxy, cell);
+}
@@ -0,0 +1,253 @@
+#pragma once
+
+#include "../math/geometry.h"
+#include "bvh.h"
+
+#include <algorithm>
+#include <vector>
+
+// Handle to an object in a LooseGrid, valid until it is removed
+typedef int GridProxy;
+
+#define INVALID_GRID_PROXY (-1)
+
+// Uniform grid of cells over a fixed region, where each object is filed
+// under the single cell containing its centre. Objects may hang over into
+// neighbouring cells by up to half a cell, so a cell's "loose" bounds are
+// twice its size. Objects larger than that, or whose centre falls outside
+// the region, go on an overflow list that every query checks.
+//
+// Compared with BVH, moving an object is a couple of index updates and
+// there is nothing to rebalance or refit, which suits many similarly
+// sized objects that move every frame. Queries get slower when objects
+// clump into a few cells or the cell size is badly chosen; as a rule of
+// thumb it should be around the size of the larger common objects.
+class LooseGrid
+{
+private:
+    struct Object
+    {
+        AABB box;
+        unsigned int userData;
+        int cell;       // -1 on the overflow list, -2 once freed
+        int prev, next; // in the cell or overflow list, or free list
+    };
+
+    struct Cell
+    {
+        int head = -1;
+        int count = 0;
+    };
+
+    AABB region;
+    float cellSize, invCellSize;
+    int dims[3];
+
+    std::vector<Cell> cells;
+    std::vector<Object> objects;
+    int overflowHead = -1;
+    int freeList = -1;
+    int count = 0;
+
+    // Visit stamps for raycast(), so no cell is tested twice per cast
+    mutable std::vector<unsigned int> cellStamps;
+    mutable unsigned int stamp = 0;
+
+    int cellFor(const AABB &box) const;
+    void link(int object, int cell);
+    void unlink(int object);
+
+    int cellIndex(int x, int y, int z) const { return (z * dims[1] + y) * dims[0] + x; }
+    void cellCoords(const vec3 &p, int coords[3]) const;
+
+    AABB looseBounds(int x, int y, int z) const
+    {
+        vec3 min = region.min + vec3((x - 0.5f) * cellSize, (y - 0.5f) * cellSize, (z - 0.5f) * cellSize);
+        return AABB(min, min + vec3(2.0f * cellSize));
+    }
+
+public:
+    // 'region' is rounded up to a whole number of cells
+    LooseGrid(const AABB &region, float cellSize);
+
+    GridProxy insert(const AABB &box, unsigned int userData);
+    void remove(GridProxy proxy);
+    void update(GridProxy proxy, const AABB &box);
+
+    const AABB &getBox(GridProxy proxy) const { return objects[proxy].box; }
+    unsigned int getUserData(GridProxy proxy) const { return objects[proxy].userData; }
+    int getCount() const { return count; }
+
+    // Same contracts as the BVH queries of the same names
+    template <typename F>
+    void queryAABB(const AABB &box, F &&fn) const;
+
+    template <typename F>
+    void queryFrustum(const Frustum &frustum, F &&fn) const;
+
+    template <typename F>
+    void raycast(const vec3 &origin, const vec3 &direction, float maxDistance, F &&fn) const;
+};
+
+template <typename F>
+void LooseGrid::queryAABB(const AABB &box, F &&fn) const
+{
+    for (int o = overflowHead; o >= 0; o = objects[o].next)
+    {
+        if (overlaps(objects[o].box, box))
+            fn(objects[o].userData);
+    }
+
+    // Anything touching the box has its centre within half a cell of it
+    int lo[3], hi[3];
+    vec3 half(0.5f * cellSize);
+    cellCoords(box.min - half, lo);
+    cellCoords(box.max + half, hi);
+
+    for (int z = lo[2]; z <= hi[2]; z++)
+    {
+        for (int y = lo[1]; y <= hi[1]; y++)
+        {
+            for (int x = lo[0]; x <= hi[0]; x++)
+            {
+                for (int o = cells[cellIndex(x, y, z)].head; o >= 0; o = objects[o].next)
+                {
+                    if (overlaps(objects[o].box, box))
+                        fn(objects[o].userData);
+                }
+            }
+        }
+    }
+}
+
+template <typename F>
+void LooseGrid::queryFrustum(const Frustum &frustum, F &&fn) const
+{
+    for (int o = overflowHead; o >= 0; o = objects[o].next)
+    {
+        if (frustum.containsAABB(objects[o].box))
+            fn(objects[o].userData);
+    }
+
+    // Only cells within half a cell of the frustum's corners can hold
+    // anything inside it
+    AABB bounds = frustumBounds(frustum);
+    int lo[3], hi[3];
+    vec3 half(0.5f * cellSize);
+    cellCoords(bounds.min - half, lo);
+    cellCoords(bounds.max + half, hi);
+
+    for (int z = lo[2]; z <= hi[2]; z++)
+    {
+        for (int y = lo[1]; y <= hi[1]; y++)
+        {
+            for (int x = lo[0]; x <= hi[0]; x++)
+            {
+                const Cell &cell = cells[cellIndex(x, y, z)];
+                if (cell.count == 0 || !frustum.containsAABB(looseBounds(x, y, z)))
+                    continue;
+
+                for (int o = cell.head; o >= 0; o = objects[o].next)
+                {
+                    if (frustum.containsAABB(objects[o].box))
+                        fn(objects[o].userData);
+                }
+            }
+        }
+    }
+}
+
+template <typename F>
+void LooseGrid::raycast(const vec3 &origin, const vec3 &direction, float maxDistance, F &&fn) const
+{
+    vec3 invDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+    // Overflow objects are few, so they are simply tested up front
+    for (int o = overflowHead; o >= 0 && maxDistance > 0.0f; o = objects[o].next)
+    {
+        float distance = RayBoxDistance(origin, invDirection, objects[o].box, maxDistance);
+        if (distance != INFINITY)
+            maxDistance = fn(objects[o].userData, distance);
+    }
+    if (maxDistance <= 0.0f)
+        return;
+
+    // Clip the ray to the region, grown by the half cell objects can
+    // overhang, then step through it cell by cell (Amanatides-Woo)
+    AABB grown(region.min - vec3(0.5f * cellSize), region.max + vec3(0.5f * cellSize));
+    float t = RayBoxDistance(origin, invDirection, grown, maxDistance);
+    if (t == INFINITY)
+        return;
+
+    if (++stamp == 0)
+    {
+        // Wrapped around: forget every old stamp
+        std::fill(cellStamps.begin(), cellStamps.end(), 0u);
+        stamp = 1;
+    }
+
+    // Not clamped: the ray may start in the overhang outside the region
+    int cell[3], step[3];
+    float next[3], delta[3];
+    vec3 start = origin + direction * t;
+    for (int k = 0; k < 3; k++)
+    {
+        cell[k] = (int)floorf((start[k] - region.min[k]) * invCellSize);
+        cell[k] = cell[k] < -1 ? -1 : (cell[k] > dims[k] ? dims[k] : cell[k]);
+
+        float boundary = region.min[k] + cellSize * (direction[k] >= 0.0f ? cell[k] + 1 : cell[k]);
+        step[k] = direction[k] >= 0.0f ? 1 : -1;
+        delta[k] = fabsf(cellSize * invDirection[k]);
+        next[k] = direction[k] != 0.0f ? (boundary - origin[k]) * invDirection[k] : INFINITY;
+    }
+
+    // Any hit point lies in the cell being stepped through, and the
+    // object hit is filed under that cell or one of its neighbours. Cells
+    // are visited in order of entry, so stopping once the entry distance
+    // passes maxDistance misses nothing.
+    while (t <= maxDistance)
+    {
+        for (int dz = -1; dz <= 1; dz++)
+        {
+            int z = cell[2] + dz;
+            if (z < 0 || z >= dims[2])
+                continue;
+            for (int dy = -1; dy <= 1; dy++)
+            {
+                int y = cell[1] + dy;
+                if (y < 0 || y >= dims[1])
+                    continue;
+                for (int dx = -1; dx <= 1; dx++)
+                {
+                    int x = cell[0] + dx;
+                    if (x < 0 || x >= dims[0])
+                        continue;
+
+                    int index = cellIndex(x, y, z);
+                    if (cellStamps[index] == stamp)
+                        continue;
+                    cellStamps[index] = stamp;
+
+                    for (int o = cells[index].head; o >= 0; o = objects[o].next)
+                    {
+                        float distance = RayBoxDistance(origin, invDirection, objects[o].box, maxDistance);
+                        if (distance == INFINITY)
+                            continue;
+                        maxDistance = fn(objects[o].userData, distance);
+                        if (maxDistance <= 0.0f)
+                            return;
+                    }
+                }
+            }
+        }
+
+        int axis = next[0] < next[1] ? (next[0] < next[2] ? 0 : 2) : (next[1] < next[2] ? 1 : 2);
+        t = next[axis];
+        next[axis] += delta[axis];
+        cell[axis] += step[axis];
+
+        // Stepped out past the grown region: nothing further can be hit
+        if (cell[axis] < -1 || cell[axis] > dims[axis])
+            return;
+    }
+}
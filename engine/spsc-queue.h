@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+// Fixed-size lock-free queue for one producer thread and one consumer
+// thread, e.g. the game thread feeding a real-time thread that must never
+// block on a mutex. Neither side allocates or waits: push() fails when the
+// queue is full and pop() when it is empty.
+//
+// 'Capacity' must be a power of two.
+template <typename T, uint32_t Capacity>
+class SpscQueue
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+private:
+    T items[Capacity];
+
+    // Free-running counters; only their difference matters, so they may
+    // wrap. Kept on separate cache lines so the two threads do not keep
+    // stealing the line from each other.
+    alignas(64) std::atomic<uint32_t> head{0}; // next to pop, written by the consumer
+    alignas(64) std::atomic<uint32_t> tail{0}; // next to push, written by the producer
+
+public:
+    // Producer only
+    bool push(const T &item)
+    {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == Capacity)
+            return false;
+
+        items[t & (Capacity - 1)] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only
+    bool pop(T &item)
+    {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+            return false;
+
+        item = items[h & (Capacity - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate when called while the other thread is active
+    uint32_t size() const
+    {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+};
@@ -0,0 +1,43 @@
+#include "string-id.h"
+
+#ifndef NDEBUG
+#include <mutex>
+#include <unordered_map>
+
+// Ids are built on any thread, so the table is shared behind a lock
+static std::mutex namesMutex;
+static std::unordered_map<uint64_t, std::string> &Names()
+{
+    static std::unordered_map<uint64_t, std::string> names;
+    return names;
+}
+#endif
+
+StringId::StringId(const char *string, size_t length) : hash(HashString(string, length))
+{
+    RegisterStringId(string, length);
+}
+
+void RegisterStringId(const char *string, size_t length)
+{
+#ifndef NDEBUG
+    std::lock_guard<std::mutex> lock(namesMutex);
+    Names().emplace(HashString(string, length), std::string(string, length));
+#else
+    (void)string;
+    (void)length;
+#endif
+}
+
+const char *StringIdName(StringId id)
+{
+#ifndef NDEBUG
+    std::lock_guard<std::mutex> lock(namesMutex);
+    auto found = Names().find(id.hash);
+    if (found != Names().end())
+        return found->second.c_str();
+#else
+    (void)id;
+#endif
+    return "?";
+}
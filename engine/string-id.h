@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+#define STRING_ID_OFFSET 0xcbf29ce484222325ull
+#define STRING_ID_PRIME 0x100000001b3ull
+
+// 64-bit FNV-1a, usable at compile time
+constexpr uint64_t HashString(const char *string, size_t length)
+{
+    uint64_t hash = STRING_ID_OFFSET;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= (unsigned char)string[i];
+        hash *= STRING_ID_PRIME;
+    }
+    return hash;
+}
+
+// A name reduced to its hash, for lookups that should cost an integer
+// compare rather than a string compare or an allocation. Built from a
+// string literal, the hash is worked out by the compiler:
+//
+//     shader->setFloat("exposure", value);
+//
+// Only the hash is kept. Debug builds remember the names of ids built at
+// run time (and of any passed to RegisterStringId) so StringIdName() can
+// turn an id back into something readable; release builds cannot.
+struct StringId
+{
+    uint64_t hash = 0;
+
+    constexpr StringId() {}
+    constexpr explicit StringId(uint64_t hash) : hash(hash) {}
+
+    template <size_t N>
+    constexpr StringId(const char (&literal)[N]) : hash(HashString(literal, N - 1)) {}
+
+    explicit StringId(const char *string, size_t length);
+    explicit StringId(const std::string &string) : StringId(string.data(), string.size()) {}
+
+    constexpr bool operator==(StringId other) const { return hash == other.hash; }
+    constexpr bool operator!=(StringId other) const { return hash != other.hash; }
+    constexpr bool operator<(StringId other) const { return hash < other.hash; }
+};
+
+// Debug builds only; does nothing with NDEBUG defined
+void RegisterStringId(const char *string, size_t length);
+
+// The name behind an id, or "?" if it is not known (always, in release
+// builds). For logging.
+const char *StringIdName(StringId id);
+
+namespace std
+{
+    template <>
+    struct hash<StringId>
+    {
+        size_t operator()(StringId id) const { return (size_t)id.hash; }
+    };
+}
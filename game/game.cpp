@@ -3,16 +3,90 @@
 #include <iostream>
 #include <assert.h>
 #include <math.h>
+#include <vector>
+
+#include "../engine/math/quat.h"
 
 #include "renderer/shader.h"
+#include "renderer/mesh.h"
+#include "renderer/mesh-asset.h"
+#include "renderer/assets.h"
+#include "renderer/gpu-resources.h"
+#include "renderer/gpu-timer.h"
+#include "renderer/post-process.h"
+#include "renderer/dynamic-resolution.h"
+#include "renderer/clustered-lighting.h"
+#include "renderer/cascaded-shadows.h"
+#include "renderer/particles.h"
+#include "renderer/render-graph.h"
+#include "renderer/lod.h"
+#include "renderer/instancing.h"
+#include "renderer/uniform-ring.h"
+#include "renderer/uniforms.h"
+
+#define NUM_TRIANGLES 5
+
+#define CAMERA_FOV 1.0f
+#define CAMERA_NEAR 0.1f
+#define CAMERA_FAR 100.0f
+
+// Simplification error allowed on screen before a finer LOD is drawn
+#define LOD_ERROR_PIXELS 4.0f
+
+// Radians per second with a key held or the stick all the way over
+#define CAMERA_ORBIT_SPEED 1.5f
+#define CAMERA_DISTANCE 2.5f
+
+// Coloured lights circling the torus
+#define NUM_LIGHTS 24
+
+// Tori lying along the torus's path that never move, so the cached
+// shadow cascades hold them
+#define NUM_STATIC_TORI 8
+
+// Towards the sun
+#define SUN_DIRECTION vec3(0.3f, 0.8f, 0.5f)
+
+// A fountain among the static tori, holding around 750k particles at
+// once, within the million the system has room for
+#define MAX_PARTICLES (1 << 20)
+#define FOUNTAIN_RATE 250000.0f
+
+struct Spinner
+{
+    float x;
+    float rate;
+    float angle;
+};
 
 class TonicGame : public Game
 {
 private:
     OpenGL *gl;
-    unsigned int VBO, VAO;
+    GpuResources *resources;
     float timeValue = 0.0f;
-    Shader *shader;
+    float cameraYaw = 0.0f, cameraPitch = 0.0f;
+    ShaderHandle shader;
+    ShaderHandle modelShader;
+    ShaderHandle shadowShader;
+    ShaderHandle instancedShadowShader;
+    Mesh *triangle;
+    MeshHandle torus;
+    std::vector<int> torusLods; // per submesh, kept for hysteresis
+    mat4 staticTori[NUM_STATIC_TORI];
+    std::vector<int> staticLods; // per static torus and submesh
+    InstanceRenderer *instancer;
+    UniformRing *uniforms;
+    RenderGraph *graph;
+    GpuTimer *gpuTimer;
+    PostProcessStack *post;
+    DynamicResolution resolution;
+    ClusteredLighting *lighting;
+    CascadedShadows *shadows;
+    ParticleSystem *particles;
+    ParticleEmitter fountain;
+    InstanceData instances[NUM_TRIANGLES];
+    Query<Spinner> *spinners;
 
 public:
     TonicGame(OpenGL *gl)
@@ -20,12 +94,40 @@ public:
         this->gl = gl;
     }
 
+    // Called by the platform while the GL context is still current, before
+    // it deletes the asset cache and the world
+    ~TonicGame()
+    {
+        delete spinners;
+        delete particles;
+        delete shadows;
+        delete lighting;
+        delete post;
+        delete gpuTimer;
+        delete graph;
+        delete uniforms;
+        delete instancer;
+        delete triangle;
+
+        // Cached shaders and meshes free their GL objects through
+        // 'resources', so they have to go before it does
+        shader.reset();
+        modelShader.reset();
+        shadowShader.reset();
+        instancedShadowShader.reset();
+        torus.reset();
+        assets->purge();
+        delete resources;
+    }
+
     void Setup()
     {
-        std::string vertShader = platform->ReadFileToString("/share/tonic/shaders/basic.vert");
-        std::string fragShader = platform->ReadFileToString("/share/tonic/shaders/basic.frag");
-        
-        shader = new Shader(platform, gl, vertShader, fragShader);
+        resources = new GpuResources(gl);
+        RegisterRendererAssets(assets, platform, gl, resources);
+        shader = LoadShader(assets, "/share/tonic/shaders/instanced.vert", "/share/tonic/shaders/basic.frag");
+        modelShader = LoadShader(assets, "/share/tonic/shaders/model.vert", "/share/tonic/shaders/lit.frag");
+        shadowShader = LoadShader(assets, "/share/tonic/shaders/shadow.vert", "/share/tonic/shaders/shadow.frag");
+        instancedShadowShader = LoadShader(assets, "/share/tonic/shaders/instanced.vert", "/share/tonic/shaders/shadow.frag");
 
         // set up vertex data (and buffer(s)) and configure vertex attributes
         // ------------------------------------------------------------------
@@ -37,43 +139,238 @@ public:
             0.0f,  0.5f, 0.0f,  0.0f, 0.0f, 1.0f    // top 
         };
 
-        gl->glGenVertexArrays(1, &VAO);
-        gl->glGenBuffers(1, &VBO);
-        // bind the Vertex Array Object first, then bind and set vertex buffer(s), and then configure vertex attributes(s).
-        gl->glBindVertexArray(VAO);
+        triangle = new Mesh(gl, vertices, 3);
+        instancer = new InstanceRenderer(gl, NUM_TRIANGLES);
+        torus = LoadMesh(assets, "/share/tonic/models/torus.tmesh");
+        torusLods.assign(torus ? torus->getSubmeshCount() : 0, 0);
+        staticLods.assign(torus ? NUM_STATIC_TORI * torus->getSubmeshCount() : 0, 0);
+        uniforms = new UniformRing(platform, gl, 64 * 1024);
+        graph = new RenderGraph(platform, gl, resources);
+        gpuTimer = new GpuTimer(gl, resources, profiler);
+        post = new PostProcessStack(gl, resources, assets, gpuTimer);
+        lighting = new ClusteredLighting(platform, gl, resources, NUM_LIGHTS);
+        shadows = new CascadedShadows(platform, gl, resources, gpuTimer);
+        particles = new ParticleSystem(platform, gl, resources, MAX_PARTICLES);
 
-        gl->glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        gl->glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-        
-        // position attribute
-        gl->glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-        gl->glEnableVertexAttribArray(0);
-        // color attribute
-        gl->glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3* sizeof(float)));
-        gl->glEnableVertexAttribArray(1);
-
-        // note that this is allowed, the call to glVertexAttribPointer registered VBO as the vertex attribute's bound vertex buffer object so afterwards we can safely unbind
-        gl->glBindBuffer(GL_ARRAY_BUFFER, 0); 
-
-        // You can unbind the VAO afterwards so other VAO calls won't accidentally modify this VAO, but this rarely happens. Modifying other
-        // VAOs requires a call to glBindVertexArray anyways so we generally don't unbind VAOs (nor VBOs) when it's not directly necessary.
-        gl->glBindVertexArray(0);
+        fountain.position = vec3(0.0f, -1.5f, -10.0f);
+        fountain.radius = 0.1f;
+        fountain.velocity = vec3(0.0f, 6.0f, 0.0f);
+        fountain.spread = 1.5f;
+        fountain.color = vec4(1.0f, 0.6f, 0.25f, 0.05f);
+        fountain.minLifetime = 2.0f;
+        fountain.maxLifetime = 4.0f;
+        fountain.rate = FOUNTAIN_RATE;
+
+        // Lying flat below the torus's path, alternating sides
+        for (int i = 0; i < NUM_STATIC_TORI; i++)
+            staticTori[i] = composeTransform(vec3(i % 2 ? 2.0f : -2.0f, -1.5f, -5.0f * i),
+                                             quat::axisAngle(vec3(1.0f, 0.0f, 0.0f), 1.5707963f),
+                                             vec3(1.0f));
+
+        // Lay the triangles out in a row, each spinning at its own rate
+        for (int i = 0; i < NUM_TRIANGLES; i++)
+            world->create(Spinner{-0.8f + 1.6f * i / (NUM_TRIANGLES - 1), 0.5f + 0.25f * i, 0.0f});
+
+        spinners = new Query<Spinner>(world);
+    }
+
+    // The tori, at the LODs the view last picked
+    void drawTorus(const mat4 &transform, const vec4 *colors, const int *lods)
+    {
+        for (int i = 0; i < torus->getSubmeshCount(); i++)
+        {
+            DrawUniforms draw;
+            draw.transform = transform * torus->getDequantizeMatrix();
+            draw.color = colors ? colors[i % 2] : vec4(1.0f);
+            uniforms->bind(UNIFORM_BINDING_DRAW, uniforms->push(draw));
+            torus->drawSubmesh(i, lods[i]);
+        }
+    }
+
+    // Depth only, into a shadow cascade
+    void drawCasters(int triangleCount, const mat4 &torusTransform, bool dynamic)
+    {
+        if (torus && shadowShader)
+        {
+            gl->glUseProgram(shadowShader->shaderId);
+            for (int i = 0; i < NUM_STATIC_TORI; i++)
+                drawTorus(staticTori[i], nullptr, &staticLods[i * torus->getSubmeshCount()]);
+            if (dynamic)
+                drawTorus(torusTransform, nullptr, torusLods.data());
+        }
+
+        if (dynamic && instancedShadowShader)
+        {
+            gl->glUseProgram(instancedShadowShader->shaderId);
+            instancer->draw(triangle, instances, triangleCount);
+        }
+    }
+
+    // The spinning triangles, the torus behind them, and the static tori
+    void drawScene(int triangleCount, const mat4 &torusTransform, const LodView &lodView)
+    {
+        glEnable(GL_DEPTH_TEST);
+
+        if (shader)
+        {
+            gl->glUseProgram(shader->shaderId);
+            instancer->draw(triangle, instances, triangleCount);
+        }
+
+        if (!torus || !modelShader)
+            return;
+
+        // One colour per submesh
+        const vec4 torusColors[] = { vec4(0.9f, 0.5f, 0.2f, 1.0f), vec4(0.3f, 0.6f, 0.9f, 1.0f) };
+
+        const vec4 staticColors[] = { vec4(0.6f, 0.6f, 0.6f, 1.0f), vec4(0.4f, 0.4f, 0.45f, 1.0f) };
+        int submeshes = torus->getSubmeshCount();
+
+        gl->glUseProgram(modelShader->shaderId);
+        for (int i = 0; i < submeshes; i++)
+            torusLods[i] = SelectLod(torus.get(), i, torusTransform, lodView, torusLods[i], LOD_ERROR_PIXELS);
+        drawTorus(torusTransform, torusColors, torusLods.data());
+
+        for (int t = 0; t < NUM_STATIC_TORI; t++)
+        {
+            int *lods = &staticLods[t * submeshes];
+            for (int i = 0; i < submeshes; i++)
+                lods[i] = SelectLod(torus.get(), i, staticTori[t], lodView, lods[i], LOD_ERROR_PIXELS);
+            drawTorus(staticTori[t], staticColors, lods);
+        }
     }
 
     void Frame(float deltaTime)
     {
-        glClearColor(0.0, 17.0f/256, 43.0f/256, 1.0);
-        glClear(GL_COLOR_BUFFER_BIT);
+        timeValue += deltaTime;
+
+        uniforms->beginFrame();
+        gpuTimer->beginFrame();
+        gpuTimer->begin("gpu frame");
+
+        // Leave some of the display's refresh for the compositor, once
+        // the platform has said what it is
+        float refreshMs = profiler->getPresentStats().refreshMs;
+        if (refreshMs > 0.0f && resolution.getConfig().targetMs != refreshMs * 0.85f)
+        {
+            DynamicResolutionConfig config = resolution.getConfig();
+            config.targetMs = refreshMs * 0.85f;
+            resolution.setConfig(config);
+        }
+
+        // The window may have been resized since the last frame
+        int windowWidth, windowHeight;
+        platform->GetWindowSize(&windowWidth, &windowHeight);
+        float aspect = (float)windowWidth / windowHeight;
+
+        const ProfileStat *gpuFrame = gpuTimer->get("gpu frame");
+        resolution.update(gpuFrame ? gpuFrame->last : 0.0f);
+        int sceneWidth = resolution.apply(windowWidth);
+        int sceneHeight = resolution.apply(windowHeight);
+
+        // Shared blocks, bound once for every draw this frame
+        FrameUniforms frame;
+        frame.time = timeValue;
+        frame.deltaTime = deltaTime;
+        frame.resolution = vec2((float)sceneWidth, (float)sceneHeight);
+        uniforms->bind(UNIFORM_BINDING_FRAME, uniforms->push(frame));
+
+        // Orbit the scene with the arrow keys or the first gamepad's
+        // left stick
+        float turnX = input->getGamepadAxis(0, INPUT_PAD_LEFT_X);
+        float turnY = input->getGamepadAxis(0, INPUT_PAD_LEFT_Y);
+        turnX += (input->isKeyDown(INPUT_KEY_RIGHT) ? 1.0f : 0.0f) - (input->isKeyDown(INPUT_KEY_LEFT) ? 1.0f : 0.0f);
+        turnY += (input->isKeyDown(INPUT_KEY_DOWN) ? 1.0f : 0.0f) - (input->isKeyDown(INPUT_KEY_UP) ? 1.0f : 0.0f);
+        cameraYaw += turnX * CAMERA_ORBIT_SPEED * deltaTime;
+        cameraPitch = fminf(fmaxf(cameraPitch - turnY * CAMERA_ORBIT_SPEED * deltaTime, -1.2f), 1.2f);
+
+        CameraUniforms camera;
+        vec3 eye = vec3(sinf(cameraYaw) * cosf(cameraPitch), sinf(cameraPitch), cosf(cameraYaw) * cosf(cameraPitch)) * CAMERA_DISTANCE;
+        camera.view = mat4::lookAt(eye, vec3(0.0f), vec3(0.0f, 1.0f, 0.0f));
+        camera.projection = mat4::perspective(CAMERA_FOV, aspect, CAMERA_NEAR, CAMERA_FAR);
+        camera.viewProjection = camera.projection * camera.view;
+        camera.position = vec4(eye, 1.0f);
+        UniformAllocation cameraBlock = uniforms->push(camera);
+        uniforms->bind(UNIFORM_BINDING_CAMERA, cameraBlock);
+
+        int count = 0;
+        spinners->forEach([&](Spinner &spinner) {
+            spinner.angle += spinner.rate * deltaTime;
+
+            InstanceData &instance = instances[count];
+            instance.transform = composeTransform(vec3(spinner.x, 0.0f, 0.0f),
+                                                  quat::axisAngle(vec3(0.0f, 0.0f, 1.0f), spinner.angle),
+                                                  vec3(0.3f));
+
+            float brightness = 0.6f + 0.4f * sinf(timeValue + count);
+            instance.color = vec4(vec3(brightness), 1.0f);
+            count++;
+        });
+
+        // Torus tumbling behind the triangles, drifting away and back so
+        // its LODs switch over
+        float torusDepth = -2.0f - 38.0f * (0.5f - 0.5f * cosf(timeValue * 0.3f));
+        mat4 torusTransform = composeTransform(vec3(0.0f, 0.0f, torusDepth),
+                                               quat::axisAngle(normalize(vec3(1.0f, 1.0f, 0.0f)), timeValue * 0.4f),
+                                               vec3(1.0f));
+        LodView lodView = MakeLodView(eye, CAMERA_FOV, sceneHeight);
+
+        lighting->clear();
+        for (int i = 0; i < NUM_LIGHTS; i++)
+        {
+            float angle = timeValue * 0.7f + i * (6.2831853f / NUM_LIGHTS);
+            float height = 0.6f * sinf(timeValue * 1.3f + i);
+
+            Light light;
+            light.position = vec3(cosf(angle) * 1.6f, height, torusDepth + sinf(angle) * 1.6f);
+            light.range = 2.5f;
+            light.color = vec3(0.5f + 0.5f * cosf(i * 2.1f), 0.5f + 0.5f * cosf(i * 2.1f + 2.1f), 0.5f + 0.5f * cosf(i * 2.1f + 4.2f));
+            light.intensity = 2.0f;
+            lighting->add(light);
+        }
+        lighting->update(uniforms, camera.view, CAMERA_FOV, aspect, CAMERA_NEAR, CAMERA_FAR);
+
+        // Shadow casters use the LODs the view picked last frame
+        shadows->update(camera.view, CAMERA_FOV, aspect, CAMERA_NEAR, SUN_DIRECTION);
+        shadows->render(uniforms, [&](int, bool dynamic) {
+            drawCasters(count, torusTransform, dynamic);
+        });
+        shadows->bind(uniforms);
+        uniforms->bind(UNIFORM_BINDING_CAMERA, cameraBlock);
+
+        {
+            GpuScope scope(gpuTimer, "gpu particles");
+            particles->emit(fountain, deltaTime);
+            particles->update(uniforms, deltaTime);
+        }
+
+        graph->reset();
+        RenderResource backbuffer = graph->importBackbuffer("backbuffer", windowWidth, windowHeight);
+        RenderResource sceneColor;
+
+        graph->addPass("scene",
+            [&](RenderPassBuilder &builder) {
+                sceneColor = builder.write(builder.create("scene color", RenderTargetDesc{ sceneWidth, sceneHeight, RENDER_FORMAT_RGBA16F }), RENDER_LOAD_CLEAR);
+                builder.write(builder.create("scene depth", RenderTargetDesc{ sceneWidth, sceneHeight, RENDER_FORMAT_DEPTH24 }), RENDER_LOAD_CLEAR);
+                builder.setClearColor(vec4(0.0f, 17.0f / 256, 43.0f / 256, 1.0f));
+            },
+            [&](RenderPassContext &) {
+                drawScene(count, torusTransform, lodView);
+                particles->draw();
+            });
 
-        gl->glUseProgram(shader->shaderId);
+        // The scene is drawn at the dynamic resolution; the first post
+        // effect, or the final blit, filters it up to the window
+        post->addPasses(graph, sceneColor, backbuffer);
+        graph->execute();
+        gpuTimer->end("gpu frame");
 
-        gl->glBindVertexArray(VAO); // seeing as we only have a single VAO there's no need to bind it every time, but we'll do so to keep things a bit more organized
-        glDrawArrays(GL_TRIANGLES, 0, 3);
-        // glBindVertexArray(0); // no need to unbind it every time 
+        uniforms->endFrame();
+        resources->endFrame();
     }
 };
 
 Game *Initialize(OpenGL *gl)
 {
     return new TonicGame(gl);
-}
\ No newline at end of file
+}
@@ -0,0 +1,53 @@
+#include "assets.h"
+
+// Between the two stages' paths in a shader's cache key
+#define SHADER_PATH_SEPARATOR '|'
+
+void RegisterRendererAssets(AssetCache *cache, Platform *platform, OpenGL *gl, GpuResources *resources)
+{
+    cache->setLoader(ASSET_SHADER,
+        [platform, gl, resources](const std::string &path, size_t &bytes) -> void * {
+            size_t separator = path.find(SHADER_PATH_SEPARATOR);
+            if (separator == std::string::npos)
+            {
+                platform->Log("Error: '%s' does not name a vertex and a fragment shader\n", path.c_str());
+                return nullptr;
+            }
+
+            std::string vertexData = platform->ReadFileToString(path.substr(0, separator));
+            std::string fragmentData = platform->ReadFileToString(path.substr(separator + 1));
+            Shader *shader = new Shader(platform, gl, resources, vertexData, fragmentData);
+            if (!shader->isLinked())
+            {
+                delete shader;
+                return nullptr;
+            }
+
+            // The driver's copy is out of sight; its binary is the best
+            // estimate going
+            GLint length = 0;
+            gl->glGetProgramiv(shader->shaderId, GL_PROGRAM_BINARY_LENGTH, &length);
+            bytes = (size_t)length;
+            return shader;
+        },
+        [](void *asset) { delete (Shader *)asset; });
+
+    cache->setLoader(ASSET_MESH,
+        [platform, gl, resources](const std::string &path, size_t &bytes) -> void * {
+            MeshAsset *mesh = new MeshAsset(platform, gl, resources, path);
+            if (!mesh->isLoaded())
+            {
+                delete mesh;
+                return nullptr;
+            }
+
+            bytes = mesh->getGpuBytes();
+            return mesh;
+        },
+        [](void *asset) { delete (MeshAsset *)asset; });
+}
+
+ShaderHandle LoadShader(AssetCache *cache, const std::string &vertexPath, const std::string &fragmentPath)
+{
+    return ShaderHandle(cache, vertexPath + SHADER_PATH_SEPARATOR + fragmentPath);
+}
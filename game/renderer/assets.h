@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../../engine/assets/asset-cache.h"
+#include "../../engine/opengl.h"
+#include "../../engine/platform.h"
+#include "gpu-resources.h"
+#include "shader.h"
+#include "mesh-asset.h"
+
+#include <string>
+
+typedef AssetHandle<Shader, ASSET_SHADER> ShaderHandle;
+typedef AssetHandle<MeshAsset, ASSET_MESH> MeshHandle;
+
+// Registers the shader and mesh loaders with the cache. Their GL objects
+// come from 'resources', so evicting one never stalls on the GPU; the
+// cache must still go before the context and 'resources' do.
+//
+// Textures have no loader yet; acquiring one fails with an error.
+void RegisterRendererAssets(AssetCache *cache, Platform *platform, OpenGL *gl, GpuResources *resources);
+
+// A program built from a vertex and a fragment shader, cached under both
+// paths together, so programs sharing a stage are still told apart
+ShaderHandle LoadShader(AssetCache *cache, const std::string &vertexPath, const std::string &fragmentPath);
+
+inline MeshHandle LoadMesh(AssetCache *cache, const std::string &path)
+{
+    return MeshHandle(cache, path);
+}
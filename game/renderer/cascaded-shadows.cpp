@@ -0,0 +1,204 @@
+#include "cascaded-shadows.h"
+
+#include <math.h>
+
+static const char *timerNames[SHADOW_CASCADES] = {
+    "gpu shadow cascade 0", "gpu shadow cascade 1", "gpu shadow cascade 2", "gpu shadow cascade 3"
+};
+
+// Radii are rounded up to this, so float noise in the fit never changes
+// a cascade's size
+#define SHADOW_RADIUS_STEP (1.0f / 16.0f)
+
+static float RoundRadius(float radius)
+{
+    return ceilf(radius / SHADOW_RADIUS_STEP) * SHADOW_RADIUS_STEP;
+}
+
+CascadedShadows::CascadedShadows(Platform *platform, OpenGL *gl, GpuResources *resources, GpuTimer *timer, int mapSize)
+{
+    this->gl = gl;
+    this->resources = resources;
+    this->timer = timer;
+    this->mapSize = mapSize;
+
+    for (Cascade &cascade : cascades)
+    {
+        cascade.valid = false;
+        cascade.dirty = false;
+    }
+
+    texture = resources->createTexture();
+    glBindTexture(GL_TEXTURE_2D_ARRAY, resources->get(texture));
+    gl->glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_DEPTH_COMPONENT32F, mapSize, mapSize, SHADOW_CASCADES);
+
+    // Linear filtering with comparison gives 2x2 PCF for free
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    for (int i = 0; i < SHADOW_CASCADES; i++)
+    {
+        framebuffers[i] = resources->createFramebuffer();
+        gl->glBindFramebuffer(GL_FRAMEBUFFER, resources->get(framebuffers[i]));
+        gl->glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, resources->get(texture), 0, i);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+
+        GLenum status = gl->glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        if (status != GL_FRAMEBUFFER_COMPLETE)
+            platform->Log("Error: Framebuffer for shadow cascade %d is incomplete (0x%x)\n", i, status);
+    }
+    gl->glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+CascadedShadows::~CascadedShadows()
+{
+    for (FramebufferHandle &framebuffer : framebuffers)
+        resources->destroy(framebuffer);
+    resources->destroy(texture);
+}
+
+void CascadedShadows::invalidateStatic()
+{
+    for (int i = SHADOW_CACHED_FROM; i < SHADOW_CASCADES; i++)
+        cascades[i].valid = false;
+}
+
+// Centres an orthographic projection on a light space sphere, moved to
+// the nearest whole texel
+void CascadedShadows::fit(Cascade &cascade, const vec3 &center, float radius)
+{
+    float texel = 2.0f * radius / mapSize;
+    cascade.center = vec3(floorf(center.x / texel) * texel, floorf(center.y / texel) * texel, center.z);
+    cascade.radius = radius;
+
+    // The light looks down -z, so casters nearer the light have larger z
+    const vec3 &c = cascade.center;
+    mat4 projection = mat4::ortho(c.x - radius, c.x + radius, c.y - radius, c.y + radius,
+                                  -(c.z + radius + SHADOW_CASTER_REACH), -(c.z - radius));
+    cascade.viewProjection = projection * lightView;
+    cascade.valid = true;
+    cascade.dirty = true;
+}
+
+void CascadedShadows::update(const mat4 &view, float fovY, float aspect, float zNear, const vec3 &lightDirection)
+{
+    vec3 toLight = normalize(lightDirection);
+    if (dot(toLight, direction) < 0.99999f)
+    {
+        direction = toLight;
+        vec3 up = fabsf(toLight.y) > 0.99f ? vec3(0.0f, 0.0f, 1.0f) : vec3(0.0f, 1.0f, 0.0f);
+        lightView = mat4::lookAt(vec3(0.0f), -toLight, up);
+
+        for (Cascade &cascade : cascades)
+            cascade.valid = false;
+    }
+
+    viewToWorld = inverseAffine(view);
+    float tanY = tanf(fovY * 0.5f);
+    float tanX = tanY * aspect;
+
+    float sliceNear = zNear;
+    for (int i = 0; i < SHADOW_CASCADES; i++)
+    {
+        Cascade &cascade = cascades[i];
+        cascade.dirty = false;
+
+        float t = (float)(i + 1) / SHADOW_CASCADES;
+        float even = zNear + (distance - zNear) * t;
+        float logarithmic = zNear * powf(distance / zNear, t);
+        float sliceFar = even + (logarithmic - even) * SHADOW_SPLIT_LAMBDA;
+        cascade.split = sliceFar;
+
+        // The slice's centroid is on the view axis, and its far corners
+        // are the furthest from it, so the sphere depends only on the
+        // slice's depths and not on which way the camera faces
+        float halfDepth = 0.5f * (sliceFar - sliceNear);
+        float radius = RoundRadius(sqrtf((tanX * tanX + tanY * tanY) * sliceFar * sliceFar + halfDepth * halfDepth));
+        vec3 center = transformPoint(lightView, transformPoint(viewToWorld, vec3(0.0f, 0.0f, -(sliceNear + halfDepth))));
+        sliceNear = sliceFar;
+
+        if (i < SHADOW_CACHED_FROM)
+        {
+            fit(cascade, center, radius);
+            continue;
+        }
+
+        // Still inside what was drawn last time?
+        if (cascade.valid && fabsf(center.x - cascade.center.x) + radius <= cascade.radius &&
+            fabsf(center.y - cascade.center.y) + radius <= cascade.radius &&
+            fabsf(center.z - cascade.center.z) + radius <= cascade.radius)
+            continue;
+
+        fit(cascade, center, RoundRadius(radius * (1.0f + SHADOW_CACHE_MARGIN)));
+    }
+}
+
+void CascadedShadows::render(UniformRing *uniforms, ShadowDrawFunc draw)
+{
+    drawn = 0;
+
+    glEnable(GL_DEPTH_TEST);
+    glDepthMask(GL_TRUE);
+    glViewport(0, 0, mapSize, mapSize);
+
+    // Slope scaled bias keeps surfaces facing away from the light from
+    // shadowing themselves
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(2.0f, 4.0f);
+
+    for (int i = 0; i < SHADOW_CASCADES; i++)
+    {
+        Cascade &cascade = cascades[i];
+        if (!cascade.dirty)
+            continue;
+
+        GpuScope scope(timer, timerNames[i]);
+
+        float depth = 1.0f;
+        gl->glBindFramebuffer(GL_FRAMEBUFFER, resources->get(framebuffers[i]));
+        gl->glClearBufferfv(GL_DEPTH, 0, &depth);
+
+        CameraUniforms camera;
+        camera.view = lightView;
+        camera.projection = cascade.viewProjection * inverseAffine(lightView);
+        camera.viewProjection = cascade.viewProjection;
+        camera.position = vec4(direction, 0.0f);
+        uniforms->bind(UNIFORM_BINDING_CAMERA, uniforms->push(camera));
+
+        draw(i, i < SHADOW_CACHED_FROM);
+        cascade.dirty = false;
+        drawn++;
+    }
+
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    gl->glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void CascadedShadows::bind(UniformRing *uniforms)
+{
+    // Maps clip space to texture coordinates and depth
+    mat4 bias = mat4::translate(vec3(0.5f)) * mat4::scale(vec3(0.5f));
+
+    DirectionalLightUniforms light;
+    light.direction = vec4(direction, 0.0f);
+    light.color = vec4(color, 0.0f);
+    light.shadow = vec4(0.0005f, 1.5f, 1.0f / mapSize, (float)SHADOW_CASCADES);
+    for (int i = 0; i < SHADOW_CASCADES; i++)
+    {
+        const Cascade &cascade = cascades[i];
+        (&light.splits.x)[i] = cascade.split;
+        (&light.texelSizes.x)[i] = 2.0f * cascade.radius / mapSize;
+        light.cascades[i] = bias * cascade.viewProjection * viewToWorld;
+    }
+    uniforms->bind(UNIFORM_BINDING_DIRECTIONAL_LIGHT, uniforms->push(light));
+
+    gl->glActiveTexture(GL_TEXTURE0 + SHADOW_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, resources->get(texture));
+    gl->glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "../../engine/opengl.h"
+#include "../../engine/platform.h"
+#include "../../engine/math/mat.h"
+
+#include "gpu-resources.h"
+#include "gpu-timer.h"
+#include "uniform-ring.h"
+#include "uniforms.h"
+
+#include <functional>
+
+#define SHADOW_MAP_SIZE 2048
+
+// Where the cascades split the view, between evenly spaced (0) and
+// logarithmic (1), which gives each cascade the same resolution per
+// unit of depth it covers
+#define SHADOW_SPLIT_LAMBDA 0.75f
+
+// Cascades from this one on hold only static casters, and keep their
+// contents from frame to frame until they no longer cover the view
+#define SHADOW_CACHED_FROM 2
+
+// How much further than needed a cached cascade reaches, as a fraction
+// of what it has to cover, so the camera can move a way before it is
+// redrawn
+#define SHADOW_CACHE_MARGIN 0.25f
+
+// Casters this far towards the light beyond what a cascade covers still
+// land in it
+#define SHADOW_CASTER_REACH 50.0f
+
+// lit.frag samples the shadow map here
+#define SHADOW_TEXTURE_UNIT 2
+
+// Draws the casters for one cascade, with the Camera block bound to the
+// cascade's light view. Static casters always; moving ones only if
+// 'dynamic', as the cached cascades must not hold them.
+typedef std::function<void(int cascade, bool dynamic)> ShadowDrawFunc;
+
+// Shadows from one directional light, in SHADOW_CASCADES cascades that
+// each cover a stretch of the view's depth, rendered into the layers of
+// one depth texture array.
+//
+// Each cascade is fitted to the bounding sphere of its slice of the view
+// frustum rather than to the slice itself, so its size does not change
+// as the camera turns, and is moved only in whole texels, so the shadow
+// edges stay put instead of shimmering as the camera moves.
+//
+// The far cascades are cached: they are drawn once, with static casters
+// only, and redrawn when the light turns, the view leaves the area they
+// cover, or invalidateStatic() says the static casters changed. Each
+// cascade drawn is timed on the GPU as "gpu shadow cascade N".
+class CascadedShadows
+{
+private:
+    OpenGL *gl;
+    GpuResources *resources;
+    GpuTimer *timer;
+
+    TextureHandle texture;
+    FramebufferHandle framebuffers[SHADOW_CASCADES];
+    int mapSize;
+
+    struct Cascade
+    {
+        mat4 viewProjection; // world to the light's clip space
+        vec3 center;         // in light space, snapped to texels
+        float radius;
+        float split;         // view depth where the cascade ends
+        bool valid;          // holds a usable rendering
+        bool dirty;          // to be drawn this frame
+    };
+    Cascade cascades[SHADOW_CASCADES];
+
+    vec3 direction = vec3(0.0f);
+    mat4 lightView;
+    mat4 viewToWorld;
+    int drawn = 0;
+
+    void fit(Cascade &cascade, const vec3 &center, float radius);
+
+public:
+    vec3 color = vec3(0.8f);
+    float distance = 40.0f; // shadows end this far from the camera
+
+    CascadedShadows(Platform *platform, OpenGL *gl, GpuResources *resources, GpuTimer *timer, int mapSize = SHADOW_MAP_SIZE);
+    ~CascadedShadows();
+
+    // The static casters moved; redraw the cached cascades
+    void invalidateStatic();
+
+    // Fits the cascades to a perspective view, for a light shining from
+    // 'lightDirection' (towards the light), and works out which to draw
+    void update(const mat4 &view, float fovY, float aspect, float zNear, const vec3 &lightDirection);
+
+    // Draws the cascades that need it. Leaves the Camera block bound to
+    // the last one's; bind the view's camera again afterwards.
+    void render(UniformRing *uniforms, ShadowDrawFunc draw);
+
+    // Binds the DirectionalLight block and the shadow map for lit draws
+    void bind(UniformRing *uniforms);
+
+    // Cascades drawn by the last render(), cached ones included
+    int getDrawnCascades() const { return drawn; }
+};
@@ -0,0 +1,108 @@
+#include "clustered-lighting.h"
+#include "uniforms.h"
+
+#include <math.h>
+
+ClusteredLighting::ClusteredLighting(Platform *platform, OpenGL *gl, GpuResources *resources, int maxLights)
+{
+    this->gl = gl;
+    this->resources = resources;
+    this->capacity = maxLights;
+    this->indexCapacity = CLUSTER_COUNT * CLUSTER_AVERAGE_LIGHTS;
+
+    cullShader = new Shader(platform, gl, resources, platform->ReadFileToString("/share/tonic/shaders/cluster-lights.comp"));
+
+    lights.reserve(maxLights);
+    lightData.resize(maxLights);
+
+    // Only the lights and the counter are written from the CPU; the grid
+    // and index lists never leave the GPU
+    lightBuffer = resources->createBuffer();
+    gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, resources->get(lightBuffer));
+    gl->glBufferStorage(GL_SHADER_STORAGE_BUFFER, maxLights * sizeof(LightData), NULL, GL_DYNAMIC_STORAGE_BIT);
+
+    gridBuffer = resources->createBuffer();
+    gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, resources->get(gridBuffer));
+    gl->glBufferStorage(GL_SHADER_STORAGE_BUFFER, CLUSTER_COUNT * 2 * sizeof(unsigned int), NULL, 0);
+
+    indexBuffer = resources->createBuffer();
+    gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, resources->get(indexBuffer));
+    gl->glBufferStorage(GL_SHADER_STORAGE_BUFFER, indexCapacity * sizeof(unsigned int), NULL, 0);
+
+    counterBuffer = resources->createBuffer();
+    gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, resources->get(counterBuffer));
+    gl->glBufferStorage(GL_SHADER_STORAGE_BUFFER, 2 * sizeof(unsigned int), NULL, GL_DYNAMIC_STORAGE_BIT);
+    gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+ClusteredLighting::~ClusteredLighting()
+{
+    delete cullShader;
+    resources->destroy(lightBuffer);
+    resources->destroy(gridBuffer);
+    resources->destroy(indexBuffer);
+    resources->destroy(counterBuffer);
+}
+
+void ClusteredLighting::add(const Light &light)
+{
+    if ((int)lights.size() < capacity)
+        lights.push_back(light);
+}
+
+void ClusteredLighting::update(UniformRing *uniforms, const mat4 &view, float fovY, float aspect, float zNear, float zFar)
+{
+    int count = (int)lights.size();
+    for (int i = 0; i < count; i++)
+    {
+        const Light &light = lights[i];
+        LightData &data = lightData[i];
+
+        data.positionRange = vec4(transformPoint(view, light.position), light.range);
+        if (light.type == LIGHT_SPOT)
+        {
+            data.colorInner = vec4(light.color * light.intensity, cosf(light.innerAngle));
+            data.directionOuter = vec4(normalize(transformVector(view, light.direction)), cosf(light.outerAngle));
+        }
+        else
+        {
+            // Every direction is past a cone this wide, so it lights all round
+            data.colorInner = vec4(light.color * light.intensity, -1.0f);
+            data.directionOuter = vec4(0.0f, 0.0f, -1.0f, -2.0f);
+        }
+    }
+
+    if (count > 0)
+    {
+        gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, resources->get(lightBuffer));
+        gl->glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, count * sizeof(LightData), lightData.data());
+    }
+
+    unsigned int counter[2] = { 0, indexCapacity }; // used so far, capacity
+    gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, resources->get(counterBuffer));
+    gl->glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(counter), counter);
+    gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    // Slices split [near, far] geometrically: slice k starts at
+    // near * (far / near)^(k / CLUSTER_Z)
+    float logRatio = logf(zFar / zNear);
+    float tanY = tanf(fovY * 0.5f);
+
+    LightingUniforms lighting;
+    lighting.clusters = vec4((float)CLUSTER_X, (float)CLUSTER_Y, (float)CLUSTER_Z, (float)count);
+    lighting.frustum = vec4(tanY * aspect, tanY, zNear, zFar);
+    lighting.slicing = vec4(CLUSTER_Z / logRatio, -CLUSTER_Z * logf(zNear) / logRatio, 0.0f, 0.0f);
+    lighting.ambient = vec4(ambient, 0.0f);
+    uniforms->bind(UNIFORM_BINDING_LIGHTING, uniforms->push(lighting));
+
+    gl->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_STORAGE_LIGHTS, resources->get(lightBuffer));
+    gl->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_STORAGE_GRID, resources->get(gridBuffer));
+    gl->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_STORAGE_INDICES, resources->get(indexBuffer));
+    gl->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_STORAGE_COUNTER, resources->get(counterBuffer));
+
+    gl->glUseProgram(cullShader->shaderId);
+    gl->glDispatchCompute(CLUSTER_X, CLUSTER_Y, CLUSTER_Z);
+
+    // Fragment shaders read the lists next
+    gl->glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "../../engine/opengl.h"
+#include "../../engine/platform.h"
+#include "../../engine/math/mat.h"
+
+#include "gpu-resources.h"
+#include "shader.h"
+#include "uniform-ring.h"
+
+#include <vector>
+
+// The view frustum is split into a grid of clusters: tiles across the
+// screen, and slices in depth that grow exponentially, so clusters stay
+// roughly cube shaped from near to far
+#define CLUSTER_X 16
+#define CLUSTER_Y 9
+#define CLUSTER_Z 24
+#define CLUSTER_COUNT (CLUSTER_X * CLUSTER_Y * CLUSTER_Z)
+
+// Lights a single cluster can list; any more that touch it are dropped.
+// Matches MAX_CLUSTER_LIGHTS in cluster-lights.comp.
+#define CLUSTER_MAX_LIGHTS 256
+
+// Size of the index list all clusters share, as an average per cluster
+#define CLUSTER_AVERAGE_LIGHTS 64
+
+// Shader storage binding points read by cluster-lights.comp and lit.frag
+#define LIGHT_STORAGE_LIGHTS 5
+#define LIGHT_STORAGE_GRID 6
+#define LIGHT_STORAGE_INDICES 7
+#define LIGHT_STORAGE_COUNTER 8
+
+enum LightType
+{
+    LIGHT_POINT,
+    LIGHT_SPOT
+};
+
+// A light as the game describes it, in world space
+struct Light
+{
+    LightType type = LIGHT_POINT;
+    vec3 position = vec3(0.0f);
+    float range = 1.0f; // falls off to nothing at this distance
+    vec3 color = vec3(1.0f);
+    float intensity = 1.0f;
+
+    // Spot lights only: the direction they point and the half angles, in
+    // radians, of the fully lit cone and of its edge
+    vec3 direction = vec3(0.0f, 0.0f, -1.0f);
+    float innerAngle = 0.3f;
+    float outerAngle = 0.5f;
+};
+
+// struct Light in cluster-lights.comp and lit.frag, std430, view space
+struct alignas(16) LightData
+{
+    vec4 positionRange;  // w the range
+    vec4 colorInner;     // color times intensity; w cos of the inner angle
+    vec4 directionOuter; // w cos of the outer angle, below -1 for point lights
+};
+
+static_assert(sizeof(LightData) == 48, "LightData must match std430");
+
+// Clustered forward lighting. Each frame the lights are moved into view
+// space and uploaded, then a compute pass, one work group per cluster,
+// lists the lights whose spheres touch each cluster. Lit fragment shaders
+// find their cluster from their screen position and depth and loop over
+// just those lights, so the cost per pixel follows the lights nearby
+// rather than the lights in the scene.
+//
+// The lists are never read back: the grid and index buffers stay on the
+// GPU, bound for every lit draw after update().
+class ClusteredLighting
+{
+private:
+    OpenGL *gl;
+    GpuResources *resources;
+    Shader *cullShader;
+
+    BufferHandle lightBuffer, gridBuffer, indexBuffer, counterBuffer;
+    int capacity;
+    unsigned int indexCapacity;
+
+    std::vector<Light> lights;
+    std::vector<LightData> lightData;
+
+public:
+    vec3 ambient = vec3(0.05f);
+
+    ClusteredLighting(Platform *platform, OpenGL *gl, GpuResources *resources, int maxLights);
+    ~ClusteredLighting();
+
+    // The frame's lights. Past 'maxLights' they are ignored.
+    void clear() { lights.clear(); }
+    void add(const Light &light);
+    int getLightCount() const { return (int)lights.size(); }
+
+    // Uploads the lights, bins them into clusters for a perspective view
+    // with these parameters, and binds the Lighting block and the buffers
+    // lit shaders read. Call once a frame, before the lit draws.
+    void update(UniformRing *uniforms, const mat4 &view, float fovY, float aspect, float zNear, float zFar);
+};
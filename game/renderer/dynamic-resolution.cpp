@@ -0,0 +1,65 @@
+#include "dynamic-resolution.h"
+
+#include <math.h>
+
+// Slack for scales that are meant to be a multiple of the step but miss
+// it by rounding, so they do not drop a whole step
+#define STEP_EPSILON 1e-3f
+
+DynamicResolution::DynamicResolution(const DynamicResolutionConfig &config)
+{
+    setConfig(config);
+    scale = maxSteps * this->config.step;
+}
+
+float DynamicResolution::clampSteps(float steps) const
+{
+    return fminf(fmaxf(steps, minSteps), maxSteps);
+}
+
+void DynamicResolution::setConfig(const DynamicResolutionConfig &config)
+{
+    this->config = config;
+    if (this->config.step <= 0.0f)
+        this->config.step = 0.05f;
+
+    // The limits move onto the grid, inwards, but never past each other
+    // or down to nothing
+    float step = this->config.step;
+    maxSteps = fmaxf(floorf(this->config.maxScale / step + STEP_EPSILON), 1.0f);
+    minSteps = fminf(fmaxf(ceilf(this->config.minScale / step - STEP_EPSILON), 1.0f), maxSteps);
+    scale = clampSteps(roundf(scale / step)) * step;
+}
+
+void DynamicResolution::update(float gpuMs)
+{
+    if (settleFrames > 0)
+    {
+        settleFrames--;
+        return;
+    }
+    if (gpuMs <= 0.0f)
+        return;
+
+    // Counted in steps, so the scale stays exactly on the grid
+    float steps = roundf(scale / config.step);
+    float ideal = floorf(scale * sqrtf(config.targetMs / gpuMs) / config.step + STEP_EPSILON);
+    float next = steps;
+    if (gpuMs > config.targetMs)
+        next = ideal;
+    else if (gpuMs < config.targetMs * DYNAMIC_RESOLUTION_RAISE_BELOW)
+        next = fmaxf(steps, fminf(steps + 1.0f, ideal));
+
+    next = clampSteps(next);
+    if (next == steps)
+        return;
+
+    scale = next * config.step;
+    settleFrames = DYNAMIC_RESOLUTION_SETTLE_FRAMES;
+}
+
+int DynamicResolution::apply(int size) const
+{
+    int scaled = (int)(size * scale + 0.5f);
+    return scaled > 0 ? scaled : 1;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "gpu-timer.h"
+
+// Frames to wait after a change before judging it. GPU times arrive
+// GPU_TIMER_LATENCY frames late, so reacting sooner would keep correcting
+// for load that has already been dealt with.
+#define DYNAMIC_RESOLUTION_SETTLE_FRAMES (GPU_TIMER_LATENCY + 2)
+
+// GPU time, as a fraction of the target, under which resolution goes back
+// up. The gap to 1 keeps it from flipping between two steps.
+#define DYNAMIC_RESOLUTION_RAISE_BELOW 0.85f
+
+struct DynamicResolutionConfig
+{
+    float targetMs = 14.0f; // GPU time per frame to stay under
+    float minScale = 0.5f;  // of the output's width and height
+    float maxScale = 1.0f;
+
+    // Scales are multiples of this, and the limits are rounded inwards to
+    // one. Each new size means new render targets, so small steps would
+    // only churn the pool.
+    float step = 0.05f;
+};
+
+// Picks the resolution to render the scene at from how long the GPU took
+// over recent frames. Time spent filling pixels goes with their number,
+// the square of the scale, so the controller jumps straight down to the
+// scale that should fit a spike, but climbs back a step at a time.
+class DynamicResolution
+{
+private:
+    DynamicResolutionConfig config;
+    float scale = 1.0f;
+    int settleFrames = 0;
+
+    // The limits as multiples of the step
+    float minSteps, maxSteps;
+
+    float clampSteps(float steps) const;
+
+public:
+    explicit DynamicResolution(const DynamicResolutionConfig &config = DynamicResolutionConfig());
+
+    // Once a frame, with the latest GPU frame time; 0 if there is none yet
+    void update(float gpuMs);
+
+    void setConfig(const DynamicResolutionConfig &config);
+    const DynamicResolutionConfig &getConfig() const { return config; }
+
+    float getScale() const { return scale; }
+
+    // A dimension of the output at the current scale
+    int apply(int size) const;
+};
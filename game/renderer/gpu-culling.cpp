@@ -0,0 +1,193 @@
+#include "gpu-culling.h"
+
+#include "../../engine/math/geometry.h"
+
+#define CULL_GROUP_SIZE 64
+#define HIZ_GROUP_SIZE 8
+
+static unsigned int GroupCount(int size, int groupSize)
+{
+    return (size + groupSize - 1) / groupSize;
+}
+
+HiZPyramid::HiZPyramid(Platform *platform, OpenGL *gl, GpuResources *resources)
+{
+    this->gl = gl;
+    this->resources = resources;
+
+    copyShader = new Shader(platform, gl, resources, platform->ReadFileToString("/share/tonic/shaders/hiz-copy.comp"));
+    downsampleShader = new Shader(platform, gl, resources, platform->ReadFileToString("/share/tonic/shaders/hiz-downsample.comp"));
+}
+
+HiZPyramid::~HiZPyramid()
+{
+    delete copyShader;
+    delete downsampleShader;
+    resources->destroy(textureHandle);
+}
+
+void HiZPyramid::build(unsigned int depthTexture, int width, int height)
+{
+    if (width != this->width || height != this->height)
+    {
+        resources->destroy(textureHandle);
+
+        this->width = width;
+        this->height = height;
+
+        levels = 1;
+        for (int size = width > height ? width : height; size > 1; size /= 2)
+            levels++;
+
+        textureHandle = resources->createTexture();
+        texture = resources->get(textureHandle);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        gl->glTexStorage2D(GL_TEXTURE_2D, levels, GL_R32F, width, height);
+
+        // The cull shader picks a level itself; never blend between texels
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    // Level 0 is a straight copy of the depth buffer
+    gl->glUseProgram(copyShader->shaderId);
+    gl->glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    gl->glBindImageTexture(0, texture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+    gl->glDispatchCompute(GroupCount(width, HIZ_GROUP_SIZE), GroupCount(height, HIZ_GROUP_SIZE), 1);
+
+    gl->glUseProgram(downsampleShader->shaderId);
+
+    int levelWidth = width, levelHeight = height;
+    for (int level = 1; level < levels; level++)
+    {
+        levelWidth = levelWidth > 1 ? levelWidth / 2 : 1;
+        levelHeight = levelHeight > 1 ? levelHeight / 2 : 1;
+
+        gl->glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+        gl->glBindImageTexture(0, texture, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+        gl->glBindImageTexture(1, texture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        gl->glDispatchCompute(GroupCount(levelWidth, HIZ_GROUP_SIZE), GroupCount(levelHeight, HIZ_GROUP_SIZE), 1);
+    }
+
+    gl->glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+GpuCuller::GpuCuller(Platform *platform, OpenGL *gl, GpuResources *resources, int maxDraws)
+{
+    this->gl = gl;
+    this->resources = resources;
+    this->capacity = maxDraws;
+
+    cullShader = new Shader(platform, gl, resources, platform->ReadFileToString("/share/tonic/shaders/cull.comp"));
+
+    planesLocation = cullShader->getUniformLocation("planes");
+    viewProjLocation = cullShader->getUniformLocation("viewProj");
+    drawCountLocation = cullShader->getUniformLocation("drawCount");
+    compactLocation = cullShader->getUniformLocation("compact");
+    useHiZLocation = cullShader->getUniformLocation("useHiZ");
+    hizSizeLocation = cullShader->getUniformLocation("hizSize");
+    hizLevelsLocation = cullShader->getUniformLocation("hizLevels");
+
+    if (!gl->glMultiDrawElementsIndirectCount)
+        platform->Log("GpuCuller: no glMultiDrawElementsIndirectCount, culled draws are submitted with no instances\n");
+
+    // Both buffers are only ever touched by the GPU, apart from resetting
+    // the counter each frame and reading it back on request
+    commandHandle = resources->createBuffer();
+    commandBuffer = resources->get(commandHandle);
+    gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer);
+    gl->glBufferStorage(GL_SHADER_STORAGE_BUFFER, maxDraws * sizeof(DrawElementsIndirectCommand), NULL, 0);
+
+    GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    countHandle = resources->createBuffer();
+    countBuffer = resources->get(countHandle);
+    gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, countBuffer);
+    gl->glBufferStorage(GL_SHADER_STORAGE_BUFFER, sizeof(unsigned int), NULL, GL_DYNAMIC_STORAGE_BIT | flags);
+    countData = (unsigned int *)gl->glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, sizeof(unsigned int), flags);
+    gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+GpuCuller::~GpuCuller()
+{
+    delete cullShader;
+    resources->destroy(commandHandle);
+    resources->destroy(countHandle);
+}
+
+void GpuCuller::draw(StaticMeshBatch *batch, Shader *drawShader, const mat4 &viewProj, HiZPyramid *hiz)
+{
+    if (!batch->isBuilt() || batch->getDrawCount() == 0)
+        return;
+
+    BatchFrame frame = batch->prepare();
+    int drawCount = frame.drawCount < capacity ? frame.drawCount : capacity;
+    bool compact = gl->glMultiDrawElementsIndirectCount != nullptr;
+
+    unsigned int zero = 0;
+    gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, countBuffer);
+    gl->glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zero), &zero);
+    gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    // Planes are vec3 + float, so the array uploads as six vec4s
+    static_assert(sizeof(Plane) == 4 * sizeof(float), "Plane must pack to a vec4");
+    Frustum frustum = extractFrustum(viewProj);
+
+    // Cull
+    gl->glUseProgram(cullShader->shaderId);
+    gl->glUniform4fv(planesLocation, 6, &frustum.planes[0].normal.x);
+    gl->glUniformMatrix4fv(viewProjLocation, 1, GL_FALSE, viewProj.data());
+    gl->glUniform1i(drawCountLocation, drawCount);
+    gl->glUniform1i(compactLocation, compact);
+    gl->glUniform1i(useHiZLocation, hiz != nullptr);
+
+    if (hiz)
+    {
+        gl->glUniform2f(hizSizeLocation, (float)hiz->width, (float)hiz->height);
+        gl->glUniform1i(hizLevelsLocation, hiz->levels);
+        gl->glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, hiz->texture);
+    }
+
+    gl->glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, frame.buffer, frame.drawDataOffset, drawCount * sizeof(DrawData));
+    gl->glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 1, frame.buffer, frame.commandsOffset, drawCount * sizeof(DrawElementsIndirectCommand));
+    gl->glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 2, frame.buffer, frame.spheresOffset, drawCount * 4 * sizeof(float));
+    gl->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, commandBuffer);
+    gl->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, countBuffer);
+
+    gl->glDispatchCompute(GroupCount(drawCount, CULL_GROUP_SIZE), 1, 1);
+
+    // The commands and count are consumed as indirect parameters
+    gl->glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+    // Draw survivors
+    gl->glUseProgram(drawShader->shaderId);
+    batch->bind(frame);
+
+    gl->glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    if (compact)
+    {
+        gl->glBindBuffer(GL_PARAMETER_BUFFER, countBuffer);
+        gl->glMultiDrawElementsIndirectCount(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)0, 0, drawCount, 0);
+        gl->glBindBuffer(GL_PARAMETER_BUFFER, 0);
+    }
+    else
+    {
+        gl->glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)0, drawCount, 0);
+    }
+    gl->glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    batch->finish();
+}
+
+int GpuCuller::readVisibleCount()
+{
+    // The counter is written by the shader, so make those writes visible
+    // to the mapping before waiting
+    gl->glMemoryBarrier(GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT);
+    glFinish();
+
+    return (int)*countData;
+}
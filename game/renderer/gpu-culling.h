@@ -0,0 +1,73 @@
+#pragma once
+
+#include "../../engine/opengl.h"
+#include "../../engine/platform.h"
+#include "../../engine/math/mat.h"
+
+#include "gpu-resources.h"
+#include "shader.h"
+#include "static-batch.h"
+
+// Max-depth mip chain built from a depth texture, used to reject objects
+// hidden behind geometry drawn in the previous frame. Each texel of level
+// N holds the farthest depth of the 2x2 texels beneath it in level N-1.
+class HiZPyramid
+{
+private:
+    OpenGL *gl;
+    GpuResources *resources;
+    Shader *copyShader;
+    Shader *downsampleShader;
+    TextureHandle textureHandle;
+
+public:
+    unsigned int texture = 0; // GL name of the current pyramid
+    int width = 0, height = 0;
+    int levels = 0;
+
+    HiZPyramid(Platform *platform, OpenGL *gl, GpuResources *resources);
+    ~HiZPyramid();
+
+    // Rebuilds every level from 'depthTexture', reallocating the pyramid
+    // when the size changes. The old one is retired, so the previous
+    // frame's culling can still read it.
+    void build(unsigned int depthTexture, int width, int height);
+};
+
+// Culls the draws of a StaticMeshBatch on the GPU. A compute pass tests
+// each draw's bounding sphere against the view frustum (and optionally a
+// HiZPyramid), appending survivors to an output command buffer and
+// counting them atomically. The batch is then drawn with
+// glMultiDrawElementsIndirectCount, so nothing is read back to the CPU.
+// Where that is missing (before GL 4.6, without ARB_indirect_parameters)
+// every command is drawn instead, the culled ones with no instances.
+class GpuCuller
+{
+private:
+    OpenGL *gl;
+    GpuResources *resources;
+    Shader *cullShader;
+    BufferHandle commandHandle, countHandle;
+    unsigned int commandBuffer;
+    unsigned int countBuffer;
+    unsigned int *countData; // persistently mapped, for readVisibleCount()
+    int capacity;
+
+    int planesLocation, viewProjLocation, drawCountLocation, compactLocation;
+    int useHiZLocation, hizSizeLocation, hizLevelsLocation;
+
+public:
+    GpuCuller(Platform *platform, OpenGL *gl, GpuResources *resources, int maxDraws);
+    ~GpuCuller();
+
+    // Culls 'batch' against 'viewProj' and draws what is left with
+    // 'drawShader'. 'hiz' may be null to skip occlusion culling; it is
+    // expected to hold the previous frame's depth.
+    void draw(StaticMeshBatch *batch, Shader *drawShader, const mat4 &viewProj, HiZPyramid *hiz = nullptr);
+
+    // Waits for the GPU, then returns how many draws the last draw() kept.
+    // Stalls the pipeline, so only for benchmarks and debugging.
+    int readVisibleCount();
+
+    bool hasIndirectCount() const { return gl->glMultiDrawElementsIndirectCount != nullptr; }
+};
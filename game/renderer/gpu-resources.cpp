@@ -0,0 +1,190 @@
+#include "gpu-resources.h"
+
+GpuResources::~GpuResources()
+{
+    glFinish();
+
+    for (Retired &batch : retired)
+    {
+        gl->glDeleteSync(batch.fence);
+        for (int type = 0; type < GPU_RESOURCE_TYPE_COUNT; type++)
+            deleteNames((GpuResourceType)type, batch.names[type]);
+    }
+
+    for (int type = 0; type < GPU_RESOURCE_TYPE_COUNT; type++)
+    {
+        for (const Slot &slot : pools[type].slots)
+        {
+            if (slot.name)
+                pending[type].push_back(slot.name);
+        }
+        deleteNames((GpuResourceType)type, pending[type]);
+    }
+}
+
+uint32_t GpuResources::add(GpuResourceType type, unsigned int name, uint32_t &generation)
+{
+    Pool &pool = pools[type];
+
+    uint32_t index;
+    if (!pool.freeSlots.empty())
+    {
+        index = pool.freeSlots.back();
+        pool.freeSlots.pop_back();
+    }
+    else
+    {
+        index = (uint32_t)pool.slots.size();
+        pool.slots.push_back(Slot{ 0, 1 });
+    }
+
+    pool.slots[index].name = name;
+    generation = pool.slots[index].generation;
+    stats.live[type]++;
+    return index;
+}
+
+unsigned int GpuResources::lookup(GpuResourceType type, uint32_t index, uint32_t generation) const
+{
+    const Pool &pool = pools[type];
+    if (index >= pool.slots.size() || pool.slots[index].generation != generation)
+        return 0;
+    return pool.slots[index].name;
+}
+
+void GpuResources::retire(GpuResourceType type, uint32_t index, uint32_t generation)
+{
+    Pool &pool = pools[type];
+    if (!lookup(type, index, generation))
+        return;
+
+    Slot &slot = pool.slots[index];
+    pending[type].push_back(slot.name);
+    slot.name = 0;
+
+    // The slot can be reused straight away; only the GL name has to wait
+    if (++slot.generation == 0)
+        slot.generation = 1;
+    pool.freeSlots.push_back(index);
+
+    stats.live[type]--;
+    stats.pending++;
+}
+
+void GpuResources::deleteNames(GpuResourceType type, std::vector<unsigned int> &names)
+{
+    if (names.empty())
+        return;
+
+    GLsizei count = (GLsizei)names.size();
+    switch (type)
+    {
+    case GPU_BUFFER:
+        gl->glDeleteBuffers(count, names.data());
+        break;
+    case GPU_TEXTURE:
+        glDeleteTextures(count, names.data());
+        break;
+    case GPU_PROGRAM:
+        for (unsigned int name : names)
+            gl->glDeleteProgram(name);
+        break;
+    case GPU_VERTEX_ARRAY:
+        gl->glDeleteVertexArrays(count, names.data());
+        break;
+    case GPU_FRAMEBUFFER:
+        gl->glDeleteFramebuffers(count, names.data());
+        break;
+    case GPU_RENDERBUFFER:
+        gl->glDeleteRenderbuffers(count, names.data());
+        break;
+    case GPU_QUERY:
+        gl->glDeleteQueries(count, names.data());
+        break;
+    default:
+        break;
+    }
+
+    stats.deleted += names.size();
+    names.clear();
+}
+
+BufferHandle GpuResources::createBuffer()
+{
+    unsigned int name = 0;
+    gl->glGenBuffers(1, &name);
+    return add<GPU_BUFFER>(name);
+}
+
+TextureHandle GpuResources::createTexture()
+{
+    unsigned int name = 0;
+    glGenTextures(1, &name);
+    return add<GPU_TEXTURE>(name);
+}
+
+ProgramHandle GpuResources::createProgram()
+{
+    return add<GPU_PROGRAM>(gl->glCreateProgram());
+}
+
+VertexArrayHandle GpuResources::createVertexArray()
+{
+    unsigned int name = 0;
+    gl->glGenVertexArrays(1, &name);
+    return add<GPU_VERTEX_ARRAY>(name);
+}
+
+FramebufferHandle GpuResources::createFramebuffer()
+{
+    unsigned int name = 0;
+    gl->glGenFramebuffers(1, &name);
+    return add<GPU_FRAMEBUFFER>(name);
+}
+
+RenderbufferHandle GpuResources::createRenderbuffer()
+{
+    unsigned int name = 0;
+    gl->glGenRenderbuffers(1, &name);
+    return add<GPU_RENDERBUFFER>(name);
+}
+
+QueryHandle GpuResources::createQuery()
+{
+    unsigned int name = 0;
+    gl->glGenQueries(1, &name);
+    return add<GPU_QUERY>(name);
+}
+
+void GpuResources::endFrame()
+{
+    bool anyPending = false;
+    for (int type = 0; type < GPU_RESOURCE_TYPE_COUNT; type++)
+        anyPending |= !pending[type].empty();
+
+    if (anyPending)
+    {
+        retired.emplace_back();
+        Retired &batch = retired.back();
+        batch.fence = gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        for (int type = 0; type < GPU_RESOURCE_TYPE_COUNT; type++)
+            batch.names[type].swap(pending[type]);
+    }
+
+    // Fences signal in order, so stop at the first the GPU has not passed
+    while (!retired.empty())
+    {
+        Retired &batch = retired.front();
+        GLenum status = gl->glClientWaitSync(batch.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            break;
+
+        gl->glDeleteSync(batch.fence);
+        for (int type = 0; type < GPU_RESOURCE_TYPE_COUNT; type++)
+        {
+            stats.pending -= batch.names[type].size();
+            deleteNames((GpuResourceType)type, batch.names[type]);
+        }
+        retired.pop_front();
+    }
+}
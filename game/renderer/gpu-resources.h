@@ -0,0 +1,135 @@
+#pragma once
+
+#include "../../engine/opengl.h"
+
+#include <deque>
+#include <stdint.h>
+#include <vector>
+
+enum GpuResourceType
+{
+    GPU_BUFFER,
+    GPU_TEXTURE,
+    GPU_PROGRAM,
+    GPU_VERTEX_ARRAY,
+    GPU_FRAMEBUFFER,
+    GPU_RENDERBUFFER,
+    GPU_QUERY,
+    GPU_RESOURCE_TYPE_COUNT
+};
+
+// Refers to a GL object through a GpuResources pool: a slot in the pool
+// and the generation the slot was at when the object was made. Once the
+// object is destroyed the slot's generation moves on, so stale handles
+// resolve to 0 instead of to whatever reuses the slot or the GL name.
+// Default constructed handles are null.
+template <GpuResourceType Type>
+struct GpuHandle
+{
+    uint32_t index = 0;
+    uint32_t generation = 0; // 0 for a null handle; live slots start at 1
+
+    explicit operator bool() const { return generation != 0; }
+    bool operator==(const GpuHandle &other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const GpuHandle &other) const { return !(*this == other); }
+};
+
+typedef GpuHandle<GPU_BUFFER> BufferHandle;
+typedef GpuHandle<GPU_TEXTURE> TextureHandle;
+typedef GpuHandle<GPU_PROGRAM> ProgramHandle;
+typedef GpuHandle<GPU_VERTEX_ARRAY> VertexArrayHandle;
+typedef GpuHandle<GPU_FRAMEBUFFER> FramebufferHandle;
+typedef GpuHandle<GPU_RENDERBUFFER> RenderbufferHandle;
+typedef GpuHandle<GPU_QUERY> QueryHandle;
+
+struct GpuResourceStats
+{
+    unsigned int live[GPU_RESOURCE_TYPE_COUNT];
+    unsigned int pending;   // destroyed, waiting for the GPU to finish with them
+    unsigned int deleted;   // handed back to GL so far
+};
+
+// Owns the GL objects the renderer creates, in one dense pool per type.
+//
+// Destroying an object only retires it: the handle goes stale at once,
+// but the GL name is kept until a fence placed at the end of the frame
+// shows the GPU has finished every command that could still use it. The
+// fences are polled, never waited on, so freeing things mid-frame neither
+// stalls the pipeline nor pulls an object out from under a queued draw.
+class GpuResources
+{
+private:
+    OpenGL *gl;
+
+    struct Slot
+    {
+        unsigned int name; // 0 while the slot is free
+        uint32_t generation;
+    };
+
+    struct Pool
+    {
+        std::vector<Slot> slots;
+        std::vector<uint32_t> freeSlots;
+    };
+    Pool pools[GPU_RESOURCE_TYPE_COUNT];
+
+    // Names destroyed this frame, and earlier frames' behind their fences
+    std::vector<unsigned int> pending[GPU_RESOURCE_TYPE_COUNT];
+    struct Retired
+    {
+        GLsync fence;
+        std::vector<unsigned int> names[GPU_RESOURCE_TYPE_COUNT];
+    };
+    std::deque<Retired> retired;
+
+    GpuResourceStats stats = {};
+
+    uint32_t add(GpuResourceType type, unsigned int name, uint32_t &generation);
+    unsigned int lookup(GpuResourceType type, uint32_t index, uint32_t generation) const;
+    void retire(GpuResourceType type, uint32_t index, uint32_t generation);
+    void deleteNames(GpuResourceType type, std::vector<unsigned int> &names);
+
+    template <GpuResourceType Type>
+    GpuHandle<Type> add(unsigned int name)
+    {
+        GpuHandle<Type> handle;
+        handle.index = add(Type, name, handle.generation);
+        return handle;
+    }
+
+public:
+    explicit GpuResources(OpenGL *gl) : gl(gl) {}
+
+    // Waits for the GPU and deletes everything, retired or not. The GL
+    // context must still be current.
+    ~GpuResources();
+
+    BufferHandle createBuffer();
+    TextureHandle createTexture();
+    ProgramHandle createProgram();
+    VertexArrayHandle createVertexArray();
+    FramebufferHandle createFramebuffer();
+    RenderbufferHandle createRenderbuffer();
+    QueryHandle createQuery();
+
+    // The GL name, or 0 if the handle is null or its object was destroyed
+    template <GpuResourceType Type>
+    unsigned int get(GpuHandle<Type> handle) const { return lookup(Type, handle.index, handle.generation); }
+
+    // Retires the object and nulls the handle. Stale and null handles are
+    // ignored.
+    template <GpuResourceType Type>
+    void destroy(GpuHandle<Type> &handle)
+    {
+        retire(Type, handle.index, handle.generation);
+        handle = GpuHandle<Type>();
+    }
+
+    // Once the frame's commands are submitted: fences what was destroyed
+    // during it, and deletes whatever earlier fences show the GPU is done
+    // with
+    void endFrame();
+
+    const GpuResourceStats &getStats() const { return stats; }
+};
@@ -0,0 +1,116 @@
+#include "gpu-timer.h"
+
+#include <string.h>
+
+GpuTimer::GpuTimer(OpenGL *gl, GpuResources *resources, Profiler *profiler)
+{
+    this->gl = gl;
+    this->resources = resources;
+    this->profiler = profiler;
+    scopes.reserve(GPU_TIMER_MAX_SCOPES);
+}
+
+GpuTimer::~GpuTimer()
+{
+    for (Scope &scope : scopes)
+    {
+        for (int i = 0; i < GPU_TIMER_LATENCY; i++)
+        {
+            resources->destroy(scope.start[i]);
+            resources->destroy(scope.end[i]);
+        }
+    }
+}
+
+GpuTimer::Scope *GpuTimer::find(const char *name)
+{
+    for (Scope &scope : scopes)
+    {
+        if (scope.name == name)
+            return &scope;
+    }
+
+    // The same name from another translation unit may be another pointer
+    for (Scope &scope : scopes)
+    {
+        if (strcmp(scope.name, name) == 0)
+            return &scope;
+    }
+
+    if (scopes.size() == GPU_TIMER_MAX_SCOPES)
+        return nullptr;
+
+    scopes.emplace_back();
+    Scope &scope = scopes.back();
+    scope.name = name;
+    scope.samples = 0;
+    for (int i = 0; i < GPU_TIMER_LATENCY; i++)
+    {
+        scope.start[i] = resources->createQuery();
+        scope.end[i] = resources->createQuery();
+        scope.issued[i] = false;
+    }
+    return &scope;
+}
+
+const ProfileStat *GpuTimer::get(const char *name) const
+{
+    for (const Scope &scope : scopes)
+    {
+        if ((scope.name == name || strcmp(scope.name, name) == 0) && scope.samples > 0)
+            return &scope.time;
+    }
+    return nullptr;
+}
+
+// Reads back the current slot's queries, issued GPU_TIMER_LATENCY frames
+// ago, if the GPU has got to them
+void GpuTimer::collect(Scope &scope)
+{
+    if (!scope.issued[slot])
+        return;
+    scope.issued[slot] = false;
+
+    // The end query is the later of the two, so the start is ready too
+    GLint available = 0;
+    gl->glGetQueryObjectiv(resources->get(scope.end[slot]), GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+    {
+        dropped++;
+        return;
+    }
+
+    GLuint64 start = 0, end = 0;
+    gl->glGetQueryObjectui64v(resources->get(scope.start[slot]), GL_QUERY_RESULT, &start);
+    gl->glGetQueryObjectui64v(resources->get(scope.end[slot]), GL_QUERY_RESULT, &end);
+
+    float ms = end > start ? (float)(end - start) / 1e6f : 0.0f;
+    scope.time.add(ms);
+    scope.samples++;
+    if (profiler)
+        profiler->record(scope.name, ms);
+}
+
+void GpuTimer::beginFrame()
+{
+    slot = (slot + 1) % GPU_TIMER_LATENCY;
+    for (Scope &scope : scopes)
+        collect(scope);
+}
+
+void GpuTimer::begin(const char *name)
+{
+    Scope *scope = find(name);
+    if (scope)
+        gl->glQueryCounter(resources->get(scope->start[slot]), GL_TIMESTAMP);
+}
+
+void GpuTimer::end(const char *name)
+{
+    Scope *scope = find(name);
+    if (scope)
+    {
+        gl->glQueryCounter(resources->get(scope->end[slot]), GL_TIMESTAMP);
+        scope->issued[slot] = true;
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "../../engine/opengl.h"
+#include "../../engine/profiler/profiler.h"
+#include "gpu-resources.h"
+
+#include <vector>
+
+// Frames between timing something and reading the result back. By then
+// the GPU has finished with it, so reading never waits on the driver.
+#define GPU_TIMER_LATENCY 4
+
+#define GPU_TIMER_MAX_SCOPES 32
+
+// Times spans of GPU work with pairs of timestamp queries. Timestamps,
+// unlike GL_TIME_ELAPSED queries, may nest and overlap, so a whole frame
+// and the passes within it can be timed at once.
+//
+// Results arrive GPU_TIMER_LATENCY frames late. One that still is not
+// ready by then is dropped rather than waited for. Each result also goes
+// to the profiler, if given, as a section of the same name, so GPU times
+// show up in its log beside the CPU ones.
+//
+// Scopes are looked up by name pointer first, as with Profiler, so pass
+// string literals. Each scope may be timed once per frame.
+class GpuTimer
+{
+private:
+    OpenGL *gl;
+    GpuResources *resources;
+    Profiler *profiler;
+
+    struct Scope
+    {
+        const char *name;
+        ProfileStat time;
+        unsigned int samples;
+        QueryHandle start[GPU_TIMER_LATENCY];
+        QueryHandle end[GPU_TIMER_LATENCY];
+        bool issued[GPU_TIMER_LATENCY]; // both queries, this frame slot
+    };
+    std::vector<Scope> scopes;
+
+    int slot = 0; // of the current frame
+    unsigned int dropped = 0;
+
+    Scope *find(const char *name);
+    void collect(Scope &scope);
+
+public:
+    GpuTimer(OpenGL *gl, GpuResources *resources, Profiler *profiler);
+    ~GpuTimer();
+
+    // Before the frame's first scope: reads back what the GPU finished
+    // since, and moves on to the next frame's queries
+    void beginFrame();
+
+    void begin(const char *name);
+    void end(const char *name);
+
+    // GPU milliseconds per frame, or nullptr if no result has come back yet
+    const ProfileStat *get(const char *name) const;
+
+    // Results given up on because the GPU was too far behind
+    unsigned int getDropped() const { return dropped; }
+};
+
+// Times the GPU work issued within the enclosing block
+class GpuScope
+{
+private:
+    GpuTimer *timer;
+    const char *name;
+
+public:
+    GpuScope(GpuTimer *timer, const char *name) : timer(timer), name(name) { timer->begin(name); }
+    ~GpuScope() { timer->end(name); }
+};
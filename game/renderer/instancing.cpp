@@ -0,0 +1,65 @@
+#include "instancing.h"
+
+#include <stddef.h>
+
+InstanceRenderer::InstanceRenderer(OpenGL *gl, int capacity)
+{
+    this->gl = gl;
+    this->capacity = capacity;
+
+    gl->glGenBuffers(1, &instanceVBO);
+    gl->glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    gl->glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(InstanceData), NULL, GL_STREAM_DRAW);
+    gl->glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+InstanceRenderer::~InstanceRenderer()
+{
+    gl->glDeleteBuffers(1, &instanceVBO);
+}
+
+// Wire our instance buffer into the mesh's VAO. Expects the VAO to be bound.
+void InstanceRenderer::bindAttributes(Mesh *mesh)
+{
+    gl->glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+
+    // A mat4 attribute occupies four consecutive locations, one per column
+    for (int column = 0; column < 4; column++)
+    {
+        unsigned int location = MESH_INSTANCE_ATTRIB_START + column;
+        size_t offset = offsetof(InstanceData, transform) + column * sizeof(vec4);
+        gl->glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)offset);
+        gl->glEnableVertexAttribArray(location);
+        gl->glVertexAttribDivisor(location, 1);
+    }
+
+    unsigned int colorLocation = MESH_INSTANCE_ATTRIB_START + 4;
+    gl->glVertexAttribPointer(colorLocation, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)offsetof(InstanceData, color));
+    gl->glEnableVertexAttribArray(colorLocation);
+    gl->glVertexAttribDivisor(colorLocation, 1);
+
+    mesh->instanceVBO = instanceVBO;
+}
+
+void InstanceRenderer::draw(Mesh *mesh, const InstanceData *instances, int count)
+{
+    gl->glBindVertexArray(mesh->VAO);
+
+    if (mesh->instanceVBO != instanceVBO)
+        bindAttributes(mesh);
+    else
+        gl->glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+
+    for (int first = 0; first < count; first += capacity)
+    {
+        int batch = count - first < capacity ? count - first : capacity;
+
+        // Orphan the old storage, then fill only the part we use
+        gl->glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(InstanceData), NULL, GL_STREAM_DRAW);
+        gl->glBufferSubData(GL_ARRAY_BUFFER, 0, batch * sizeof(InstanceData), instances + first);
+
+        mesh->drawInstanced(batch);
+    }
+
+    gl->glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "../../engine/opengl.h"
+#include "../../engine/math/mat.h"
+
+#include "mesh.h"
+
+// Per-instance attributes streamed alongside a mesh. The layout matches
+// instanced.vert: a column-major model matrix in locations 2-5 followed by
+// an RGBA tint in location 6.
+struct InstanceData
+{
+    mat4 transform;
+    vec4 color;
+};
+
+// Streams arrays of InstanceData into a single vertex buffer and draws a
+// mesh for all of them in one call. The buffer is orphaned before every
+// upload so the driver can hand us fresh storage instead of stalling on
+// draws that are still reading the previous contents.
+class InstanceRenderer
+{
+private:
+    OpenGL *gl;
+    unsigned int instanceVBO;
+    int capacity;
+
+    void bindAttributes(Mesh *mesh);
+
+public:
+    InstanceRenderer(OpenGL *gl, int capacity);
+    ~InstanceRenderer();
+
+    // Draws 'count' instances of 'mesh' with the currently bound program.
+    // Batches larger than the buffer capacity are split into several draws.
+    void draw(Mesh *mesh, const InstanceData *instances, int count);
+};
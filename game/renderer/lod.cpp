@@ -0,0 +1,42 @@
+#include "lod.h"
+
+#include <math.h>
+
+LodView MakeLodView(const vec3 &eye, float fovY, int screenHeight)
+{
+    LodView view;
+    view.eye = eye;
+    view.pixelsPerUnit = screenHeight / (2.0f * tanf(fovY * 0.5f));
+    return view;
+}
+
+int SelectLod(const MeshAsset *mesh, int submesh, const mat4 &transform, const LodView &view,
+              int currentLod, float maxErrorPixels, float hysteresis)
+{
+    int lodCount = mesh->getLodCount(submesh);
+    if (lodCount <= 1)
+        return 0;
+
+    // The errors and sphere are in object space; a non-uniform scale
+    // stretches them by at most its largest axis
+    float scale = sqrtf(fmaxf(dot(transform[0], transform[0]),
+                              fmaxf(dot(transform[1], transform[1]), dot(transform[2], transform[2]))));
+
+    const float *sphere = mesh->getSubmesh(submesh).sphere;
+    vec4 center = transform * vec4(sphere[0], sphere[1], sphere[2], 1.0f);
+    float distance = length(vec3(center.x, center.y, center.z) - view.eye) - sphere[3] * scale;
+
+    // Inside the sphere: nothing can be coarse enough
+    if (distance <= 0.0f)
+        return 0;
+
+    float pixelsPerError = scale * view.pixelsPerUnit / distance;
+    auto projectedError = [&](int lod) { return mesh->getLod(submesh, lod).error * pixelsPerError; };
+
+    int lod = currentLod < 0 ? 0 : (currentLod >= lodCount ? lodCount - 1 : currentLod);
+    while (lod + 1 < lodCount && projectedError(lod + 1) < maxErrorPixels * (1.0f - hysteresis))
+        lod++;
+    while (lod > 0 && projectedError(lod) > maxErrorPixels * (1.0f + hysteresis))
+        lod--;
+    return lod;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../../engine/math/mat.h"
+
+#include "mesh-asset.h"
+
+// What LOD selection needs to know about the camera
+struct LodView
+{
+    vec3 eye;
+
+    // Pixels covered by one world unit at a distance of one unit
+    float pixelsPerUnit;
+};
+
+// 'fovY' in radians, as passed to mat4::perspective
+LodView MakeLodView(const vec3 &eye, float fovY, int screenHeight);
+
+// Picks a level of detail for one submesh of 'mesh' drawn with
+// 'transform': the coarsest level whose simplification error projects to
+// at most 'maxErrorPixels' on screen. Distance is taken to the nearest
+// point of the submesh's bounding sphere, so the estimate errs on the side
+// of detail.
+//
+// 'currentLod' is the level chosen last frame. A level only changes once
+// its error crosses the threshold by the fraction 'hysteresis', so an
+// object hovering around a boundary does not flicker between two levels.
+int SelectLod(const MeshAsset *mesh, int submesh, const mat4 &transform, const LodView &view,
+              int currentLod, float maxErrorPixels = 1.0f, float hysteresis = 0.25f);
@@ -0,0 +1,141 @@
+#include "mesh-asset.h"
+
+#include <string.h>
+
+// True if [offset, offset + length) lies inside a file of 'size' bytes
+static bool InFile(uint64_t offset, uint64_t length, size_t size)
+{
+    return offset % MESH_SECTION_ALIGN == 0 && offset + length <= size;
+}
+
+bool MeshAsset::validate(const unsigned char *data, size_t size)
+{
+    if (size < sizeof(MeshFileHeader))
+        return false;
+
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != MESH_FILE_MAGIC || header.version != MESH_FILE_VERSION || header.fileSize != size)
+        return false;
+    if (header.indexSize != 2 && header.indexSize != 4)
+        return false;
+
+    return InFile(header.submeshOffset, (uint64_t)header.submeshCount * sizeof(MeshSubmesh), size) &&
+           InFile(header.lodOffset, (uint64_t)header.lodCount * sizeof(MeshLod), size) &&
+           InFile(header.meshletOffset, (uint64_t)header.meshletCount * sizeof(MeshMeshlet), size) &&
+           InFile(header.vertexOffset, (uint64_t)header.vertexCount * MESH_VERTEX_STRIDE, size) &&
+           InFile(header.indexOffset, (uint64_t)header.indexCount * header.indexSize, size) &&
+           InFile(header.meshletVertexOffset, (uint64_t)header.meshletVertexCount * sizeof(uint32_t), size) &&
+           InFile(header.meshletTriangleOffset, (uint64_t)header.meshletTriangleCount * 3, size);
+}
+
+MeshAsset::MeshAsset(Platform *platform, OpenGL *gl, GpuResources *resources, const std::string &path)
+{
+    this->platform = platform;
+    this->gl = gl;
+    this->resources = resources;
+
+    size_t size = 0;
+    const unsigned char *data = (const unsigned char *)platform->MapFile(path, &size);
+    if (!data)
+        return;
+
+    if (!validate(data, size))
+    {
+        platform->Log("Error: '%s' is not a valid mesh file\n", path.c_str());
+        platform->UnmapFile(data, size);
+        return;
+    }
+
+    const MeshSubmesh *fileSubmeshes = (const MeshSubmesh *)(data + header.submeshOffset);
+    const MeshLod *fileLods = (const MeshLod *)(data + header.lodOffset);
+    const MeshMeshlet *fileMeshlets = (const MeshMeshlet *)(data + header.meshletOffset);
+    submeshes.assign(fileSubmeshes, fileSubmeshes + header.submeshCount);
+    lods.assign(fileLods, fileLods + header.lodCount);
+    meshlets.assign(fileMeshlets, fileMeshlets + header.meshletCount);
+
+    bool rangesValid = true;
+    for (const MeshSubmesh &submesh : submeshes)
+    {
+        if ((uint64_t)submesh.firstIndex + submesh.indexCount > header.indexCount ||
+            submesh.lodCount == 0 || (uint64_t)submesh.firstLod + submesh.lodCount > header.lodCount)
+            rangesValid = false;
+    }
+    for (const MeshLod &lod : lods)
+    {
+        if ((uint64_t)lod.firstIndex + lod.indexCount > header.indexCount)
+            rangesValid = false;
+    }
+
+    if (!rangesValid)
+    {
+        platform->Log("Error: '%s' has a submesh outside its index buffer\n", path.c_str());
+        platform->UnmapFile(data, size);
+        submeshes.clear();
+        lods.clear();
+        meshlets.clear();
+        return;
+    }
+
+    vertexArray = resources->createVertexArray();
+    vertexBuffer = resources->createBuffer();
+    indexBuffer = resources->createBuffer();
+
+    gl->glBindVertexArray(resources->get(vertexArray));
+
+    // Straight from the mapping; the data is already in its GPU layout
+    gl->glBindBuffer(GL_ARRAY_BUFFER, resources->get(vertexBuffer));
+    gl->glBufferStorage(GL_ARRAY_BUFFER, (GLsizeiptr)header.vertexCount * MESH_VERTEX_STRIDE, data + header.vertexOffset, 0);
+
+    gl->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, resources->get(indexBuffer));
+    gl->glBufferStorage(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)header.indexCount * header.indexSize, data + header.indexOffset, 0);
+
+    gl->glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, MESH_VERTEX_STRIDE, (void *)MESH_VERTEX_POSITION_OFFSET);
+    gl->glEnableVertexAttribArray(0);
+    gl->glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, MESH_VERTEX_STRIDE, (void *)MESH_VERTEX_NORMAL_OFFSET);
+    gl->glEnableVertexAttribArray(1);
+    gl->glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, MESH_VERTEX_STRIDE, (void *)MESH_VERTEX_UV_OFFSET);
+    gl->glEnableVertexAttribArray(2);
+
+    gl->glBindVertexArray(0);
+
+    // GL has its own copy now
+    platform->UnmapFile(data, size);
+    loaded = true;
+}
+
+MeshAsset::~MeshAsset()
+{
+    resources->destroy(vertexArray);
+    resources->destroy(vertexBuffer);
+    resources->destroy(indexBuffer);
+}
+
+void MeshAsset::draw()
+{
+    if (!loaded)
+        return;
+
+    // The index buffer also holds the simplified LODs, so draw the
+    // full-detail range of each submesh rather than all of it
+    for (int i = 0; i < (int)submeshes.size(); i++)
+        drawSubmesh(i, 0);
+}
+
+void MeshAsset::drawSubmesh(int submesh, int lod)
+{
+    if (!loaded)
+        return;
+
+    const MeshLod &range = getLod(submesh, lod);
+    size_t offset = (size_t)range.firstIndex * header.indexSize;
+
+    gl->glBindVertexArray(resources->get(vertexArray));
+    glDrawElements(GL_TRIANGLES, range.indexCount, header.indexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, (void *)offset);
+}
+
+mat4 MeshAsset::getDequantizeMatrix() const
+{
+    vec3 min(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+    vec3 max(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+    return mat4::translate(min) * mat4::scale(max - min);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "../../engine/opengl.h"
+#include "../../engine/platform.h"
+#include "../../engine/math/mat.h"
+#include "../../engine/assets/mesh-format.h"
+#include "gpu-resources.h"
+
+#include <string>
+#include <vector>
+
+// Mesh loaded from a .tmesh file produced by tools/mesh-convert. The file
+// is mapped and its vertex and index ranges are handed to GL as they are;
+// loading only checks the header and copies the small submesh, LOD and
+// meshlet tables.
+//
+// Vertex attributes, matching the quantised layout in mesh-format.h:
+//   location 0  position, normalised unsigned shorts in [0, 1] across the
+//               bounds; multiply by getDequantizeMatrix() to recover it
+//   location 1  normal, vec3 in [-1, 1]
+//   location 2  uv, vec2
+class MeshAsset
+{
+private:
+    OpenGL *gl;
+    Platform *platform;
+    GpuResources *resources;
+
+    VertexArrayHandle vertexArray;
+    BufferHandle vertexBuffer, indexBuffer;
+    MeshFileHeader header = {};
+    std::vector<MeshSubmesh> submeshes;
+    std::vector<MeshLod> lods;
+    std::vector<MeshMeshlet> meshlets;
+    bool loaded = false;
+
+    bool validate(const unsigned char *data, size_t size);
+
+public:
+    MeshAsset(Platform *platform, OpenGL *gl, GpuResources *resources, const std::string &path);
+
+    // Retires the buffers; draws already queued are unaffected
+    ~MeshAsset();
+
+    // False if the file was missing or malformed; the mesh then draws nothing
+    bool isLoaded() const { return loaded; }
+
+    // What the vertex and index buffers take up on the GPU
+    size_t getGpuBytes() const { return (size_t)header.vertexCount * MESH_VERTEX_STRIDE + (size_t)header.indexCount * header.indexSize; }
+
+    // Every submesh at full detail
+    void draw();
+
+    // One submesh at the given level of detail, 0 being full detail
+    void drawSubmesh(int submesh, int lod = 0);
+
+    // Maps quantised positions back to object space. Put it between the
+    // model transform and the vertex, i.e. transform * getDequantizeMatrix().
+    mat4 getDequantizeMatrix() const;
+
+    const MeshFileHeader &getHeader() const { return header; }
+    int getSubmeshCount() const { return (int)submeshes.size(); }
+    const MeshSubmesh &getSubmesh(int submesh) const { return submeshes[submesh]; }
+    int getLodCount(int submesh) const { return (int)submeshes[submesh].lodCount; }
+    const MeshLod &getLod(int submesh, int lod) const { return lods[submeshes[submesh].firstLod + lod]; }
+    const std::vector<MeshMeshlet> &getMeshlets() const { return meshlets; }
+};
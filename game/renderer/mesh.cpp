@@ -0,0 +1,61 @@
+#include "mesh.h"
+
+Mesh::Mesh(OpenGL *gl, const float *vertices, int vertexCount, const unsigned int *indices, int indexCount)
+{
+    this->gl = gl;
+    this->vertexCount = vertexCount;
+    this->indexCount = indexCount;
+    EBO = 0;
+
+    gl->glGenVertexArrays(1, &VAO);
+    gl->glGenBuffers(1, &VBO);
+    gl->glBindVertexArray(VAO);
+
+    gl->glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    gl->glBufferData(GL_ARRAY_BUFFER, vertexCount * 6 * sizeof(float), vertices, GL_STATIC_DRAW);
+
+    if (indices)
+    {
+        // The element buffer binding is recorded in the VAO, so leave it bound
+        gl->glGenBuffers(1, &EBO);
+        gl->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        gl->glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indices, GL_STATIC_DRAW);
+    }
+
+    // position attribute
+    gl->glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+    gl->glEnableVertexAttribArray(0);
+    // color attribute
+    gl->glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+    gl->glEnableVertexAttribArray(1);
+
+    gl->glBindBuffer(GL_ARRAY_BUFFER, 0);
+    gl->glBindVertexArray(0);
+}
+
+Mesh::~Mesh()
+{
+    gl->glDeleteVertexArrays(1, &VAO);
+    gl->glDeleteBuffers(1, &VBO);
+    if (EBO)
+        gl->glDeleteBuffers(1, &EBO);
+}
+
+void Mesh::draw() const
+{
+    gl->glBindVertexArray(VAO);
+
+    if (EBO)
+        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, (void*)0);
+    else
+        glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+}
+
+// Assumes VAO is already bound and its instance attributes configured
+void Mesh::drawInstanced(int instanceCount) const
+{
+    if (EBO)
+        gl->glDrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, (void*)0, instanceCount);
+    else
+        gl->glDrawArraysInstanced(GL_TRIANGLES, 0, vertexCount, instanceCount);
+}
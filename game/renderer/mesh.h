@@ -0,0 +1,31 @@
+#pragma once
+
+#include "../../engine/opengl.h"
+
+// Vertex layout shared by all meshes: interleaved position and colour.
+// Attribute locations 0 and 1 are reserved for these; per-instance
+// attributes start at MESH_INSTANCE_ATTRIB_START.
+#define MESH_INSTANCE_ATTRIB_START 2
+
+class Mesh
+{
+private:
+    OpenGL *gl;
+
+public:
+    unsigned int VAO, VBO, EBO;
+    int vertexCount;
+    int indexCount;
+
+    // The instance buffer whose attributes are currently wired into VAO,
+    // so the instancing path only has to configure them once per mesh.
+    unsigned int instanceVBO = 0;
+
+    // 'vertices' holds 6 floats per vertex (position, colour). Indices are
+    // optional; pass nullptr/0 to draw with glDrawArrays.
+    Mesh(OpenGL *gl, const float *vertices, int vertexCount, const unsigned int *indices = nullptr, int indexCount = 0);
+    ~Mesh();
+
+    void draw() const;
+    void drawInstanced(int instanceCount) const;
+};
@@ -0,0 +1,155 @@
+#include "particles.h"
+#include "uniforms.h"
+
+#include <math.h>
+
+// Layout of the state buffer, in uints; see ParticleState in the shaders
+#define STATE_COUNTS 0   // live particles in each buffer
+#define STATE_DRAW 4     // DrawArraysIndirectCommand
+#define STATE_DISPATCH 8 // DispatchIndirectCommand for the next simulate
+#define STATE_SIZE 12
+
+ParticleSystem::ParticleSystem(Platform *platform, OpenGL *gl, GpuResources *resources, int capacity)
+{
+    this->gl = gl;
+    this->resources = resources;
+    this->capacity = capacity;
+
+    emitShader = new Shader(platform, gl, resources, platform->ReadFileToString("/share/tonic/shaders/particle-emit.comp"));
+    simulateShader = new Shader(platform, gl, resources, platform->ReadFileToString("/share/tonic/shaders/particle-simulate.comp"));
+    finishShader = new Shader(platform, gl, resources, platform->ReadFileToString("/share/tonic/shaders/particle-finish.comp"));
+    drawShader = new Shader(platform, gl, resources,
+                            platform->ReadFileToString("/share/tonic/shaders/particle.vert"),
+                            platform->ReadFileToString("/share/tonic/shaders/particle.frag"));
+
+    // Neither the particles nor their counts are ever touched by the CPU
+    // after this
+    for (BufferHandle &buffer : particleBuffers)
+    {
+        buffer = resources->createBuffer();
+        gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, resources->get(buffer));
+        gl->glBufferStorage(GL_SHADER_STORAGE_BUFFER, capacity * sizeof(ParticleData), NULL, 0);
+    }
+
+    // Both buffers empty: draw 0 instances of a 4 vertex strip, and
+    // dispatch no simulate groups
+    unsigned int state[STATE_SIZE] = {};
+    state[STATE_DRAW] = 4;
+    state[STATE_DISPATCH + 1] = 1;
+    state[STATE_DISPATCH + 2] = 1;
+
+    stateBuffer = resources->createBuffer();
+    gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, resources->get(stateBuffer));
+    gl->glBufferStorage(GL_SHADER_STORAGE_BUFFER, sizeof(state), state, 0);
+    gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    // Quads are built from gl_VertexID and gl_InstanceID, but core
+    // profiles still want a vertex array bound to draw
+    vertexArray = resources->createVertexArray();
+}
+
+ParticleSystem::~ParticleSystem()
+{
+    delete emitShader;
+    delete simulateShader;
+    delete finishShader;
+    delete drawShader;
+    resources->destroy(particleBuffers[0]);
+    resources->destroy(particleBuffers[1]);
+    resources->destroy(stateBuffer);
+    resources->destroy(vertexArray);
+}
+
+void ParticleSystem::emit(const ParticleEmitter &emitter, float deltaTime)
+{
+    if (emitCalls == (int)carry.size())
+        carry.push_back(0.0f);
+
+    float &owed = carry[emitCalls++];
+    owed += emitter.rate * deltaTime;
+    int count = (int)owed;
+    owed -= count;
+
+    if (count > 0)
+        emissions.push_back(Emission{ emitter, count });
+}
+
+void ParticleSystem::burst(const ParticleEmitter &emitter, int count)
+{
+    if (count > 0)
+        emissions.push_back(Emission{ emitter, count });
+}
+
+void ParticleSystem::update(UniformRing *uniforms, float deltaTime)
+{
+    int source = current;
+    int destination = 1 - current;
+
+    ParticleUniforms block = {};
+    block.forces = vec4(gravity, drag);
+    block.timing = vec4(deltaTime, (float)(seed++ & 0xffff), 0.0f, 0.0f);
+    block.counts = vec4(0.0f, (float)capacity, (float)source, (float)destination);
+
+    gl->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PARTICLE_STORAGE_SOURCE, resources->get(particleBuffers[source]));
+    gl->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PARTICLE_STORAGE_DESTINATION, resources->get(particleBuffers[destination]));
+    gl->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PARTICLE_STORAGE_STATE, resources->get(stateBuffer));
+
+    // As many groups as last frame's finish pass found particles
+    uniforms->bind(UNIFORM_BINDING_PARTICLES, uniforms->push(block));
+    gl->glUseProgram(simulateShader->shaderId);
+    gl->glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, resources->get(stateBuffer));
+    gl->glDispatchComputeIndirect(STATE_DISPATCH * sizeof(unsigned int));
+    gl->glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+
+    // Emission appends behind the survivors through the same counter,
+    // which each dispatch must see the last one's additions to
+    gl->glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    gl->glUseProgram(emitShader->shaderId);
+    for (const Emission &emission : emissions)
+    {
+        const ParticleEmitter &emitter = emission.emitter;
+        ParticleUniforms emit = block;
+        emit.position = vec4(emitter.position, emitter.radius);
+        emit.velocity = vec4(emitter.velocity, emitter.spread);
+        emit.color = emitter.color;
+        emit.spawn = vec4(emitter.minLifetime, emitter.maxLifetime, emitter.minSize, emitter.maxSize);
+        emit.timing.y = (float)(seed++ & 0xffff);
+        emit.counts.x = (float)emission.count;
+        uniforms->bind(UNIFORM_BINDING_PARTICLES, uniforms->push(emit));
+
+        int count = emission.count < capacity ? emission.count : capacity;
+        gl->glDispatchCompute((count + PARTICLE_GROUP_SIZE - 1) / PARTICLE_GROUP_SIZE, 1, 1);
+        gl->glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+    emissions.clear();
+    emitCalls = 0;
+
+    uniforms->bind(UNIFORM_BINDING_PARTICLES, uniforms->push(block));
+    gl->glUseProgram(finishShader->shaderId);
+    gl->glDispatchCompute(1, 1, 1);
+
+    // The next simulate and this frame's draw read the commands, and the
+    // vertex shader the particles
+    gl->glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+    current = destination;
+}
+
+void ParticleSystem::draw()
+{
+    glEnable(GL_DEPTH_TEST);
+    glDepthMask(GL_FALSE);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE);
+
+    gl->glUseProgram(drawShader->shaderId);
+    gl->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PARTICLE_STORAGE_SOURCE, resources->get(particleBuffers[current]));
+    gl->glBindVertexArray(resources->get(vertexArray));
+    gl->glBindBuffer(GL_DRAW_INDIRECT_BUFFER, resources->get(stateBuffer));
+    gl->glDrawArraysIndirect(GL_TRIANGLE_STRIP, (const void *)(STATE_DRAW * sizeof(unsigned int)));
+    gl->glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    gl->glBindVertexArray(0);
+
+    glDisable(GL_BLEND);
+    glDepthMask(GL_TRUE);
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "../../engine/opengl.h"
+#include "../../engine/platform.h"
+#include "../../engine/math/mat.h"
+
+#include "gpu-resources.h"
+#include "shader.h"
+#include "uniform-ring.h"
+
+#include <vector>
+
+// Shader storage binding points read by the particle shaders
+#define PARTICLE_STORAGE_SOURCE 9
+#define PARTICLE_STORAGE_DESTINATION 10
+#define PARTICLE_STORAGE_STATE 11
+
+// Matches local_size_x in particle-emit.comp and particle-simulate.comp
+#define PARTICLE_GROUP_SIZE 256
+
+// Where particles start and how they look, in world space
+struct ParticleEmitter
+{
+    vec3 position = vec3(0.0f);
+    float radius = 0.0f;      // particles start anywhere in this sphere
+    vec3 velocity = vec3(0.0f, 1.0f, 0.0f);
+    float spread = 0.5f;      // random speed added in any direction
+    vec4 color = vec4(1.0f);  // alpha scales the brightness, which fades out over the lifetime
+    float minLifetime = 1.0f, maxLifetime = 2.0f; // seconds
+    float minSize = 0.02f, maxSize = 0.05f;       // world units across
+    float rate = 1000.0f;     // particles per second
+};
+
+// struct Particle in the particle shaders, std430
+struct alignas(16) ParticleData
+{
+    vec4 positionLife;  // w seconds left to live
+    vec4 velocitySize;  // w size
+    vec4 color;         // rgb brightness; a 1 / lifetime, to fade by the life left
+};
+
+static_assert(sizeof(ParticleData) == 48, "ParticleData must match std430");
+
+// Particles that live entirely on the GPU. Each frame three compute passes
+// run over two particle buffers that swap roles:
+//
+//   simulate  moves the live particles in the source buffer and appends
+//             those still alive to the destination, which compacts out
+//             the dead ones
+//   emit      appends new particles to the destination, one dispatch per
+//             emitter, dropping any past the capacity
+//   finish    clamps the destination's count, and writes it into the
+//             indirect draw command and the next frame's indirect
+//             simulate dispatch
+//
+// The counts stay in a GPU buffer and feed glDispatchComputeIndirect and
+// glDrawArraysIndirect directly, so however many particles there are,
+// nothing is ever read back. The CPU only decides how many to emit.
+class ParticleSystem
+{
+private:
+    OpenGL *gl;
+    GpuResources *resources;
+    Shader *emitShader;
+    Shader *simulateShader;
+    Shader *finishShader;
+    Shader *drawShader;
+
+    BufferHandle particleBuffers[2];
+    BufferHandle stateBuffer;
+    VertexArrayHandle vertexArray;
+    int capacity;
+    int current = 0; // buffer holding the latest particles
+
+    struct Emission
+    {
+        ParticleEmitter emitter;
+        int count;
+    };
+    std::vector<Emission> emissions;
+    std::vector<float> carry; // fraction of a particle owed to each emit() call
+    int emitCalls = 0;
+    unsigned int seed = 1;
+
+public:
+    vec3 gravity = vec3(0.0f, -9.8f, 0.0f);
+    float drag = 0.1f; // velocity decays as exp(-drag * seconds)
+
+    ParticleSystem(Platform *platform, OpenGL *gl, GpuResources *resources, int capacity);
+    ~ParticleSystem();
+
+    // Emits emitter.rate * deltaTime particles at the next update(). Call
+    // in the same order every frame: the fraction of a particle left over
+    // is carried per call, so low rates still emit on average.
+    void emit(const ParticleEmitter &emitter, float deltaTime);
+
+    // Emits exactly 'count' particles at the next update()
+    void burst(const ParticleEmitter &emitter, int count);
+
+    // Runs the frame's simulation and emission on the GPU
+    void update(UniformRing *uniforms, float deltaTime);
+
+    // Draws the particles as camera facing, additively blended quads,
+    // depth tested against but not writing the bound depth buffer
+    void draw();
+
+    int getCapacity() const { return capacity; }
+};
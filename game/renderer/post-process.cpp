@@ -0,0 +1,228 @@
+#include "post-process.h"
+
+#include <math.h>
+
+static const char *timerNames[POST_EFFECT_COUNT] = { "gpu bloom", "gpu tonemap", "gpu color grade", "gpu fxaa" };
+static const char *passNames[POST_EFFECT_COUNT] = { "bloom", "tonemap", "color grade", "fxaa" };
+
+static RenderTargetDesc ScaledDesc(const RenderTargetDesc &desc, float scale, RenderFormat format)
+{
+    scale = fminf(fmaxf(scale, 0.0f), 1.0f);
+    int width = (int)(desc.width * scale + 0.5f);
+    int height = (int)(desc.height * scale + 0.5f);
+    return RenderTargetDesc{ width > 0 ? width : 1, height > 0 ? height : 1, format };
+}
+
+static vec2 TexelSize(const RenderTargetDesc &desc)
+{
+    return vec2(1.0f / desc.width, 1.0f / desc.height);
+}
+
+PostProcessStack::PostProcessStack(OpenGL *gl, GpuResources *resources, AssetCache *assets, GpuTimer *timer)
+{
+    this->gl = gl;
+    this->resources = resources;
+    this->timer = timer;
+
+    extractShader = LoadShader(assets, "/share/tonic/shaders/fullscreen.vert", "/share/tonic/shaders/bloom-extract.frag");
+    blurShader = LoadShader(assets, "/share/tonic/shaders/fullscreen.vert", "/share/tonic/shaders/blur.frag");
+    tonemapShader = LoadShader(assets, "/share/tonic/shaders/fullscreen.vert", "/share/tonic/shaders/tonemap.frag");
+    gradeShader = LoadShader(assets, "/share/tonic/shaders/fullscreen.vert", "/share/tonic/shaders/color-grade.frag");
+    fxaaShader = LoadShader(assets, "/share/tonic/shaders/fullscreen.vert", "/share/tonic/shaders/fxaa.frag");
+    fullscreenVertexArray = resources->createVertexArray();
+
+    // Bloom is blurry by nature, so it loses little at half resolution
+    effects[POST_BLOOM].scale = 0.5f;
+}
+
+PostProcessStack::~PostProcessStack()
+{
+    resources->destroy(fullscreenVertexArray);
+}
+
+const ProfileStat *PostProcessStack::getTime(PostEffect effect) const
+{
+    return timer->get(timerNames[effect]);
+}
+
+void PostProcessStack::useShader(const Shader *shader, unsigned int source)
+{
+    glDisable(GL_DEPTH_TEST);
+    gl->glUseProgram(shader->shaderId);
+    gl->glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, source);
+}
+
+void PostProcessStack::drawFullscreen()
+{
+    gl->glBindVertexArray(resources->get(fullscreenVertexArray));
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+// Bright-pass and downsample in one go, then a separable blur. The
+// timing spans all three passes, which the graph runs back to back as
+// each consumes the last one's output.
+RenderResource PostProcessStack::addBloom(RenderGraph *graph, RenderResource scene, const RenderTargetDesc &output)
+{
+    RenderTargetDesc desc = ScaledDesc(output, effects[POST_BLOOM].scale, RENDER_FORMAT_R11G11B10F);
+    RenderResource bright, blurred, bloom;
+
+    graph->addPass("bloom extract",
+        [&](RenderPassBuilder &builder) {
+            builder.read(scene);
+            bright = builder.write(builder.create("bloom bright", desc), RENDER_LOAD_ANY);
+        },
+        [this, scene](RenderPassContext &context) {
+            timer->begin(timerNames[POST_BLOOM]);
+            if (!extractShader)
+                return;
+
+            useShader(extractShader.get(), context.getTexture(scene));
+            extractShader->setVec2("texelSize", TexelSize(context.getDesc(scene)));
+            extractShader->setFloat("threshold", settings.bloomThreshold);
+            drawFullscreen();
+        });
+
+    graph->addPass("bloom blur x",
+        [&](RenderPassBuilder &builder) {
+            builder.read(bright);
+            blurred = builder.write(builder.create("bloom blur", desc), RENDER_LOAD_ANY);
+        },
+        [this, bright, desc](RenderPassContext &context) {
+            if (!blurShader)
+                return;
+
+            useShader(blurShader.get(), context.getTexture(bright));
+            blurShader->setVec2("direction", vec2(1.0f / desc.width, 0.0f));
+            drawFullscreen();
+        });
+
+    graph->addPass("bloom blur y",
+        [&](RenderPassBuilder &builder) {
+            builder.read(blurred);
+            bloom = builder.write(builder.create("bloom", desc), RENDER_LOAD_ANY);
+        },
+        [this, blurred, desc](RenderPassContext &context) {
+            if (blurShader)
+            {
+                useShader(blurShader.get(), context.getTexture(blurred));
+                blurShader->setVec2("direction", vec2(0.0f, 1.0f / desc.height));
+                drawFullscreen();
+            }
+            timer->end(timerNames[POST_BLOOM]);
+        });
+
+    return bloom;
+}
+
+// Renders one effect from 'source' into a new transient at the effect's
+// scale, or into 'output' if that is valid
+RenderResource PostProcessStack::addEffect(RenderGraph *graph, PostEffect effect, RenderResource source,
+                                           RenderResource bloom, RenderResource output, const RenderTargetDesc &desc)
+{
+    RenderResource written;
+
+    graph->addPass(passNames[effect],
+        [&](RenderPassBuilder &builder) {
+            builder.read(source);
+            if (bloom.isValid())
+                builder.read(bloom);
+            if (output.isValid())
+                written = builder.write(output, RENDER_LOAD_ANY);
+            else
+                written = builder.write(builder.create(passNames[effect], desc), RENDER_LOAD_ANY);
+        },
+        [this, effect, source, bloom](RenderPassContext &context) {
+            GpuScope scope(timer, timerNames[effect]);
+            unsigned int texture = context.getTexture(source);
+
+            switch (effect)
+            {
+            case POST_TONEMAP:
+                if (!tonemapShader)
+                    return;
+                useShader(tonemapShader.get(), texture);
+                tonemapShader->setFloat("exposure", settings.exposure);
+                tonemapShader->setFloat("bloomIntensity", bloom.isValid() ? settings.bloomIntensity : 0.0f);
+                tonemapShader->setInt("bloom", 1);
+                gl->glActiveTexture(GL_TEXTURE1);
+                glBindTexture(GL_TEXTURE_2D, bloom.isValid() ? context.getTexture(bloom) : 0);
+                gl->glActiveTexture(GL_TEXTURE0);
+                break;
+
+            case POST_COLOR_GRADE:
+                if (!gradeShader)
+                    return;
+                useShader(gradeShader.get(), texture);
+                gradeShader->setVec4("lift", vec4(settings.lift, 0.0f));
+                gradeShader->setVec4("gamma", vec4(settings.gamma, 1.0f));
+                gradeShader->setVec4("gain", vec4(settings.gain, 1.0f));
+                gradeShader->setFloat("saturation", settings.saturation);
+                break;
+
+            case POST_FXAA:
+                if (!fxaaShader)
+                    return;
+                useShader(fxaaShader.get(), texture);
+                fxaaShader->setVec2("texelSize", TexelSize(context.getDesc(source)));
+                break;
+
+            default:
+                return;
+            }
+
+            drawFullscreen();
+        });
+
+    return written;
+}
+
+void PostProcessStack::addPasses(RenderGraph *graph, RenderResource scene, RenderResource output)
+{
+    RenderTargetDesc outputDesc = graph->getDesc(output);
+
+    PostEffect chain[POST_EFFECT_COUNT];
+    int count = 0;
+    for (int effect = POST_TONEMAP; effect < POST_EFFECT_COUNT; effect++)
+    {
+        if (effects[effect].enabled)
+            chain[count++] = (PostEffect)effect;
+    }
+
+    RenderResource bloom;
+    if (effects[POST_BLOOM].enabled && effects[POST_TONEMAP].enabled)
+        bloom = addBloom(graph, scene, outputDesc);
+
+    RenderResource current = scene;
+    bool presented = false;
+    for (int i = 0; i < count; i++)
+    {
+        PostEffect effect = chain[i];
+
+        // Once tone mapped, colours fit in 8 bits
+        RenderFormat format = effects[POST_TONEMAP].enabled ? RENDER_FORMAT_RGBA8 : RENDER_FORMAT_RGBA16F;
+        RenderTargetDesc desc = ScaledDesc(outputDesc, effects[effect].scale, format);
+
+        // The last effect can skip the copy at the end if it is full size
+        RenderResource target;
+        if (i == count - 1 && desc.width == outputDesc.width && desc.height == outputDesc.height)
+        {
+            target = output;
+            presented = true;
+        }
+
+        current = addEffect(graph, effect, current, effect == POST_TONEMAP ? bloom : RenderResource(), target, desc);
+    }
+
+    if (presented)
+        return;
+
+    graph->addPass("post output",
+        [&](RenderPassBuilder &builder) {
+            builder.read(current);
+            builder.write(output, RENDER_LOAD_ANY);
+        },
+        [current](RenderPassContext &context) {
+            context.blit(current);
+        });
+}
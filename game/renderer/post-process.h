@@ -0,0 +1,92 @@
+#pragma once
+
+#include "../../engine/opengl.h"
+#include "../../engine/assets/asset-cache.h"
+#include "../../engine/math/vec.h"
+#include "assets.h"
+#include "gpu-resources.h"
+#include "gpu-timer.h"
+#include "render-graph.h"
+
+// In the order they run
+enum PostEffect
+{
+    POST_BLOOM,       // bright parts bleed into their surroundings
+    POST_TONEMAP,     // HDR to displayable colour, bloom added in
+    POST_COLOR_GRADE, // lift, gamma, gain and saturation
+    POST_FXAA,        // smooths edges found in the final image
+    POST_EFFECT_COUNT
+};
+
+struct PostEffectConfig
+{
+    bool enabled = true;
+
+    // Of the output's resolution. The effect renders at this size and the
+    // next one filters it up or down as it reads it, so turning an effect
+    // down saves fill rate at the cost of sharpness.
+    float scale = 1.0f;
+};
+
+struct PostProcessSettings
+{
+    float exposure = 1.0f;
+
+    float bloomThreshold = 0.8f; // brightest channel above which pixels bloom
+    float bloomIntensity = 0.6f;
+
+    vec3 lift = vec3(0.0f);
+    vec3 gamma = vec3(1.0f);
+    vec3 gain = vec3(1.0f);
+    float saturation = 1.0f;
+};
+
+// Tone mapping, bloom, colour grading and FXAA as render graph passes, so
+// their intermediate targets come from the graph's pool and share memory
+// with one another and with the rest of the frame.
+//
+// The last effect writes straight to the output when it runs at full
+// resolution; otherwise its result is blitted there. Each effect is timed
+// on the GPU as "gpu <effect>".
+//
+// Bloom needs tone mapping to be composited, so it is skipped when tone
+// mapping is off.
+class PostProcessStack
+{
+private:
+    OpenGL *gl;
+    GpuResources *resources;
+    GpuTimer *timer;
+
+    ShaderHandle extractShader;
+    ShaderHandle blurShader;
+    ShaderHandle tonemapShader;
+    ShaderHandle gradeShader;
+    ShaderHandle fxaaShader;
+    VertexArrayHandle fullscreenVertexArray; // fullscreen.vert needs no attributes, only some array bound
+
+    PostEffectConfig effects[POST_EFFECT_COUNT];
+
+    // Binds the shader, with 'source' on texture unit 0; set its uniforms,
+    // then draw
+    void useShader(const Shader *shader, unsigned int source);
+    void drawFullscreen();
+
+    RenderResource addBloom(RenderGraph *graph, RenderResource scene, const RenderTargetDesc &output);
+    RenderResource addEffect(RenderGraph *graph, PostEffect effect, RenderResource source, RenderResource bloom,
+                             RenderResource output, const RenderTargetDesc &desc);
+
+public:
+    PostProcessSettings settings;
+
+    PostProcessStack(OpenGL *gl, GpuResources *resources, AssetCache *assets, GpuTimer *timer);
+    ~PostProcessStack();
+
+    PostEffectConfig &getEffect(PostEffect effect) { return effects[effect]; }
+
+    // Adds the passes taking 'scene', in HDR, to 'output'
+    void addPasses(RenderGraph *graph, RenderResource scene, RenderResource output);
+
+    // GPU milliseconds an effect took, or nullptr if it has not been timed
+    const ProfileStat *getTime(PostEffect effect) const;
+};
@@ -0,0 +1,592 @@
+#include "render-graph.h"
+
+#include <algorithm>
+
+static GLenum InternalFormat(RenderFormat format)
+{
+    switch (format)
+    {
+    case RENDER_FORMAT_RGBA16F:
+        return GL_RGBA16F;
+    case RENDER_FORMAT_R11G11B10F:
+        return GL_R11F_G11F_B10F;
+    case RENDER_FORMAT_DEPTH24:
+        return GL_DEPTH_COMPONENT24;
+    case RENDER_FORMAT_DEPTH32F:
+        return GL_DEPTH_COMPONENT32F;
+    case RENDER_FORMAT_RGBA8:
+    default:
+        return GL_RGBA8;
+    }
+}
+
+static bool IsDepthFormat(RenderFormat format)
+{
+    return format == RENDER_FORMAT_DEPTH24 || format == RENDER_FORMAT_DEPTH32F;
+}
+
+size_t RenderFormatSize(RenderFormat format)
+{
+    return format == RENDER_FORMAT_RGBA16F ? 8 : 4;
+}
+
+static size_t TargetBytes(const RenderTargetDesc &desc)
+{
+    return (size_t)desc.width * desc.height * RenderFormatSize(desc.format);
+}
+
+// Texture and renderbuffer names are separate namespaces, so framebuffer
+// keys tell them apart
+static uint64_t AttachmentKey(unsigned int name, bool renderbuffer)
+{
+    return (uint64_t)name << 1 | (renderbuffer ? 1 : 0);
+}
+
+RenderResource RenderPassBuilder::create(const char *name, const RenderTargetDesc &desc)
+{
+    RenderResource resource;
+    resource.version = graph->addVersion(graph->addResource(name, desc, false, false, 0), -1, -1);
+    return resource;
+}
+
+RenderResource RenderPassBuilder::read(RenderResource resource)
+{
+    graph->passes[pass].reads.push_back(resource.version);
+    graph->versions[resource.version].readers.push_back(pass);
+    graph->resourceList[graph->versions[resource.version].resource].sampled = true;
+    return resource;
+}
+
+RenderResource RenderPassBuilder::write(RenderResource resource, RenderLoad load)
+{
+    // Keeping the old contents is reading them, though not sampling them
+    if (load == RENDER_LOAD_KEEP)
+    {
+        graph->passes[pass].reads.push_back(resource.version);
+        graph->versions[resource.version].readers.push_back(pass);
+    }
+
+    int index = graph->versions[resource.version].resource;
+    RenderResource written;
+    written.version = graph->addVersion(index, pass, resource.version);
+
+    RenderGraph::Pass &p = graph->passes[pass];
+    if (IsDepthFormat(graph->resourceList[index].desc.format))
+        p.depth = RenderGraph::Attachment{ written.version, load };
+    else
+        p.colors.push_back(RenderGraph::Attachment{ written.version, load });
+    return written;
+}
+
+void RenderPassBuilder::setClearColor(const vec4 &color)
+{
+    graph->passes[pass].clearColor = color;
+}
+
+void RenderPassBuilder::setSideEffect()
+{
+    graph->passes[pass].sideEffect = true;
+}
+
+unsigned int RenderPassContext::getTexture(RenderResource resource) const
+{
+    return graph->resourceList[graph->versions[resource.version].resource].texture;
+}
+
+const RenderTargetDesc &RenderPassContext::getDesc(RenderResource resource) const
+{
+    return graph->getDesc(resource);
+}
+
+void RenderPassContext::blit(RenderResource source)
+{
+    graph->blit(source.version);
+}
+
+RenderGraph::RenderGraph(Platform *platform, OpenGL *gl, GpuResources *resources)
+{
+    this->platform = platform;
+    this->gl = gl;
+    this->resources = resources;
+}
+
+RenderGraph::~RenderGraph()
+{
+    for (auto &pair : framebuffers)
+        resources->destroy(pair.second);
+    for (Target &target : targets)
+    {
+        resources->destroy(target.texture);
+        resources->destroy(target.renderbuffer);
+    }
+}
+
+void RenderGraph::reset()
+{
+    resourceList.clear();
+    versions.clear();
+    passes.clear();
+    order.clear();
+}
+
+int RenderGraph::addResource(const char *name, const RenderTargetDesc &desc, bool imported, bool backbuffer, unsigned int texture)
+{
+    resourceList.push_back(Resource{ name, desc, imported, backbuffer, texture, 0, false, -1, -1, -1 });
+    return (int)resourceList.size() - 1;
+}
+
+int RenderGraph::addVersion(int resource, int producer, int previous)
+{
+    versions.push_back(Version{ resource, producer, previous, {} });
+    return (int)versions.size() - 1;
+}
+
+RenderResource RenderGraph::importBackbuffer(const char *name, int width, int height)
+{
+    RenderResource resource;
+    resource.version = addVersion(addResource(name, RenderTargetDesc{ width, height, RENDER_FORMAT_RGBA8 }, true, true, 0), -1, -1);
+    return resource;
+}
+
+RenderResource RenderGraph::importTexture(const char *name, const RenderTargetDesc &desc, unsigned int texture)
+{
+    RenderResource resource;
+    resource.version = addVersion(addResource(name, desc, true, false, texture), -1, -1);
+    return resource;
+}
+
+void RenderGraph::addPass(const char *name, RenderPassSetup setup, RenderPassExecute execute)
+{
+    Pass pass;
+    pass.name = name;
+    pass.execute = execute;
+    pass.depth = Attachment{ -1, RENDER_LOAD_ANY };
+    pass.clearColor = vec4(0.0f);
+    pass.sideEffect = false;
+    pass.live = false;
+    passes.push_back(pass);
+
+    RenderPassBuilder builder(this, (int)passes.size() - 1);
+    setup(builder);
+}
+
+const RenderTargetDesc &RenderGraph::getDesc(RenderResource resource) const
+{
+    return resourceList[versions[resource.version].resource].desc;
+}
+
+// A pass is needed if it writes something that outlives the frame (an
+// imported resource), has side effects, or feeds a pass that is needed
+void RenderGraph::cull()
+{
+    std::vector<int> work;
+    for (int i = 0; i < (int)passes.size(); i++)
+    {
+        Pass &pass = passes[i];
+        pass.live = pass.sideEffect;
+        for (const Attachment &color : pass.colors)
+            pass.live |= resourceList[versions[color.version].resource].imported;
+        if (pass.depth.version >= 0)
+            pass.live |= resourceList[versions[pass.depth.version].resource].imported;
+
+        if (pass.live)
+            work.push_back(i);
+    }
+
+    while (!work.empty())
+    {
+        Pass &pass = passes[work.back()];
+        work.pop_back();
+
+        for (int version : pass.reads)
+        {
+            int producer = versions[version].producer;
+            if (producer >= 0 && !passes[producer].live)
+            {
+                passes[producer].live = true;
+                work.push_back(producer);
+            }
+        }
+    }
+}
+
+// Topological order of the live passes. A pass comes after the producers
+// of what it reads, and after every reader and the producer of what it
+// writes over.
+bool RenderGraph::sort()
+{
+    int count = (int)passes.size();
+    std::vector<std::vector<int>> edges(count);
+    std::vector<int> incoming(count, 0);
+
+    auto addEdge = [&](int from, int to) {
+        if (from < 0 || from == to || !passes[from].live)
+            return;
+        edges[from].push_back(to);
+        incoming[to]++;
+    };
+
+    for (int i = 0; i < count; i++)
+    {
+        const Pass &pass = passes[i];
+        if (!pass.live)
+            continue;
+
+        for (int version : pass.reads)
+            addEdge(versions[version].producer, i);
+
+        std::vector<Attachment> writes = pass.colors;
+        if (pass.depth.version >= 0)
+            writes.push_back(pass.depth);
+        for (const Attachment &write : writes)
+        {
+            int previous = versions[write.version].previous;
+            if (previous < 0)
+                continue;
+            addEdge(versions[previous].producer, i);
+            for (int reader : versions[previous].readers)
+                addEdge(reader, i);
+        }
+    }
+
+    std::vector<int> ready;
+    int live = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (!passes[i].live)
+            continue;
+        live++;
+        if (incoming[i] == 0)
+            ready.push_back(i);
+    }
+
+    // Of the passes that are ready, run the one whose inputs were made
+    // most recently, so what one pass produces is consumed right away and
+    // its target freed for the next. Declaration order breaks ties.
+    std::vector<int> position(count, -1);
+    order.clear();
+    while (!ready.empty())
+    {
+        size_t best = 0;
+        int bestInput = -2;
+        for (size_t r = 0; r < ready.size(); r++)
+        {
+            int latestInput = -1;
+            for (int version : passes[ready[r]].reads)
+            {
+                int producer = versions[version].producer;
+                if (producer >= 0)
+                    latestInput = std::max(latestInput, position[producer]);
+            }
+            if (latestInput > bestInput || (latestInput == bestInput && ready[r] < ready[best]))
+            {
+                best = r;
+                bestInput = latestInput;
+            }
+        }
+
+        int pass = ready[best];
+        ready.erase(ready.begin() + best);
+        position[pass] = (int)order.size();
+        order.push_back(pass);
+
+        for (int next : edges[pass])
+        {
+            if (--incoming[next] == 0)
+                ready.push_back(next);
+        }
+    }
+
+    if ((int)order.size() == live)
+        return true;
+
+    // The builder only hands out versions that already exist, so this
+    // should not happen; run them as declared rather than not at all
+    order.clear();
+    for (int i = 0; i < count; i++)
+    {
+        if (passes[i].live)
+            order.push_back(i);
+    }
+    return false;
+}
+
+void RenderGraph::computeLifetimes()
+{
+    for (int position = 0; position < (int)order.size(); position++)
+    {
+        const Pass &pass = passes[order[position]];
+
+        auto touch = [&](int version) {
+            Resource &resource = resourceList[versions[version].resource];
+            if (resource.firstPass < 0)
+                resource.firstPass = position;
+            resource.lastPass = position;
+        };
+
+        for (int version : pass.reads)
+            touch(version);
+        for (const Attachment &color : pass.colors)
+            touch(color.version);
+        if (pass.depth.version >= 0)
+            touch(pass.depth.version);
+    }
+}
+
+int RenderGraph::acquireTarget(const RenderTargetDesc &desc, bool renderbuffer)
+{
+    for (int i = 0; i < (int)targets.size(); i++)
+    {
+        Target &target = targets[i];
+        if (!target.inUse && target.desc == desc && (bool)target.renderbuffer == renderbuffer)
+        {
+            target.inUse = true;
+            target.idleFrames = -1; // used this frame
+            return i;
+        }
+    }
+
+    Target target;
+    target.desc = desc;
+    target.inUse = true;
+    target.idleFrames = -1;
+
+    // Cheaper to make, and the driver may keep it somewhere faster
+    if (renderbuffer)
+    {
+        target.renderbuffer = resources->createRenderbuffer();
+        gl->glBindRenderbuffer(GL_RENDERBUFFER, resources->get(target.renderbuffer));
+        gl->glRenderbufferStorage(GL_RENDERBUFFER, InternalFormat(desc.format), desc.width, desc.height);
+        gl->glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        targets.push_back(target);
+        return (int)targets.size() - 1;
+    }
+
+    target.texture = resources->createTexture();
+    glBindTexture(GL_TEXTURE_2D, resources->get(target.texture));
+    gl->glTexStorage2D(GL_TEXTURE_2D, 1, InternalFormat(desc.format), desc.width, desc.height);
+    GLint filter = IsDepthFormat(desc.format) ? GL_NEAREST : GL_LINEAR;
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    targets.push_back(target);
+    return (int)targets.size() - 1;
+}
+
+void RenderGraph::releaseTarget(int target)
+{
+    targets[target].inUse = false;
+}
+
+// Frees targets that have sat idle for a while, with any framebuffers
+// that use them
+void RenderGraph::trimTargets()
+{
+    for (size_t i = 0; i < targets.size();)
+    {
+        Target &target = targets[i];
+        if (++target.idleFrames <= RENDER_TARGET_MAX_IDLE_FRAMES)
+        {
+            i++;
+            continue;
+        }
+
+        uint64_t key = target.renderbuffer ? AttachmentKey(resources->get(target.renderbuffer), true)
+                                           : AttachmentKey(resources->get(target.texture), false);
+        for (auto it = framebuffers.begin(); it != framebuffers.end();)
+        {
+            if (std::find(it->first.begin(), it->first.end(), key) != it->first.end())
+            {
+                resources->destroy(it->second);
+                it = framebuffers.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        resources->destroy(target.texture);
+        resources->destroy(target.renderbuffer);
+        targets.erase(targets.begin() + i);
+    }
+}
+
+// Framebuffers are cached by their attachments, colour attachments
+// first, then 0, then the depth attachment
+unsigned int RenderGraph::getFramebuffer(const std::vector<int> &colors, int depth, const char *name)
+{
+    std::vector<uint64_t> key;
+    for (int version : colors)
+    {
+        const Resource &resource = resourceList[versions[version].resource];
+        if (resource.backbuffer)
+            return 0;
+        key.push_back(resource.renderbuffer ? AttachmentKey(resource.renderbuffer, true) : AttachmentKey(resource.texture, false));
+    }
+    key.push_back(0);
+    if (depth >= 0)
+    {
+        const Resource &resource = resourceList[versions[depth].resource];
+        key.push_back(resource.renderbuffer ? AttachmentKey(resource.renderbuffer, true) : AttachmentKey(resource.texture, false));
+    }
+
+    auto found = framebuffers.find(key);
+    if (found != framebuffers.end())
+        return resources->get(found->second);
+
+    FramebufferHandle handle = resources->createFramebuffer();
+    unsigned int framebuffer = resources->get(handle);
+    gl->glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+    auto attach = [&](GLenum attachment, uint64_t entry) {
+        unsigned int object = (unsigned int)(entry >> 1);
+        if (entry & 1)
+            gl->glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment, GL_RENDERBUFFER, object);
+        else
+            gl->glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, object, 0);
+    };
+
+    std::vector<GLenum> drawBuffers;
+    for (size_t i = 0; i < colors.size(); i++)
+    {
+        attach(GL_COLOR_ATTACHMENT0 + (GLenum)i, key[i]);
+        drawBuffers.push_back(GL_COLOR_ATTACHMENT0 + (GLenum)i);
+    }
+    if (depth >= 0)
+        attach(GL_DEPTH_ATTACHMENT, key.back());
+
+    if (drawBuffers.empty())
+        glDrawBuffer(GL_NONE);
+    else
+        gl->glDrawBuffers((GLsizei)drawBuffers.size(), drawBuffers.data());
+
+    GLenum status = gl->glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+        platform->Log("Error: Framebuffer for pass '%s' is incomplete (0x%x)\n", name, status);
+
+    framebuffers[key] = handle;
+    return framebuffer;
+}
+
+void RenderGraph::beginPass(const Pass &pass)
+{
+    // Compute passes and the like have nothing to bind
+    if (pass.colors.empty() && pass.depth.version < 0)
+        return;
+
+    std::vector<int> colors;
+    for (const Attachment &color : pass.colors)
+        colors.push_back(color.version);
+    currentFramebuffer = getFramebuffer(colors, pass.depth.version, pass.name);
+    gl->glBindFramebuffer(GL_FRAMEBUFFER, currentFramebuffer);
+
+    int version = pass.colors.empty() ? pass.depth.version : pass.colors[0].version;
+    const RenderTargetDesc &desc = resourceList[versions[version].resource].desc;
+    glViewport(0, 0, desc.width, desc.height);
+
+    for (size_t i = 0; i < pass.colors.size(); i++)
+    {
+        if (pass.colors[i].load == RENDER_LOAD_CLEAR)
+            gl->glClearBufferfv(GL_COLOR, (GLint)i, &pass.clearColor.x);
+    }
+    if (pass.depth.version >= 0 && pass.depth.load == RENDER_LOAD_CLEAR)
+    {
+        float depth = 1.0f;
+        glDepthMask(GL_TRUE);
+        gl->glClearBufferfv(GL_DEPTH, 0, &depth);
+    }
+}
+
+void RenderGraph::blit(int version)
+{
+    const Pass &pass = passes[currentPass];
+    if (pass.colors.empty())
+    {
+        platform->Log("Error: Pass '%s' blits without a colour attachment\n", pass.name);
+        return;
+    }
+
+    const RenderTargetDesc &from = resourceList[versions[version].resource].desc;
+    const RenderTargetDesc &to = resourceList[versions[pass.colors[0].version].resource].desc;
+
+    // The source's own framebuffer, as a pass writing only it would have
+    unsigned int source = getFramebuffer(std::vector<int>{ version }, -1, pass.name);
+    gl->glBindFramebuffer(GL_READ_FRAMEBUFFER, source);
+    gl->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, currentFramebuffer);
+
+    GLenum filter = (from.width == to.width && from.height == to.height) ? GL_NEAREST : GL_LINEAR;
+    gl->glBlitFramebuffer(0, 0, from.width, from.height, 0, 0, to.width, to.height, GL_COLOR_BUFFER_BIT, filter);
+
+    gl->glBindFramebuffer(GL_FRAMEBUFFER, currentFramebuffer);
+}
+
+void RenderGraph::execute()
+{
+    cull();
+    if (!sort())
+        platform->Log("Error: Render graph has a cycle; running passes in declaration order\n");
+    computeLifetimes();
+
+    // Which transients start and end at each pass
+    std::vector<std::vector<int>> starts(order.size()), ends(order.size());
+    stats = RenderGraphStats();
+    for (int i = 0; i < (int)resourceList.size(); i++)
+    {
+        const Resource &resource = resourceList[i];
+        if (resource.imported)
+            continue;
+        stats.transients++;
+        if (resource.firstPass < 0)
+            continue;
+
+        starts[resource.firstPass].push_back(i);
+        ends[resource.lastPass].push_back(i);
+        stats.unaliasedBytes += TargetBytes(resource.desc);
+    }
+
+    for (int position = 0; position < (int)order.size(); position++)
+    {
+        for (int index : starts[position])
+        {
+            Resource &resource = resourceList[index];
+            resource.target = acquireTarget(resource.desc, !resource.sampled);
+            resource.texture = resources->get(targets[resource.target].texture);
+            resource.renderbuffer = resources->get(targets[resource.target].renderbuffer);
+        }
+
+        currentPass = order[position];
+        const Pass &pass = passes[currentPass];
+        beginPass(pass);
+        RenderPassContext context(this);
+        pass.execute(context);
+
+        // Free for the next transient of the same shape
+        for (int index : ends[position])
+            releaseTarget(resourceList[index].target);
+    }
+
+    gl->glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    currentPass = -1;
+    currentFramebuffer = 0;
+
+    stats.passes = (int)passes.size();
+    stats.culledPasses = (int)(passes.size() - order.size());
+    for (const Target &target : targets)
+    {
+        if (target.idleFrames < 0)
+        {
+            stats.targets++;
+            if (target.renderbuffer)
+                stats.renderbuffers++;
+            stats.transientBytes += TargetBytes(target.desc);
+        }
+        stats.pooledBytes += TargetBytes(target.desc);
+    }
+
+    trimTargets();
+}
@@ -0,0 +1,257 @@
+#pragma once
+
+#include "../../engine/opengl.h"
+#include "../../engine/platform.h"
+#include "../../engine/math/vec.h"
+#include "gpu-resources.h"
+
+#include <functional>
+#include <map>
+#include <stdint.h>
+#include <vector>
+
+// Frames a render target stays in the pool unused before it is freed, so
+// a resize or a pass that is switched off does not hold memory for long
+#define RENDER_TARGET_MAX_IDLE_FRAMES 3
+
+enum RenderFormat
+{
+    RENDER_FORMAT_RGBA8,
+    RENDER_FORMAT_RGBA16F,
+    RENDER_FORMAT_R11G11B10F,
+    RENDER_FORMAT_DEPTH24,
+    RENDER_FORMAT_DEPTH32F
+};
+
+struct RenderTargetDesc
+{
+    int width;
+    int height;
+    RenderFormat format;
+
+    bool operator==(const RenderTargetDesc &other) const
+    {
+        return width == other.width && height == other.height && format == other.format;
+    }
+};
+
+// What a pass does with an attachment's previous contents
+enum RenderLoad
+{
+    RENDER_LOAD_KEEP,  // draws on top of them; depends on whoever wrote them
+    RENDER_LOAD_CLEAR, // clears first, to the pass's clear colour or depth 1
+    RENDER_LOAD_ANY    // overwrites every pixel, so never mind
+};
+
+// One version of a resource in the graph. Every write makes a new
+// version, so each version has a single pass that produces it and the
+// graph can tell exactly who depends on whom.
+struct RenderResource
+{
+    int version = -1;
+
+    bool isValid() const { return version >= 0; }
+};
+
+class RenderGraph;
+
+// Handed to a pass's setup function to declare what it uses
+class RenderPassBuilder
+{
+private:
+    RenderGraph *graph;
+    int pass;
+
+public:
+    RenderPassBuilder(RenderGraph *graph, int pass) : graph(graph), pass(pass) {}
+
+    // A render target that only lives within the frame. Its memory comes
+    // from a pool and is shared with other transients whose lifetimes do
+    // not overlap, so its contents are undefined until written.
+    RenderResource create(const char *name, const RenderTargetDesc &desc);
+
+    // Sampled as a texture, or the source of RenderPassContext::blit. A
+    // transient nothing reads this way is given a renderbuffer rather
+    // than a texture.
+    RenderResource read(RenderResource resource);
+
+    // Rendered to as an attachment: colour attachments in the order they
+    // are written, or the depth attachment for depth formats. Returns the
+    // new version, which later passes read or write in turn.
+    RenderResource write(RenderResource resource, RenderLoad load = RENDER_LOAD_KEEP);
+
+    void setClearColor(const vec4 &color);
+
+    // Runs even if nothing reads its output, e.g. for readbacks
+    void setSideEffect();
+};
+
+// Handed to a pass's execute function; the pass's framebuffer is already
+// bound, cleared as requested and the viewport set
+class RenderPassContext
+{
+private:
+    RenderGraph *graph;
+
+public:
+    explicit RenderPassContext(RenderGraph *graph) : graph(graph) {}
+
+    // GL texture name behind a resource the pass declared
+    unsigned int getTexture(RenderResource resource) const;
+    const RenderTargetDesc &getDesc(RenderResource resource) const;
+
+    // Copies a colour resource the pass reads over the whole of its first
+    // colour attachment, filtering linearly if the sizes differ
+    void blit(RenderResource source);
+};
+
+struct RenderGraphStats
+{
+    int passes;
+    int culledPasses;
+    int transients;        // declared this frame
+    int targets;           // textures they were given; fewer is aliasing
+    int renderbuffers;     // of those, renderbuffers for the never sampled
+    size_t transientBytes; // held by those textures
+    size_t unaliasedBytes; // what one texture per transient would have taken
+    size_t pooledBytes;    // everything in the pool, in use or idle
+};
+
+typedef std::function<void(RenderPassBuilder &builder)> RenderPassSetup;
+typedef std::function<void(RenderPassContext &context)> RenderPassExecute;
+
+// Builds each frame from scratch as a list of passes and the render
+// targets they read and write, then works out what actually has to run:
+//
+//   - passes whose output nothing uses are culled
+//   - the rest are ordered by their dependencies, running each consumer
+//     as soon as its inputs are ready so transients live no longer than
+//     they have to; passes must declare everything they depend on
+//   - transient targets get a texture from a pool for just the span of
+//     passes that use them; a texture freed by one transient is handed to
+//     the next with the same size and format, so targets alias one
+//     another over the frame rather than each having its own. Transients
+//     that are only ever attached, like most depth buffers, get
+//     renderbuffers instead.
+//   - framebuffers for each combination of attachments are cached
+//
+// Usage, once a frame:
+//
+//     graph->reset();
+//     RenderResource backbuffer = graph->importBackbuffer("backbuffer", width, height);
+//     graph->addPass("scene", setup, execute);
+//     ...
+//     graph->execute();
+class RenderGraph
+{
+private:
+    OpenGL *gl;
+    Platform *platform;
+    GpuResources *resources;
+
+    friend class RenderPassBuilder;
+    friend class RenderPassContext;
+
+    struct Resource
+    {
+        const char *name;
+        RenderTargetDesc desc;
+        bool imported;
+        bool backbuffer;
+        unsigned int texture;  // imported, or assigned while executing
+        unsigned int renderbuffer; // assigned instead if never sampled
+        bool sampled;
+        int target;            // index into 'targets' while assigned, else -1
+        int firstPass, lastPass; // in execution order, among live passes
+    };
+
+    struct Version
+    {
+        int resource;
+        int producer; // pass, or -1 for a created or imported resource
+        int previous; // version this one was written over, or -1
+        std::vector<int> readers;
+    };
+
+    struct Attachment
+    {
+        int version; // the one written
+        RenderLoad load;
+    };
+
+    struct Pass
+    {
+        const char *name;
+        RenderPassExecute execute;
+        std::vector<int> reads;          // versions
+        std::vector<Attachment> colors;
+        Attachment depth;
+        vec4 clearColor;
+        bool sideEffect;
+        bool live;
+    };
+
+    // Pooled textures and renderbuffers, kept across frames
+    struct Target
+    {
+        RenderTargetDesc desc;
+        TextureHandle texture;
+        RenderbufferHandle renderbuffer; // instead of the texture
+        bool inUse;
+        int idleFrames;
+    };
+
+    std::vector<Resource> resourceList;
+    std::vector<Version> versions;
+    std::vector<Pass> passes;
+    std::vector<int> order; // live passes, in execution order
+
+    std::vector<Target> targets;
+    std::map<std::vector<uint64_t>, FramebufferHandle> framebuffers;
+    int currentPass = -1;
+    unsigned int currentFramebuffer = 0;
+
+    RenderGraphStats stats = {};
+
+    int addResource(const char *name, const RenderTargetDesc &desc, bool imported, bool backbuffer, unsigned int texture);
+    int addVersion(int resource, int producer, int previous);
+
+    void cull();
+    bool sort();
+    void computeLifetimes();
+
+    int acquireTarget(const RenderTargetDesc &desc, bool renderbuffer);
+    void releaseTarget(int target);
+    void trimTargets();
+
+    void beginPass(const Pass &pass);
+    unsigned int getFramebuffer(const std::vector<int> &colors, int depth, const char *name);
+    void blit(int version);
+
+public:
+    RenderGraph(Platform *platform, OpenGL *gl, GpuResources *resources);
+    ~RenderGraph();
+
+    // Forgets the previous frame's passes and resources; the pool and
+    // framebuffer cache are kept
+    void reset();
+
+    // The window's framebuffer. A pass writing it may not write anything
+    // else.
+    RenderResource importBackbuffer(const char *name, int width, int height);
+
+    // A texture owned elsewhere that passes read or render to
+    RenderResource importTexture(const char *name, const RenderTargetDesc &desc, unsigned int texture);
+
+    void addPass(const char *name, RenderPassSetup setup, RenderPassExecute execute);
+
+    const RenderTargetDesc &getDesc(RenderResource resource) const;
+
+    // Culls, orders, assigns targets and runs the passes
+    void execute();
+
+    const RenderGraphStats &getStats() const { return stats; }
+};
+
+// Bytes per pixel of a format
+size_t RenderFormatSize(RenderFormat format);
@@ -1,11 +1,16 @@
 #include "shader.h"
 
 #include "../../engine/platform.h"
+#include "uniforms.h"
 
-Shader::Shader(Platform *platform, OpenGL *gl, std::string vertexData, std::string fragmentData)
+#include <algorithm>
+#include <string.h>
+
+Shader::Shader(Platform *platform, OpenGL *gl, GpuResources *resources, const std::string &vertexData, const std::string &fragmentData)
 {
     this->platform = platform;
     this->gl = gl;
+    this->resources = resources;
 
     const char *vertexSource = vertexData.c_str();
     const char *fragmentSource = fragmentData.c_str();
@@ -39,7 +44,8 @@ Shader::Shader(Platform *platform, OpenGL *gl, std::string vertexData, std::stri
     }
 
     // Link Shaders
-    shaderId = gl->glCreateProgram();
+    program = resources->createProgram();
+    shaderId = resources->get(program);
     gl->glAttachShader(shaderId, vertexShader);
     gl->glAttachShader(shaderId, fragmentShader);
     gl->glLinkProgram(shaderId);
@@ -51,23 +57,144 @@ Shader::Shader(Platform *platform, OpenGL *gl, std::string vertexData, std::stri
         gl->glGetProgramInfoLog(shaderId, 512, NULL, infoLog);
         platform->Log("Error: Shader Program Linking Failed\n%s\n", infoLog);
     }
+    linked = success;
 
     // Cleanup
     gl->glDeleteShader(vertexShader);
     gl->glDeleteShader(fragmentShader);
+
+    findUniforms();
+    bindSharedBlocks();
+}
+
+Shader::Shader(Platform *platform, OpenGL *gl, GpuResources *resources, const std::string &computeData)
+{
+    this->platform = platform;
+    this->gl = gl;
+    this->resources = resources;
+
+    const char *computeSource = computeData.c_str();
+
+    // Setup Compute Shader
+    unsigned int computeShader = gl->glCreateShader(GL_COMPUTE_SHADER);
+    gl->glShaderSource(computeShader, 1, &computeSource, NULL);
+    gl->glCompileShader(computeShader);
+
+    // Check for errors
+    int success;
+    char infoLog[512];
+    gl->glGetShaderiv(computeShader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        gl->glGetShaderInfoLog(computeShader, 512, NULL, infoLog);
+        platform->Log("Error: Compute Shader Compilation Failed\n%s\n", infoLog);
+    }
+
+    // Link Shader
+    program = resources->createProgram();
+    shaderId = resources->get(program);
+    gl->glAttachShader(shaderId, computeShader);
+    gl->glLinkProgram(shaderId);
+
+    // Check for errors
+    gl->glGetProgramiv(shaderId, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        gl->glGetProgramInfoLog(shaderId, 512, NULL, infoLog);
+        platform->Log("Error: Shader Program Linking Failed\n%s\n", infoLog);
+    }
+    linked = success;
+
+    // Cleanup
+    gl->glDeleteShader(computeShader);
+
+    findUniforms();
+    bindSharedBlocks();
+}
+
+Shader::~Shader()
+{
+    resources->destroy(program);
+}
+
+void Shader::bindSharedBlocks()
+{
+    bindUniformBlock("Frame", UNIFORM_BINDING_FRAME);
+    bindUniformBlock("Camera", UNIFORM_BINDING_CAMERA);
+    bindUniformBlock("Draw", UNIFORM_BINDING_DRAW);
+    bindUniformBlock("Lighting", UNIFORM_BINDING_LIGHTING);
+    bindUniformBlock("DirectionalLight", UNIFORM_BINDING_DIRECTIONAL_LIGHT);
+    bindUniformBlock("Particles", UNIFORM_BINDING_PARTICLES);
+}
+
+void Shader::findUniforms()
+{
+    int count = 0;
+    gl->glGetProgramiv(shaderId, GL_ACTIVE_UNIFORMS, &count);
+
+    for (int i = 0; i < count; i++)
+    {
+        char name[256];
+        GLsizei length = 0;
+        GLint size;
+        GLenum type;
+        gl->glGetActiveUniform(shaderId, (GLuint)i, sizeof(name), &length, &size, &type, name);
+
+        // Block members have no location of their own
+        int location = gl->glGetUniformLocation(shaderId, name);
+        if (location < 0)
+            continue;
+
+        // Arrays are reported as "name[0]"; look them up as "name"
+        if (length > 3 && strcmp(name + length - 3, "[0]") == 0)
+            length -= 3;
+
+        uniforms.push_back(Uniform{ StringId(name, (size_t)length), location });
+    }
+
+    std::sort(uniforms.begin(), uniforms.end(), [](const Uniform &a, const Uniform &b) { return a.name < b.name; });
 }
 
-void Shader::setBool(const std::string &name, bool value) const
-{         
-    gl->glUniform1i(gl->glGetUniformLocation(shaderId, name.c_str()), (int)value); 
+int Shader::getUniformLocation(StringId name) const
+{
+    auto found = std::lower_bound(uniforms.begin(), uniforms.end(), name,
+                                  [](const Uniform &uniform, StringId name) { return uniform.name < name; });
+    if (found == uniforms.end() || found->name != name)
+        return -1;
+    return found->location;
 }
 
-void Shader::setInt(const std::string &name, int value) const
-{ 
-    gl->glUniform1i(gl->glGetUniformLocation(shaderId, name.c_str()), value); 
+void Shader::setBool(StringId name, bool value) const
+{
+    gl->glUniform1i(getUniformLocation(name), (int)value);
 }
 
-void Shader::setFloat(const std::string &name, float value) const
-{ 
-    gl->glUniform1f(gl->glGetUniformLocation(shaderId, name.c_str()), value); 
-} 
\ No newline at end of file
+void Shader::setInt(StringId name, int value) const
+{
+    gl->glUniform1i(getUniformLocation(name), value);
+}
+
+void Shader::setFloat(StringId name, float value) const
+{
+    gl->glUniform1f(getUniformLocation(name), value);
+}
+
+void Shader::setVec2(StringId name, const vec2 &value) const
+{
+    gl->glUniform2f(getUniformLocation(name), value.x, value.y);
+}
+
+void Shader::setVec4(StringId name, const vec4 &value) const
+{
+    gl->glUniform4f(getUniformLocation(name), value.x, value.y, value.z, value.w);
+}
+
+bool Shader::bindUniformBlock(const char *name, unsigned int binding) const
+{
+    unsigned int index = gl->glGetUniformBlockIndex(shaderId, name);
+    if (index == GL_INVALID_INDEX)
+        return false;
+
+    gl->glUniformBlockBinding(shaderId, index, binding);
+    return true;
+}
@@ -2,8 +2,12 @@
 
 #include "../../engine/opengl.h"
 #include "../../engine/platform.h"
+#include "../../engine/string-id.h"
+#include "../../engine/math/vec.h"
+#include "gpu-resources.h"
 
 #include <string>
+#include <vector>
 
 class Shader
 {
@@ -11,13 +15,51 @@ private:
     // TODO: Try and avoid having these here. Maybe move this to a Renderer class?
     OpenGL *gl;
     Platform *platform;
+    GpuResources *resources;
+    ProgramHandle program;
+    bool linked = false;
+
+    // Every active uniform outside a block, sorted by name
+    struct Uniform
+    {
+        StringId name;
+        int location;
+    };
+    std::vector<Uniform> uniforms;
+
+    void findUniforms();
+
+    // Attaches whichever of the shared blocks in uniforms.h the program uses
+    void bindSharedBlocks();
 
 public:
-    unsigned int shaderId;
+    unsigned int shaderId; // GL name of 'program', for as long as the Shader lives
+
+    Shader(Platform *platform, OpenGL *gl, GpuResources *resources, const std::string &vertexData, const std::string &fragmentData);
+
+    // Compute-only program
+    Shader(Platform *platform, OpenGL *gl, GpuResources *resources, const std::string &computeData);
+
+    // The program is retired, not deleted, so draws already queued with it
+    // still work
+    ~Shader();
+
+    // False if a stage failed to compile or the program failed to link
+    bool isLinked() const { return linked; }
+
+    // Looked up in the table built at link time, so a name given as a
+    // literal costs a binary search over integers rather than a call into
+    // the driver. -1 if the program has no such active uniform, which the
+    // setters below quietly ignore, as GL does.
+    int getUniformLocation(StringId name) const;
 
-    Shader(Platform *platform, OpenGL *gl, std::string vertexData, std::string fragmentData);
+    void setBool(StringId name, bool value) const;
+    void setInt(StringId name, int value) const;
+    void setFloat(StringId name, float value) const;
+    void setVec2(StringId name, const vec2 &value) const;
+    void setVec4(StringId name, const vec4 &value) const;
 
-    void setBool(const std::string &name, bool value) const;  
-    void setInt(const std::string &name, int value) const;   
-    void setFloat(const std::string &name, float value) const;
+    // Points a uniform block at a binding point. Returns false if the
+    // program has no active block of that name.
+    bool bindUniformBlock(const char *name, unsigned int binding) const;
 };
\ No newline at end of file
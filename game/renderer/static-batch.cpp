@@ -0,0 +1,232 @@
+#include "static-batch.h"
+
+#include <math.h>
+#include <string.h>
+
+// Round 'size' up to the next multiple of 'alignment'
+static size_t AlignUp(size_t size, size_t alignment)
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+StaticMeshBatch::StaticMeshBatch(Platform *platform, OpenGL *gl, int maxDraws)
+{
+    this->platform = platform;
+    this->gl = gl;
+    this->maxDraws = maxDraws;
+}
+
+unsigned int StaticMeshBatch::addMesh(const float *vertices, int vertexCount, const unsigned int *indices, int indexCount)
+{
+    if (built)
+    {
+        platform->Log("Error: Meshes must be added to a StaticMeshBatch before build()\n");
+        return BATCH_INVALID_ID;
+    }
+    if (vertexCount <= 0 || indexCount <= 0)
+    {
+        platform->Log("Error: Empty mesh added to a StaticMeshBatch\n");
+        return BATCH_INVALID_ID;
+    }
+
+    MeshRange range;
+    range.firstIndex = (unsigned int)this->indices.size();
+    range.indexCount = indexCount;
+    range.baseVertex = (int)(this->vertices.size() / 6);
+
+    // Bounding sphere centred on the bounding box, which is cheap and
+    // close enough for culling
+    float min[3] = { vertices[0], vertices[1], vertices[2] };
+    float max[3] = { vertices[0], vertices[1], vertices[2] };
+    for (int i = 1; i < vertexCount; i++)
+    {
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float value = vertices[i * 6 + axis];
+            min[axis] = value < min[axis] ? value : min[axis];
+            max[axis] = value > max[axis] ? value : max[axis];
+        }
+    }
+
+    float radiusSq = 0.0f;
+    for (int axis = 0; axis < 3; axis++)
+        range.sphere[axis] = (min[axis] + max[axis]) * 0.5f;
+    for (int i = 0; i < vertexCount; i++)
+    {
+        float dx = vertices[i * 6 + 0] - range.sphere[0];
+        float dy = vertices[i * 6 + 1] - range.sphere[1];
+        float dz = vertices[i * 6 + 2] - range.sphere[2];
+        float distSq = dx * dx + dy * dy + dz * dz;
+        radiusSq = distSq > radiusSq ? distSq : radiusSq;
+    }
+    range.sphere[3] = sqrtf(radiusSq);
+
+    this->vertices.insert(this->vertices.end(), vertices, vertices + vertexCount * 6);
+    this->indices.insert(this->indices.end(), indices, indices + indexCount);
+
+    meshes.push_back(range);
+    return (unsigned int)meshes.size() - 1;
+}
+
+void StaticMeshBatch::build()
+{
+    // Nothing could ever be drawn, and GL rejects empty buffer storage,
+    // so there is nothing to upload
+    if (meshes.empty() || maxDraws <= 0)
+    {
+        VAO = VBO = EBO = drawIdVBO = ringBuffer = 0;
+        built = true;
+        return;
+    }
+
+    gl->glGenVertexArrays(1, &VAO);
+    gl->glBindVertexArray(VAO);
+
+    // Shared geometry never changes, so use immutable storage
+    gl->glGenBuffers(1, &VBO);
+    gl->glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    gl->glBufferStorage(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), 0);
+
+    gl->glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+    gl->glEnableVertexAttribArray(0);
+    gl->glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+    gl->glEnableVertexAttribArray(1);
+
+    gl->glGenBuffers(1, &EBO);
+    gl->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    gl->glBufferStorage(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), 0);
+
+    // Draw index attribute: element i holds i, and each command's
+    // baseInstance selects which element its instance reads
+    std::vector<unsigned int> drawIds(maxDraws);
+    for (int i = 0; i < maxDraws; i++)
+        drawIds[i] = i;
+
+    gl->glGenBuffers(1, &drawIdVBO);
+    gl->glBindBuffer(GL_ARRAY_BUFFER, drawIdVBO);
+    gl->glBufferStorage(GL_ARRAY_BUFFER, maxDraws * sizeof(unsigned int), drawIds.data(), 0);
+    gl->glVertexAttribIPointer(2, 1, GL_UNSIGNED_INT, sizeof(unsigned int), (void*)0);
+    gl->glEnableVertexAttribArray(2);
+    gl->glVertexAttribDivisor(2, 1);
+
+    gl->glBindVertexArray(0);
+    gl->glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // One persistently mapped buffer holds, for each frame in flight, the
+    // indirect commands followed by the per-draw data and bounds. These are
+    // bound at offsets into it, so each must respect the SSBO alignment.
+    GLint alignment = 256;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+
+    drawDataOffset = AlignUp(maxDraws * sizeof(DrawElementsIndirectCommand), alignment);
+    spheresOffset = AlignUp(drawDataOffset + maxDraws * sizeof(DrawData), alignment);
+    regionSize = AlignUp(spheresOffset + maxDraws * 4 * sizeof(float), alignment);
+
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    gl->glGenBuffers(1, &ringBuffer);
+    gl->glBindBuffer(GL_DRAW_INDIRECT_BUFFER, ringBuffer);
+    gl->glBufferStorage(GL_DRAW_INDIRECT_BUFFER, regionSize * BATCH_FRAMES_IN_FLIGHT, NULL, flags);
+    ringData = (unsigned char *)gl->glMapBufferRange(GL_DRAW_INDIRECT_BUFFER, 0, regionSize * BATCH_FRAMES_IN_FLIGHT, flags);
+    gl->glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    // Geometry now lives on the GPU
+    vertices = std::vector<float>();
+    indices = std::vector<unsigned int>();
+    built = true;
+}
+
+unsigned int StaticMeshBatch::addDraw(unsigned int mesh, const DrawData &data)
+{
+    if ((int)draws.size() >= maxDraws)
+    {
+        platform->Log("Error: StaticMeshBatch is full (%d draws)\n", maxDraws);
+        return BATCH_INVALID_ID;
+    }
+    if (mesh >= meshes.size())
+    {
+        platform->Log("Error: StaticMeshBatch has no mesh %u\n", mesh);
+        return BATCH_INVALID_ID;
+    }
+
+    drawMeshes.push_back(mesh);
+    draws.push_back(data);
+    return (unsigned int)draws.size() - 1;
+}
+
+void StaticMeshBatch::setDraw(unsigned int draw, const DrawData &data)
+{
+    if (draw >= draws.size())
+    {
+        platform->Log("Error: StaticMeshBatch has no draw %u\n", draw);
+        return;
+    }
+
+    draws[draw] = data;
+}
+
+BatchFrame StaticMeshBatch::prepare()
+{
+    int drawCount = (int)draws.size();
+
+    // Wait until the GPU has finished with this region from
+    // BATCH_FRAMES_IN_FLIGHT frames ago
+    if (fences[frameIndex])
+    {
+        while (gl->glClientWaitSync(fences[frameIndex], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED);
+        gl->glDeleteSync(fences[frameIndex]);
+        fences[frameIndex] = nullptr;
+    }
+
+    BatchFrame frame;
+    frame.buffer = ringBuffer;
+    frame.commandsOffset = frameIndex * regionSize;
+    frame.drawDataOffset = frame.commandsOffset + drawDataOffset;
+    frame.spheresOffset = frame.commandsOffset + spheresOffset;
+    frame.drawCount = drawCount;
+
+    auto commands = (DrawElementsIndirectCommand *)(ringData + frame.commandsOffset);
+    auto spheres = (float *)(ringData + frame.spheresOffset);
+
+    for (int i = 0; i < drawCount; i++)
+    {
+        const MeshRange &mesh = meshes[drawMeshes[i]];
+        commands[i].count = mesh.indexCount;
+        commands[i].instanceCount = 1;
+        commands[i].firstIndex = mesh.firstIndex;
+        commands[i].baseVertex = mesh.baseVertex;
+        commands[i].baseInstance = i;
+
+        memcpy(spheres + i * 4, mesh.sphere, sizeof(mesh.sphere));
+    }
+
+    memcpy(ringData + frame.drawDataOffset, draws.data(), drawCount * sizeof(DrawData));
+
+    return frame;
+}
+
+void StaticMeshBatch::bind(const BatchFrame &frame)
+{
+    gl->glBindVertexArray(VAO);
+    gl->glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, frame.buffer, frame.drawDataOffset, frame.drawCount * sizeof(DrawData));
+}
+
+void StaticMeshBatch::finish()
+{
+    fences[frameIndex] = gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    frameIndex = (frameIndex + 1) % BATCH_FRAMES_IN_FLIGHT;
+}
+
+void StaticMeshBatch::draw()
+{
+    if (!built || draws.empty())
+        return;
+
+    BatchFrame frame = prepare();
+    bind(frame);
+
+    gl->glBindBuffer(GL_DRAW_INDIRECT_BUFFER, frame.buffer);
+    gl->glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)frame.commandsOffset, frame.drawCount, 0);
+    gl->glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    finish();
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "../../engine/opengl.h"
+#include "../../engine/platform.h"
+#include "../../engine/math/mat.h"
+
+#include <vector>
+
+// Number of regions in the persistently mapped ring, so the CPU can write
+// frame N+2 while the GPU is still consuming frame N.
+#define BATCH_FRAMES_IN_FLIGHT 3
+
+// Returned by addMesh() and addDraw() when they fail; 0 is a valid id
+#define BATCH_INVALID_ID (~0u)
+
+// Layout of one command in GL_DRAW_INDIRECT_BUFFER, as defined by
+// glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand
+{
+    unsigned int count;
+    unsigned int instanceCount;
+    unsigned int firstIndex;
+    int baseVertex;
+    unsigned int baseInstance;
+};
+
+// Per-draw data read by batch.vert from the shader storage buffer. Must
+// match the std430 layout of 'DrawData' in the shader. The transform is
+// object to world; batch.vert applies the camera, and GpuCuller culls the
+// world-space bounds.
+struct DrawData
+{
+    mat4 transform;
+    vec4 color;
+};
+
+// Location of one mesh inside the shared vertex/index buffers
+struct MeshRange
+{
+    unsigned int firstIndex;
+    unsigned int indexCount;
+    int baseVertex;
+
+    // Object-space bounding sphere: centre xyz, radius w
+    float sphere[4];
+};
+
+// Where this frame's data lives inside the ring buffer, as returned by
+// StaticMeshBatch::prepare(). The regions are, in order: one indirect
+// command per draw, one DrawData per draw and one object-space bounding
+// sphere (vec4) per draw.
+struct BatchFrame
+{
+    unsigned int buffer;
+    size_t commandsOffset;
+    size_t drawDataOffset;
+    size_t spheresOffset;
+    int drawCount;
+};
+
+// Packs many static meshes into one vertex buffer and one index buffer and
+// draws every registered object with a single glMultiDrawElementsIndirect.
+//
+// Each draw's baseInstance is set to its index in the draw list. A vertex
+// attribute with divisor 1 over the sequence 0..n-1 then yields that index
+// in the shader, which uses it to fetch transform and colour from an SSBO.
+// This works on GL 4.3 without gl_DrawID or ARB_shader_draw_parameters.
+class StaticMeshBatch
+{
+private:
+    OpenGL *gl;
+    Platform *platform;
+
+    // CPU copies, only kept until build()
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+
+    std::vector<MeshRange> meshes;
+    std::vector<unsigned int> drawMeshes;
+    std::vector<DrawData> draws;
+
+    unsigned int VAO, VBO, EBO, drawIdVBO;
+    unsigned int ringBuffer;
+    unsigned char *ringData = nullptr;
+    GLsync fences[BATCH_FRAMES_IN_FLIGHT] = {};
+    int frameIndex = 0;
+    int maxDraws;
+
+    size_t drawDataOffset, spheresOffset, regionSize;
+    bool built = false;
+
+public:
+    StaticMeshBatch(Platform *platform, OpenGL *gl, int maxDraws);
+
+    // Meshes use the same 6-float vertex layout as Mesh. Returns a mesh id,
+    // or BATCH_INVALID_ID after build() or for an empty mesh.
+    unsigned int addMesh(const float *vertices, int vertexCount, const unsigned int *indices, int indexCount);
+
+    // Uploads the shared buffers. Meshes can not be added afterwards. A
+    // batch without meshes creates no buffers and never draws.
+    void build();
+
+    // Draws are the objects placed in the scene. Returns a draw id, or
+    // BATCH_INVALID_ID if the batch is full or 'mesh' is not one of its
+    // meshes.
+    unsigned int addDraw(unsigned int mesh, const DrawData &data);
+
+    // Replaces a draw's data. Ids that addDraw() never returned are
+    // logged and ignored.
+    void setDraw(unsigned int draw, const DrawData &data);
+
+    const MeshRange &getMesh(unsigned int mesh) const { return meshes[mesh]; }
+    unsigned int getDrawMesh(unsigned int draw) const { return drawMeshes[draw]; }
+    int getDrawCount() const { return (int)draws.size(); }
+    int getMaxDraws() const { return maxDraws; }
+    bool isBuilt() const { return built; }
+
+    // Writes this frame's commands, draw data and bounds into the next
+    // region of the ring, waiting first if the GPU is still reading it.
+    BatchFrame prepare();
+
+    // Binds the shared geometry and the frame's draw data (SSBO binding 0)
+    void bind(const BatchFrame &frame);
+
+    // Fences the frame's region and advances the ring. Call once the
+    // frame's draws have been submitted.
+    void finish();
+
+    // prepare(), then a single multi-draw of every object with the
+    // currently bound program, then finish()
+    void draw();
+};
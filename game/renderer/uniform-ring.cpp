@@ -0,0 +1,84 @@
+#include "uniform-ring.h"
+
+UniformRing::UniformRing(Platform *platform, OpenGL *gl, size_t frameCapacity)
+{
+    this->platform = platform;
+    this->gl = gl;
+
+    // Offsets passed to glBindBufferRange must be multiples of this,
+    // typically 256 bytes on desktop drivers
+    GLint offsetAlignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+    alignment = (size_t)offsetAlignment;
+
+    regionSize = (frameCapacity + alignment - 1) / alignment * alignment;
+
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    gl->glGenBuffers(1, &buffer);
+    gl->glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    gl->glBufferStorage(GL_UNIFORM_BUFFER, regionSize * UNIFORM_FRAMES_IN_FLIGHT, NULL, flags);
+    ringData = (unsigned char *)gl->glMapBufferRange(GL_UNIFORM_BUFFER, 0, regionSize * UNIFORM_FRAMES_IN_FLIGHT, flags);
+    gl->glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    if (!ringData)
+        platform->Log("Error: Could not map uniform ring buffer\n");
+}
+
+UniformRing::~UniformRing()
+{
+    for (GLsync &fence : fences)
+    {
+        if (fence)
+            gl->glDeleteSync(fence);
+    }
+
+    // Deleting the buffer unmaps it
+    gl->glDeleteBuffers(1, &buffer);
+}
+
+void UniformRing::beginFrame()
+{
+    frameIndex = (frameIndex + 1) % UNIFORM_FRAMES_IN_FLIGHT;
+
+    if (fences[frameIndex])
+    {
+        while (gl->glClientWaitSync(fences[frameIndex], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED);
+        gl->glDeleteSync(fences[frameIndex]);
+        fences[frameIndex] = 0;
+    }
+
+    head = 0;
+}
+
+void UniformRing::endFrame()
+{
+    fences[frameIndex] = gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+UniformAllocation UniformRing::allocate(size_t size)
+{
+    size_t offset = (head + alignment - 1) / alignment * alignment;
+
+    if (!ringData || offset + size > regionSize)
+    {
+        // Only report the first time, rather than every draw of every frame
+        if (!overflowed)
+            platform->Log("Error: Uniform ring full (%zu bytes per frame)\n", regionSize);
+        overflowed = true;
+        return UniformAllocation{nullptr, 0, 0};
+    }
+
+    head = offset + size;
+
+    size_t ringOffset = frameIndex * regionSize + offset;
+    return UniformAllocation{ringData + ringOffset, ringOffset, size};
+}
+
+void UniformRing::bind(unsigned int binding, const UniformAllocation &allocation)
+{
+    if (!allocation.data)
+        return;
+
+    gl->glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, allocation.offset, allocation.size);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "../../engine/opengl.h"
+#include "../../engine/platform.h"
+
+#include <string.h>
+
+// Number of regions in the ring, so the CPU can fill frame N+2 while the
+// GPU is still reading frame N
+#define UNIFORM_FRAMES_IN_FLIGHT 3
+
+// A block of constants written into the ring for the current frame
+struct UniformAllocation
+{
+    void *data;    // nullptr if the frame's region was full
+    size_t offset; // from the start of the ring buffer
+    size_t size;
+};
+
+// One large, persistently mapped uniform buffer that per-frame and per-draw
+// constants are sub-allocated from. Each frame writes linearly into its own
+// region; a fence per region stops it being overwritten while the GPU may
+// still read it. Binding constants is then a single glBindBufferRange at
+// the allocation's offset, rather than a glUniform* call per value.
+class UniformRing
+{
+private:
+    OpenGL *gl;
+    Platform *platform;
+
+    unsigned int buffer;
+    unsigned char *ringData;
+    GLsync fences[UNIFORM_FRAMES_IN_FLIGHT] = {};
+    int frameIndex = 0;
+
+    size_t regionSize;
+    size_t alignment;
+    size_t head = 0;
+    bool overflowed = false;
+
+public:
+    // 'frameCapacity' is the most constant data a single frame can use
+    UniformRing(Platform *platform, OpenGL *gl, size_t frameCapacity);
+    ~UniformRing();
+
+    // Moves to the next region, waiting if the GPU is still reading it
+    void beginFrame();
+
+    // Fences the frame's region. Call once the frame's draws are submitted.
+    void endFrame();
+
+    // Space for 'size' bytes of constants, aligned for glBindBufferRange
+    UniformAllocation allocate(size_t size);
+
+    template <typename T>
+    UniformAllocation push(const T &value)
+    {
+        UniformAllocation allocation = allocate(sizeof(T));
+        if (allocation.data)
+            memcpy(allocation.data, &value, sizeof(T));
+        return allocation;
+    }
+
+    // Binds an allocation to a uniform block binding point
+    void bind(unsigned int binding, const UniformAllocation &allocation);
+
+    unsigned int getBuffer() const { return buffer; }
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "../../engine/math/mat.h"
+
+#include <stddef.h>
+
+// C++ mirrors of the uniform blocks shared by the shaders. Each must match
+// the std140 layout of the block of the same name: vec4 and mat4 members
+// are 16-byte aligned, and a vec3 must be padded out to a vec4, so only
+// float, vec2, vec4 and mat4 members are used here.
+//
+// Every program declaring one of these blocks has it bound to the fixed
+// binding point below (see Shader::bindUniformBlock), so a block bound
+// once per frame is seen by every draw.
+
+#define UNIFORM_BINDING_FRAME 0
+#define UNIFORM_BINDING_CAMERA 1
+#define UNIFORM_BINDING_DRAW 2
+#define UNIFORM_BINDING_LIGHTING 3
+#define UNIFORM_BINDING_DIRECTIONAL_LIGHT 4
+#define UNIFORM_BINDING_PARTICLES 5
+
+// Size of the cascade arrays in the DirectionalLight block
+#define SHADOW_CASCADES 4
+
+// layout(std140) uniform Frame
+struct alignas(16) FrameUniforms
+{
+    float time;
+    float deltaTime;
+    vec2 resolution;
+};
+
+// layout(std140) uniform Camera
+struct alignas(16) CameraUniforms
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 position; // w unused
+};
+
+// layout(std140) uniform Draw
+struct alignas(16) DrawUniforms
+{
+    mat4 transform;
+    vec4 color;
+};
+
+// layout(std140) uniform Lighting, see ClusteredLighting
+struct alignas(16) LightingUniforms
+{
+    vec4 clusters; // across, down and deep; w the number of lights
+    vec4 frustum;  // tangents of the half angles across and down, near, far
+    vec4 slicing;  // depth slice = log(-z) * x + y; zw unused
+    vec4 ambient;  // w unused
+};
+
+// layout(std140) uniform DirectionalLight, see CascadedShadows
+struct alignas(16) DirectionalLightUniforms
+{
+    vec4 direction;  // world space, towards the light; w unused
+    vec4 color;      // w unused
+    vec4 splits;     // view depth at which each cascade ends
+    vec4 texelSizes; // world size of a shadow map texel in each cascade
+    vec4 shadow;     // x depth bias, y normal offset in texels, z 1 / map size, w cascades in use
+    mat4 cascades[SHADOW_CASCADES]; // view space to shadow map coordinates
+};
+
+// layout(std140) uniform Particles, see ParticleSystem. Pushed for each
+// dispatch: emission reads the emitter, simulation the forces.
+struct alignas(16) ParticleUniforms
+{
+    vec4 position; // emitter centre; w radius of the sphere particles start in
+    vec4 velocity; // starting velocity; w random speed added in any direction
+    vec4 color;    // rgb times a is the starting brightness
+    vec4 spawn;    // lifetime min, max; size min, max
+    vec4 forces;   // xyz gravity, w drag per second
+    vec4 timing;   // x delta time, y random seed; zw unused
+    vec4 counts;   // x particles to emit, y capacity, z source count slot, w destination slot
+};
+
+static_assert(sizeof(FrameUniforms) == 16, "FrameUniforms must match std140");
+static_assert(offsetof(CameraUniforms, position) == 192 && sizeof(CameraUniforms) == 208, "CameraUniforms must match std140");
+static_assert(offsetof(DrawUniforms, color) == 64 && sizeof(DrawUniforms) == 80, "DrawUniforms must match std140");
+static_assert(sizeof(LightingUniforms) == 64, "LightingUniforms must match std140");
+static_assert(offsetof(DirectionalLightUniforms, cascades) == 80 && sizeof(DirectionalLightUniforms) == 80 + 64 * SHADOW_CASCADES,
+              "DirectionalLightUniforms must match std140");
+static_assert(sizeof(ParticleUniforms) == 112, "ParticleUniforms must match std140");
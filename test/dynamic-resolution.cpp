@@ -0,0 +1,64 @@
+#include "../game/renderer/dynamic-resolution.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Drives DynamicResolution with GPU times that follow the pixel count,
+// under loads that swing from idle to several times the target, and
+// checks that every scale it picks is a multiple of the step within the
+// limits, including for limits and steps that do not line up.
+
+#define FRAMES 20000
+
+static int failures = 0;
+
+static void Check(const DynamicResolutionConfig &config)
+{
+    DynamicResolution resolution(config);
+    float step = resolution.getConfig().step;
+
+    srand(1);
+    float load = 10.0f; // GPU ms at full scale
+    for (int frame = 0; frame < FRAMES; frame++)
+    {
+        // A random walk, with the occasional spike
+        load *= 0.9f + 0.2f * rand() / RAND_MAX;
+        load = fminf(fmaxf(load, 1.0f), 60.0f);
+        float spike = rand() % 100 == 0 ? 3.0f : 1.0f;
+
+        float scale = resolution.getScale();
+        resolution.update(load * spike * scale * scale);
+
+        scale = resolution.getScale();
+        float steps = scale / step;
+        if (fabsf(steps - roundf(steps)) > 1e-4f || scale < config.minScale - 1e-4f || scale > config.maxScale + 1e-4f)
+        {
+            printf("FAIL: step %.3f, limits %.3f to %.3f: scale %.6f at frame %d\n",
+                   step, config.minScale, config.maxScale, scale, frame);
+            failures++;
+            return;
+        }
+    }
+}
+
+int main()
+{
+    DynamicResolutionConfig config;
+    Check(config);
+
+    config.minScale = 0.33f;
+    config.maxScale = 0.96f;
+    config.step = 0.07f;
+    Check(config);
+
+    config.minScale = 0.25f;
+    config.maxScale = 1.0f;
+    config.step = 0.1f;
+    config.targetMs = 8.0f;
+    Check(config);
+
+    if (failures == 0)
+        printf("dynamic resolution: all scales on the grid\n");
+    return failures > 0;
+}
@@ -0,0 +1,277 @@
+#include "obj.h"
+#include "optimize.h"
+#include "meshlets.h"
+#include "simplify.h"
+#include "assets/mesh-format.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+// Converts an OBJ file into the runtime .tmesh format (see
+// assets/mesh-format.h), optimising the triangle order for the vertex
+// cache and overdraw on the way.
+//
+//   mesh-convert input.obj output.tmesh
+
+// Clusters may be reordered for overdraw as long as the cache miss rate
+// grows by no more than this factor
+#define OVERDRAW_THRESHOLD 1.05f
+
+// No LOD goes below this many triangles per submesh
+#define LOD_MIN_TRIANGLES 64
+
+static uint16_t FloatToHalf(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint32_t sign = (bits >> 16) & 0x8000;
+    int exponent = (int)((bits >> 23) & 0xff) - 127 + 15;
+    uint32_t mantissa = bits & 0x7fffff;
+
+    if (((bits >> 23) & 0xff) == 0xff)
+        return (uint16_t)(sign | 0x7c00 | (mantissa ? 0x200 : 0)); // inf, nan
+    if (exponent >= 31)
+        return (uint16_t)(sign | 0x7c00);                           // overflow
+    if (exponent <= 0)
+    {
+        // Denormal or zero
+        if (exponent < -10)
+            return (uint16_t)sign;
+        mantissa |= 0x800000;
+        uint32_t shift = (uint32_t)(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        if ((mantissa >> (shift - 1)) & 1)
+            half++;
+        return (uint16_t)(sign | half);
+    }
+
+    // Round to nearest; a carry into the exponent is still correct
+    uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+    if (mantissa & 0x1000)
+        half++;
+    return (uint16_t)half;
+}
+
+static uint32_t PackNormal(const vec3 &normal)
+{
+    uint32_t packed = 0;
+    for (int k = 0; k < 3; k++)
+    {
+        float clamped = normal[k] < -1.0f ? -1.0f : (normal[k] > 1.0f ? 1.0f : normal[k]);
+        int value = (int)lroundf(clamped * 511.0f);
+        packed |= ((uint32_t)value & 0x3ff) << (10 * k);
+    }
+    return packed;
+}
+
+static uint32_t AlignSection(uint32_t offset)
+{
+    return (offset + MESH_SECTION_ALIGN - 1) & ~(uint32_t)(MESH_SECTION_ALIGN - 1);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: %s input.obj output.tmesh\n", argv[0]);
+        return 1;
+    }
+
+    SourceMesh mesh;
+    if (!LoadObj(argv[1], mesh))
+        return 1;
+
+    unsigned int sourceVertexCount = (unsigned int)mesh.vertices.size();
+    size_t triangleCount = 0;
+    float acmrBefore = 0.0f, acmrAfter = 0.0f;
+
+    for (SourceSubmesh &submesh : mesh.submeshes)
+    {
+        size_t triangles = submesh.indices.size() / 3;
+        acmrBefore += ComputeAcmr(submesh.indices, sourceVertexCount, 16) * triangles;
+
+        OptimizeVertexCache(submesh.indices, sourceVertexCount);
+        OptimizeOverdraw(submesh.indices, mesh.vertices, OVERDRAW_THRESHOLD);
+
+        acmrAfter += ComputeAcmr(submesh.indices, sourceVertexCount, 16) * triangles;
+        triangleCount += triangles;
+
+        // Simplified from the optimised order; the LODs get their own
+        // cache optimisation, but overdraw matters less at a distance
+        submesh.lods = BuildLods(submesh.indices, mesh.vertices, MESH_MAX_LODS - 1, LOD_MIN_TRIANGLES);
+        for (SourceLod &lod : submesh.lods)
+            OptimizeVertexCache(lod.indices, sourceVertexCount);
+    }
+    OptimizeVertexFetch(mesh);
+
+    // Bounds, for quantisation and culling
+    MeshFileHeader header = {};
+    header.magic = MESH_FILE_MAGIC;
+    header.version = MESH_FILE_VERSION;
+    header.vertexCount = (uint32_t)mesh.vertices.size();
+    header.submeshCount = (uint32_t)mesh.submeshes.size();
+
+    vec3 min(INFINITY), max(-INFINITY);
+    for (const SourceVertex &vertex : mesh.vertices)
+    {
+        min = vmin(min, vertex.position);
+        max = vmax(max, vertex.position);
+    }
+    vec3 extent = max - min;
+    for (int k = 0; k < 3; k++)
+    {
+        header.boundsMin[k] = min[k];
+        header.boundsMax[k] = max[k];
+    }
+
+    std::vector<unsigned int> allIndices;
+    std::vector<MeshSubmesh> submeshes;
+    std::vector<MeshLod> lods;
+    MeshletData meshlets;
+
+    for (const SourceSubmesh &source : mesh.submeshes)
+    {
+        MeshSubmesh submesh = {};
+        strncpy(submesh.name, source.name.c_str(), MESH_NAME_LENGTH - 1);
+        submesh.firstIndex = (uint32_t)allIndices.size();
+        submesh.indexCount = (uint32_t)source.indices.size();
+        submesh.lodCount = 1 + (uint32_t)source.lods.size();
+        submesh.firstMeshlet = (uint32_t)meshlets.meshlets.size();
+        ComputeSphere(mesh.vertices, source.indices.data(), source.indices.size(), submesh.sphere);
+
+        BuildMeshlets(source.indices, mesh.vertices, meshlets);
+        submesh.meshletCount = (uint32_t)meshlets.meshlets.size() - submesh.firstMeshlet;
+
+        allIndices.insert(allIndices.end(), source.indices.begin(), source.indices.end());
+        submeshes.push_back(submesh);
+    }
+
+    // LOD 0 is the full-detail range; the simplified ranges follow all of
+    // the full-detail ones in the index buffer
+    for (size_t i = 0; i < submeshes.size(); i++)
+    {
+        submeshes[i].firstLod = (uint32_t)lods.size();
+        lods.push_back(MeshLod{submeshes[i].firstIndex, submeshes[i].indexCount, 0.0f});
+
+        for (const SourceLod &source : mesh.submeshes[i].lods)
+        {
+            lods.push_back(MeshLod{(uint32_t)allIndices.size(), (uint32_t)source.indices.size(), source.error});
+            allIndices.insert(allIndices.end(), source.indices.begin(), source.indices.end());
+        }
+    }
+
+    std::vector<unsigned int> everyVertex(mesh.vertices.size());
+    for (size_t i = 0; i < everyVertex.size(); i++)
+        everyVertex[i] = (unsigned int)i;
+    ComputeSphere(mesh.vertices, everyVertex.data(), everyVertex.size(), header.sphere);
+
+    header.indexCount = (uint32_t)allIndices.size();
+    header.lodCount = (uint32_t)lods.size();
+    header.indexSize = header.vertexCount <= 0x10000 ? 2 : 4;
+    header.meshletCount = (uint32_t)meshlets.meshlets.size();
+    header.meshletVertexCount = (uint32_t)meshlets.vertices.size();
+    header.meshletTriangleCount = (uint32_t)(meshlets.triangles.size() / 3);
+
+    // Quantised, interleaved vertices
+    std::vector<unsigned char> vertexData(mesh.vertices.size() * MESH_VERTEX_STRIDE);
+    for (size_t i = 0; i < mesh.vertices.size(); i++)
+    {
+        const SourceVertex &vertex = mesh.vertices[i];
+        unsigned char *out = &vertexData[i * MESH_VERTEX_STRIDE];
+
+        uint16_t position[4] = {0, 0, 0, 0};
+        for (int k = 0; k < 3; k++)
+        {
+            float t = extent[k] > 0.0f ? (vertex.position[k] - min[k]) / extent[k] : 0.0f;
+            position[k] = (uint16_t)lroundf(t * 65535.0f);
+        }
+        uint32_t normal = PackNormal(vertex.normal);
+        uint16_t uv[2] = {FloatToHalf(vertex.uv.x), FloatToHalf(vertex.uv.y)};
+
+        memcpy(out + MESH_VERTEX_POSITION_OFFSET, position, sizeof(position));
+        memcpy(out + MESH_VERTEX_NORMAL_OFFSET, &normal, sizeof(normal));
+        memcpy(out + MESH_VERTEX_UV_OFFSET, uv, sizeof(uv));
+    }
+
+    std::vector<unsigned char> indexData(allIndices.size() * header.indexSize);
+    for (size_t i = 0; i < allIndices.size(); i++)
+    {
+        if (header.indexSize == 2)
+        {
+            uint16_t index = (uint16_t)allIndices[i];
+            memcpy(&indexData[i * 2], &index, 2);
+        }
+        else
+        {
+            uint32_t index = allIndices[i];
+            memcpy(&indexData[i * 4], &index, 4);
+        }
+    }
+
+    // Section offsets
+    uint32_t offset = AlignSection(sizeof(MeshFileHeader));
+    header.submeshOffset = offset;
+    offset = AlignSection(offset + header.submeshCount * sizeof(MeshSubmesh));
+    header.lodOffset = offset;
+    offset = AlignSection(offset + header.lodCount * sizeof(MeshLod));
+    header.meshletOffset = offset;
+    offset = AlignSection(offset + header.meshletCount * sizeof(MeshMeshlet));
+    header.vertexOffset = offset;
+    offset = AlignSection(offset + (uint32_t)vertexData.size());
+    header.indexOffset = offset;
+    offset = AlignSection(offset + (uint32_t)indexData.size());
+    header.meshletVertexOffset = offset;
+    offset = AlignSection(offset + header.meshletVertexCount * sizeof(uint32_t));
+    header.meshletTriangleOffset = offset;
+    offset = offset + (uint32_t)meshlets.triangles.size();
+    header.fileSize = offset;
+
+    std::vector<unsigned char> file(header.fileSize, 0);
+    memcpy(&file[0], &header, sizeof(header));
+    if (!submeshes.empty())
+        memcpy(&file[header.submeshOffset], submeshes.data(), submeshes.size() * sizeof(MeshSubmesh));
+    if (!lods.empty())
+        memcpy(&file[header.lodOffset], lods.data(), lods.size() * sizeof(MeshLod));
+    if (!meshlets.meshlets.empty())
+        memcpy(&file[header.meshletOffset], meshlets.meshlets.data(), meshlets.meshlets.size() * sizeof(MeshMeshlet));
+    if (!vertexData.empty())
+        memcpy(&file[header.vertexOffset], vertexData.data(), vertexData.size());
+    if (!indexData.empty())
+        memcpy(&file[header.indexOffset], indexData.data(), indexData.size());
+    if (!meshlets.vertices.empty())
+        memcpy(&file[header.meshletVertexOffset], meshlets.vertices.data(), meshlets.vertices.size() * sizeof(uint32_t));
+    if (!meshlets.triangles.empty())
+        memcpy(&file[header.meshletTriangleOffset], meshlets.triangles.data(), meshlets.triangles.size());
+
+    FILE *output = fopen(argv[2], "wb");
+    if (!output || fwrite(file.data(), 1, file.size(), output) != file.size())
+    {
+        fprintf(stderr, "Error: could not write '%s'\n", argv[2]);
+        if (output)
+            fclose(output);
+        return 1;
+    }
+    fclose(output);
+
+    if (triangleCount > 0)
+    {
+        printf("%s: %u vertices, %zu triangles, %u submeshes, %u meshlets, ACMR %.3f -> %.3f\n",
+               argv[2], header.vertexCount, triangleCount, header.submeshCount, header.meshletCount,
+               acmrBefore / triangleCount, acmrAfter / triangleCount);
+    }
+
+    for (const MeshSubmesh &submesh : submeshes)
+    {
+        printf("  %-16s", submesh.name);
+        for (uint32_t i = 0; i < submesh.lodCount; i++)
+        {
+            const MeshLod &lod = lods[submesh.firstLod + i];
+            printf("  LOD%u %u tris (error %.4f)", i, lod.indexCount / 3, lod.error);
+        }
+        printf("\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,153 @@
+#include "meshlets.h"
+
+#include <math.h>
+
+void ComputeSphere(const std::vector<SourceVertex> &vertices, const unsigned int *indices, size_t count, float sphere[4])
+{
+    vec3 min(INFINITY), max(-INFINITY);
+    for (size_t i = 0; i < count; i++)
+    {
+        min = vmin(min, vertices[indices[i]].position);
+        max = vmax(max, vertices[indices[i]].position);
+    }
+
+    vec3 centre = (min + max) * 0.5f;
+    float radius = 0.0f;
+    for (size_t i = 0; i < count; i++)
+    {
+        float distance = length(vertices[indices[i]].position - centre);
+        radius = distance > radius ? distance : radius;
+    }
+
+    sphere[0] = centre.x;
+    sphere[1] = centre.y;
+    sphere[2] = centre.z;
+    sphere[3] = radius;
+}
+
+// Fills in the bounds of the meshlet most recently added to 'data'
+static void FinishMeshlet(const std::vector<SourceVertex> &vertices, MeshletData &data)
+{
+    MeshMeshlet &meshlet = data.meshlets.back();
+    const uint32_t *local = &data.vertices[meshlet.vertexOffset];
+    const uint8_t *triangles = &data.triangles[meshlet.triangleOffset * 3];
+
+    ComputeSphere(vertices, local, meshlet.vertexCount, meshlet.sphere);
+    vec3 centre(meshlet.sphere[0], meshlet.sphere[1], meshlet.sphere[2]);
+
+    // Cone axis: the average facing of the triangles
+    std::vector<vec3> normals;
+    vec3 axis(0.0f);
+    for (uint32_t t = 0; t < meshlet.triangleCount; t++)
+    {
+        const vec3 &a = vertices[local[triangles[t * 3]]].position;
+        const vec3 &b = vertices[local[triangles[t * 3 + 1]]].position;
+        const vec3 &c = vertices[local[triangles[t * 3 + 2]]].position;
+        vec3 n = cross(b - a, c - a);
+        if (dot(n, n) > 0.0f)
+        {
+            n = normalize(n);
+            normals.push_back(n);
+            axis += n;
+        }
+    }
+
+    // Degenerate unless every triangle faces roughly along the axis
+    meshlet.coneCutoff = 1.0f;
+    for (int k = 0; k < 3; k++)
+    {
+        meshlet.coneApex[k] = centre[k];
+        meshlet.coneAxis[k] = 0.0f;
+    }
+
+    if (normals.empty() || dot(axis, axis) == 0.0f)
+        return;
+    axis = normalize(axis);
+
+    float minDot = 1.0f;
+    for (const vec3 &n : normals)
+        minDot = dot(n, axis) < minDot ? dot(n, axis) : minDot;
+    if (minDot <= 0.1f)
+        return;
+
+    // Move the apex back along the axis until it is behind every
+    // triangle's plane
+    float maxT = 0.0f;
+    size_t normalIndex = 0;
+    for (uint32_t t = 0; t < meshlet.triangleCount; t++)
+    {
+        const vec3 &a = vertices[local[triangles[t * 3]]].position;
+        const vec3 &b = vertices[local[triangles[t * 3 + 1]]].position;
+        const vec3 &c = vertices[local[triangles[t * 3 + 2]]].position;
+        vec3 n = cross(b - a, c - a);
+        if (dot(n, n) == 0.0f)
+            continue;
+
+        n = normals[normalIndex++];
+        float t0 = dot(centre - a, n) / dot(axis, n);
+        maxT = t0 > maxT ? t0 : maxT;
+    }
+
+    vec3 apex = centre - axis * maxT;
+    for (int k = 0; k < 3; k++)
+    {
+        meshlet.coneApex[k] = apex[k];
+        meshlet.coneAxis[k] = axis[k];
+    }
+    meshlet.coneCutoff = sqrtf(1.0f - minDot * minDot);
+}
+
+void BuildMeshlets(const std::vector<unsigned int> &indices, const std::vector<SourceVertex> &vertices, MeshletData &data)
+{
+    // Meshlet-local index of each mesh vertex in the meshlet being built
+    std::vector<int> localIndex(vertices.size(), -1);
+    bool open = false;
+
+    for (size_t t = 0; t < indices.size() / 3; t++)
+    {
+        const unsigned int *triangle = &indices[t * 3];
+
+        if (open)
+        {
+            MeshMeshlet &meshlet = data.meshlets.back();
+            uint32_t newVertices = 0;
+            for (int k = 0; k < 3; k++)
+                newVertices += localIndex[triangle[k]] < 0;
+
+            if (meshlet.vertexCount + newVertices > MESH_MESHLET_MAX_VERTICES ||
+                meshlet.triangleCount == MESH_MESHLET_MAX_TRIANGLES)
+            {
+                for (uint32_t i = 0; i < meshlet.vertexCount; i++)
+                    localIndex[data.vertices[meshlet.vertexOffset + i]] = -1;
+
+                FinishMeshlet(vertices, data);
+                open = false;
+            }
+        }
+
+        if (!open)
+        {
+            MeshMeshlet meshlet = {};
+            meshlet.vertexOffset = (uint32_t)data.vertices.size();
+            meshlet.triangleOffset = (uint32_t)(data.triangles.size() / 3);
+            data.meshlets.push_back(meshlet);
+            open = true;
+        }
+
+        MeshMeshlet &meshlet = data.meshlets.back();
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int v = triangle[k];
+            if (localIndex[v] < 0)
+            {
+                localIndex[v] = (int)meshlet.vertexCount++;
+                data.vertices.push_back(v);
+            }
+            data.triangles.push_back((uint8_t)localIndex[v]);
+        }
+        meshlet.triangleCount++;
+    }
+
+    if (open)
+        FinishMeshlet(vertices, data);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "obj.h"
+#include "assets/mesh-format.h"
+
+#include <stdint.h>
+#include <vector>
+
+struct MeshletData
+{
+    std::vector<MeshMeshlet> meshlets;
+    std::vector<uint32_t> vertices;  // meshlet-local index -> mesh vertex
+    std::vector<uint8_t> triangles;  // three meshlet-local indices each
+};
+
+// Cuts a triangle list into meshlets of at most MESH_MESHLET_MAX_VERTICES
+// vertices and MESH_MESHLET_MAX_TRIANGLES triangles, following the index
+// order (so run it after the cache optimisation), and computes each
+// meshlet's bounding sphere and backface cone. Appends to 'data'.
+void BuildMeshlets(const std::vector<unsigned int> &indices, const std::vector<SourceVertex> &vertices, MeshletData &data);
+
+// Centre and radius of a sphere around the given vertices
+void ComputeSphere(const std::vector<SourceVertex> &vertices, const unsigned int *indices, size_t count, float sphere[4]);
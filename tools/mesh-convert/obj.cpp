@@ -0,0 +1,183 @@
+#include "obj.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unordered_map>
+
+// Index triple of one face corner, 0-based, -1 if absent
+struct Corner
+{
+    int position, uv, normal;
+
+    bool operator==(const Corner &other) const
+    {
+        return position == other.position && uv == other.uv && normal == other.normal;
+    }
+};
+
+struct CornerHash
+{
+    size_t operator()(const Corner &corner) const
+    {
+        size_t hash = (size_t)corner.position * 73856093u;
+        hash ^= (size_t)(corner.uv + 1) * 19349663u;
+        hash ^= (size_t)(corner.normal + 1) * 83492791u;
+        return hash;
+    }
+};
+
+// OBJ indices are 1-based, or negative to count back from the end
+static int ResolveIndex(int index, size_t count)
+{
+    if (index > 0)
+        return index - 1;
+    if (index < 0)
+        return (int)count + index;
+    return -1;
+}
+
+static bool ParseCorner(const char *token, size_t positions, size_t uvs, size_t normals, Corner &corner)
+{
+    int p = 0, t = 0, n = 0;
+    char *end;
+
+    p = (int)strtol(token, &end, 10);
+    if (*end == '/')
+    {
+        if (end[1] != '/')
+            t = (int)strtol(end + 1, &end, 10);
+        else
+            end++;
+
+        if (*end == '/')
+            n = (int)strtol(end + 1, &end, 10);
+    }
+
+    corner.position = ResolveIndex(p, positions);
+    corner.uv = ResolveIndex(t, uvs);
+    corner.normal = ResolveIndex(n, normals);
+
+    return corner.position >= 0 && corner.position < (int)positions &&
+           corner.uv < (int)uvs && corner.normal < (int)normals;
+}
+
+bool LoadObj(const char *path, SourceMesh &mesh)
+{
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        fprintf(stderr, "Error: could not open '%s'\n", path);
+        return false;
+    }
+
+    std::vector<vec3> positions, normals;
+    std::vector<vec2> uvs;
+    std::vector<Corner> corners; // one per unique vertex
+    std::unordered_map<Corner, unsigned int, CornerHash> cornerToVertex;
+
+    mesh.submeshes.push_back(SourceSubmesh{"default", {}, {}});
+    SourceSubmesh *submesh = &mesh.submeshes.back();
+
+    char line[1024];
+    int lineNumber = 0;
+    while (fgets(line, sizeof(line), file))
+    {
+        lineNumber++;
+
+        vec3 v;
+        if (sscanf(line, "v %f %f %f", &v.x, &v.y, &v.z) == 3)
+            positions.push_back(v);
+        else if (sscanf(line, "vn %f %f %f", &v.x, &v.y, &v.z) == 3)
+            normals.push_back(v);
+        else if (sscanf(line, "vt %f %f", &v.x, &v.y) == 2)
+            uvs.push_back(vec2(v.x, v.y));
+        else if (strncmp(line, "usemtl ", 7) == 0)
+        {
+            char name[256] = "";
+            sscanf(line + 7, "%255s", name);
+
+            // Reuse the submesh if the material was seen before
+            submesh = nullptr;
+            for (SourceSubmesh &existing : mesh.submeshes)
+            {
+                if (existing.name == name)
+                    submesh = &existing;
+            }
+            if (!submesh)
+            {
+                mesh.submeshes.push_back(SourceSubmesh{name, {}, {}});
+                submesh = &mesh.submeshes.back();
+            }
+        }
+        else if (line[0] == 'f' && line[1] == ' ')
+        {
+            std::vector<unsigned int> face;
+            for (char *token = strtok(line + 2, " \t\r\n"); token; token = strtok(NULL, " \t\r\n"))
+            {
+                Corner corner;
+                if (!ParseCorner(token, positions.size(), uvs.size(), normals.size(), corner))
+                {
+                    fprintf(stderr, "Error: %s:%d: bad face index '%s'\n", path, lineNumber, token);
+                    fclose(file);
+                    return false;
+                }
+
+                auto found = cornerToVertex.find(corner);
+                if (found == cornerToVertex.end())
+                {
+                    found = cornerToVertex.emplace(corner, (unsigned int)corners.size()).first;
+                    corners.push_back(corner);
+                }
+                face.push_back(found->second);
+            }
+
+            for (size_t i = 2; i < face.size(); i++)
+            {
+                submesh->indices.push_back(face[0]);
+                submesh->indices.push_back(face[i - 1]);
+                submesh->indices.push_back(face[i]);
+            }
+        }
+    }
+    fclose(file);
+
+    // Area-weighted face normals summed per position, for corners the file
+    // gave no normal
+    std::vector<vec3> generated(positions.size(), vec3(0.0f));
+    for (const SourceSubmesh &source : mesh.submeshes)
+    {
+        for (size_t i = 0; i < source.indices.size(); i += 3)
+        {
+            int a = corners[source.indices[i]].position;
+            int b = corners[source.indices[i + 1]].position;
+            int c = corners[source.indices[i + 2]].position;
+            vec3 normal = cross(positions[b] - positions[a], positions[c] - positions[a]);
+            generated[a] += normal;
+            generated[b] += normal;
+            generated[c] += normal;
+        }
+    }
+
+    mesh.vertices.resize(corners.size());
+    for (size_t i = 0; i < corners.size(); i++)
+    {
+        const Corner &corner = corners[i];
+        SourceVertex &vertex = mesh.vertices[i];
+
+        vertex.position = positions[corner.position];
+        vertex.uv = corner.uv >= 0 ? uvs[corner.uv] : vec2(0.0f);
+
+        vec3 normal = corner.normal >= 0 ? normals[corner.normal] : generated[corner.position];
+        vertex.normal = dot(normal, normal) > 0.0f ? normalize(normal) : vec3(0.0f, 0.0f, 1.0f);
+    }
+
+    // Drop materials that ended up with no faces, e.g. the default one
+    for (size_t i = mesh.submeshes.size(); i-- > 0;)
+    {
+        if (mesh.submeshes[i].indices.empty())
+            mesh.submeshes.erase(mesh.submeshes.begin() + i);
+    }
+
+    return true;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "math/vec.h"
+
+#include <string>
+#include <vector>
+
+struct SourceVertex
+{
+    vec3 position;
+    vec3 normal;
+    vec2 uv;
+};
+
+// Simplified version of a submesh, indexing the same vertices
+struct SourceLod
+{
+    std::vector<unsigned int> indices;
+    float error; // approximate object-space distance from the original
+};
+
+// Triangles sharing a material
+struct SourceSubmesh
+{
+    std::string name;
+    std::vector<unsigned int> indices;
+    std::vector<SourceLod> lods; // coarser versions, filled in by the converter
+};
+
+// Unique vertices (one per distinct position/uv/normal triple in the
+// file) and triangle lists split by material
+struct SourceMesh
+{
+    std::vector<SourceVertex> vertices;
+    std::vector<SourceSubmesh> submeshes;
+};
+
+// Reads the geometry of a Wavefront OBJ file. Polygons are triangulated
+// as fans, and missing normals are generated by averaging the normals of
+// the faces around each position. Prints an error and returns false if
+// the file can not be read.
+bool LoadObj(const char *path, SourceMesh &mesh);
@@ -0,0 +1,324 @@
+#include "optimize.h"
+
+#include <algorithm>
+#include <math.h>
+
+// Size of the cache Forsyth's scoring models; real hardware caches vary,
+// and the algorithm is not sensitive to the exact value
+#define FORSYTH_CACHE_SIZE 32
+
+// Cache assumed when measuring and splitting clusters
+#define SIMULATED_CACHE_SIZE 16
+
+float ComputeAcmr(const std::vector<unsigned int> &indices, unsigned int vertexCount, int cacheSize)
+{
+    if (indices.empty())
+        return 0.0f;
+
+    // FIFO cache: a vertex is resident if it entered within the last
+    // 'cacheSize' insertions
+    std::vector<unsigned int> insertedAt(vertexCount, 0);
+    unsigned int insertions = 0;
+    unsigned int misses = 0;
+
+    for (unsigned int index : indices)
+    {
+        if (insertedAt[index] == 0 || insertions - insertedAt[index] >= (unsigned int)cacheSize)
+        {
+            insertedAt[index] = ++insertions;
+            misses++;
+        }
+    }
+
+    return (float)misses / (indices.size() / 3);
+}
+
+static float VertexScore(int activeTriangles, int cachePosition)
+{
+    if (activeTriangles == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        // The last triangle's vertices get a fixed score, so the next
+        // triangle doesn't simply reuse the same edge every time
+        if (cachePosition < 3)
+            score = 0.75f;
+        else
+            score = powf(1.0f - (cachePosition - 3) / (float)(FORSYTH_CACHE_SIZE - 3), 1.5f);
+    }
+
+    // Favour vertices with few triangles left, so they get finished off
+    // rather than leaving lone triangles for later
+    return score + 2.0f / sqrtf((float)activeTriangles);
+}
+
+void OptimizeVertexCache(std::vector<unsigned int> &indices, unsigned int vertexCount)
+{
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return;
+
+    // Triangles using each vertex, packed into one array
+    std::vector<unsigned int> adjacencyStart(vertexCount + 1, 0);
+    for (unsigned int index : indices)
+        adjacencyStart[index + 1]++;
+    for (unsigned int v = 0; v < vertexCount; v++)
+        adjacencyStart[v + 1] += adjacencyStart[v];
+
+    std::vector<unsigned int> adjacency(indices.size());
+    std::vector<unsigned int> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        for (int k = 0; k < 3; k++)
+            adjacency[fill[indices[t * 3 + k]]++] = (unsigned int)t;
+    }
+
+    // Active triangles are kept at the front of each vertex's list
+    std::vector<int> activeCount(vertexCount);
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (unsigned int v = 0; v < vertexCount; v++)
+    {
+        activeCount[v] = (int)(adjacencyStart[v + 1] - adjacencyStart[v]);
+        vertexScore[v] = VertexScore(activeCount[v], -1);
+    }
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] +
+                           vertexScore[indices[t * 3 + 2]];
+    }
+
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+
+    // Three extra slots hold vertices pushed out by the newest triangle
+    std::vector<unsigned int> cache, nextCache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    nextCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+    size_t scanCursor = 0;
+    long best = -1;
+
+    for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+    {
+        // Nothing in the cache connects to unemitted triangles: fall back
+        // to the best remaining triangle, found by a scan that only ever
+        // moves forward
+        if (best < 0)
+        {
+            float bestScore = -1.0f;
+            for (size_t t = scanCursor; t < triangleCount; t++)
+            {
+                if (!emitted[t] && triangleScore[t] > bestScore)
+                {
+                    bestScore = triangleScore[t];
+                    best = (long)t;
+                }
+            }
+            while (scanCursor < triangleCount && emitted[scanCursor])
+                scanCursor++;
+        }
+
+        size_t triangle = (size_t)best;
+        emitted[triangle] = true;
+
+        nextCache.clear();
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int v = indices[triangle * 3 + k];
+            output.push_back(v);
+            nextCache.push_back(v);
+
+            // Swap the triangle out of the vertex's active range
+            unsigned int *list = &adjacency[adjacencyStart[v]];
+            int count = activeCount[v];
+            for (int i = 0; i < count; i++)
+            {
+                if (list[i] == triangle)
+                {
+                    std::swap(list[i], list[count - 1]);
+                    break;
+                }
+            }
+            activeCount[v]--;
+        }
+
+        for (unsigned int v : cache)
+        {
+            if (v != nextCache[0] && v != nextCache[1] && v != nextCache[2])
+                nextCache.push_back(v);
+        }
+
+        // Rescore everything that was or is in the cache, then pick the
+        // best triangle touching it
+        for (size_t i = 0; i < nextCache.size(); i++)
+        {
+            unsigned int v = nextCache[i];
+            cachePosition[v] = i < FORSYTH_CACHE_SIZE ? (int)i : -1;
+
+            float newScore = VertexScore(activeCount[v], cachePosition[v]);
+            float delta = newScore - vertexScore[v];
+            vertexScore[v] = newScore;
+
+            const unsigned int *list = &adjacency[adjacencyStart[v]];
+            for (int j = 0; j < activeCount[v]; j++)
+                triangleScore[list[j]] += delta;
+        }
+
+        best = -1;
+        float bestScore = -1.0f;
+        for (size_t i = 0; i < nextCache.size() && i < FORSYTH_CACHE_SIZE; i++)
+        {
+            unsigned int v = nextCache[i];
+            const unsigned int *list = &adjacency[adjacencyStart[v]];
+            for (int j = 0; j < activeCount[v]; j++)
+            {
+                if (triangleScore[list[j]] > bestScore)
+                {
+                    bestScore = triangleScore[list[j]];
+                    best = (long)list[j];
+                }
+            }
+        }
+
+        if (nextCache.size() > FORSYTH_CACHE_SIZE)
+            nextCache.resize(FORSYTH_CACHE_SIZE);
+        cache.swap(nextCache);
+    }
+
+    indices.swap(output);
+}
+
+struct Cluster
+{
+    size_t start, end; // triangle range
+    float sortKey;
+};
+
+void OptimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<SourceVertex> &vertices, float threshold)
+{
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2)
+        return;
+
+    // Split wherever a triangle misses the cache on all three vertices:
+    // the cache was effectively flushed there, so reordering clusters
+    // costs little extra transform work
+    std::vector<Cluster> clusters;
+    std::vector<unsigned int> insertedAt(vertices.size(), 0);
+    unsigned int insertions = 0;
+    size_t start = 0;
+
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        int misses = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int v = indices[t * 3 + k];
+            if (insertedAt[v] == 0 || insertions - insertedAt[v] >= SIMULATED_CACHE_SIZE)
+            {
+                insertedAt[v] = ++insertions;
+                misses++;
+            }
+        }
+
+        if (misses == 3 && t > start)
+        {
+            clusters.push_back(Cluster{start, t, 0.0f});
+            start = t;
+        }
+    }
+    clusters.push_back(Cluster{start, triangleCount, 0.0f});
+
+    if (clusters.size() < 2)
+        return;
+
+    // Area-weighted centroid of the whole mesh
+    vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        const vec3 &a = vertices[indices[t * 3]].position;
+        const vec3 &b = vertices[indices[t * 3 + 1]].position;
+        const vec3 &c = vertices[indices[t * 3 + 2]].position;
+        float area = length(cross(b - a, c - a));
+        meshCentroid += (a + b + c) * (area / 3.0f);
+        meshArea += area;
+    }
+    if (meshArea > 0.0f)
+        meshCentroid = meshCentroid / meshArea;
+
+    // Clusters far out along their own normal are likely to occlude the
+    // rest of the mesh, so they sort first
+    for (Cluster &cluster : clusters)
+    {
+        vec3 centroid(0.0f), normal(0.0f);
+        float area = 0.0f;
+        for (size_t t = cluster.start; t < cluster.end; t++)
+        {
+            const vec3 &a = vertices[indices[t * 3]].position;
+            const vec3 &b = vertices[indices[t * 3 + 1]].position;
+            const vec3 &c = vertices[indices[t * 3 + 2]].position;
+            vec3 n = cross(b - a, c - a);
+            float triangleArea = length(n);
+            centroid += (a + b + c) * (triangleArea / 3.0f);
+            normal += n;
+            area += triangleArea;
+        }
+
+        if (area > 0.0f && dot(normal, normal) > 0.0f)
+            cluster.sortKey = dot(centroid / area - meshCentroid, normalize(normal));
+    }
+
+    std::stable_sort(clusters.begin(), clusters.end(),
+                     [](const Cluster &a, const Cluster &b) { return a.sortKey > b.sortKey; });
+
+    std::vector<unsigned int> sorted;
+    sorted.reserve(indices.size());
+    for (const Cluster &cluster : clusters)
+        sorted.insert(sorted.end(), indices.begin() + cluster.start * 3, indices.begin() + cluster.end * 3);
+
+    unsigned int vertexCount = (unsigned int)vertices.size();
+    float before = ComputeAcmr(indices, vertexCount, SIMULATED_CACHE_SIZE);
+    float after = ComputeAcmr(sorted, vertexCount, SIMULATED_CACHE_SIZE);
+    if (after <= before * threshold)
+        indices.swap(sorted);
+}
+
+void OptimizeVertexFetch(SourceMesh &mesh)
+{
+    std::vector<unsigned int> remap(mesh.vertices.size(), ~0u);
+    std::vector<SourceVertex> reordered;
+    reordered.reserve(mesh.vertices.size());
+
+    for (SourceSubmesh &submesh : mesh.submeshes)
+    {
+        for (unsigned int &index : submesh.indices)
+        {
+            if (remap[index] == ~0u)
+            {
+                remap[index] = (unsigned int)reordered.size();
+                reordered.push_back(mesh.vertices[index]);
+            }
+            index = remap[index];
+        }
+    }
+
+    // LODs only use vertices of the full-detail triangles
+    for (SourceSubmesh &submesh : mesh.submeshes)
+    {
+        for (SourceLod &lod : submesh.lods)
+        {
+            for (unsigned int &index : lod.indices)
+                index = remap[index];
+        }
+    }
+
+    // Vertices no triangle uses are dropped
+    mesh.vertices.swap(reordered);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "obj.h"
+
+#include <vector>
+
+// Average number of post-transform cache misses per triangle (ACMR) for
+// a FIFO cache of 'cacheSize' entries. 3.0 is the worst case; around 0.6
+// to 0.7 is typical of a well optimised mesh.
+float ComputeAcmr(const std::vector<unsigned int> &indices, unsigned int vertexCount, int cacheSize);
+
+// Reorders triangles so vertices are reused while still in the
+// post-transform cache, using Tom Forsyth's linear-speed algorithm.
+void OptimizeVertexCache(std::vector<unsigned int> &indices, unsigned int vertexCount);
+
+// Groups the (cache optimised) triangles into clusters and sorts them so
+// outward-facing clusters on the outside of the mesh draw first, which
+// lets early depth testing reject more of what is drawn after them.
+// Clusters are split at cache flushes, and the new order is only kept if
+// its ACMR stays within 'threshold' times the input's.
+void OptimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<SourceVertex> &vertices, float threshold);
+
+// Renumbers vertices in order of first use so vertex fetch walks memory
+// linearly. Rewrites the indices of every submesh and its LODs.
+void OptimizeVertexFetch(SourceMesh &mesh);
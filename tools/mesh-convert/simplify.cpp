@@ -0,0 +1,328 @@
+#include "simplify.h"
+
+#include <algorithm>
+#include <math.h>
+#include <queue>
+#include <string.h>
+#include <unordered_map>
+
+// Symmetric 4x4 matrix summing the squared distance to a set of planes,
+// and how many planes went into it
+struct Quadric
+{
+    double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+    double weight;
+
+    static Quadric fromPlane(double a, double b, double c, double d)
+    {
+        return Quadric{a * a, a * b, a * c, a * d, b * b, b * c, b * d, c * c, c * d, d * d, 1.0};
+    }
+
+    void add(const Quadric &q)
+    {
+        a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+        b2 += q.b2; bc += q.bc; bd += q.bd;
+        c2 += q.c2; cd += q.cd;
+        d2 += q.d2;
+        weight += q.weight;
+    }
+
+    double evaluate(const vec3 &p) const
+    {
+        double x = p.x, y = p.y, z = p.z;
+        double error = a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x +
+                       b2 * y * y + 2 * bc * y * z + 2 * bd * y +
+                       c2 * z * z + 2 * cd * z + d2;
+        return error > 0.0 ? error : 0.0;
+    }
+
+    // Root mean square distance from 'p' to the planes
+    double distance(const vec3 &p) const { return weight > 0.0 ? sqrt(evaluate(p) / weight) : 0.0; }
+};
+
+// Collapse of vertex 'from' onto vertex 'to'
+struct Collapse
+{
+    double cost, distance;
+    unsigned int from, to;
+    unsigned int fromVersion, toVersion;
+
+    bool operator>(const Collapse &other) const { return cost > other.cost; }
+};
+
+struct PositionHash
+{
+    size_t operator()(const vec3 &p) const
+    {
+        unsigned int bits[3];
+        memcpy(bits, &p, sizeof(bits));
+        return bits[0] * 73856093u ^ bits[1] * 19349663u ^ bits[2] * 83492791u;
+    }
+};
+
+struct PositionEqual
+{
+    bool operator()(const vec3 &a, const vec3 &b) const { return a.x == b.x && a.y == b.y && a.z == b.z; }
+};
+
+class Simplifier
+{
+private:
+    const std::vector<SourceVertex> &vertices;
+    std::vector<unsigned int> indices;
+    size_t triangleCount;
+    double maxDistance = 0.0;
+
+    std::vector<bool> triangleAlive;
+    std::vector<std::vector<unsigned int>> vertexTriangles;
+    std::vector<Quadric> quadrics;
+    std::vector<bool> locked, collapsed;
+    std::vector<unsigned int> version;
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> queue;
+
+    const vec3 &position(unsigned int v) const { return vertices[v].position; }
+
+    vec3 triangleNormal(const unsigned int *triangle, unsigned int moved, const vec3 &movedTo) const
+    {
+        vec3 p[3];
+        for (int k = 0; k < 3; k++)
+            p[k] = triangle[k] == moved ? movedTo : position(triangle[k]);
+        return cross(p[1] - p[0], p[2] - p[0]);
+    }
+
+    void pushCollapse(unsigned int from, unsigned int to)
+    {
+        if (locked[from])
+            return;
+
+        Quadric q = quadrics[from];
+        q.add(quadrics[to]);
+        queue.push(Collapse{q.evaluate(position(to)), q.distance(position(to)), from, to, version[from], version[to]});
+    }
+
+    // Neighbours of v through live triangles
+    void neighbours(unsigned int v, std::vector<unsigned int> &out) const
+    {
+        out.clear();
+        for (unsigned int t : vertexTriangles[v])
+        {
+            if (!triangleAlive[t])
+                continue;
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int w = indices[t * 3 + k];
+                if (w != v && std::find(out.begin(), out.end(), w) == out.end())
+                    out.push_back(w);
+            }
+        }
+    }
+
+    bool isValid(const Collapse &collapse, std::vector<unsigned int> &scratchA, std::vector<unsigned int> &scratchB) const
+    {
+        unsigned int u = collapse.from, v = collapse.to;
+        if (collapsed[u] || collapsed[v] || version[u] != collapse.fromVersion || version[v] != collapse.toVersion)
+            return false;
+
+        // The edge must still exist, and the two ends must share exactly
+        // the two vertices opposite it; more would pinch the surface
+        neighbours(u, scratchA);
+        neighbours(v, scratchB);
+        if (std::find(scratchA.begin(), scratchA.end(), v) == scratchA.end())
+            return false;
+
+        int shared = 0;
+        for (unsigned int w : scratchA)
+            shared += std::find(scratchB.begin(), scratchB.end(), w) != scratchB.end();
+        if (shared != 2)
+            return false;
+
+        // No remaining triangle may flip over or collapse to nothing
+        for (unsigned int t : vertexTriangles[u])
+        {
+            const unsigned int *triangle = &indices[t * 3];
+            if (!triangleAlive[t] || triangle[0] == v || triangle[1] == v || triangle[2] == v)
+                continue;
+
+            vec3 before = triangleNormal(triangle, u, position(u));
+            vec3 after = triangleNormal(triangle, u, position(v));
+            if (dot(before, after) <= 0.0f || dot(after, after) <= 1e-12f * dot(before, before))
+                return false;
+        }
+
+        return true;
+    }
+
+public:
+    Simplifier(const std::vector<unsigned int> &sourceIndices, const std::vector<SourceVertex> &vertices)
+        : vertices(vertices), indices(sourceIndices)
+    {
+        triangleCount = indices.size() / 3;
+        size_t vertexCount = vertices.size();
+
+        triangleAlive.assign(triangleCount, true);
+        vertexTriangles.assign(vertexCount, {});
+        quadrics.assign(vertexCount, Quadric{});
+        locked.assign(vertexCount, false);
+        collapsed.assign(vertexCount, false);
+        version.assign(vertexCount, 0);
+
+        // Face planes, summed into each corner's quadric
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            const unsigned int *triangle = &indices[t * 3];
+            vec3 n = triangleNormal(triangle, ~0u, vec3(0.0f));
+            if (dot(n, n) > 0.0f)
+            {
+                n = normalize(n);
+                Quadric q = Quadric::fromPlane(n.x, n.y, n.z, -dot(n, position(triangle[0])));
+                for (int k = 0; k < 3; k++)
+                    quadrics[triangle[k]].add(q);
+            }
+
+            for (int k = 0; k < 3; k++)
+                vertexTriangles[triangle[k]].push_back((unsigned int)t);
+        }
+
+        // Seams: several vertices used here at one position
+        std::unordered_map<vec3, unsigned int, PositionHash, PositionEqual> firstAtPosition;
+        for (unsigned int v = 0; v < vertexCount; v++)
+        {
+            if (vertexTriangles[v].empty())
+                continue;
+
+            auto found = firstAtPosition.emplace(position(v), v);
+            if (!found.second)
+            {
+                locked[v] = true;
+                locked[found.first->second] = true;
+            }
+        }
+
+        // Borders: edges used by only one triangle
+        std::unordered_map<unsigned long long, int> edgeUses;
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int a = indices[t * 3 + k], b = indices[t * 3 + (k + 1) % 3];
+                unsigned long long key = a < b ? ((unsigned long long)a << 32 | b) : ((unsigned long long)b << 32 | a);
+                edgeUses[key]++;
+            }
+        }
+        for (const auto &edge : edgeUses)
+        {
+            if (edge.second == 1)
+            {
+                locked[edge.first >> 32] = true;
+                locked[edge.first & 0xffffffffu] = true;
+            }
+        }
+
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int a = indices[t * 3 + k], b = indices[t * 3 + (k + 1) % 3];
+                pushCollapse(a, b);
+                pushCollapse(b, a);
+            }
+        }
+    }
+
+    // Collapses until at most 'targetTriangles' remain or nothing more can
+    // go. Can be called again with a lower target to continue from here.
+    void run(size_t targetTriangles)
+    {
+        std::vector<unsigned int> scratchA, scratchB, around;
+
+        while (triangleCount > targetTriangles && !queue.empty())
+        {
+            Collapse collapse = queue.top();
+            queue.pop();
+
+            if (!isValid(collapse, scratchA, scratchB))
+                continue;
+
+            unsigned int u = collapse.from, v = collapse.to;
+            for (unsigned int t : vertexTriangles[u])
+            {
+                if (!triangleAlive[t])
+                    continue;
+
+                unsigned int *triangle = &indices[t * 3];
+                if (triangle[0] == v || triangle[1] == v || triangle[2] == v)
+                {
+                    triangleAlive[t] = false;
+                    triangleCount--;
+                    continue;
+                }
+
+                for (int k = 0; k < 3; k++)
+                {
+                    if (triangle[k] == u)
+                        triangle[k] = v;
+                }
+                vertexTriangles[v].push_back(t);
+            }
+
+            vertexTriangles[u].clear();
+            collapsed[u] = true;
+            quadrics[v].add(quadrics[u]);
+            maxDistance = collapse.distance > maxDistance ? collapse.distance : maxDistance;
+
+            // Everything touching v now has a different cost
+            version[v]++;
+            neighbours(v, around);
+            for (unsigned int w : around)
+            {
+                pushCollapse(v, w);
+                pushCollapse(w, v);
+            }
+        }
+    }
+
+    size_t getTriangleCount() const { return triangleCount; }
+
+    // Largest distance any collapse has moved the surface from the planes
+    // of the original triangles around it, in model units. The summed cost
+    // grows with the number of planes as well as with the distance, so it
+    // only orders collapses and is not reported.
+    float getError() const { return (float)maxDistance; }
+
+    void getIndices(std::vector<unsigned int> &out) const
+    {
+        out.clear();
+        out.reserve(triangleCount * 3);
+        for (size_t t = 0; t < triangleAlive.size(); t++)
+        {
+            if (triangleAlive[t])
+                out.insert(out.end(), indices.begin() + t * 3, indices.begin() + t * 3 + 3);
+        }
+    }
+};
+
+std::vector<SourceLod> BuildLods(const std::vector<unsigned int> &indices, const std::vector<SourceVertex> &vertices,
+                                     int maxLods, size_t minTriangles)
+{
+    std::vector<SourceLod> lods;
+    Simplifier simplifier(indices, vertices);
+
+    size_t triangles = indices.size() / 3;
+    while ((int)lods.size() < maxLods && triangles / 2 >= minTriangles)
+    {
+        simplifier.run(triangles / 2);
+
+        // Stop once collapses run out, e.g. when only locked vertices are left
+        if (simplifier.getTriangleCount() > triangles * 3 / 4)
+            break;
+
+        triangles = simplifier.getTriangleCount();
+
+        SourceLod lod;
+        simplifier.getIndices(lod.indices);
+        lod.error = simplifier.getError();
+        lods.push_back(lod);
+    }
+
+    return lods;
+}
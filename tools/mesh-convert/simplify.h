@@ -0,0 +1,22 @@
+#pragma once
+
+#include "obj.h"
+
+#include <vector>
+
+// Builds a chain of successively coarser versions of a triangle list, each
+// with about half the triangles of the one before, using quadric error
+// metric edge collapses (Garland and Heckbert). Every vertex is collapsed
+// onto a neighbour, so all LODs index the same vertex array as the input
+// and can share one vertex buffer. Each LOD continues from the previous
+// one, keeping the quadrics of the original surface, so errors are
+// measured against the full-detail mesh.
+//
+// Vertices on open borders, and vertices whose position is shared with
+// another vertex (UV or normal seams), never move, so neighbouring
+// submeshes and seams stay watertight.
+//
+// Stops after 'maxLods', before going under 'minTriangles', or when
+// simplification stalls.
+std::vector<SourceLod> BuildLods(const std::vector<unsigned int> &indices, const std::vector<SourceVertex> &vertices,
+                                     int maxLods, size_t minTriangles);